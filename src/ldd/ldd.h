@@ -2,6 +2,7 @@
 #define _LDD_H_
 
 #include <stdio.h>
+#include <stdint.h>
 #include "cudd.h"
 
 #ifndef __cplusplus
@@ -33,12 +34,18 @@ typedef struct theory theory_t;
 
 typedef struct LddManager LddManager;
 
+typedef struct LddCubeBuilder LddCubeBuilder;
+
 
 
 /**
  * Theory inerface. Variables are represented by integers. Unless
  * otherwise mentioned, it is the user's responsibility to destroy
  * objects created by her.
+ *
+ * The optional members come last, from scratch_begin on. A theory
+ * that does not implement one must set it to NULL, e.g., by zeroing
+ * the structure before filling it in.
  */
 struct theory
 {
@@ -277,14 +284,43 @@ struct theory
    */
   void (*theory_debug_dump) (LddManager * tdd);
 
-  /** Incremental Quantifier elimination */
+  /**
+      Incremental Quantifier elimination. qelim_solve() returns NULL
+      on error. When every variable is quantified, it must return a
+      constant, and must neither create nodes nor change the theory:
+      Ldd_IsSatParallel() calls it from several threads at once, on
+      contexts of private managers that share the theory.
+   */
   qelim_context_t* (*qelim_init)(LddManager *m, int* vars);
   void (*qelim_push)(qelim_context_t* ctx, lincons_t l);
   lincons_t (*qelim_pop)(qelim_context_t* ctx);
   LddNode* (*qelim_solve)(qelim_context_t* ctx);
   void (*qelim_destroy_context)(qelim_context_t* ctx);
 
+  /**
+     \brief Opens a scope for temporary theory objects. Every
+     constraint, term and constant created until the matching
+     scratch_end() may be released in bulk by scratch_end(), and must
+     not be used after it. Constraints stored in the manager are not
+     affected. Optional, may be NULL.
+   */
+  void (*scratch_begin)(theory_t* self);
+  void (*scratch_end)(theory_t* self);
 
+  /**
+     \brief Returns 1 if every term of the theory has a single
+     variable. Eliminating a variable then amounts to dropping the
+     constraints on it, see Ldd_ExistsAbstractBox(). Optional, may be
+     NULL.
+   */
+  int (*is_box)(theory_t* self);
+
+  /**
+   * Substitute (t[i] + c[i]) for x[i] in l, for all i < n at once.
+   * t[i] and c[i] may be NULL. Optional, may be NULL.
+   */
+  LddNode* (*subst_vec)(LddManager *m, lincons_t l, int *x,
+			linterm_t *t, constant_t *c, size_t n);
 
 };
 
@@ -330,6 +366,14 @@ LddNode* Ldd_And (LddManager* m, LddNode* n1, LddNode* n2);
 LddNode* Ldd_Or (LddManager* m, LddNode* n1, LddNode* n2);
 LddNode* Ldd_Xor (LddManager* m, LddNode* n1, LddNode* n2);
 LddNode* Ldd_Ite (LddManager* m, LddNode* n1, LddNode* n2, LddNode* n3);
+LddNode* Ldd_AndN (LddManager* m, LddNode** fs, size_t n);
+LddNode* Ldd_OrN (LddManager* m, LddNode** fs, size_t n);
+
+LddCubeBuilder* Ldd_CubeBuilderInit (LddManager* m);
+void Ldd_CubeBuilderQuit (LddCubeBuilder* b);
+int Ldd_CubeBuilderAddCube (LddCubeBuilder* b, lincons_t* cons, size_t n);
+size_t Ldd_CubeBuilderSize (LddCubeBuilder* b);
+LddNode* Ldd_CubeBuilderBuild (LddCubeBuilder* b);
 
 LddNode* Ldd_ExistsAbstract (LddManager*, LddNode*, int);
 LddNode* Ldd_UnivAbstract (LddManager*, LddNode*, int);
@@ -337,6 +381,11 @@ LddNode* Ldd_UnivAbstract (LddManager*, LddNode*, int);
 LddNode* Ldd_ExistsAbstractLW (LddManager*, LddNode *, int);
 LddNode* Ldd_ExistsAbstractFM (LddManager*, LddNode *, int);
 LddNode* Ldd_ExistsAbstractSFM (LddManager*, LddNode *, int);
+LddNode* Ldd_ExistsAbstractBox (LddManager*, LddNode *, int);
+LddNode* Ldd_MvExistAbstractBox (LddManager*, LddNode *, int *, size_t);
+LddNode* Ldd_AndExistsAbstractFM (LddManager*, LddNode*, LddNode*, int);
+LddNode* Ldd_AndExistsAbstractBox (LddManager*, LddNode*, LddNode*, 
+				   int *, size_t);
 
 LddNode* Ldd_ExistAbstractPAT (LddManager*, LddNode *, int*);
 
@@ -346,6 +395,9 @@ LddNode* Ldd_Resolve (LddManager*, LddNode*,
 		       linterm_t, lincons_t, lincons_t, int);
 
 void Ldd_ManagerDebugDump (LddManager*);
+double Ldd_ReadCacheLookUps (LddManager*);
+double Ldd_ReadCacheHits (LddManager*);
+unsigned int Ldd_ReadCacheSlots (LddManager*);
 int Ldd_PathSize (LddManager*, LddNode*);
   
 void Ldd_SanityCheck (LddManager*);
@@ -353,6 +405,9 @@ void Ldd_NodeSanityCheck (LddManager*, LddNode*);
 
 LddNode *Ldd_SatReduce (LddManager *, LddNode*, int);
 bool Ldd_IsSat (LddManager *, LddNode*);
+int Ldd_IsSatParallel (LddManager *, LddNode*, int);
+int Ldd_Leq (LddManager *, LddNode *, LddNode *);
+int Ldd_Equiv (LddManager *, LddNode *, LddNode *);
 int Ldd_UnsatSize (LddManager *, LddNode*);
 theory_t *Ldd_SyntacticImplicationTheory (theory_t *t);
 void Ldd_VarOccurrences (LddManager *, LddNode *, int*);
@@ -364,14 +419,45 @@ LddManager * Ldd_BddlikeManager (LddManager *);
 LddManager *Ldd_SetExistsAbstract (LddManager *, 
                                    LddNode*(*)(LddManager*,LddNode*,int));
 LddNode * Ldd_MvExistAbstract (LddManager*, LddNode *, int * , size_t );
+LddNode * Ldd_AndExistsAbstract (LddManager*, LddNode *, LddNode *, 
+				  int *, size_t);
+LddManager *Ldd_SetElimOrder (LddManager *,
+			      int(*)(LddManager*,int*,int*,size_t,int*));
+int Ldd_ElimOrderMinOccur (LddManager*, int*, int*, size_t, int*);
+int Ldd_ElimOrderMinResolvents (LddManager*, int*, int*, size_t, int*);
+int Ldd_ElimOrderMinFill (LddManager*, int*, int*, size_t, int*);
+int Ldd_ElimOrderBoxFirst (LddManager*, int*, int*, size_t, int*);
 LddNode * Ldd_BoxExtrapolate (LddManager*, LddNode*, LddNode*);
 LddNode * Ldd_BoxWiden (LddManager*, LddNode*, LddNode*);
 LddNode * Ldd_BoxWiden2 (LddManager*, LddNode*, LddNode*);
   LddNode * Ldd_IntervalWiden (LddManager*, LddNode *, LddNode*);
+LddNode * Ldd_BoxWidenThresholds (LddManager*, LddNode*, LddNode*,
+				  constant_t**, int*, int);
+LddNode * Ldd_BoxWiden2Thresholds (LddManager*, LddNode*, LddNode*,
+				   constant_t**, int*, int);
+LddNode * Ldd_IntervalWidenThresholds (LddManager*, LddNode*, LddNode*,
+				       constant_t**, int*, int);
 
 LddNode* Ldd_TermReplace (LddManager*, LddNode*, linterm_t, linterm_t, constant_t, constant_t, constant_t);
   LddNode* Ldd_TermCopy (LddManager*, LddNode*, linterm_t, linterm_t);
 LddNode* Ldd_TermMinmaxApprox (LddManager*, LddNode*);
+LddNode* Ldd_BoxHull (LddManager*, LddNode*);
+LddNode* Ldd_BoxJoinK (LddManager*, LddNode*, int,
+		       double (*)(LddManager*, LddNode*, LddNode*));
+double Ldd_BoxDistance (LddManager*, LddNode*, LddNode*);
+int Ldd_GetBounds (LddManager*, LddNode*, linterm_t, constant_t*, constant_t*,
+		   int*, int*);
+int Ldd_GetBoundsN (LddManager*, LddNode*, constant_t*, constant_t*,
+		    int*, int*);
+int Ldd_Eval (LddManager*, LddNode*, const int64_t*);
+int Ldd_EvalBatch (LddManager*, LddNode*, const int64_t * const *, size_t,
+		   char*);
+LddNode* Ldd_BoxesXpy (LddManager*, LddNode*, linterm_t, linterm_t);
+LddNode* Ldd_BoxesXpc (LddManager*, LddNode*, linterm_t, constant_t);
+LddNode* Ldd_BoxesXc (LddManager*, LddNode*, linterm_t, constant_t);
+LddNode* Ldd_BoxesXy (LddManager*, LddNode*, linterm_t, linterm_t);
+LddNode* Ldd_BoxesXneg (LddManager*, LddNode*, linterm_t);
+LddNode* Ldd_BoxesHavoc (LddManager*, LddNode*, linterm_t);
 LddNode* Ldd_TermConstrain (LddManager*, LddNode*, 
 				linterm_t, linterm_t, constant_t);
 LddNodeset* Ldd_NodesetUnion (LddManager*, LddNodeset*, LddNodeset*);
@@ -386,8 +472,16 @@ LddNode* Ldd_SubstTermForVar (LddManager*, LddNode*, int,
                               linterm_t, constant_t);
 LddNode* Ldd_SubstTermPlusForVar (LddManager*, LddNode*, int,
                                   linterm_t, constant_t);
+LddNode* Ldd_VectorSubst (LddManager*, LddNode*, int*, linterm_t*,
+			  constant_t*, size_t);
+LddNode* Ldd_Permute (LddManager*, LddNode*, int*);
+LddNode* Ldd_Transfer (LddManager*, LddManager*, LddNode*);
+int Ldd_TransferN (LddManager*, LddManager*, LddNode**, LddNode**, int);
   int Ldd_DumpSmtLibV1 (LddManager*, LddNode*, char**, char*, FILE*);
 LddNode* Ldd_Cofactor (LddManager*, LddNode*, LddNode*);
+LddNode* Ldd_Constrain (LddManager*, LddNode*, LddNode*);
+LddNode* Ldd_Restrict (LddManager*, LddNode*, LddNode*);
+LddNode* Ldd_Minimize (LddManager*, LddNode*, LddNode*);
   int Ldd_TermLeq (LddManager *, LddNode *, LddNode *);
 
 
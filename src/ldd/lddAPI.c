@@ -75,6 +75,21 @@ Ldd_SetExistsAbstract (LddManager *ldd,
   return ldd;
 }
 
+/**
+   \brief Sets the order in which Ldd_MvExistAbstract() eliminates
+   variables.
+
+   \sa Ldd_ElimOrderMinOccur(), Ldd_ElimOrderMinResolvents(),
+   Ldd_ElimOrderMinFill(), Ldd_ElimOrderBoxFirst()
+ */
+LddManager *
+Ldd_SetElimOrder (LddManager *ldd,
+		  int(*fn)(LddManager*,int*,int*,size_t,int*))
+{
+  ldd->elimOrder = fn;
+  return ldd;
+}
+
 
 
 /**
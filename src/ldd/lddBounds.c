@@ -0,0 +1,397 @@
+/**
+   Bounds of terms over all the paths of an LDD.
+
+   The interval of a term over f is the union, over the paths of f, of
+   the interval given by the bounds on the term along the path. It is
+   computed bottom-up with theory constants only: the interval of a
+   node is the join of the intervals of its children, each met with
+   the constraint of the node or with its negation. The intervals of
+   every node are computed once.
+
+   For the box theories, and whenever the paths of f are satisfiable,
+   this is the tightest interval of the term over f. Otherwise, it
+   contains it.
+ */
+#include "util.h"
+#include "lddInt.h"
+
+/**
+   \brief A bound k of a term, strict or not. k is NULL if the bound
+   is infinite.
+ */
+typedef struct lddBound
+{
+  constant_t k;
+  int strict;
+} lddBound;
+
+/**
+   \brief An interval of a term.
+ */
+typedef struct lddInterval
+{
+  int empty;
+  lddBound lo;
+  lddBound hi;
+} lddInterval;
+
+/**
+   \brief A query of n intervals.
+ */
+typedef struct lddBoundsQuery
+{
+  int n;
+  /* the term of the single interval and its negation, or NULL for
+     the intervals of all variables */
+  linterm_t t;
+  linterm_t nt;
+  /* the intervals of every visited node */
+  st_table *memo;
+} lddBoundsQuery;
+
+static lddInterval *lddBoundsRecur (LddManager *, LddNode *,
+				    lddBoundsQuery *);
+static int lddBoundsRun (LddManager *, LddNode *, lddBoundsQuery *,
+			 constant_t *, constant_t *, int *, int *);
+
+
+/**
+   \brief Computes the interval of the term t over f.
+
+   On return, *lo and *hi are the bounds of t, or NULL if it is
+   unbounded, and *strict_lo and *strict_hi tell whether they are
+   strict. The caller must destroy the bounds. Any of the pointers may
+   be NULL if that bound is not needed. No LDD is built.
+
+   \return 1 if successful; 0 if no path of f is satisfiable; -1 if
+   out of memory
+
+   \sa Ldd_GetBoundsN(), Ldd_TermMinmaxApprox(), Ldd_BoxHull()
+ */
+int
+Ldd_GetBounds (LddManager *ldd, LddNode *f, linterm_t t,
+	       constant_t *lo, constant_t *hi, int *strict_lo, int *strict_hi)
+{
+  lddBoundsQuery q;
+  int res;
+
+  q.n = 1;
+  q.t = t;
+  q.nt = THEORY->negate_term (t);
+  res = lddBoundsRun (ldd, f, &q, lo, hi, strict_lo, strict_hi);
+  THEORY->destroy_term (q.nt);
+  return res;
+}
+
+/**
+   \brief Computes the interval over f of every variable of the
+   theory, in a single pass.
+
+   lo, hi, strict_lo and strict_hi are arrays with an entry per
+   variable, filled as by Ldd_GetBounds(). Only the bounds of single
+   variables, with coefficient 1 or -1, are taken into account.
+
+   \return 1 if successful; 0 if no path of f is satisfiable; -1 if
+   out of memory
+
+   \sa Ldd_GetBounds()
+ */
+int
+Ldd_GetBoundsN (LddManager *ldd, LddNode *f,
+		constant_t *lo, constant_t *hi, int *strict_lo, int *strict_hi)
+{
+  lddBoundsQuery q;
+
+  q.n = (int) THEORY->num_of_vars (THEORY);
+  q.t = q.nt = NULL;
+  return lddBoundsRun (ldd, f, &q, lo, hi, strict_lo, strict_hi);
+}
+
+
+/**
+   \brief Frees the constants of an interval.
+ */
+static void
+lddIntervalClear (LddManager *ldd, lddInterval *i)
+{
+  if (i->lo.k != NULL) THEORY->destroy_cst (i->lo.k);
+  if (i->hi.k != NULL) THEORY->destroy_cst (i->hi.k);
+  i->lo.k = i->hi.k = NULL;
+}
+
+/**
+   \brief Returns the sign of a - b.
+ */
+static int
+lddCstCmp (LddManager *ldd, constant_t a, constant_t b)
+{
+  constant_t nb, d;
+  int sgn;
+
+  nb = THEORY->negate_cst (b);
+  d = THEORY->add_cst (a, nb);
+  sgn = THEORY->sgn_cst (d);
+  THEORY->destroy_cst (d);
+  THEORY->destroy_cst (nb);
+  return sgn;
+}
+
+/**
+   \brief Meets i with the bound b, an upper bound if upper is set
+   and a lower bound otherwise. Takes the constant of b.
+ */
+static void
+lddIntervalMeet (LddManager *ldd, lddInterval *i, lddBound b, int upper)
+{
+  lddBound *old;
+  int c;
+
+  if (i->empty)
+    {
+      THEORY->destroy_cst (b.k);
+      return;
+    }
+
+  old = upper ? &i->hi : &i->lo;
+  if (old->k == NULL)
+    *old = b;
+  else
+    {
+      c = lddCstCmp (ldd, b.k, old->k);
+      /* a smaller upper bound, or a larger lower bound, is tighter */
+      if ((upper ? c < 0 : c > 0) || (c == 0 && b.strict))
+	{
+	  THEORY->destroy_cst (old->k);
+	  *old = b;
+	}
+      else
+	THEORY->destroy_cst (b.k);
+    }
+
+  if (i->lo.k != NULL && i->hi.k != NULL)
+    {
+      c = lddCstCmp (ldd, i->lo.k, i->hi.k);
+      if (c > 0 || (c == 0 && (i->lo.strict || i->hi.strict)))
+	{
+	  lddIntervalClear (ldd, i);
+	  i->empty = 1;
+	}
+    }
+}
+
+/**
+   \brief Returns the looser of the bounds a and b, as a new bound.
+ */
+static lddBound
+lddBoundJoin (LddManager *ldd, lddBound a, lddBound b, int upper)
+{
+  lddBound r;
+  int c;
+
+  r.k = NULL;
+  r.strict = 0;
+  if (a.k == NULL || b.k == NULL) return r;
+
+  c = lddCstCmp (ldd, a.k, b.k);
+  if (c == 0)
+    {
+      r.k = THEORY->dup_cst (a.k);
+      r.strict = a.strict && b.strict;
+    }
+  else
+    {
+      r = (upper ? c > 0 : c < 0) ? a : b;
+      r.k = THEORY->dup_cst (r.k);
+    }
+  return r;
+}
+
+/**
+   \brief Sets r to the join of a and b.
+ */
+static void
+lddIntervalJoin (LddManager *ldd, lddInterval *r,
+		 lddInterval *a, lddInterval *b)
+{
+  if (a->empty) a = b;
+  else if (b->empty) b = a;
+
+  r->empty = a->empty;
+  r->lo.k = r->hi.k = NULL;
+  r->lo.strict = r->hi.strict = 0;
+  if (r->empty) return;
+
+  r->lo = lddBoundJoin (ldd, a->lo, b->lo, 0);
+  r->hi = lddBoundJoin (ldd, a->hi, b->hi, 1);
+}
+
+/**
+   \brief Sets r to a copy of a.
+ */
+static void
+lddIntervalCopy (LddManager *ldd, lddInterval *r, lddInterval *a)
+{
+  *r = *a;
+  if (r->lo.k != NULL) r->lo.k = THEORY->dup_cst (r->lo.k);
+  if (r->hi.k != NULL) r->hi.k = THEORY->dup_cst (r->hi.k);
+}
+
+/**
+   \brief Returns the interval of q that the constraint c bounds, or
+   -1. *sgn is set to the sign of the coefficient of the interval's
+   term in c.
+ */
+static int
+lddBoundsSlot (LddManager *ldd, lddBoundsQuery *q, lincons_t c, int *sgn)
+{
+  linterm_t t;
+  constant_t a;
+
+  t = THEORY->get_term (c);
+
+  if (q->t != NULL)
+    {
+      if (THEORY->term_equals (t, q->t)) *sgn = 1;
+      else if (THEORY->term_equals (t, q->nt)) *sgn = -1;
+      else return -1;
+      return 0;
+    }
+
+  if (THEORY->term_size (t) != 1) return -1;
+  a = THEORY->term_get_coeff (t, 0);
+  if (THEORY->cst_get_si_den (a) != 1) return -1;
+  switch (THEORY->cst_get_si_num (a))
+    {
+    case 1: *sgn = 1; break;
+    case -1: *sgn = -1; break;
+    default: return -1;
+    }
+  return THEORY->term_get_var (t, 0);
+}
+
+/**
+   \brief Meets i with the bound that the literal c, or !c if neg is
+   set, puts on the term with coefficient sgn in c.
+ */
+static void
+lddIntervalMeetCons (LddManager *ldd, lddInterval *i, lincons_t c,
+		     int sgn, int neg)
+{
+  lddBound b;
+  constant_t k;
+
+  /* t <= k, t > k, -t <= k and -t > k */
+  k = THEORY->get_constant (c);
+  b.k = sgn > 0 ? THEORY->dup_cst (k) : THEORY->negate_cst (k);
+  b.strict = neg ? !THEORY->is_strict (c) : THEORY->is_strict (c);
+  lddIntervalMeet (ldd, i, b, (sgn > 0) != neg);
+}
+
+static lddInterval *
+lddBoundsRecur (LddManager *ldd, LddNode *f, lddBoundsQuery *q)
+{
+  LddNode *F;
+  lddInterval *res, *it, *ie, tmp [2];
+  lincons_t c;
+  int i, s, sgn;
+
+  if (st_lookup (q->memo, (char*) f, (char**) &res)) return res;
+
+  F = Cudd_Regular (f);
+  it = ie = NULL;
+  if (F != DD_ONE (CUDD))
+    {
+      it = lddBoundsRecur (ldd, Cudd_NotCond (cuddT (F), F != f), q);
+      if (it == NULL) return NULL;
+      ie = lddBoundsRecur (ldd, Cudd_NotCond (cuddE (F), F != f), q);
+      if (ie == NULL) return NULL;
+    }
+
+  res = ALLOC (lddInterval, q->n);
+  if (res == NULL) return NULL;
+
+  if (F == DD_ONE (CUDD))
+    {
+      /* true leaves every term unbounded, and false has no values */
+      for (i = 0; i < q->n; i++)
+	{
+	  res [i].empty = f != F;
+	  res [i].lo.k = res [i].hi.k = NULL;
+	  res [i].lo.strict = res [i].hi.strict = 0;
+	}
+    }
+  else
+    {
+      c = lddC (ldd, F->index);
+      s = lddBoundsSlot (ldd, q, c, &sgn);
+
+      for (i = 0; i < q->n; i++)
+	if (i != s)
+	  lddIntervalJoin (ldd, &res [i], &it [i], &ie [i]);
+
+      if (s >= 0)
+	{
+	  /* meet copies of the children's intervals with c and !c */
+	  lddIntervalCopy (ldd, &tmp [0], &it [s]);
+	  lddIntervalMeetCons (ldd, &tmp [0], c, sgn, 0);
+	  lddIntervalCopy (ldd, &tmp [1], &ie [s]);
+	  lddIntervalMeetCons (ldd, &tmp [1], c, sgn, 1);
+	  lddIntervalJoin (ldd, &res [s], &tmp [0], &tmp [1]);
+	  lddIntervalClear (ldd, &tmp [0]);
+	  lddIntervalClear (ldd, &tmp [1]);
+	}
+    }
+
+  if (st_insert (q->memo, (char*) f, (char*) res) == ST_OUT_OF_MEM)
+    {
+      for (i = 0; i < q->n; i++)
+	lddIntervalClear (ldd, &res [i]);
+      FREE (res);
+      return NULL;
+    }
+  return res;
+}
+
+/**
+   \brief Runs the query q on f, and copies its intervals out.
+ */
+static int
+lddBoundsRun (LddManager *ldd, LddNode *f, lddBoundsQuery *q,
+	      constant_t *lo, constant_t *hi, int *strict_lo, int *strict_hi)
+{
+  st_generator *gen;
+  lddInterval *r;
+  LddNode *key;
+  int i, res;
+
+  q->memo = st_init_table (st_ptrcmp, st_ptrhash);
+  if (q->memo == NULL) return -1;
+
+  r = lddBoundsRecur (ldd, f, q);
+  if (r == NULL)
+    res = -1;
+  else
+    {
+      /* an empty interval means that no path is satisfiable */
+      res = f != Cudd_Not (DD_ONE (CUDD));
+      for (i = 0; i < q->n; i++)
+	{
+	  if (r [i].empty) res = 0;
+	  if (lo != NULL)
+	    lo [i] = r [i].lo.k != NULL ? THEORY->dup_cst (r [i].lo.k) : NULL;
+	  if (hi != NULL)
+	    hi [i] = r [i].hi.k != NULL ? THEORY->dup_cst (r [i].hi.k) : NULL;
+	  if (strict_lo != NULL) strict_lo [i] = r [i].lo.strict;
+	  if (strict_hi != NULL) strict_hi [i] = r [i].hi.strict;
+	}
+    }
+
+  st_foreach_item (q->memo, gen, (char**)&key, (char**)&r)
+    {
+      for (i = 0; i < q->n; i++)
+	lddIntervalClear (ldd, &r [i]);
+      FREE (r);
+    }
+  st_free_table (q->memo);
+  return res;
+}
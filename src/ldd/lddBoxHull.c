@@ -0,0 +1,520 @@
+/**
+   Size-controlled joins of Boxes LDDs.
+
+   Every path of a Boxes LDD is a box, and the LDD is their union. The
+   join of two boxes is their box hull: for every term bounded in
+   both, the weaker of their upper bounds and the weaker of their
+   lower bounds. Ldd_BoxHull() joins all the paths of an LDD into one
+   box, and Ldd_BoxJoinK() into at most k boxes, merging the closest
+   pairs first. Both work bottom-up, and visit every node once: the
+   boxes of a node are the boxes of its children, conjoined with its
+   constraint or with its negation, and joined again if there are too
+   many.
+
+   Both results contain the LDD. For the box theories, the box hull is
+   the least box that does.
+ */
+#include "util.h"
+#include "lddInt.h"
+
+/**
+   \brief The bounds of a box on one term.
+ */
+typedef struct lddBoxBound
+{
+  /** term group of the bounds */
+  int term;
+  /** literal of the upper bound t <= k, or NULL */
+  LddNode *hi;
+  /** literal of the lower bound !(t <= k), or NULL */
+  LddNode *lo;
+} lddBoxBound;
+
+/**
+   \brief At most k boxes of a node.
+ */
+typedef struct lddBoxList
+{
+  int n;
+  LddNode **box;
+} lddBoxList;
+
+/**
+   \brief State of Ldd_BoxJoinK.
+ */
+typedef struct lddBoxJoinK
+{
+  int k;
+  double (*dist)(LddManager*, LddNode*, LddNode*);
+  /** the boxes of every visited node */
+  st_table *lists;
+} lddBoxJoinK;
+
+static LddNode *lddBoxHullRecur (LddManager *, LddNode *, DdLocalCache *);
+static lddBoxList *lddBoxJoinKRecur (LddManager *, LddNode *,
+				     lddBoxJoinK *);
+static LddNode *lddBoxJoin (LddManager *, LddNode *, LddNode *);
+
+
+/**
+   \brief Computes the box hull of f.
+
+   \return a pointer to a cube that contains f if successful; NULL
+   otherwise
+
+   \sa Ldd_BoxJoinK(), Ldd_TermMinmaxApprox()
+ */
+LddNode *
+Ldd_BoxHull (LddManager *ldd, LddNode *f)
+{
+  DdLocalCache *cache;
+  LddNode *res;
+
+  do
+    {
+      CUDD->reordered = 0;
+      cache = cuddLocalCacheInit (CUDD, 1, 2, CUDD->maxCacheHard);
+      if (cache == NULL) return NULL;
+
+      res = lddBoxHullRecur (ldd, f, cache);
+      if (res != NULL) cuddRef (res);
+      cuddLocalCacheQuit (cache);
+    } while (CUDD->reordered == 1);
+
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Over-approximates f by the union of at most k boxes.
+
+   The paths of f are joined bottom-up. Whenever a node has more than
+   k boxes, the two boxes with the smallest distance dist are replaced
+   by their box hull, until k are left. If dist is NULL,
+   Ldd_BoxDistance() is used. With k = 1, the result is Ldd_BoxHull().
+
+   \return a pointer to the result if successful; NULL otherwise
+
+   \sa Ldd_BoxHull(), Ldd_BoxDistance()
+ */
+LddNode *
+Ldd_BoxJoinK (LddManager *ldd, LddNode *f, int k,
+	      double (*dist)(LddManager*, LddNode*, LddNode*))
+{
+  lddBoxJoinK a;
+  lddBoxList *l;
+  st_generator *gen;
+  LddNode *res, *tmp, *key;
+  int i;
+
+  a.k = k < 1 ? 1 : k;
+  a.dist = dist != NULL ? dist : Ldd_BoxDistance;
+
+  do
+    {
+      CUDD->reordered = 0;
+      a.lists = st_init_table (st_ptrcmp, st_ptrhash);
+      if (a.lists == NULL) return NULL;
+
+      res = NULL;
+      l = lddBoxJoinKRecur (ldd, f, &a);
+      if (l != NULL)
+	{
+	  /* the union of the boxes of the root */
+	  res = Cudd_Not (DD_ONE (CUDD));
+	  cuddRef (res);
+	  for (i = 0; res != NULL && i < l->n; i++)
+	    {
+	      tmp = lddAndRecur (ldd, Cudd_Not (res), Cudd_Not (l->box [i]));
+	      if (tmp != NULL) cuddRef (tmp);
+	      Cudd_IterDerefBdd (CUDD, res);
+	      res = tmp == NULL ? NULL : Cudd_Not (tmp);
+	    }
+	}
+
+      st_foreach_item (a.lists, gen, (char**)&key, (char**)&l)
+	{
+	  for (i = 0; i < l->n; i++)
+	    Cudd_IterDerefBdd (CUDD, l->box [i]);
+	  FREE (l->box);
+	  FREE (l);
+	}
+      st_free_table (a.lists);
+    } while (CUDD->reordered == 1);
+
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+
+/**
+   \brief Returns the bounds of the cube f in a new array *b, one
+   entry per term.
+
+   \return the number of entries, or -1 if out of memory
+ */
+static int
+lddBoxBounds (LddManager *ldd, LddNode *f, lddBoxBound **b)
+{
+  LddNode *one, *zero, *F, *fv, *fnv, *lit, **old;
+  int n, i, size;
+
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+
+  size = 0;
+  for (F = Cudd_Regular (f); F != one; F = Cudd_Regular (cuddT (F)) == one ?
+	 Cudd_Regular (cuddE (F)) : Cudd_Regular (cuddT (F)))
+    size++;
+
+  *b = ALLOC (lddBoxBound, size > 0 ? size : 1);
+  if (*b == NULL) return -1;
+
+  n = 0;
+  while (f != one)
+    {
+      F = Cudd_Regular (f);
+      fv = Cudd_NotCond (cuddT (F), F != f);
+      fnv = Cudd_NotCond (cuddE (F), F != f);
+
+      /* f is a cube, so one of the children is false */
+      if (fnv == zero)
+	{
+	  lit = CUDD->vars [F->index];
+	  f = fv;
+	}
+      else
+	{
+	  assert (fv == zero);
+	  lit = Cudd_Not (CUDD->vars [F->index]);
+	  f = fnv;
+	}
+
+      for (i = 0; i < n && (*b) [i].term != ldd->ddTerm [F->index]; i++);
+      if (i == n)
+	{
+	  (*b) [n].term = ldd->ddTerm [F->index];
+	  (*b) [n].hi = (*b) [n].lo = NULL;
+	  n++;
+	}
+
+      /* a cube has at most one bound of each kind on a term */
+      old = lit == CUDD->vars [F->index] ? &(*b) [i].hi : &(*b) [i].lo;
+      assert (*old == NULL);
+      *old = lit;
+    }
+  return n;
+}
+
+/**
+   \brief The constant of the constraint of the literal lit.
+ */
+static double
+lddLitConstant (LddManager *ldd, LddNode *lit)
+{
+  constant_t k;
+
+  k = THEORY->get_constant (lddC (ldd, Cudd_Regular (lit)->index));
+  return (double) THEORY->cst_get_si_num (k) /
+    (double) THEORY->cst_get_si_den (k);
+}
+
+/**
+   \brief The distance between the boxes a and b.
+
+   This is the L1 distance between their closest points: the sum, over
+   the terms bounded in both, of the gap between their intervals, or 0
+   if the intervals intersect or touch. Strictness is ignored.
+
+   \sa Ldd_BoxJoinK()
+ */
+double
+Ldd_BoxDistance (LddManager *ldd, LddNode *a, LddNode *b)
+{
+  lddBoxBound *ba, *bb;
+  int na, nb, i, j;
+  double d, g, gap;
+
+  if (Cudd_Regular (a) == DD_ONE (CUDD) ||
+      Cudd_Regular (b) == DD_ONE (CUDD))
+    return 0.0;
+
+  na = lddBoxBounds (ldd, a, &ba);
+  if (na < 0) return 0.0;
+  nb = lddBoxBounds (ldd, b, &bb);
+  if (nb < 0)
+    {
+      FREE (ba);
+      return 0.0;
+    }
+
+  d = 0.0;
+  for (i = 0; i < na; i++)
+    for (j = 0; j < nb; j++)
+      {
+	if (ba [i].term != bb [j].term) continue;
+
+	/* b above a, or a above b */
+	gap = 0.0;
+	if (ba [i].hi != NULL && bb [j].lo != NULL)
+	  gap = lddLitConstant (ldd, bb [j].lo) -
+	    lddLitConstant (ldd, ba [i].hi);
+	if (bb [j].hi != NULL && ba [i].lo != NULL)
+	  {
+	    g = lddLitConstant (ldd, ba [i].lo) -
+	      lddLitConstant (ldd, bb [j].hi);
+	    if (g > gap) gap = g;
+	  }
+	if (gap > 0.0) d += gap;
+      }
+
+  FREE (ba);
+  FREE (bb);
+  return d;
+}
+
+/**
+   \brief Returns the box hull of the boxes a and b.
+ */
+static LddNode *
+lddBoxJoin (LddManager *ldd, LddNode *a, LddNode *b)
+{
+  lddBoxBound *ba, *bb;
+  LddNode *one, *res, *tmp, *lit [2];
+  int na, nb, i, j, l;
+
+  one = DD_ONE (CUDD);
+
+  if (a == Cudd_Not (one) || a == b) return b;
+  if (b == Cudd_Not (one)) return a;
+  if (a == one || b == one) return one;
+
+  na = lddBoxBounds (ldd, a, &ba);
+  if (na < 0) return NULL;
+  nb = lddBoxBounds (ldd, b, &bb);
+  if (nb < 0)
+    {
+      FREE (ba);
+      return NULL;
+    }
+
+  res = one;
+  cuddRef (res);
+  for (i = 0; res != NULL && i < na; i++)
+    {
+      for (j = 0; j < nb && bb [j].term != ba [i].term; j++);
+      /* a term bounded in one box only is unbounded in the hull */
+      if (j == nb) continue;
+
+      /* the weaker upper bound t <= k, and the weaker lower bound
+	 !(t <= k), which negates the stronger constraint */
+      lit [0] = lit [1] = NULL;
+      if (ba [i].hi != NULL && bb [j].hi != NULL)
+	lit [0] = lddIsStronger (ldd, Cudd_Regular (ba [i].hi)->index,
+				 Cudd_Regular (bb [j].hi)->index) ?
+	  bb [j].hi : ba [i].hi;
+      if (ba [i].lo != NULL && bb [j].lo != NULL)
+	lit [1] = lddIsStronger (ldd, Cudd_Regular (ba [i].lo)->index,
+				 Cudd_Regular (bb [j].lo)->index) ?
+	  ba [i].lo : bb [j].lo;
+
+      for (l = 0; res != NULL && l < 2; l++)
+	{
+	  if (lit [l] == NULL) continue;
+	  tmp = lddAndRecur (ldd, res, lit [l]);
+	  if (tmp != NULL) cuddRef (tmp);
+	  Cudd_IterDerefBdd (CUDD, res);
+	  res = tmp;
+	}
+    }
+
+  FREE (ba);
+  FREE (bb);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Returns lit && f, and releases f.
+ */
+static LddNode *
+lddBoxAndLit (LddManager *ldd, LddNode *lit, LddNode *f)
+{
+  LddNode *res;
+
+  res = lddAndRecur (ldd, lit, f);
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, f);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+static LddNode *
+lddBoxHullRecur (LddManager *ldd, LddNode *f, DdLocalCache *cache)
+{
+  LddNode *F, *root, *t, *e, *res;
+
+  F = Cudd_Regular (f);
+  if (F == DD_ONE (CUDD)) return f;
+
+  if (F->ref != 1 && (res = cuddLocalCacheLookup (cache, &f)) != NULL)
+    return res;
+
+  root = CUDD->vars [F->index];
+
+  t = lddBoxHullRecur (ldd, Cudd_NotCond (cuddT (F), F != f), cache);
+  if (t == NULL) return NULL;
+  cuddRef (t);
+  t = lddBoxAndLit (ldd, root, t);
+  if (t == NULL) return NULL;
+  cuddRef (t);
+
+  e = lddBoxHullRecur (ldd, Cudd_NotCond (cuddE (F), F != f), cache);
+  if (e != NULL)
+    {
+      cuddRef (e);
+      e = lddBoxAndLit (ldd, Cudd_Not (root), e);
+    }
+  if (e == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, t);
+      return NULL;
+    }
+  cuddRef (e);
+
+  res = lddBoxJoin (ldd, t, e);
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, t);
+  Cudd_IterDerefBdd (CUDD, e);
+  if (res == NULL) return NULL;
+
+  if (F->ref != 1)
+    cuddLocalCacheInsert (cache, &f, res);
+  cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Joins the closest boxes of l until at most k are left.
+
+   \return 1 if successful; 0 otherwise
+ */
+static int
+lddBoxListReduce (LddManager *ldd, lddBoxList *l, lddBoxJoinK *a)
+{
+  double *d, min;
+  LddNode *box;
+  int n, i, j, mi, mj;
+
+  n = l->n;
+  if (n <= a->k) return 1;
+
+  /* d [i * n + j], for i < j, is the distance between boxes i and j.
+     A merged box j is NULL. */
+  d = ALLOC (double, n * n);
+  if (d == NULL) return 0;
+  for (i = 0; i < n; i++)
+    for (j = i + 1; j < n; j++)
+      d [i * n + j] = a->dist (ldd, l->box [i], l->box [j]);
+
+  while (l->n > a->k)
+    {
+      mi = mj = -1;
+      min = 0.0;
+      for (i = 0; i < n; i++)
+	if (l->box [i] != NULL)
+	  for (j = i + 1; j < n; j++)
+	    if (l->box [j] != NULL && (mi < 0 || d [i * n + j] < min))
+	      {
+		mi = i;
+		mj = j;
+		min = d [i * n + j];
+	      }
+
+      box = lddBoxJoin (ldd, l->box [mi], l->box [mj]);
+      if (box == NULL) break;
+      cuddRef (box);
+      Cudd_IterDerefBdd (CUDD, l->box [mi]);
+      Cudd_IterDerefBdd (CUDD, l->box [mj]);
+      l->box [mi] = box;
+      l->box [mj] = NULL;
+      l->n--;
+
+      for (j = 0; j < n; j++)
+	if (j != mi && l->box [j] != NULL)
+	  d [j < mi ? j * n + mi : mi * n + j] =
+	    a->dist (ldd, l->box [j < mi ? j : mi], l->box [j < mi ? mi : j]);
+    }
+  FREE (d);
+
+  /* compact the boxes */
+  for (i = j = 0; i < n; i++)
+    if (l->box [i] != NULL)
+      l->box [j++] = l->box [i];
+  return l->n <= a->k;
+}
+
+static lddBoxList *
+lddBoxJoinKRecur (LddManager *ldd, LddNode *f, lddBoxJoinK *a)
+{
+  LddNode *F, *root, *box, *lit;
+  lddBoxList *l, *c [2];
+  int i, j;
+
+  if (st_lookup (a->lists, (char*) f, (char**) &l)) return l;
+
+  F = Cudd_Regular (f);
+  if (F != DD_ONE (CUDD))
+    {
+      c [0] = lddBoxJoinKRecur (ldd, Cudd_NotCond (cuddT (F), F != f), a);
+      if (c [0] == NULL) return NULL;
+      c [1] = lddBoxJoinKRecur (ldd, Cudd_NotCond (cuddE (F), F != f), a);
+      if (c [1] == NULL) return NULL;
+    }
+
+  l = ALLOC (lddBoxList, 1);
+  if (l == NULL) return NULL;
+  l->n = 0;
+  l->box = ALLOC (LddNode*, F != DD_ONE (CUDD) ? c [0]->n + c [1]->n + 1 : 1);
+  if (l->box == NULL)
+    {
+      FREE (l);
+      return NULL;
+    }
+  if (st_insert (a->lists, (char*) f, (char*) l) == ST_OUT_OF_MEM)
+    {
+      FREE (l->box);
+      FREE (l);
+      return NULL;
+    }
+
+  if (F == DD_ONE (CUDD))
+    {
+      /* true is one box, and false none */
+      if (f == F)
+	{
+	  l->box [l->n++] = f;
+	  cuddRef (f);
+	}
+      return l;
+    }
+
+  /* the boxes of the children, with the constraint of f or its
+     negation */
+  root = CUDD->vars [F->index];
+  for (i = 0; i < 2; i++)
+    {
+      lit = Cudd_NotCond (root, i == 1);
+      for (j = 0; j < c [i]->n; j++)
+	{
+	  box = lddAndRecur (ldd, lit, c [i]->box [j]);
+	  if (box == NULL) return NULL;
+	  if (box == Cudd_Not (DD_ONE (CUDD))) continue;
+	  cuddRef (box);
+	  l->box [l->n++] = box;
+	}
+    }
+
+  if (!lddBoxListReduce (ldd, l, a)) return NULL;
+  return l;
+}
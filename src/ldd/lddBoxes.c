@@ -1,7 +1,10 @@
 #include "util.h"
 #include "lddInt.h"
 
-static LddNode *expandToInfinity (LddManager *, LddNode*, lincons_t);
+static LddNode *expandToInfinity (LddManager *, LddNode*, lincons_t,
+				  lddThresholds*);
+static LddNode *lddWidenThresholds (LddManager *, LddNode *, LddNode *,
+				    constant_t **, int *, int, int);
 
 LddNode *
 Ldd_BoxWiden (LddManager *ldd, LddNode *f, LddNode *g)
@@ -11,7 +14,7 @@ Ldd_BoxWiden (LddManager *ldd, LddNode *f, LddNode *g)
   do
     {
       CUDD->reordered = 0;
-      res = lddBoxWidenRecur (ldd, f, g);
+      res = lddBoxWidenRecur (ldd, f, g, NULL);
     } while (CUDD->reordered == 1);
   
   return (res);
@@ -25,7 +28,7 @@ Ldd_BoxWiden2 (LddManager *ldd, LddNode *f, LddNode *g)
   do
     {
       CUDD->reordered = 0;
-      res = lddBoxWiden2Recur (ldd, f, g, NULL);
+      res = lddBoxWiden2Recur (ldd, f, g, NULL, NULL);
     } while (CUDD->reordered == 1);
   
   return (res);
@@ -39,13 +42,167 @@ Ldd_IntervalWiden (LddManager *ldd, LddNode *f, LddNode *g)
   do
     {
       CUDD->reordered = 0;
-      res = lddIntervalWidenRecur (ldd, f, g);
+      res = lddIntervalWidenRecur (ldd, f, g, NULL);
     } while (CUDD->reordered == 1);
   
   return res;
 }
 
+/**
+   \brief Widens f by g like Ldd_BoxWiden, but moves an unstable bound
+   of a variable to the nearest of its landmarks, and only to infinity
+   when there is none.
+
+   th[x] is an ascending array of n[x] landmark constants of variable
+   x, for every x smaller than size. An upper bound x <= k becomes
+   x <= l for the smallest landmark l >= k, and a lower bound -x <= k
+   becomes -x <= -l for the largest landmark l <= -k. Since every
+   landmark is used at most once per bound, an ascending chain is
+   still stabilized in finitely many steps.
+
+   \return a pointer to the result if successful; NULL otherwise
+
+   \sa Ldd_BoxWiden(), Ldd_BoxWiden2Thresholds(),
+   Ldd_IntervalWidenThresholds()
+ */
+LddNode *
+Ldd_BoxWidenThresholds (LddManager *ldd, LddNode *f, LddNode *g,
+			constant_t **th, int *n, int size)
+{
+  return lddWidenThresholds (ldd, f, g, th, n, size, 0);
+}
+
+/**
+   \brief Widens f by g like Ldd_BoxWiden2, with the landmarks th of
+   Ldd_BoxWidenThresholds.
+
+   \sa Ldd_BoxWidenThresholds()
+ */
+LddNode *
+Ldd_BoxWiden2Thresholds (LddManager *ldd, LddNode *f, LddNode *g,
+			 constant_t **th, int *n, int size)
+{
+  return lddWidenThresholds (ldd, f, g, th, n, size, 1);
+}
+
+/**
+   \brief Widens f by g like Ldd_IntervalWiden, with the landmarks th
+   of Ldd_BoxWidenThresholds.
+
+   \sa Ldd_BoxWidenThresholds()
+ */
+LddNode *
+Ldd_IntervalWidenThresholds (LddManager *ldd, LddNode *f, LddNode *g,
+			     constant_t **th, int *n, int size)
+{
+  return lddWidenThresholds (ldd, f, g, th, n, size, 2);
+}
+
+/**
+   \brief Common driver of the widenings with thresholds. op is 0 for
+   Ldd_BoxWiden, 1 for Ldd_BoxWiden2 and 2 for Ldd_IntervalWiden.
+
+   The results depend on the landmarks, so they are kept in a local
+   cache rather than in the computed table of the manager.
+ */
+static LddNode *
+lddWidenThresholds (LddManager *ldd, LddNode *f, LddNode *g,
+		    constant_t **th, int *n, int size, int op)
+{
+  lddThresholds t;
+  LddNode *res;
+
+  t.th = th;
+  t.n = n;
+  t.size = size;
+
+  do
+    {
+      CUDD->reordered = 0;
+      /* Ldd_BoxWiden2 keys its results on a flag as well */
+      t.cache = cuddLocalCacheInit (CUDD, 3, 2, CUDD->maxCacheHard);
+      if (t.cache == NULL) return NULL;
+
+      if (op == 0)
+	res = lddBoxWidenRecur (ldd, f, g, &t);
+      else if (op == 1)
+	res = lddBoxWiden2Recur (ldd, f, g, NULL, &t);
+      else
+	res = lddIntervalWidenRecur (ldd, f, g, &t);
+
+      if (res != NULL) cuddRef (res);
+      cuddLocalCacheQuit (t.cache);
+    } while (CUDD->reordered == 1);
+
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Returns the landmark bound of th that is implied by the
+   bound c, or NULL if there is none. The caller must destroy the
+   result.
+ */
+static lincons_t
+lddThresholdCons (LddManager *ldd, lddThresholds *th, lincons_t c)
+{
+  linterm_t t;
+  constant_t a, k, nk, d;
+  lincons_t res;
+  int x, i, step;
+
+  if (th == NULL) return NULL;
+
+  t = THEORY->get_term (c);
+  if (THEORY->term_size (t) != 1) return NULL;
+  x = THEORY->term_get_var (t, 0);
+  if (x >= th->size || th->n [x] == 0) return NULL;
+
+  /* a*x <= a*l is implied by a*x <= k iff a*l >= k. The products are
+     ascending in l if a > 0, and descending otherwise. */
+  a = THEORY->term_get_coeff (t, 0);
+  step = THEORY->sgn_cst (a) > 0 ? 1 : -1;
+  nk = THEORY->negate_cst (THEORY->get_constant (c));
+  res = NULL;
+  for (i = step > 0 ? 0 : th->n [x] - 1;
+       res == NULL && 0 <= i && i < th->n [x]; i += step)
+    {
+      k = THEORY->mul_cst (a, th->th [x][i]);
+      d = THEORY->add_cst (k, nk);
+      if (THEORY->sgn_cst (d) >= 0)
+	res = THEORY->create_cons (THEORY->dup_term (t), 0, k);
+      else
+	THEORY->destroy_cst (k);
+      THEORY->destroy_cst (d);
+    }
+  THEORY->destroy_cst (nk);
+  return res;
+}
+
+/**
+   \brief Returns f conjoined with the landmark bound of th implied by
+   the bound c, or f if there is none.
+ */
+static LddNode *
+lddThresholdAnd (LddManager *ldd, lddThresholds *th, lincons_t c,
+		 LddNode *f)
+{
+  lincons_t wCons;
+  LddNode *w, *r;
+
+  wCons = lddThresholdCons (ldd, th, c);
+  if (wCons == NULL) return f;
 
+  w = THEORY->to_ldd (ldd, wCons);
+  THEORY->destroy_lincons (wCons);
+  if (w == NULL) return NULL;
+  cuddRef (w);
+  r = lddAndRecur (ldd, w, f);
+  if (r != NULL) cuddRef (r);
+  Cudd_IterDerefBdd (CUDD, w);
+  if (r != NULL) cuddDeref (r);
+  return r;
+}
 
 /** 
  * Extrapolation for intervals. 
@@ -458,7 +615,8 @@ lddBoxExtrapolateRecur (LddManager *ldd,
 LddNode *
 lddBoxWidenRecur (LddManager *ldd,
 		  LddNode *f,
-		  LddNode *g)
+		  LddNode *g,
+		  lddThresholds *th)
 {
   DdManager * manager;
   DdNode *F, *fv, *fnv, *G, *gv, *gnv;
@@ -466,6 +624,7 @@ lddBoxWidenRecur (LddManager *ldd,
   unsigned int topf, topg, index;
 
   lincons_t vCons;
+  DdNode *key [3];
 
   manager = CUDD;
   statLine(manager);
@@ -482,8 +641,14 @@ lddBoxWidenRecur (LddManager *ldd,
   
 
   /* Check cache. */
+  key [0] = f;
+  key [1] = g;
+  key [2] = one;
   if (F->ref != 1 || G->ref != 1) {
-    r = cuddCacheLookup2(manager, (DD_CTFP)Ldd_BoxWiden, f, g);
+    if (th != NULL)
+      r = cuddLocalCacheLookup (th->cache, key);
+    else
+      r = cuddCacheLookup2(manager, (DD_CTFP)Ldd_BoxWiden, f, g);
     if (r != NULL) return(r);
   }
   else
@@ -560,20 +725,34 @@ lddBoxWidenRecur (LddManager *ldd,
     }
   
   
-  e = lddBoxWidenRecur (ldd, fnv, gnv);
+  e = lddBoxWidenRecur (ldd, fnv, gnv, th);
   if (e == NULL) return NULL;
   cuddRef (e);
 
   if (index != F->index && fv == gv)
-    /* reference to e is migrated into r */
-    r = e;
+    {
+      if (th != NULL && fv == zero)
+	{
+	  /* the lower bound !vCons of g is dropped, unless it has a
+	     landmark */
+	  lincons_t nCons = THEORY->negate_cons (vCons);
+	  r = lddThresholdAnd (ldd, th, nCons, e);
+	  THEORY->destroy_lincons (nCons);
+	  if (r != NULL) cuddRef (r);
+	  Cudd_IterDerefBdd (CUDD, e);
+	  if (r == NULL) return NULL;
+	}
+      else
+	/* reference to e is migrated into r */
+	r = e;
+    }
   else
     {
       DdNode *E = Cudd_Regular (e);
       lincons_t eCons = NULL;
 
       
-      t = lddBoxWidenRecur (ldd, fv, gv);
+      t = lddBoxWidenRecur (ldd, fv, gv, th);
       if (t == NULL)
 	{
 	  Cudd_IterDerefBdd (manager, e);
@@ -623,7 +802,7 @@ lddBoxWidenRecur (LddManager *ldd,
 	  if (eCons != NULL && THEORY->is_stronger_cons (vCons, eCons))
 	    {
 	      DdNode* ee;
-	      ee = expandToInfinity (ldd, e, vCons);
+	      ee = expandToInfinity (ldd, e, vCons, th);
 	      if (ee != NULL) cuddRef (ee);
 	      Cudd_IterDerefBdd (CUDD, e);
 	      if (ee == NULL)
@@ -656,18 +835,25 @@ lddBoxWidenRecur (LddManager *ldd,
   
   
   if (F->ref != 1 || G->ref != 1)
-    cuddCacheInsert2(manager, (DD_CTFP)Ldd_BoxWiden, f, g, r);
+    {
+      if (th != NULL)
+	cuddLocalCacheInsert (th->cache, key, r);
+      else
+	cuddCacheInsert2(manager, (DD_CTFP)Ldd_BoxWiden, f, g, r);
+    }
   
   cuddDeref (r);
   return r;
 }
 
 /** Interval widen f by g. Assume that f and g are cubes, and f is
-    term-contained in g */
+    term-contained in g. An unstable bound is moved to a landmark of th,
+    if any. */
 LddNode *
 lddIntervalWidenRecur (LddManager *ldd,
 		       LddNode *f,
-		       LddNode *g)
+		       LddNode *g,
+		       lddThresholds *th)
 {
   DdNode *one, *zero, *res, *F, *G;
 
@@ -695,7 +881,7 @@ lddIntervalWidenRecur (LddManager *ldd,
 
   if (! (THEORY->term_equals (THEORY->get_term (fCons), 
 			      THEORY->get_term (gCons))))
-    return lddIntervalWidenRecur (ldd, (fv != zero ? fv : fnv), g);
+    return lddIntervalWidenRecur (ldd, (fv != zero ? fv : fnv), g, th);
   
 
   gv = Cudd_NotCond (cuddT (G), g != G);
@@ -706,25 +892,52 @@ lddIntervalWidenRecur (LddManager *ldd,
     {
       assert (fv == zero);
       /* recursive call */
-      rest = lddIntervalWidenRecur (ldd, fnv, gnv);
+      rest = lddIntervalWidenRecur (ldd, fnv, gnv, th);
     }
   /* g is an upper bound, but f is a lower bound */
   else if (fv == zero)
-    return lddIntervalWidenRecur (ldd, fnv, g);
+    return lddIntervalWidenRecur (ldd, fnv, g, th);
   else
     {
       /* both f and g are upper bounds */
       assert (gnv == zero);
       assert (fnv == zero);
-      rest = lddIntervalWidenRecur (ldd, fv, gv);
+      rest = lddIntervalWidenRecur (ldd, fv, gv, th);
     }
 
-  if (F->index != G->index) return rest;
+  if (F->index != G->index && th == NULL) return rest;
 
   if (rest == NULL) return NULL;
   cuddRef (rest);
 
-  gVar = Cudd_bddIthVar (CUDD, G->index);
+  if (F->index != G->index)
+    {
+      lincons_t fBound, gBound, wCons;
+
+      /* the landmark of the weaker of the two bounds */
+      fBound = fv == zero ? THEORY->negate_cons (fCons) : 
+	THEORY->dup_lincons (fCons);
+      gBound = gv == zero ? THEORY->negate_cons (gCons) : 
+	THEORY->dup_lincons (gCons);
+      wCons = lddThresholdCons (ldd, th, 
+				THEORY->is_stronger_cons (gBound, fBound) ?
+				fBound : gBound);
+      THEORY->destroy_lincons (fBound);
+      THEORY->destroy_lincons (gBound);
+      if (wCons == NULL)
+	{
+	  cuddDeref (rest);
+	  return rest;
+	}
+
+      gVar = THEORY->to_ldd (ldd, wCons);
+      THEORY->destroy_lincons (wCons);
+    }
+  else
+    {
+      gVar = Cudd_bddIthVar (CUDD, G->index);
+      if (gVar != NULL) gVar = Cudd_NotCond (gVar, gv == zero);
+    }
   if (gVar == NULL)
     {
       Cudd_IterDerefBdd (CUDD, rest);
@@ -732,7 +945,6 @@ lddIntervalWidenRecur (LddManager *ldd,
     }
   cuddRef (gVar);
   
-  gVar = Cudd_NotCond (gVar, gv == zero);
   res = lddAndRecur (ldd, gVar, rest);
   cuddRef (res);
   
@@ -754,7 +966,8 @@ LddNode *
 lddBoxWiden2Recur (LddManager *ldd,
 		   LddNode *f,
 		   LddNode *g,
-		   lincons_t lastC)
+		   lincons_t lastC,
+		   lddThresholds *th)
 {
   DdManager * manager;
   DdNode *F, *fv, *fnv, *G, *gv, *gnv;
@@ -765,6 +978,7 @@ lddBoxWiden2Recur (LddManager *ldd,
   int sameT = 0;
   
   lincons_t vCons;
+  DdNode *key [3];
 
   /* new top level constraint if needed */
   DdNode* newV = NULL;
@@ -828,9 +1042,15 @@ lddBoxWiden2Recur (LddManager *ldd,
 				THEORY->get_term (lastC)));
 
   /* Check cache. */
+  key [0] = f;
+  key [1] = g;
+  key [2] = Cudd_NotCond (one, !sameT);
   if (F->ref != 1 || G->ref != 1) {
     /** Conceptually, they key is (Ldd_BoxWiden2, sameT, f, g) */
-    r = cuddCacheLookup2(manager, (DD_CTFP)hashKey2(Ldd_BoxWiden2,sameT), f, g);
+    if (th != NULL)
+      r = cuddLocalCacheLookup (th->cache, key);
+    else
+      r = cuddCacheLookup2(manager, (DD_CTFP)hashKey2(Ldd_BoxWiden2,sameT), f, g);
     if (r != NULL) return(r);
   }
   else
@@ -870,13 +1090,27 @@ lddBoxWiden2Recur (LddManager *ldd,
     }
   
   
-  e = lddBoxWiden2Recur (ldd, fnv, gnv, vCons);
+  e = lddBoxWiden2Recur (ldd, fnv, gnv, vCons, th);
   if (e == NULL) return NULL;
   cuddRef (e);
 
   if (index != F->index && fv == gv && !sameT)
-    /* reference to e is migrated into r */
-    r = e;
+    {
+      if (th != NULL && fv == zero)
+	{
+	  /* the lower bound !vCons of g is dropped, unless it has a
+	     landmark */
+	  lincons_t nCons = THEORY->negate_cons (vCons);
+	  r = lddThresholdAnd (ldd, th, nCons, e);
+	  THEORY->destroy_lincons (nCons);
+	  if (r != NULL) cuddRef (r);
+	  Cudd_IterDerefBdd (CUDD, e);
+	  if (r == NULL) return NULL;
+	}
+      else
+	/* reference to e is migrated into r */
+	r = e;
+    }
   else 
     {
       if (index != F->index && fv == gv && sameT)
@@ -886,7 +1120,7 @@ lddBoxWiden2Recur (LddManager *ldd,
 
 	  /* Widen THEN part. lastC=NULL since THEN has a different
 	     term than current top term */
-	  t = lddBoxWiden2Recur (ldd, fv, gv, NULL);
+	  t = lddBoxWiden2Recur (ldd, fv, gv, NULL, th);
 	  if (t == NULL)
 	    {
 	      Cudd_IterDerefBdd (manager, e);
@@ -932,7 +1166,7 @@ lddBoxWiden2Recur (LddManager *ldd,
 	  DdNode *E = Cudd_Regular (e);
 	  lincons_t eCons = NULL;
 
-	  t = lddBoxWiden2Recur (ldd, fv, gv, NULL);
+	  t = lddBoxWiden2Recur (ldd, fv, gv, NULL, th);
 	  if (t == NULL)
 	    {
 	      Cudd_IterDerefBdd (manager, e);
@@ -1013,7 +1247,7 @@ lddBoxWiden2Recur (LddManager *ldd,
 	      if (eCons != NULL && THEORY->is_stronger_cons (vCons, eCons))
 		{
 		  DdNode* ee;
-		  ee = expandToInfinity (ldd, e, vCons);
+		  ee = expandToInfinity (ldd, e, vCons, th);
 		  if (ee != NULL) cuddRef (ee);
 		  Cudd_IterDerefBdd (CUDD, e);
 		  if (ee == NULL)
@@ -1072,7 +1306,12 @@ lddBoxWiden2Recur (LddManager *ldd,
 
   
   if (F->ref != 1 || G->ref != 1)
-    cuddCacheInsert2(manager, (DD_CTFP)hashKey2(Ldd_BoxWiden2,sameT), f, g, r);
+    {
+      if (th != NULL)
+	cuddLocalCacheInsert (th->cache, key, r);
+      else
+	cuddCacheInsert2(manager, (DD_CTFP)hashKey2(Ldd_BoxWiden2,sameT), f, g, r);
+    }
   
   cuddDeref (r);
   return r;
@@ -1868,8 +2107,13 @@ lddTermConstrainRecur (LddManager *ldd, LddNode *f, linterm_t t1,
 }
 
 
+/**
+   \brief Removes from f the weakest bound with the same term as c
+   that is weaker than c, or replaces it by its landmark in th.
+ */
 static LddNode *
-expandToInfinity (LddManager *ldd, LddNode *f, lincons_t c)
+expandToInfinity (LddManager *ldd, LddNode *f, lincons_t c,
+		  lddThresholds *th)
 {
   DdNode *F, *one, *fv, *fnv, *Fnv;
   
@@ -1889,15 +2133,19 @@ expandToInfinity (LddManager *ldd, LddNode *f, lincons_t c)
   if (fnv == one) return f;
 
   /* same as fnv == zero */
-  if (Fnv == one) return fv;
+  if (Fnv == one) return lddThresholdAnd (ldd, th, lddC (ldd, F->index), fv);
   
   fnvCons = lddC (ldd, Fnv->index);
   if (fnvCons == NULL || ! THEORY->is_stronger_cons (c, fnvCons)) return f;
   
   t = fv;
-  e = expandToInfinity (ldd, fnv, c);
+  e = expandToInfinity (ldd, fnv, c, th);
+  if (e == NULL) return NULL;
   
-  assert (t != e);
+  /* a landmark may coincide with the bound it replaces */
+  if (e == fnv) return f;
+  if (e == t) return t;
+  cuddRef (e);
   
   if (Cudd_IsComplement (t))
     {
@@ -1906,6 +2154,9 @@ expandToInfinity (LddManager *ldd, LddNode *f, lincons_t c)
     }
   else
     r = lddUniqueInter (ldd, (int) F->index, t, e);
+  if (r != NULL) cuddRef (r);
+  Cudd_IterDerefBdd (CUDD, e);
+  if (r != NULL) cuddDeref (r);
   return r;  
 }
 
@@ -1958,7 +2209,7 @@ Ldd_TermLeq (LddManager *ldd,
     /* Here neither f nor g is constant. */
 
     /* Check cache. */
-    tmp = cuddCacheLookup2(CUDD,(DD_CTFP)Ldd_TermLeq,f,g);
+    tmp = cuddCacheLookup2(CUDD,lddTermLeqTag,f,g);
     if (tmp != NULL) {
 	return(tmp == one);
     }
@@ -2015,7 +2266,7 @@ Ldd_TermLeq (LddManager *ldd,
     res = Ldd_TermLeq (ldd,fnv,gnv) && Ldd_TermLeq(ldd,fv,gv);
 
     /* Store result in cache and return. */
-    cuddCacheInsert2(CUDD,(DD_CTFP)Ldd_TermLeq,f,g,(res ? one : zero));
+    cuddCacheInsert2(CUDD,lddTermLeqTag,f,g,(res ? one : zero));
     return(res);
     
 }
@@ -1,178 +1,632 @@
+/**
+   Assignments on Boxes LDDs.
+
+   The post-image of an assignment x := e on an LDD in which x and the
+   terms of e are only constrained by bounds is computed in a single
+   cached traversal, instead of a quantifier elimination over a copy
+   of x followed by a conjunction and a renaming.
+
+   x := x + c and x := -x move every bound of x independently, so the
+   constraints on x are rewritten in place. For x := y, the constraints
+   on x are dropped, and every constraint on y is copied to x on both
+   branches. For x := x + y, the constraints on x are dropped, the
+   bounds of x and y that hold on the path are collected on the way
+   down, and the new bounds of x are their sums at the leaves, with
+   the bounds of x counted twice for x := x + x. That
+   result is cached on the node and the bounds collected so far, so a
+   sub-diagram is visited once for every distinct pair of intervals
+   that reaches it.
+
+   Every path of the LDD is a box, and its image is the box hull of the
+   post-image of the path. For havoc x, x := c, x := x + c and x := -x,
+   this is exact. For x := y and x := x + y, the relation between x and
+   y is lost, as in any box domain.
+ */
 #include "util.h"
 #include "lddInt.h"
 
+/* the indices of the collected bounds */
+#define XLO 0
+#define XHI 1
+#define YLO 2
+#define YHI 3
+#define NBOUNDS 4
+
+/* how the constraints on x and y are transformed */
+typedef enum
+{
+  /* the constraints on x are mapped */
+  LDD_BOXES_REWRITE,
+  /* the constraints on x are dropped, the ones on y are mapped and
+     added */
+  LDD_BOXES_COPY,
+  /* the constraints on x are dropped, and x is bounded by the sum of
+     the bounds of x and y at the leaves */
+  LDD_BOXES_SUM
+} lddBoxesMode;
+
+/**
+   An assignment x := a*x + b*y + c, with a, b in {-1, 0, 1}, in the
+   form in which it is applied to the constraints on x and y.
+ */
+typedef struct lddBoxesAssign
+{
+  lddBoxesMode mode;
+
+  /* the assigned term, and its negation */
+  linterm_t x;
+  linterm_t nx;
+  /* the term read by the assignment, and its negation, or NULL */
+  linterm_t y;
+  linterm_t ny;
+
+  /* a constraint t <= k on the mapped term, or -t <= k, becomes
+     x <= k + off[0], or -x <= k + off[1], respectively. If neg is set,
+     -x and x are swapped. off[i] may be NULL. */
+  int neg;
+  constant_t off [2];
+
+  /* LDD_VAR_BIT of the variables of x and y */
+  uint64_t mask;
+
+  DdLocalCache *cache;
+} lddBoxesAssign;
+
+static void lddBoxesAssignInit (lddBoxesAssign *, lddBoxesMode,
+				linterm_t, linterm_t);
+static LddNode *lddBoxesAssignApply (LddManager *, LddNode *,
+				     lddBoxesAssign *);
+static LddNode *lddBoxesAssignRecur (LddManager *, LddNode *,
+				     lddBoxesAssign *, LddNode **);
+
+
 /**
-   Computes post of "x := x + y" on an input Boxes LDD.
+   \brief Computes the post-image of x := x + y on a Boxes LDD.
+
+   x and y must be terms of a single variable with coefficient 1, and
+   f must only constrain them with bounds. The bounds of x on every
+   path of f are replaced by the sum of the bounds of x and y on that
+   path. If x and y are the same term, this is x := 2x.
+
+   \return a pointer to the result if successful; NULL otherwise
 
-   ldd -- the manager
-   f   -- input Boxes LDD
-   x   -- term being assigned
-   y   -- term being added
+   \sa Ldd_BoxesXpc(), Ldd_BoxesXy(), Ldd_TermReplace()
  */
 LddNode *
 Ldd_BoxesXpy (LddManager *ldd, LddNode *f, linterm_t x, linterm_t y)
 {
+  lddBoxesAssign a;
+
+  /* x := x + x reads the bounds of x twice */
+  lddBoxesAssignInit (&a, LDD_BOXES_SUM, x,
+		      THEORY->term_equals (x, y) ? NULL : y);
+  return lddBoxesAssignApply (ldd, f, &a);
+}
+
+/**
+   \brief Computes the post-image of x := x + c on a Boxes LDD.
+
+   \return a pointer to the result if successful; NULL otherwise
+
+   \sa Ldd_BoxesXpy(), Ldd_SubstTermPlusForVar()
+ */
+LddNode *
+Ldd_BoxesXpc (LddManager *ldd, LddNode *f, linterm_t x, constant_t c)
+{
+  lddBoxesAssign a;
   LddNode *res;
-  DdLocalCache *cache;
-  
+
+  if (THEORY->sgn_cst (c) == 0) return f;
+
+  lddBoxesAssignInit (&a, LDD_BOXES_REWRITE, x, NULL);
+  /* x <= k becomes x <= k + c, and -x <= k becomes -x <= k - c */
+  a.off [0] = THEORY->dup_cst (c);
+  a.off [1] = THEORY->negate_cst (c);
+  res = lddBoxesAssignApply (ldd, f, &a);
+  THEORY->destroy_cst (a.off [0]);
+  THEORY->destroy_cst (a.off [1]);
+  return res;
+}
+
+/**
+   \brief Computes the post-image of x := -x on a Boxes LDD.
+
+   \return a pointer to the result if successful; NULL otherwise
+ */
+LddNode *
+Ldd_BoxesXneg (LddManager *ldd, LddNode *f, linterm_t x)
+{
+  lddBoxesAssign a;
+
+  lddBoxesAssignInit (&a, LDD_BOXES_REWRITE, x, NULL);
+  a.neg = 1;
+  return lddBoxesAssignApply (ldd, f, &a);
+}
+
+/**
+   \brief Computes the post-image of x := y on a Boxes LDD.
+
+   The bounds of x on every path of f are replaced by the bounds of y
+   on that path.
+
+   \return a pointer to the result if successful; NULL otherwise
+
+   \sa Ldd_BoxesXpy(), Ldd_TermCopy()
+ */
+LddNode *
+Ldd_BoxesXy (LddManager *ldd, LddNode *f, linterm_t x, linterm_t y)
+{
+  lddBoxesAssign a;
+
+  if (THEORY->term_equals (x, y)) return f;
+
+  lddBoxesAssignInit (&a, LDD_BOXES_COPY, x, y);
+  return lddBoxesAssignApply (ldd, f, &a);
+}
+
+/**
+   \brief Computes the post-image of havoc x on a Boxes LDD, i.e., the
+   existential quantification of x.
+
+   \return a pointer to the result if successful; NULL otherwise
+
+   \sa Ldd_ExistsAbstractBox()
+ */
+LddNode *
+Ldd_BoxesHavoc (LddManager *ldd, LddNode *f, linterm_t x)
+{
+  return Ldd_ExistsAbstractBox (ldd, f, THEORY->term_get_var (x, 0));
+}
+
+/**
+   \brief Computes the post-image of x := c on a Boxes LDD.
+
+   \return a pointer to the result if successful; NULL otherwise
+
+   \sa Ldd_BoxesHavoc()
+ */
+LddNode *
+Ldd_BoxesXc (LddManager *ldd, LddNode *f, linterm_t x, constant_t c)
+{
+  LddNode *res, *hi, *lo, *tmp;
+  lincons_t l;
+
+  res = Ldd_BoxesHavoc (ldd, f, x);
+  if (res == NULL) return NULL;
+  cuddRef (res);
+
+  /* x <= c && -x <= -c */
+  l = THEORY->create_cons (THEORY->dup_term (x), 0, THEORY->dup_cst (c));
+  hi = THEORY->to_ldd (ldd, l);
+  THEORY->destroy_lincons (l);
+  if (hi == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, res);
+      return NULL;
+    }
+  cuddRef (hi);
+
+  l = THEORY->create_cons (THEORY->negate_term (x), 0,
+			   THEORY->negate_cst (c));
+  lo = THEORY->to_ldd (ldd, l);
+  THEORY->destroy_lincons (l);
+  if (lo == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, res);
+      Cudd_IterDerefBdd (CUDD, hi);
+      return NULL;
+    }
+  cuddRef (lo);
+
+  tmp = Ldd_And (ldd, hi, lo);
+  if (tmp != NULL) cuddRef (tmp);
+  Cudd_IterDerefBdd (CUDD, hi);
+  Cudd_IterDerefBdd (CUDD, lo);
+  if (tmp == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, res);
+      return NULL;
+    }
+
+  hi = Ldd_And (ldd, res, tmp);
+  if (hi != NULL) cuddRef (hi);
+  Cudd_IterDerefBdd (CUDD, res);
+  Cudd_IterDerefBdd (CUDD, tmp);
+  if (hi == NULL) return NULL;
+
+  cuddDeref (hi);
+  return hi;
+}
+
+
+/**
+   \brief Initializes a to an assignment to x that reads y, which may
+   be NULL.
+ */
+static void
+lddBoxesAssignInit (lddBoxesAssign *a, lddBoxesMode mode, linterm_t x,
+		    linterm_t y)
+{
+  a->mode = mode;
+  a->x = x;
+  a->nx = NULL;
+  a->y = y;
+  a->ny = NULL;
+  a->neg = 0;
+  a->off [0] = a->off [1] = NULL;
+  a->mask = 0;
+  a->cache = NULL;
+}
+
+/**
+   \brief Applies the assignment a to f, retrying after reordering.
+ */
+static LddNode *
+lddBoxesAssignApply (LddManager *ldd, LddNode *f, lddBoxesAssign *a)
+{
+  LddNode *res;
+  LddNode *bounds [NBOUNDS];
+  int i;
+
+  a->nx = THEORY->negate_term (a->x);
+  a->mask = LDD_VAR_BIT (THEORY->term_get_var (a->x, 0));
+  if (a->y != NULL)
+    {
+      a->ny = THEORY->negate_term (a->y);
+      a->mask |= LDD_VAR_BIT (THEORY->term_get_var (a->y, 0));
+    }
+
   do
     {
       CUDD->reordered = 0;
-      cache = cuddLocalCacheInit (CUDD, 1, 2, CUDD->maxCacheHard);
-      if (cache == NULL) return NULL;
-      
-      int xlevel = THEORY->term_level (x);
-      int ylelel = THEORY->term_level (y);
-      
-      assert (xlevel != ylevel);
-      if (x < y) 
-	res = lddBoxesXpy1 (ldd, f, x, y, NULL, cache);
-      else 
-	res = lddBoxesXpy2 (ldd, f, x, y, NULL, cache);
+      a->cache = cuddLocalCacheInit (CUDD, 1 + NBOUNDS, 2,
+				     CUDD->maxCacheHard);
+      if (a->cache == NULL)
+	{
+	  res = NULL;
+	  break;
+	}
+
+      for (i = 0; i < NBOUNDS; i++)
+	bounds [i] = DD_ONE (CUDD);
+      res = lddBoxesAssignRecur (ldd, f, a, bounds);
       if (res != NULL)
 	cuddRef (res);
-      cuddLocalCacheQuit (cache);
+      cuddLocalCacheQuit (a->cache);
     }
   while (CUDD->reordered == 1);
 
+  THEORY->destroy_term (a->nx);
+  if (a->ny != NULL) THEORY->destroy_term (a->ny);
+
   if (res != NULL) cuddDeref (res);
-  return (res);
+  return res;
 }
 
+/**
+   \brief Returns the constraint that holds when the literal lit is
+   true. The caller must destroy it.
+ */
+static lincons_t
+lddLitCons (LddManager *ldd, LddNode *lit)
+{
+  lincons_t l;
+
+  l = lddC (ldd, Cudd_Regular (lit)->index);
+  return Cudd_IsComplement (lit) ?
+    THEORY->negate_cons (l) : THEORY->dup_lincons (l);
+}
 
 /**
-   Recursive step of Ldd_BoxesXpy when level(x) < level(y)
+   \brief Returns the LDD of the constraint l on t or -t mapped by a.
  */
-LddNode* 
-lddBoxesXpy1 (LddManager *ldd, LddNode *f, linterm_t x, 
-	      linterm_t y, constant_t xlbound, DdLocalCache *cache)
+static LddNode *
+lddBoxesMap (LddManager *ldd, lddBoxesAssign *a, lincons_t l, linterm_t t)
 {
-  DdNode *F, *t, *e, *r, *tmp;
+  constant_t k, off;
+  lincons_t nl;
+  LddNode *res;
+  int pos;
+
+  pos = THEORY->term_equals (THEORY->get_term (l), t);
+  off = a->off [pos ? 0 : 1];
+  k = off == NULL ? THEORY->dup_cst (THEORY->get_constant (l)) :
+    THEORY->add_cst (THEORY->get_constant (l), off);
+
+  nl = THEORY->create_cons (THEORY->dup_term (pos != a->neg ? a->x : a->nx),
+			    THEORY->is_strict (l), k);
+  res = THEORY->to_ldd (ldd, nl);
+  THEORY->destroy_lincons (nl);
+  return res;
+}
+
+/**
+   \brief Adds the literal lit, whose constraint is on t or on -t, to
+   the bounds lo and hi, keeping the stronger one.
+ */
+static void
+lddBoxesBound (LddManager *ldd, LddNode *lit, linterm_t t,
+	       LddNode **lo, LddNode **hi)
+{
+  lincons_t l, old;
+  LddNode **b;
+  unsigned int i, j;
+  int pos;
+
+  i = Cudd_Regular (lit)->index;
+  /* t <= k is an upper bound, -t <= k a lower bound, and !(t <= k)
+     is -t < -k */
+  pos = THEORY->term_equals (THEORY->get_term (lddC (ldd, i)), t);
+  if (Cudd_IsComplement (lit)) pos = !pos;
+  b = pos ? hi : lo;
+
+  if (*b == DD_ONE (CUDD))
+    {
+      *b = lit;
+      return;
+    }
+
+  /* both on t, or both on -t: !c implies !d iff d implies c */
+  j = Cudd_Regular (*b)->index;
+  if (Cudd_IsComplement (lit) == Cudd_IsComplement (*b))
+    {
+      if (Cudd_IsComplement (lit) ?
+	  lddIsStronger (ldd, j, i) : lddIsStronger (ldd, i, j))
+	*b = lit;
+      return;
+    }
+
+  /* one on t and one on -t */
+  l = lddLitCons (ldd, lit);
+  old = lddLitCons (ldd, *b);
+  if (THEORY->is_stronger_cons (l, old))
+    *b = lit;
+  THEORY->destroy_lincons (old);
+  THEORY->destroy_lincons (l);
+}
+
+/**
+   \brief Returns true if the bounds lo and hi of a term leave no
+   value for it.
+ */
+static int
+lddBoxesIsEmpty (LddManager *ldd, LddNode *lo, LddNode *hi)
+{
+  lincons_t l, h;
+  constant_t sum;
+  int sgn, empty;
+
+  if (lo == DD_ONE (CUDD) || hi == DD_ONE (CUDD)) return 0;
+
+  /* -t <= a and t <= b are unsatisfiable iff a + b < 0, or a + b = 0
+     and one of them is strict */
+  l = lddLitCons (ldd, lo);
+  h = lddLitCons (ldd, hi);
+  sum = THEORY->add_cst (THEORY->get_constant (l), THEORY->get_constant (h));
+  sgn = THEORY->sgn_cst (sum);
+  empty = sgn < 0 ||
+    (sgn == 0 && (THEORY->is_strict (l) || THEORY->is_strict (h)));
+  THEORY->destroy_cst (sum);
+  THEORY->destroy_lincons (l);
+  THEORY->destroy_lincons (h);
+  return empty;
+}
+
+/**
+   \brief Returns the LDD of t <= a + b, where a and b are the
+   constants of the literals ta <= a and tb <= b; DD_ONE if one of
+   them is DD_ONE; NULL if out of memory.
+ */
+static LddNode *
+lddBoxesSum (LddManager *ldd, linterm_t t, LddNode *ta, LddNode *tb)
+{
+  lincons_t a, b, l;
+  LddNode *res;
+
+  if (ta == DD_ONE (CUDD) || tb == DD_ONE (CUDD)) return DD_ONE (CUDD);
+
+  a = lddLitCons (ldd, ta);
+  b = lddLitCons (ldd, tb);
+  l = THEORY->create_cons (THEORY->dup_term (t),
+			   THEORY->is_strict (a) || THEORY->is_strict (b),
+			   THEORY->add_cst (THEORY->get_constant (a),
+					    THEORY->get_constant (b)));
+  THEORY->destroy_lincons (a);
+  THEORY->destroy_lincons (b);
+
+  res = THEORY->to_ldd (ldd, l);
+  THEORY->destroy_lincons (l);
+  return res;
+}
+
+/**
+   \brief The result of x := x + y at a leaf, given the collected
+   bounds.
+ */
+static LddNode *
+lddBoxesSumLeaf (LddManager *ldd, lddBoxesAssign *a, LddNode **bounds)
+{
+  LddNode *hi, *lo, *res;
+  int ylo, yhi;
+
+  /* y is x in x := x + x */
+  ylo = a->y != NULL ? YLO : XLO;
+  yhi = a->y != NULL ? YHI : XHI;
+
+  if (lddBoxesIsEmpty (ldd, bounds [XLO], bounds [XHI]) ||
+      lddBoxesIsEmpty (ldd, bounds [ylo], bounds [yhi]))
+    return Cudd_Not (DD_ONE (CUDD));
+
+  hi = lddBoxesSum (ldd, a->x, bounds [XHI], bounds [yhi]);
+  if (hi == NULL) return NULL;
+  cuddRef (hi);
+
+  lo = lddBoxesSum (ldd, a->nx, bounds [XLO], bounds [ylo]);
+  if (lo == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, hi);
+      return NULL;
+    }
+  cuddRef (lo);
+
+  res = lddAndRecur (ldd, hi, lo);
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, hi);
+  Cudd_IterDerefBdd (CUDD, lo);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Returns lit && f, and releases f.
+ */
+static LddNode *
+lddBoxesAndLit (LddManager *ldd, LddNode *lit, LddNode *f)
+{
+  LddNode *res;
+
+  res = lddAndRecur (ldd, lit, f);
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, f);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+static LddNode *
+lddBoxesAssignRecur (LddManager *ldd, LddNode *f, lddBoxesAssign *a,
+		     LddNode **bounds)
+{
+  LddNode *F, *fv, *fnv, *t, *e, *root, *lit, *res;
+  LddNode *key [1 + NBOUNDS];
+  LddNode *tb [NBOUNDS], *eb [NBOUNDS];
   lincons_t fCons;
   linterm_t fTerm;
-  constant_t fCst;
-  unsigned int topf;
+  int i, isx, isy, cached;
 
-  unsigned int xlevel;
-  
   F = Cudd_Regular (f);
+  if (F == DD_ONE (CUDD) && a->mode != LDD_BOXES_SUM) return f;
+  if (f == Cudd_Not (DD_ONE (CUDD))) return f;
+
+  /* when bounds are collected, a node with one parent may be reached
+     with the same bounds from different bounds of the parent */
+  cached = F->ref != 1 || a->mode == LDD_BOXES_SUM;
 
-  /* f is a constant */
-  if (F == DD_ONE (CUDD)) return f;
+  key [0] = f;
+  for (i = 0; i < NBOUNDS; i++)
+    key [1 + i] = bounds [i];
+  if (cached && (res = cuddLocalCacheLookup (a->cache, key)) != NULL)
+    return res;
 
-  if (F->ref != 1 && (r = cuddLocalCacheLookup (cache, &f)) != NULL)
-    return r;
-  
-  xlevel = THEORY->term_level (ldd, x);
-  fCons = ldd->ddVars [F->index];
-  fTerm = THEORY->get_term (fCons);
-  topf = CUDD->perm [F->index];
-  
-  if (topf > xlevel)
+  if (F == DD_ONE (CUDD))
     {
-      if (xlbound == NULL)  return f;
-      else return lddTermReplace (ldd, f, x, y, cst1, xlbound, NULL);
+      res = lddBoxesSumLeaf (ldd, a, bounds);
+      if (res != NULL)
+	cuddLocalCacheInsert (a->cache, key, res);
+      return res;
     }
-  
-  t = Cudd_NotCond (cuddT(F), f != F);
-  cuddRef (t);
 
-  e = Cudd_NotCond (cuddE(F), f != F);
-  cuddRef (e);
+  fv = Cudd_NotCond (cuddT (F), F != f);
+  fnv = Cudd_NotCond (cuddE (F), F != f);
 
-  if (!THEORY->term_equals (x, fTerm))
-    { 
-      /* recurse on 'then' branch */
-      tmp = lddBoxesXpy1 (ldd, t, x, y, xlbound, cache);
-      if (tmp == NULL) 
-	{
-	  Cudd_IterDerefBdd (CUDD, t);
-	  Cudd_IterDerefBdd (CUDD, e);
-	  return NULL;
-	}
-      cuddRef (tmp);
-      Cudd_IterDerefBdd (CUDD, t);
-      t = tmp;
-      
-      /* recurse on 'else' branch */
-      tmp = lddBoxesXpy1 (ldd, e, x, y, xlbound, cache);
-      if (tmp == NULL)
-	{
-	  Cudd_IterDerefBdd (CUDD, t);
-	  Cudd_IterDerefBdd (CUDD, e);
-	  return NULL;
-	}
-      cuddRef (tmp);
-      Cudd_IterDerefBdd (CUDD, e);
-      e = tmp;
-      
-      /* build ITE for the result */
-      DdNode *root = Cudd_bddIthVar (CUDD, F->index);
-      cuddRef (root);
-      /* XXX can use Ldd_Unique_Inter instead */
-      r = lddIteRecur (ldd, root, t, e);
-      if (r != NULL) 
-	{
-	  cuddRef (r);
-	  if (xlbound == NULL && F->ref != 1)
-	    cuddLocalCacheLookup (cache, &f, r);
-	}
-      Cudd_IterDerefBdd (CUDD, root);
-      Cudd_IterDerefBdd (CUDD, t);
-      Cudd_IterDerefBdd (CUDD, e);
-      if (r != NULL) cuddDeref (r);
-      return r;
+  fCons = lddC (ldd, F->index);
+  isx = isy = 0;
+  if ((ldd->ddVarMask [F->index] & a->mask) != 0)
+    {
+      fTerm = THEORY->get_term (fCons);
+      isx = THEORY->term_equals (fTerm, a->x) ||
+	THEORY->term_equals (fTerm, a->nx);
+      isy = !isx && a->y != NULL &&
+	(THEORY->term_equals (fTerm, a->y) ||
+	 THEORY->term_equals (fTerm, a->ny));
     }
 
-  /* ELSE (THEORY->term_equals (x, fTerm) */
+  for (i = 0; i < NBOUNDS; i++)
+    tb [i] = eb [i] = bounds [i];
 
-  tmp = lddTermReplace (ldd, t, x, y, cst1, xlbound, xubound);
-  if (tmp == NULL)
+  root = CUDD->vars [F->index];
+  if (a->mode == LDD_BOXES_SUM && isx)
     {
-      Cudd_IterDerefBdd (CUDD, t);
-      Cudd_IterDerefBdd (CUDD, e);
-      return NULL;
+      lddBoxesBound (ldd, root, a->x, &tb [XLO], &tb [XHI]);
+      lddBoxesBound (ldd, Cudd_Not (root), a->x, &eb [XLO], &eb [XHI]);
+    }
+  else if (a->mode == LDD_BOXES_SUM && isy)
+    {
+      lddBoxesBound (ldd, root, a->y, &tb [YLO], &tb [YHI]);
+      lddBoxesBound (ldd, Cudd_Not (root), a->y, &eb [YLO], &eb [YHI]);
     }
-  cuddRef (tmp);
-  Cudd_IterDerefBdd (CUDD, t);
-  t = tmp;
 
+  t = lddBoxesAssignRecur (ldd, fv, a, tb);
+  if (t == NULL) return NULL;
+  cuddRef (t);
 
-  tmp = lddBoxesXpy1 (ldd, e, x, y, new_xlbound);
-  if (tmp == NULL)
+  /* a dropped constraint with a valid branch is valid */
+  if (isx && a->mode != LDD_BOXES_REWRITE && t == DD_ONE (CUDD))
     {
-      Cudd_IterDerefBdd (CUDD, t);
-      Cudd_IterDerefBdd (CUDD, e);
-      return NULL;
+      if (cached)
+	cuddLocalCacheInsert (a->cache, key, t);
+      cuddDeref (t);
+      return t;
     }
-  cuddRef (tmp);
-  Cudd_IterDerefBdd (CUDD, e);
-  e = tmp;
 
-  r = lddAndRecur (ldd, Cudd_Not (t), Cudd_Not (e));
-  if (r == NULL)
+  e = lddBoxesAssignRecur (ldd, fnv, a, eb);
+  if (e == NULL)
     {
       Cudd_IterDerefBdd (CUDD, t);
-      Cudd_IterDerefBdd (CUDD, e);
       return NULL;
     }
-  cuddRef (r);
-  r = Cudd_Not (r);
+  cuddRef (e);
+
+  lit = NULL;
+  if ((isx && a->mode == LDD_BOXES_REWRITE) ||
+      (isy && a->mode == LDD_BOXES_COPY))
+    {
+      lit = lddBoxesMap (ldd, a, fCons, isx ? a->x : a->y);
+      if (lit == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, t);
+	  Cudd_IterDerefBdd (CUDD, e);
+	  return NULL;
+	}
+      cuddRef (lit);
+    }
+
+  if (isx && a->mode != LDD_BOXES_REWRITE)
+    {
+      /* drop the constraint */
+      res = lddAndRecur (ldd, Cudd_Not (t), Cudd_Not (e));
+      res = Cudd_NotCond (res, res != NULL);
+    }
+  else if (isx)
+    /* replace the constraint by lit */
+    res = lddIteRecur (ldd, lit, t, e);
+  else
+    {
+      if (lit != NULL)
+	{
+	  /* add lit to the THEN branch, and !lit to the ELSE branch */
+	  t = lddBoxesAndLit (ldd, lit, t);
+	  if (t != NULL) cuddRef (t);
+	  e = lddBoxesAndLit (ldd, Cudd_Not (lit), e);
+	  if (e != NULL) cuddRef (e);
+	  if (t == NULL || e == NULL)
+	    {
+	      if (t != NULL) Cudd_IterDerefBdd (CUDD, t);
+	      if (e != NULL) Cudd_IterDerefBdd (CUDD, e);
+	      Cudd_IterDerefBdd (CUDD, lit);
+	      return NULL;
+	    }
+	}
+      res = lddIteRecur (ldd, root, t, e);
+    }
+  if (res != NULL) cuddRef (res);
+
+  if (lit != NULL) Cudd_IterDerefBdd (CUDD, lit);
   Cudd_IterDerefBdd (CUDD, t);
   Cudd_IterDerefBdd (CUDD, e);
-      
-  if (xlbound == NULL && F->ref != 1)
-    cuddLocalCacheInsert (cache, &f, r);
-  cuddDeref (r);
-  return r;
-}
+  if (res == NULL) return NULL;
 
-/**
-   Recursive step of Ldd_BoxesXpy when  level(y) < level (x)
- */
-LddNode*
-lddBoxesXpy2 (LddManager *ldd, LddNode *f, linterm_t x, 
-	      linterm_t y, constant_t ylbound, DdLocalCache *cache)
-{
-  return NULL;
+  if (cached)
+    cuddLocalCacheInsert (a->cache, key, res);
+  cuddDeref (res);
+  return res;
 }
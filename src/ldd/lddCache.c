@@ -0,0 +1,213 @@
+/**
+   Persistent computed table of the LDD manager.
+
+   Quantification operations keep their results in a single local
+   cache of CUDD that lives as long as the manager, so that results
+   are reused across calls. CUDD clears dead entries of the cache on
+   garbage collection, flushes it before reordering, and grows it when
+   the hit rate is high. Since the table outlives a call, results are
+   stored for unshared nodes as well.
+
+   A key has four nodes: the argument, two nodes for additional
+   operands (or the one constant), and a tag node that identifies the
+   operation and the theory variable. Tag nodes are constants of the
+   CUDD manager created on demand and referenced until Ldd_Quit().
+ */
+#include "util.h"
+#include "lddInt.h"
+
+/**
+   \brief Creates the computed table of a manager.
+
+   \return 1 if successful; 0 otherwise
+ */
+int
+lddCacheInit (LddManager *ldd)
+{
+  ldd->cache = cuddLocalCacheInit (CUDD, LDD_CACHE_KEYSIZE, 2,
+				   CUDD->maxCacheHard);
+  ldd->cacheTags = NULL;
+  ldd->cacheTagsSize = 0;
+  ldd->cacheLookUps = 0;
+  ldd->cacheHits = 0;
+  return ldd->cache != NULL;
+}
+
+/**
+   \brief Releases the computed table and the tag nodes of a manager.
+ */
+void
+lddCacheQuit (LddManager *ldd)
+{
+  size_t i;
+
+  if (ldd->cache != NULL)
+    {
+      cuddLocalCacheQuit (ldd->cache);
+      ldd->cache = NULL;
+    }
+
+  for (i = 0; i < ldd->cacheTagsSize; i++)
+    if (ldd->cacheTags [i] != NULL)
+      Cudd_RecursiveDeref (CUDD, ldd->cacheTags [i]);
+  FREE (ldd->cacheTags);
+  ldd->cacheTags = NULL;
+  ldd->cacheTagsSize = 0;
+}
+
+/**
+   \brief Keeps the computed table at least half as large as the
+   unique table, like the computed table of CUDD. The size of the
+   unique table is not known when the manager is created.
+
+   A local cache of CUDD cannot be resized from outside, so it is
+   replaced, and its entries are lost. Its size is rounded down to a
+   power of 2, so it is only replaced when it can at least double.
+ */
+static void
+lddCacheFixSize (LddManager *ldd)
+{
+  DdLocalCache *cache;
+
+  if (2 * ldd->cache->slots > CUDD->slots / 2 ||
+      ldd->cache->slots >= CUDD->maxCacheHard) 
+    return;
+
+  cache = cuddLocalCacheInit (CUDD, LDD_CACHE_KEYSIZE, CUDD->slots / 2,
+			      CUDD->maxCacheHard);
+  /* keep the old table if out of memory */
+  if (cache == NULL) return;
+
+  cuddLocalCacheQuit (ldd->cache);
+  ldd->cache = cache;
+}
+
+/**
+   \brief Returns the tag node of operation op on theory variable var.
+
+   \return the tag node (not referenced) or NULL if out of memory
+ */
+LddNode *
+lddCacheTag (LddManager *ldd, int op, int var)
+{
+  size_t i, size;
+  LddNode *tag;
+
+  assert (op >= 0 && op < LDD_CACHE_NTAGS);
+  assert (var >= 0);
+
+  lddCacheFixSize (ldd);
+
+  i = (size_t)var * LDD_CACHE_NTAGS + op;
+  if (i < ldd->cacheTagsSize && ldd->cacheTags [i] != NULL)
+    return ldd->cacheTags [i];
+
+  if (i >= ldd->cacheTagsSize)
+    {
+      LddNode **tags;
+      size_t j;
+
+      size = ldd->cacheTagsSize == 0 ? 64 : ldd->cacheTagsSize;
+      while (size <= i) size = size << 1;
+
+      tags = REALLOC (LddNode*, ldd->cacheTags, size);
+      if (tags == NULL)
+	{
+	  CUDD->errorCode = CUDD_MEMORY_OUT;
+	  return NULL;
+	}
+      for (j = ldd->cacheTagsSize; j < size; j++)
+	tags [j] = NULL;
+      ldd->cacheTags = tags;
+      ldd->cacheTagsSize = size;
+    }
+
+  tag = cuddUniqueConst (CUDD, (CUDD_VALUE_TYPE) i);
+  if (tag == NULL) return NULL;
+  cuddRef (tag);
+  ldd->cacheTags [i] = tag;
+  return tag;
+}
+
+/**
+   \brief Looks up the result of an operation on (f, a, b) with tag
+   node tag.
+
+   \return the result, or NULL if not found
+ */
+LddNode *
+lddCacheLookup (LddManager *ldd, LddNode *f, LddNode *a, LddNode *b,
+		LddNode *tag)
+{
+  DdNode *key [LDD_CACHE_KEYSIZE];
+  LddNode *res;
+
+  key [0] = f;
+  key [1] = a;
+  key [2] = b;
+  key [3] = tag;
+  res = cuddLocalCacheLookup (ldd->cache, key);
+
+  /* the counters of the cache are reset when it is resized */
+  ldd->cacheLookUps++;
+  if (res != NULL) ldd->cacheHits++;
+  return res;
+}
+
+/**
+   \brief Stores the result of an operation on (f, a, b) with tag
+   node tag.
+ */
+void
+lddCacheInsert (LddManager *ldd, LddNode *f, LddNode *a, LddNode *b,
+		LddNode *tag, LddNode *res)
+{
+  DdNode *key [LDD_CACHE_KEYSIZE];
+
+  key [0] = f;
+  key [1] = a;
+  key [2] = b;
+  key [3] = tag;
+  cuddLocalCacheInsert (ldd->cache, key, res);
+}
+
+
+/**
+   \brief Returns the number of lookups in the computed table of the
+   LDD manager.
+
+   The table is used by Ldd_ExistsAbstractFM(),
+   Ldd_ExistsAbstractSFM(), Ldd_Resolve(), Ldd_ResolveElim() and
+   Ldd_SubstNinfForVar().
+
+   \sa Ldd_ReadCacheHits(), Ldd_ReadCacheSlots()
+ */
+double
+Ldd_ReadCacheLookUps (LddManager *ldd)
+{
+  return ldd->cacheLookUps;
+}
+
+/**
+   \brief Returns the number of hits in the computed table of the LDD
+   manager.
+
+   \sa Ldd_ReadCacheLookUps()
+ */
+double
+Ldd_ReadCacheHits (LddManager *ldd)
+{
+  return ldd->cacheHits;
+}
+
+/**
+   \brief Returns the number of slots of the computed table of the LDD
+   manager.
+
+   \sa Ldd_ReadCacheLookUps()
+ */
+unsigned int
+Ldd_ReadCacheSlots (LddManager *ldd)
+{
+  return ldd->cache->slots;
+}
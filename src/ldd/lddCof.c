@@ -44,7 +44,6 @@ lddCofactorRecur (LddManager *ldd,
   DdNode *one, *zero, *r, *t, *e;
   unsigned int topf, topg, index;
 
-  lincons_t vCons;
   int comple;
   
 
@@ -97,25 +96,18 @@ lddCofactorRecur (LddManager *ldd,
   }
 
 
-  /** 
-   * Get the constraint of the root node 
-   */
-  vCons = lddC (ldd, index);
-
   /** 
    * Compute LDD cofactors w.r.t. the top term.  
    * 
    * We check whether f and g have the same constraint using the
    * following facts: 
-   *   vCons is the constraint of the root diagram
+   *   index is the index of the root diagram
    *   gv == g iff g is not the root diagram
    *   fv == f iff f is not the root diagram
    */
   if (gv == g)
     {
-      lincons_t gCons = lddC (ldd, G->index);
-      
-      if (THEORY->is_stronger_cons (vCons, gCons))
+      if (lddIsStronger (ldd, index, G->index))
 	{
 	  gv = cuddT (G);
 	  if (Cudd_IsComplement (g))
@@ -124,9 +116,7 @@ lddCofactorRecur (LddManager *ldd,
     }
   else if (fv == f)
     {
-      lincons_t fCons = lddC (ldd, F->index);
-      
-      if (THEORY->is_stronger_cons (vCons, fCons))
+      if (lddIsStronger (ldd, index, F->index))
 	fv = cuddT (F);
     }
 
@@ -189,3 +179,335 @@ lddCofactorRecur (LddManager *ldd,
 
 
 	      
+
+/**
+   \brief Computes f constrained by c (the generalized cofactor of f
+   with respect to c).
+
+   The result agrees with f wherever c holds, and may depend on the
+   constraints of c. A node of f is dropped when the path of c
+   implies or refutes its constraint, i.e., when the constraint of c
+   is stronger than it in the same term group.
+
+   \return a pointer to the result if successful; NULL otherwise.
+
+   Based on Cudd_bddConstrain
+
+   \sa Ldd_Restrict(), Ldd_Minimize(), Ldd_Cofactor()
+ */
+LddNode *
+Ldd_Constrain (LddManager *ldd, LddNode *f, LddNode *c)
+{
+  LddNode *res;
+
+  do
+    {
+      CUDD->reordered = 0;
+      res = lddConstrainRecur (ldd, f, c);
+    }
+  while (CUDD->reordered == 1);
+  return res;
+}
+
+/**
+   \brief Computes f restricted to the care set c, like
+   Ldd_Constrain(), except that the constraints of c that f does not
+   depend on are existentially quantified from c. The result only
+   depends on the constraints of f, and is f if it would be larger.
+
+   \return a pointer to the result if successful; NULL otherwise.
+
+   Based on Cudd_bddRestrict
+
+   \sa Ldd_Constrain(), Ldd_Minimize()
+ */
+LddNode *
+Ldd_Restrict (LddManager *ldd, LddNode *f, LddNode *c)
+{
+  LddNode *res;
+
+  do
+    {
+      CUDD->reordered = 0;
+      res = lddRestrictRecur (ldd, f, c);
+    }
+  while (CUDD->reordered == 1);
+
+  if (res == NULL) return NULL;
+  if (Cudd_DagSize (res) > Cudd_DagSize (f))
+    {
+      cuddRef (res);
+      Cudd_IterDerefBdd (CUDD, res);
+      return f;
+    }
+  return res;
+}
+
+/**
+   \brief Finds a small LDD that agrees with f wherever c holds.
+
+   The paths of c that are unsatisfiable in the theory are removed
+   first (see Ldd_SatReduce()), which enlarges the don't care set.
+   The smallest of f, Ldd_Restrict() and Ldd_Constrain() with respect
+   to the reduced care set is returned, so the result is never larger
+   than f.
+
+   \return a pointer to the result if successful; NULL otherwise.
+
+   \sa Ldd_Restrict(), Ldd_Constrain()
+ */
+LddNode *
+Ldd_Minimize (LddManager *ldd, LddNode *f, LddNode *c)
+{
+  LddNode *care, *r, *res;
+  int size, rsize;
+
+  care = Ldd_SatReduce (ldd, c, -1);
+  if (care == NULL) return NULL;
+  cuddRef (care);
+
+  res = f;
+  cuddRef (res);
+  size = Cudd_DagSize (f);
+
+  r = Ldd_Restrict (ldd, f, care);
+  if (r != NULL)
+    {
+      cuddRef (r);
+      rsize = Cudd_DagSize (r);
+      if (rsize < size)
+	{
+	  Cudd_IterDerefBdd (CUDD, res);
+	  res = r;
+	  size = rsize;
+	}
+      else
+	Cudd_IterDerefBdd (CUDD, r);
+
+      r = Ldd_Constrain (ldd, f, care);
+    }
+  if (r == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, care);
+      Cudd_IterDerefBdd (CUDD, res);
+      return NULL;
+    }
+
+  cuddRef (r);
+  if (Cudd_DagSize (r) < size)
+    {
+      Cudd_IterDerefBdd (CUDD, res);
+      res = r;
+    }
+  else
+    Cudd_IterDerefBdd (CUDD, r);
+
+  Cudd_IterDerefBdd (CUDD, care);
+  cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Returns the node (index, t, e), and releases t and e.
+
+   \return the node (not referenced), or NULL
+ */
+static LddNode *
+lddGenCofNode (LddManager *ldd, unsigned int index, LddNode *t, LddNode *e)
+{
+  LddNode *r;
+
+  if (t == e)
+    {
+      cuddDeref (t);
+      cuddDeref (e);
+      return t;
+    }
+
+  if (Cudd_IsComplement (t))
+    {
+      r = lddUniqueInter (ldd, index, Cudd_Not (t), Cudd_Not (e));
+      r = Cudd_NotCond (r, r != NULL);
+    }
+  else
+    r = lddUniqueInter (ldd, index, t, e);
+
+  if (r != NULL) cuddRef (r);
+  Cudd_IterDerefBdd (CUDD, t);
+  Cudd_IterDerefBdd (CUDD, e);
+  if (r != NULL) cuddDeref (r);
+  return r;
+}
+
+/**
+   \brief Cofactors of f and c with respect to the top constraint of
+   the two, including the LDD cofactor when that constraint implies
+   the top constraint of the other operand.
+
+   f is regular and neither f nor c is constant.
+
+   \return the index of the top constraint
+ */
+static unsigned int
+lddGenCofTop (LddManager *ldd, LddNode *f, LddNode *c,
+	      LddNode **fv, LddNode **fnv, LddNode **cv, LddNode **cnv)
+{
+  LddNode *C;
+  unsigned int topf, topc, index;
+
+  C = Cudd_Regular (c);
+  topf = CUDD->perm [f->index];
+  topc = CUDD->perm [C->index];
+
+  if (topf <= topc)
+    {
+      index = f->index;
+      *fv = cuddT (f);
+      *fnv = cuddE (f);
+    }
+  else
+    {
+      index = C->index;
+      *fv = *fnv = f;
+    }
+
+  if (topc <= topf)
+    {
+      *cv = Cudd_NotCond (cuddT (C), c != C);
+      *cnv = Cudd_NotCond (cuddE (C), c != C);
+    }
+  else
+    *cv = *cnv = c;
+
+  if (*cv == c)
+    {
+      if (lddIsStronger (ldd, index, C->index))
+	*cv = Cudd_NotCond (cuddT (C), c != C);
+    }
+  else if (*fv == f)
+    {
+      if (lddIsStronger (ldd, index, f->index))
+	*fv = cuddT (f);
+    }
+  return index;
+}
+
+LddNode *
+lddConstrainRecur (LddManager *ldd, LddNode *f, LddNode *c)
+{
+  LddNode *F, *fv, *fnv, *cv, *cnv;
+  LddNode *one, *zero, *r, *t, *e;
+  unsigned int index;
+  int comple;
+
+  statLine (CUDD);
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+
+  if (c == one) return f;
+  if (c == zero) return zero;
+  F = Cudd_Regular (f);
+  if (cuddIsConstant (F)) return f;
+  if (f == c) return one;
+  if (f == Cudd_Not (c)) return zero;
+
+  /* constrain (!f, c) = !constrain (f, c) */
+  comple = f != F;
+
+  r = cuddCacheLookup2 (CUDD, (DD_CTFP) Ldd_Constrain, F, c);
+  if (r != NULL)
+    return Cudd_NotCond (r, comple);
+
+  index = lddGenCofTop (ldd, F, c, &fv, &fnv, &cv, &cnv);
+
+  /* the care set is on one side only: drop the node */
+  if (cv == zero)
+    r = lddConstrainRecur (ldd, fnv, cnv);
+  else if (cnv == zero)
+    r = lddConstrainRecur (ldd, fv, cv);
+  else
+    {
+      t = lddConstrainRecur (ldd, fv, cv);
+      if (t == NULL) return NULL;
+      cuddRef (t);
+      e = lddConstrainRecur (ldd, fnv, cnv);
+      if (e == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, t);
+	  return NULL;
+	}
+      cuddRef (e);
+      r = lddGenCofNode (ldd, index, t, e);
+    }
+  if (r == NULL) return NULL;
+
+  cuddCacheInsert2 (CUDD, (DD_CTFP) Ldd_Constrain, F, c, r);
+  return Cudd_NotCond (r, comple);
+}
+
+LddNode *
+lddRestrictRecur (LddManager *ldd, LddNode *f, LddNode *c)
+{
+  LddNode *F, *fv, *fnv, *cv, *cnv;
+  LddNode *one, *zero, *r, *t, *e, *d;
+  unsigned int index;
+  int comple;
+
+  statLine (CUDD);
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+
+  if (c == one) return f;
+  if (c == zero) return zero;
+  F = Cudd_Regular (f);
+  if (cuddIsConstant (F)) return f;
+  if (f == c) return one;
+  if (f == Cudd_Not (c)) return zero;
+
+  comple = f != F;
+
+  r = cuddCacheLookup2 (CUDD, (DD_CTFP) Ldd_Restrict, F, c);
+  if (r != NULL)
+    return Cudd_NotCond (r, comple);
+
+  index = lddGenCofTop (ldd, F, c, &fv, &fnv, &cv, &cnv);
+
+  if (cv == zero)
+    r = lddRestrictRecur (ldd, fnv, cnv);
+  else if (cnv == zero)
+    r = lddRestrictRecur (ldd, fv, cv);
+  else if (index != F->index)
+    {
+      /* f does not depend on the top constraint of c: quantify it */
+      d = lddAndRecur (ldd, Cudd_Not (cv), Cudd_Not (cnv));
+      if (d == NULL) return NULL;
+      cuddRef (d);
+      r = lddRestrictRecur (ldd, F, Cudd_Not (d));
+      if (r == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, d);
+	  return NULL;
+	}
+      cuddRef (r);
+      Cudd_IterDerefBdd (CUDD, d);
+      cuddDeref (r);
+    }
+  else
+    {
+      t = lddRestrictRecur (ldd, fv, cv);
+      if (t == NULL) return NULL;
+      cuddRef (t);
+      e = lddRestrictRecur (ldd, fnv, cnv);
+      if (e == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, t);
+	  return NULL;
+	}
+      cuddRef (e);
+      r = lddGenCofNode (ldd, index, t, e);
+    }
+  if (r == NULL) return NULL;
+
+  cuddCacheInsert2 (CUDD, (DD_CTFP) Ldd_Restrict, F, c, r);
+  return Cudd_NotCond (r, comple);
+}
@@ -0,0 +1,433 @@
+/**
+   Bulk construction of an LDD from a disjunction of cubes.
+
+   A cube is a conjunction of constraints. Building a DNF with
+   Ldd_FromCons(), Ldd_And() and Ldd_Or() costs a traversal of the
+   accumulated LDD for every cube. The builder instead collects the
+   cubes, and builds each one directly as a chain of nodes in the
+   variable order, after removing implied constraints. The chains are
+   sorted, so that neighbours share their top constraints, and joined
+   by a balanced tree of disjunctions.
+ */
+#include "util.h"
+#include "lddInt.h"
+
+/**
+   \brief Builder of an LDD from a disjunction of cubes.
+
+   A literal is stored as 2 * index + 1 if it is negated, and
+   2 * index otherwise, where index is the DD variable of its
+   constraint. Levels are only looked at when the LDD is built, since
+   the order may change in between.
+ */
+struct LddCubeBuilder
+{
+  LddManager *ldd;
+
+  /** literals of all cubes, one cube after the other */
+  int *lits;
+  size_t nlits;
+  size_t litsSize;
+
+  /** cube i has literals lits[start[i]] to lits[start[i+1]-1] */
+  size_t *start;
+  size_t ncubes;
+  size_t startSize;
+
+  /** true if a cube has no literals */
+  int hasTrue;
+};
+
+/**
+   \brief A cube as a sorted array of keys 2 * level + negated
+ */
+typedef struct
+{
+  int *keys;
+  size_t n;
+} lddCubeKeys;
+
+
+/**
+   \brief Creates a builder for an LDD of manager ldd.
+
+   \return the builder, or NULL if out of memory
+
+   \sa Ldd_CubeBuilderAddCube(), Ldd_CubeBuilderBuild(),
+   Ldd_CubeBuilderQuit()
+ */
+LddCubeBuilder *
+Ldd_CubeBuilderInit (LddManager *ldd)
+{
+  LddCubeBuilder *b;
+
+  b = ALLOC (LddCubeBuilder, 1);
+  if (b == NULL) return NULL;
+
+  b->ldd = ldd;
+  b->litsSize = 64;
+  b->nlits = 0;
+  b->lits = ALLOC (int, b->litsSize);
+  b->startSize = 16;
+  b->ncubes = 0;
+  b->start = ALLOC (size_t, b->startSize);
+  b->hasTrue = 0;
+
+  if (b->lits == NULL || b->start == NULL)
+    {
+      Ldd_CubeBuilderQuit (b);
+      return NULL;
+    }
+  b->start [0] = 0;
+  return b;
+}
+
+/**
+   \brief Releases a builder. LDDs it has built are not affected.
+ */
+void
+Ldd_CubeBuilderQuit (LddCubeBuilder *b)
+{
+  if (b == NULL) return;
+  FREE (b->lits);
+  FREE (b->start);
+  FREE (b);
+}
+
+/**
+   \brief Adds the cube cons[0] && ... && cons[n-1] to the
+   disjunction. The constraints are not kept and may be destroyed by
+   the caller.
+
+   \return 1 if successful; 0 otherwise
+ */
+int
+Ldd_CubeBuilderAddCube (LddCubeBuilder *b, lincons_t *cons, size_t n)
+{
+  LddManager *ldd;
+  LddNode *lit, *one;
+  size_t i, nlits;
+
+  ldd = b->ldd;
+  one = DD_ONE (CUDD);
+
+  if (b->ncubes + 2 > b->startSize)
+    {
+      size_t *start = REALLOC (size_t, b->start, 2 * b->startSize);
+      if (start == NULL) return 0;
+      b->start = start;
+      b->startSize *= 2;
+    }
+  if (b->nlits + n > b->litsSize)
+    {
+      size_t size = 2 * b->litsSize;
+      int *lits;
+
+      while (size < b->nlits + n) size *= 2;
+      lits = REALLOC (int, b->lits, size);
+      if (lits == NULL) return 0;
+      b->lits = lits;
+      b->litsSize = size;
+    }
+
+  nlits = b->nlits;
+  for (i = 0; i < n; i++)
+    {
+      lit = THEORY->to_ldd (ldd, cons [i]);
+      if (lit == NULL)
+	return 0;
+      /* a valid constraint drops out, and an unsatisfiable one drops
+	 the cube */
+      if (lit == one) continue;
+      if (lit == Cudd_Not (one)) return 1;
+
+      assert (Cudd_T (lit) == one && Cudd_E (lit) == Cudd_Not (one));
+      b->lits [nlits++] = 2 * Cudd_Regular (lit)->index +
+	Cudd_IsComplement (lit);
+    }
+
+  if (nlits == b->nlits) b->hasTrue = 1;
+  b->nlits = nlits;
+  b->start [++b->ncubes] = nlits;
+  return 1;
+}
+
+/**
+   \brief Returns the number of cubes added to a builder.
+ */
+size_t
+Ldd_CubeBuilderSize (LddCubeBuilder *b)
+{
+  return b->ncubes;
+}
+
+static int
+lddIntCmp (const void *a, const void *b)
+{
+  int x = *(const int*)a;
+  int y = *(const int*)b;
+  return x < y ? -1 : x > y;
+}
+
+/* lexicographic order of cubes, shorter cubes first on a common
+   prefix */
+static int
+lddCubeKeysCmp (const void *a, const void *b)
+{
+  const lddCubeKeys *x = (const lddCubeKeys*)a;
+  const lddCubeKeys *y = (const lddCubeKeys*)b;
+  size_t i;
+
+  for (i = 0; i < x->n && i < y->n; i++)
+    if (x->keys [i] != y->keys [i])
+      return x->keys [i] < y->keys [i] ? -1 : 1;
+  return x->n < y->n ? -1 : x->n > y->n;
+}
+
+/**
+   \brief Sorts the keys of a cube and removes the literals implied
+   by others.
+
+   Within a term group, a constraint implies the constraints below
+   it. Of the positive literals of a group, only the top one is kept,
+   and of the negative ones, only the bottom one.
+
+   \return 0 if the cube is unsatisfiable; 1 otherwise
+ */
+static int
+lddCubeCanonical (LddManager *ldd, lddCubeKeys *c)
+{
+  size_t i, j, k;
+  int *keys, a, b;
+
+  keys = c->keys;
+  qsort (keys, c->n, sizeof (int), lddIntCmp);
+
+  for (i = 0; i < c->n; i++)
+    {
+      if (keys [i] < 0) continue;
+      a = CUDD->invperm [keys [i] >> 1];
+
+      for (j = i + 1; j < c->n; j++)
+	{
+	  if (keys [j] < 0) continue;
+	  b = CUDD->invperm [keys [j] >> 1];
+
+	  if (a == b)
+	    {
+	      /* x && !x */
+	      if ((keys [i] & 1) != (keys [j] & 1)) return 0;
+	      keys [j] = -1;
+	    }
+	  else if (lddIsStronger (ldd, a, b))
+	    {
+	      if (keys [i] & 1)
+		{
+		  /* !b implies !a */
+		  if (keys [j] & 1)
+		    {
+		      keys [i] = -1;
+		      break;
+		    }
+		}
+	      else
+		{
+		  /* a implies b, and contradicts !b */
+		  if (keys [j] & 1) return 0;
+		  keys [j] = -1;
+		}
+	    }
+	  else if (lddIsStronger (ldd, b, a))
+	    {
+	      /* only when the manager is like a BDD */
+	      if (keys [j] & 1)
+		{
+		  if (keys [i] & 1) keys [j] = -1;
+		}
+	      else
+		{
+		  if (keys [i] & 1) return 0;
+		  keys [i] = -1;
+		  break;
+		}
+	    }
+	}
+    }
+
+  for (i = 0, k = 0; i < c->n; i++)
+    if (keys [i] >= 0) keys [k++] = keys [i];
+  c->n = k;
+  return 1;
+}
+
+/**
+   \brief Builds the LDD of a canonical cube, bottom up.
+
+   \return the LDD (not referenced), or NULL if out of memory or
+   reordering took place
+ */
+static LddNode *
+lddCubeChain (LddManager *ldd, lddCubeKeys *c)
+{
+  LddNode *one, *res, *tmp;
+  size_t i;
+  int index;
+
+  one = DD_ONE (CUDD);
+  res = one;
+  cuddRef (res);
+
+  for (i = c->n; i > 0; i--)
+    {
+      index = CUDD->invperm [c->keys [i - 1] >> 1];
+      /* the THEN child of a node is regular */
+      if (c->keys [i - 1] & 1)
+	{
+	  tmp = lddUniqueInter (ldd, index, one, Cudd_Not (res));
+	  tmp = Cudd_NotCond (tmp, tmp != NULL);
+	}
+      else if (Cudd_IsComplement (res))
+	{
+	  tmp = lddUniqueInter (ldd, index, Cudd_Not (res), one);
+	  tmp = Cudd_NotCond (tmp, tmp != NULL);
+	}
+      else
+	tmp = lddUniqueInter (ldd, index, res, Cudd_Not (one));
+
+      if (tmp == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, res);
+	  return NULL;
+	}
+      cuddRef (tmp);
+      Cudd_IterDerefBdd (CUDD, res);
+      res = tmp;
+    }
+
+  cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Builds the disjunction of the cubes of a builder.
+
+   \return the LDD (not referenced), or NULL if out of memory or
+   reordering took place
+ */
+static LddNode *
+lddCubeBuilderBuildInter (LddCubeBuilder *b)
+{
+  LddManager *ldd;
+  LddNode **fs, *one, *zero, *res, *tmp;
+  lddCubeKeys *cubes;
+  int *keys;
+  size_t i, j, n, step;
+
+  ldd = b->ldd;
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+
+  if (b->hasTrue) return one;
+  if (b->ncubes == 0) return zero;
+
+  keys = ALLOC (int, b->nlits);
+  cubes = ALLOC (lddCubeKeys, b->ncubes);
+  fs = ALLOC (LddNode*, b->ncubes);
+  if ((keys == NULL && b->nlits > 0) || cubes == NULL || fs == NULL)
+    {
+      FREE (keys);
+      FREE (cubes);
+      FREE (fs);
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+
+  /* canonical cubes over levels */
+  for (i = 0; i < b->nlits; i++)
+    keys [i] = 2 * CUDD->perm [b->lits [i] >> 1] + (b->lits [i] & 1);
+  for (i = 0, n = 0; i < b->ncubes; i++)
+    {
+      cubes [n].keys = keys + b->start [i];
+      cubes [n].n = b->start [i + 1] - b->start [i];
+      if (lddCubeCanonical (ldd, &cubes [n])) n++;
+    }
+  qsort (cubes, n, sizeof (lddCubeKeys), lddCubeKeysCmp);
+
+  /* a chain for each distinct cube */
+  for (i = 0, j = 0; i < n; i++)
+    {
+      if (j > 0 && lddCubeKeysCmp (&cubes [i - 1], &cubes [i]) == 0)
+	continue;
+      fs [j] = lddCubeChain (ldd, &cubes [i]);
+      if (fs [j] == NULL) break;
+      cuddRef (fs [j]);
+      j++;
+    }
+  FREE (keys);
+  FREE (cubes);
+
+  if (i < n)
+    {
+      for (i = 0; i < j; i++)
+	Cudd_IterDerefBdd (CUDD, fs [i]);
+      FREE (fs);
+      return NULL;
+    }
+  n = j;
+
+  /* balanced disjunction of neighbours */
+  res = zero;
+  for (step = 1; step < n && res != NULL; step *= 2)
+    for (i = 0; i + step < n; i += 2 * step)
+      {
+	tmp = lddAndRecur (ldd, Cudd_Not (fs [i]), Cudd_Not (fs [i + step]));
+	if (tmp == NULL)
+	  {
+	    res = NULL;
+	    break;
+	  }
+	cuddRef (tmp);
+	Cudd_IterDerefBdd (CUDD, fs [i]);
+	Cudd_IterDerefBdd (CUDD, fs [i + step]);
+	fs [i] = Cudd_Not (tmp);
+	fs [i + step] = NULL;
+      }
+
+  if (res != NULL && n > 0)
+    {
+      res = fs [0];
+      cuddDeref (res);
+      fs [0] = NULL;
+    }
+
+  /* release what is left after a failure */
+  for (i = 0; i < n; i++)
+    if (fs [i] != NULL)
+      Cudd_IterDerefBdd (CUDD, fs [i]);
+  FREE (fs);
+  return res;
+}
+
+/**
+   \brief Builds the disjunction of the cubes added to a builder. The
+   builder keeps its cubes, so more may be added and the LDD built
+   again.
+
+   \return the LDD (not referenced) if successful; NULL otherwise
+
+   \sa Ldd_CubeBuilderAddCube()
+ */
+LddNode *
+Ldd_CubeBuilderBuild (LddCubeBuilder *b)
+{
+  LddManager *ldd;
+  LddNode *res;
+
+  ldd = b->ldd;
+  do
+    {
+      CUDD->reordered = 0;
+      res = lddCubeBuilderBuildInter (b);
+    } while (CUDD->reordered == 1);
+  return res;
+}
@@ -0,0 +1,423 @@
+/**
+   Evaluation of LDDs on concrete integer points.
+
+   The constraint of every node is turned once into the form
+   a1*x1 + ... + an*xn <= k, with 64-bit integer coefficients, by
+   scaling it with the denominators of its constants. Over the
+   integers, a strict constraint t < k is t <= k - 1. The integer forms
+   are kept in the manager, indexed like its constraints, so that
+   evaluating a point is a walk of one path with integer arithmetic
+   only.
+
+   A batch of points is evaluated level by level: the points that
+   reach a node are compared with its constraint in a single loop, and
+   split between its children. The points must be small enough that
+   the values of the terms fit in 64 bits.
+ */
+#include "util.h"
+#include "lddInt.h"
+
+/** number of points of a batch that are evaluated together */
+#define LDD_EVAL_BLOCK 1024
+/** number of points at a node below which they are evaluated one at
+    a time */
+#define LDD_EVAL_MIN 8
+
+typedef struct lddEvalBatchState
+{
+  /* vals[x][p] is the value of variable x in point p */
+  const int64_t * const *vals;
+  char *out;
+  /* the points of the block at every node, and scratch space of the
+     same size */
+  size_t *idx;
+  size_t *tmp;
+  int64_t *acc;
+} lddEvalBatchState;
+
+static lddEvalCons *lddEvalGet (LddManager *, int);
+static int lddEvalBatchPoint (LddManager *, LddNode *, lddEvalBatchState *,
+			      size_t);
+static int lddEvalBatchRecur (LddManager *, LddNode *,
+			      lddEvalBatchState *, size_t, size_t);
+
+
+/**
+   \brief Evaluates f on a point.
+
+   point[x] is the value of variable x, for every variable of the
+   theory. The integer forms of the constraints on the path are
+   computed on the first evaluation, and reused afterwards.
+
+   \return 1 if the point satisfies f; 0 if it does not; -1 if out of
+   memory, or if a constraint on the path has no integer form with
+   64-bit coefficients
+
+   \sa Ldd_EvalBatch()
+ */
+int
+Ldd_Eval (LddManager *ldd, LddNode *f, const int64_t *point)
+{
+  LddNode *F, *g;
+  lddEvalCons *e;
+  int64_t s;
+  int i;
+
+  F = Cudd_Regular (f);
+  while (!cuddIsConstant (F))
+    {
+      e = F->index < ldd->evalConsSize ? &ldd->evalCons [F->index] : NULL;
+      if (e == NULL || e->valid == 0)
+	{
+	  e = lddEvalGet (ldd, F->index);
+	  if (e == NULL) return -1;
+	}
+      if (e->valid < 0) return -1;
+
+      s = 0;
+      for (i = 0; i < e->size; i++)
+	s += e->coeff [i] * point [e->var [i]];
+
+      g = s <= e->k ? cuddT (F) : cuddE (F);
+      f = Cudd_NotCond (g, Cudd_IsComplement (f));
+      F = Cudd_Regular (f);
+    }
+  return f == F;
+}
+
+/**
+   \brief Evaluates f on n points.
+
+   The points are given by variable: vals[x][p] is the value of
+   variable x in point p, for every variable of the theory and 0 <= p
+   < n. On return, out[p] is 1 if point p satisfies f, and 0
+   otherwise.
+
+   \return 1 if successful; -1 if out of memory, or if a constraint
+   reached by some point has no integer form with 64-bit coefficients
+
+   \sa Ldd_Eval()
+ */
+int
+Ldd_EvalBatch (LddManager *ldd, LddNode *f, const int64_t * const *vals,
+	       size_t n, char *out)
+{
+  lddEvalBatchState b;
+  size_t lo, m, p;
+  int res;
+
+  if (n == 0) return 1;
+
+  /* the points are evaluated a block at a time, so that the values of
+     a block and the scratch space stay in the cache */
+  m = n < LDD_EVAL_BLOCK ? n : LDD_EVAL_BLOCK;
+  b.vals = vals;
+  b.out = out;
+  b.idx = ALLOC (size_t, m);
+  b.tmp = ALLOC (size_t, m);
+  b.acc = ALLOC (int64_t, m);
+  res = b.idx != NULL && b.tmp != NULL && b.acc != NULL ? 1 : -1;
+
+  for (lo = 0; res > 0 && lo < n; lo += m)
+    {
+      if (m > n - lo) m = n - lo;
+      for (p = 0; p < m; p++)
+	b.idx [p] = lo + p;
+      if (!lddEvalBatchRecur (ldd, f, &b, 0, m)) res = -1;
+    }
+
+  FREE (b.idx);
+  FREE (b.tmp);
+  FREE (b.acc);
+  return res;
+}
+
+/**
+   \brief Releases the integer forms of the constraints of a manager.
+ */
+void
+lddEvalQuit (LddManager *ldd)
+{
+  size_t i;
+
+  for (i = 0; i < ldd->evalConsSize; i++)
+    {
+      FREE (ldd->evalCons [i].var);
+      FREE (ldd->evalCons [i].coeff);
+    }
+  FREE (ldd->evalCons);
+  ldd->evalCons = NULL;
+  ldd->evalConsSize = 0;
+}
+
+
+/**
+   \brief Sets *r to a * b.
+
+   \return 1 if successful; 0 if the product does not fit in 64 bits
+ */
+static int
+lddEvalMul (int64_t a, int64_t b, int64_t *r)
+{
+  uint64_t ua, ub;
+
+  ua = a < 0 ? -(uint64_t) a : (uint64_t) a;
+  ub = b < 0 ? -(uint64_t) b : (uint64_t) b;
+  if (ua != 0 && ub > (uint64_t) INT64_MAX / ua) return 0;
+  *r = a * b;
+  return 1;
+}
+
+/**
+   \brief Gets the numerator and the denominator of c.
+
+   \return 1 if successful; 0 if c is not exactly num/den with num and
+   den in a long
+ */
+static int
+lddEvalCst (LddManager *ldd, constant_t c, int64_t *num, int64_t *den)
+{
+  constant_t d, nd, s;
+  long n, q;
+  int ok;
+
+  n = THEORY->cst_get_si_num (c);
+  q = THEORY->cst_get_si_den (c);
+  if (q <= 0) return 0;
+
+  /* the theory cuts large constants to a long */
+  d = THEORY->create_rat_cst (n, q);
+  nd = THEORY->negate_cst (d);
+  s = THEORY->add_cst (c, nd);
+  ok = THEORY->sgn_cst (s) == 0;
+  THEORY->destroy_cst (s);
+  THEORY->destroy_cst (nd);
+  THEORY->destroy_cst (d);
+
+  *num = n;
+  *den = q;
+  return ok;
+}
+
+/**
+   \brief Multiplies *l by a factor so that it is a multiple of the
+   denominator of c.
+
+   \return 1 if successful; 0 if the constant or the multiple do not
+   fit
+ */
+static int
+lddEvalLcm (LddManager *ldd, constant_t c, int64_t *l)
+{
+  int64_t num, den, a, b, r;
+
+  if (!lddEvalCst (ldd, c, &num, &den)) return 0;
+
+  for (a = *l, b = den; b != 0; r = a % b, a = b, b = r);
+  return lddEvalMul (*l / a, den, l);
+}
+
+/**
+   \brief Sets *r to c * l, an integer since l is a multiple of the
+   denominator of c.
+ */
+static int
+lddEvalScale (LddManager *ldd, constant_t c, int64_t l, int64_t *r)
+{
+  int64_t num, den;
+
+  if (!lddEvalCst (ldd, c, &num, &den)) return 0;
+  return lddEvalMul (num, l / den, r);
+}
+
+/**
+   \brief Computes the integer form of the constraint c in e.
+
+   \return 1 if successful; 0 if out of memory
+ */
+static int
+lddEvalCompile (LddManager *ldd, lddEvalCons *e, lincons_t c)
+{
+  linterm_t t;
+  int64_t l;
+  int i, n;
+
+  t = THEORY->get_term (c);
+  n = THEORY->term_size (t);
+
+  e->var = ALLOC (int, n);
+  e->coeff = ALLOC (int64_t, n);
+  if (e->var == NULL || e->coeff == NULL)
+    {
+      FREE (e->var);
+      FREE (e->coeff);
+      return 0;
+    }
+  e->size = n;
+  e->valid = -1;
+
+  /* the least common multiple of the denominators */
+  l = 1;
+  for (i = 0; i < n; i++)
+    if (!lddEvalLcm (ldd, THEORY->term_get_coeff (t, i), &l)) return 1;
+  if (!lddEvalLcm (ldd, THEORY->get_constant (c), &l)) return 1;
+
+  for (i = 0; i < n; i++)
+    {
+      e->var [i] = THEORY->term_get_var (t, i);
+      if (!lddEvalScale (ldd, THEORY->term_get_coeff (t, i), l,
+			 &e->coeff [i]))
+	return 1;
+    }
+  if (!lddEvalScale (ldd, THEORY->get_constant (c), l, &e->k)) return 1;
+
+  if (THEORY->is_strict (c))
+    {
+      if (e->k == INT64_MIN) return 1;
+      e->k--;
+    }
+
+  e->valid = 1;
+  return 1;
+}
+
+/**
+   \brief Returns the integer form of the constraint of index idx,
+   computing it if needed.
+
+   \return a pointer to the form if successful; NULL if out of memory
+ */
+static lddEvalCons *
+lddEvalGet (LddManager *ldd, int idx)
+{
+  lddEvalCons *e;
+  size_t i, size;
+
+  if ((size_t) idx >= ldd->evalConsSize)
+    {
+      size = ddMax (ldd->varsSize, (size_t) idx + 1);
+      e = REALLOC (lddEvalCons, ldd->evalCons, size);
+      if (e == NULL) return NULL;
+      for (i = ldd->evalConsSize; i < size; i++)
+	{
+	  e [i].valid = 0;
+	  e [i].size = 0;
+	  e [i].var = NULL;
+	  e [i].coeff = NULL;
+	  e [i].k = 0;
+	}
+      ldd->evalCons = e;
+      ldd->evalConsSize = size;
+    }
+
+  e = &ldd->evalCons [idx];
+  if (e->valid == 0 && !lddEvalCompile (ldd, e, lddC (ldd, idx)))
+    return NULL;
+  return e;
+}
+
+/**
+   \brief Evaluates f on the point p of the batch b, like Ldd_Eval().
+ */
+static int
+lddEvalBatchPoint (LddManager *ldd, LddNode *f, lddEvalBatchState *b,
+		   size_t p)
+{
+  LddNode *F, *g;
+  lddEvalCons *e;
+  int64_t s;
+  int i;
+
+  F = Cudd_Regular (f);
+  while (!cuddIsConstant (F))
+    {
+      e = lddEvalGet (ldd, F->index);
+      if (e == NULL || e->valid < 0) return -1;
+
+      s = 0;
+      for (i = 0; i < e->size; i++)
+	s += e->coeff [i] * b->vals [e->var [i]][p];
+
+      g = s <= e->k ? cuddT (F) : cuddE (F);
+      f = Cudd_NotCond (g, Cudd_IsComplement (f));
+      F = Cudd_Regular (f);
+    }
+  return f == F;
+}
+
+/**
+   \brief Evaluates f on the n points b->idx[lo..lo+n).
+
+   \return 1 if successful; 0 otherwise
+ */
+static int
+lddEvalBatchRecur (LddManager *ldd, LddNode *f, lddEvalBatchState *b,
+		   size_t lo, size_t n)
+{
+  LddNode *F;
+  lddEvalCons *e;
+  const int64_t *x;
+  size_t *idx, *tmp, j, nt, ne;
+  int64_t *acc, a, k;
+  int i, s;
+
+  if (n == 0) return 1;
+
+  F = Cudd_Regular (f);
+  idx = b->idx + lo;
+  if (cuddIsConstant (F))
+    {
+      for (j = 0; j < n; j++)
+	b->out [idx [j]] = f == F;
+      return 1;
+    }
+
+  /* a few points are faster to walk down their paths */
+  if (n < LDD_EVAL_MIN)
+    {
+      for (j = 0; j < n; j++)
+	{
+	  s = lddEvalBatchPoint (ldd, f, b, idx [j]);
+	  if (s < 0) return 0;
+	  b->out [idx [j]] = s;
+	}
+      return 1;
+    }
+
+  e = lddEvalGet (ldd, F->index);
+  if (e == NULL || e->valid < 0) return 0;
+
+  /* the values of the term in all the points, a variable at a time */
+  acc = b->acc + lo;
+  for (j = 0; j < n; j++)
+    acc [j] = 0;
+  for (i = 0; i < e->size; i++)
+    {
+      x = b->vals [e->var [i]];
+      a = e->coeff [i];
+      for (j = 0; j < n; j++)
+	acc [j] += a * x [idx [j]];
+    }
+
+  /* the points that satisfy the constraint go first, and the others
+     last. Each point is written at both ends, and only the end that
+     moves keeps it, so that there are no branches. */
+  tmp = b->tmp + lo;
+  k = e->k;
+  nt = 0;
+  ne = n;
+  for (j = 0; j < n; j++)
+    {
+      s = acc [j] <= k;
+      tmp [nt] = idx [j];
+      tmp [ne - 1] = idx [j];
+      nt += s;
+      ne -= !s;
+    }
+  memcpy (idx, tmp, n * sizeof (size_t));
+
+  return
+    lddEvalBatchRecur (ldd, Cudd_NotCond (cuddT (F), F != f), b, lo, nt) &&
+    lddEvalBatchRecur (ldd, Cudd_NotCond (cuddE (F), F != f), b,
+		       lo + nt, n - nt);
+}
@@ -20,6 +20,12 @@ Ldd_GetTheory (LddManager *ldd)
    \param cudd underlying CUDD manager
    \param t theory for managing labels of nodes
    \return a pointer to the manager if successful; NULL otherwise
+
+   A manager, together with its CUDD manager and theory, must only be
+   used by one thread at a time. Work is spread over several cores by
+   running one manager per worker, each with its own theory. Dynamic
+   reordering keeps global state in CUDD, and must be disabled in
+   managers that run concurrently.
    
    \sa Cudd_Init(), and Ldd_Quit()
  */
@@ -27,7 +33,7 @@ LddManager *
 Ldd_Init (DdManager *cudd, theory_t * t)
 {
   LddManager* ldd;
-  int i;
+  size_t i;
   
   ldd = ALLOC(LddManager, 1);
   if (ldd == NULL) return 0;
@@ -37,20 +43,46 @@ Ldd_Init (DdManager *cudd, theory_t * t)
   ldd->cudd = cudd;
   ldd->theory = t;
 
-  ldd->existsAbstract = Ldd_ExistsAbstractFM;
+  /* in theories of single-variable terms, no resolvents are needed */
+  if (t->is_box != NULL && t->is_box (t))
+    ldd->existsAbstract = Ldd_ExistsAbstractBox;
+  else
+    ldd->existsAbstract = Ldd_ExistsAbstractFM;
+  ldd->elimOrder = Ldd_ElimOrderMinOccur;
 
   ldd->be_bddlike = 0;
 
   /* allocate the map from DD nodes to linear constraints*/
   ldd->varsSize = cudd->maxSize;
   ldd->ddVars = ALLOC(lincons_t,ldd->varsSize);
-  if (ldd->ddVars == NULL)
+  ldd->ddTerm = ALLOC(int,ldd->varsSize);
+  ldd->ddVarMask = ALLOC(uint64_t,ldd->varsSize);
+  if (ldd->ddVars == NULL || ldd->ddTerm == NULL || ldd->ddVarMask == NULL)
     {
+      FREE(ldd->ddVars);
+      FREE(ldd->ddTerm);
+      FREE(ldd->ddVarMask);
       FREE(ldd);
       return 0;
     }
   for (i = 0; i < ldd->varsSize; i++)
-    ldd->ddVars [i] = NULL;
+    {
+      ldd->ddVars [i] = NULL;
+      ldd->ddTerm [i] = -1;
+      ldd->ddVarMask [i] = 0;
+    }
+  ldd->numTerms = 0;
+  ldd->evalCons = NULL;
+  ldd->evalConsSize = 0;
+
+  if (!lddCacheInit (ldd))
+    {
+      FREE(ldd->ddVars);
+      FREE(ldd->ddTerm);
+      FREE(ldd->ddVarMask);
+      FREE(ldd);
+      return 0;
+    }
 
   /* add a hook to fix MTR tree after variable reordering */
   Cudd_AddHook (CUDD, &lddFixMtrTree, CUDD_POST_REORDERING_HOOK);
@@ -68,7 +100,7 @@ Ldd_Quit (LddManager * ldd)
 {
   if (ldd->ddVars != NULL)
     {
-      int i;
+      size_t i;
       for (i = 0; i < ldd->varsSize; i++)
 	if (ldd->ddVars [i] != NULL)
 	  {
@@ -78,7 +110,13 @@ Ldd_Quit (LddManager * ldd)
      
       FREE (ldd->ddVars);
       ldd->ddVars = NULL;
+      FREE (ldd->ddTerm);
+      ldd->ddTerm = NULL;
+      FREE (ldd->ddVarMask);
+      ldd->ddVarMask = NULL;
     }
+  lddCacheQuit (ldd);
+  lddEvalQuit (ldd);
   FREE (ldd);
 }
 
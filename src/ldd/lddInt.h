@@ -5,6 +5,7 @@
  * Internal header file. To be used by the tdd library and its extensions.
  */
 
+#include <stdint.h>
 #include "ldd.h"
 #include "cuddInt.h"
 
@@ -12,9 +13,36 @@
 
 #define DD_LDD_ITE_TAG 0x8a
 
+/** Operations with results in the computed table of the manager */
+#define LDD_FM_TAG 0
+#define LDD_SFM_TAG 1
+#define LDD_RESOLVE_TAG 2
+#define LDD_RESOLVE_ELIM_TAG 3
+#define LDD_SUBST_NINF_TAG 4
+#define LDD_AND_EXISTS_TAG 5
+#define LDD_CACHE_NTAGS 6
+
+/** number of nodes in a key of the computed table */
+#define LDD_CACHE_KEYSIZE 4
+
 #define CUDD ldd->cudd
 #define THEORY ldd->theory
 
+/**
+ * A constraint as a1*x1 + ... + an*xn <= k over the integers, see
+ * lddEval.c
+ */
+typedef struct lddEvalCons
+{
+  /** 1 if the fields below are set, -1 if the constraint has no such
+      form, and 0 if it has not been computed yet */
+  int valid;
+  int size;
+  int *var;
+  int64_t *coeff;
+  int64_t k;
+} lddEvalCons;
+
 /**
  * tdd manager 
  */
@@ -29,6 +57,34 @@ struct LddManager
   /** size of ddVars array */
   size_t varsSize;
 
+  /** 
+   * Metadata of the constraints in ddVars, indexed like ddVars. 
+   */
+
+  /** term group of each constraint. Constraints in the same group
+      have the same term, and each implies all the constraints of its
+      group below it in the variable order */
+  int *ddTerm;
+  /** variables of each constraint, see LDD_VAR_BIT */
+  uint64_t *ddVarMask;
+  /** number of term groups */
+  int numTerms;
+
+  /** computed table of quantification operations, see lddCache.c */
+  DdLocalCache *cache;
+  /** tag nodes of the computed table, indexed by 
+      var * LDD_CACHE_NTAGS + op */
+  LddNode **cacheTags;
+  size_t cacheTagsSize;
+  /** lookups and hits in the computed table */
+  double cacheLookUps;
+  double cacheHits;
+
+  /** integer form of the constraints in ddVars, indexed like ddVars
+      and computed on demand by Ldd_Eval() */
+  lddEvalCons *evalCons;
+  size_t evalConsSize;
+
   /** be like a BDD */
   bool be_bddlike;
 
@@ -37,12 +93,62 @@ struct LddManager
   /** default implementation of existential quantification of a single
       variable */
   LddNode* (*existsAbstract)(LddManager*,LddNode*,int);
+
+  /** order in which Ldd_MvExistAbstract eliminates variables */
+  int (*elimOrder)(LddManager*,int*,int*,size_t,int*);
 };
 
 /**
  * Extracts a constraint corresponding to a given index
  */
-#define lddC(ldd,index) ((index)>=ldd->varsSize?NULL:(ldd)->ddVars[(index)])
+#define lddC(ldd,index)						\
+  ((size_t) (index) >= (ldd)->varsSize ? NULL : (ldd)->ddVars [(index)])
+
+/**
+ * Bit of variable x in a variable mask. Variables from 63 on share
+ * the top bit.
+ */
+#define LDD_VAR_BIT(x) (((uint64_t)1) << ((x) < 63 ? (x) : 63))
+
+/**
+ * True if the constraint of index i implies the constraint of index
+ * j. Within a term group, the variable order is the implication
+ * order, and it is preserved by reordering since groups are fixed.
+ * Constraints created with Ldd_NewVar() or Ldd_NewVarAtTop() start a
+ * group of their own even if their term is already known, so
+ * across groups over the same variables the theory decides.
+ */
+#define lddIsStronger(ldd,i,j)						\
+  ((ldd)->be_bddlike ?							\
+   (ldd)->theory->is_stronger_cons ((ldd)->ddVars [i], (ldd)->ddVars [j]) : \
+   (ldd)->ddTerm [i] == (ldd)->ddTerm [j] ?				\
+   cuddI ((ldd)->cudd, i) <= cuddI ((ldd)->cudd, j) :			\
+   ((ldd)->ddVarMask [i] == (ldd)->ddVarMask [j] &&			\
+    (ldd)->theory->is_stronger_cons ((ldd)->ddVars [i], (ldd)->ddVars [j])))
+
+/**
+ * True if variable x occurs in the constraint of index i.
+ */
+#define lddHasVar(ldd,i,x)						\
+  (((ldd)->ddVarMask [i] & LDD_VAR_BIT (x)) != 0 &&			\
+   ((x) < 63 ||								\
+    (ldd)->theory->term_has_var ((ldd)->theory->get_term ((ldd)->ddVars [i]), \
+				 (x))))
+
+/**
+ * Landmarks of a widening with thresholds.
+ */
+typedef struct lddThresholds
+{
+  /** th[x] is an ascending array of n[x] constants for variable x */
+  constant_t **th;
+  int *n;
+  /** number of variables in th and n */
+  int size;
+
+  /** computed table of the widening */
+  DdLocalCache *cache;
+} lddThresholds;
 
 
 LddNode* lddUniqueInter (LddManager *m, unsigned int idx, 
@@ -52,33 +158,48 @@ LddNode* lddAndRecur (LddManager*, LddNode*, LddNode*);
 LddNode* lddXorRecur (LddManager*, LddNode*, LddNode*);
 LddNode* lddIteRecur (LddManager*, LddNode*, LddNode*, LddNode*);
 LddNode* lddExistsAbstractFMRecur (LddManager*, LddNode*, int, 
-				   DdLocalCache*);
+				   LddNode*);
+LddNode* lddAndExistsAbstractFMRecur (LddManager*, LddNode*, LddNode*, int,
+				      LddNode*, LddNode*);
 LddNode * lddResolveElimInter (LddManager * tdd, LddNode * f, 
-				   linterm_t t, lincons_t cons, int var);
+			       linterm_t t, lincons_t cons, LddNode *lit,
+			       int var);
 LddNode* lddResolveElimRecur (LddManager*, LddNode*, 
-				  linterm_t,lincons_t, lincons_t, int);
+			      linterm_t,lincons_t, lincons_t, int,
+			      LddNode*, LddNode*);
 
-LddNode* lddResolveRecur(LddManager*, LddNode*, linterm_t, lincons_t, lincons_t, int, DdHashTable*);
+LddNode* lddResolveRecur(LddManager*, LddNode*, linterm_t, lincons_t, lincons_t, int, LddNode*, LddNode*, LddNode*);
 
 LddNode* lddExistAbstractPATRecur (LddManager*, LddNode*, bool*, 
 				   qelim_context_t *,
 				   DdHashTable*);
 
+LddNode* lddMapRecur (LddManager*, LddNode*, LddNode**, int, DdHashTable*);
+int lddMapIsCopy (LddManager*, DdManager*, int*, LddNode**, int);
+
 LddNode* lddSatReduceRecur (LddManager*, LddNode*, 
 				qelim_context_t*, int);
 bool lddIsSatRecur (LddManager*, LddNode*, 
 				qelim_context_t*);
+int lddSatLookup (LddManager*, LddNode*);
+void lddSatInsert (LddManager*, LddNode*, bool);
 LddNode* lddBddExistAbstractRecur (LddManager*, LddNode*, LddNode*);
+LddNode* lddBoxExistAbstractRecur (LddManager*, LddNode*, bool*, uint64_t,
+				   DdHashTable*);
+LddNode* lddBoxAndExistAbstractRecur (LddManager*, LddNode*, LddNode*, 
+				      bool*, uint64_t, DdHashTable*);
 LddNode* lddExistsAbstractSFMRecur (LddManager*, LddNode*, int, 
-				    DdLocalCache*);
+				    LddNode*);
 
 void lddDebugPrintMtr (MtrNode*);
 int lddFixMtrTree (DdManager*, const char *, void*);
 
 LddNode* lddBoxExtrapolateRecur (LddManager*, LddNode*, LddNode*);
-LddNode* lddBoxWidenRecur (LddManager*, LddNode*, LddNode*);
-LddNode* lddBoxWiden2Recur (LddManager*, LddNode*, LddNode*, lincons_t);
-LddNode* lddIntervalWidenRecur (LddManager*, LddNode*, LddNode*);
+LddNode* lddBoxWidenRecur (LddManager*, LddNode*, LddNode*, lddThresholds*);
+LddNode* lddBoxWiden2Recur (LddManager*, LddNode*, LddNode*, lincons_t,
+			    lddThresholds*);
+LddNode* lddIntervalWidenRecur (LddManager*, LddNode*, LddNode*,
+				lddThresholds*);
 LddNode* lddTermReplaceRecur (LddManager*, LddNode*, 
 				  linterm_t, linterm_t, 
 				  constant_t, 
@@ -95,7 +216,19 @@ LddNodeset* lddNodesetUnionRecur(LddManager*, LddNodeset*, LddNodeset*);
 
 int lddIsValidNodeset (LddManager*, LddNodeset*);
 
-LddNode *lddSubstNinfForVarRecur (LddManager*, LddNode*, int, DdHashTable*);
+LddNode *lddSubstNinfForVarRecur (LddManager*, LddNode*, int, LddNode*);
 LddNode* lddCofactorRecur (LddManager*, LddNode*, LddNode*);
+LddNode* lddConstrainRecur (LddManager*, LddNode*, LddNode*);
+LddNode* lddRestrictRecur (LddManager*, LddNode*, LddNode*);
+
+int lddCacheInit (LddManager*);
+void lddCacheQuit (LddManager*);
+LddNode* lddCacheTag (LddManager*, int, int);
+void lddEvalQuit (LddManager*);
+DdNode* lddTermLeqTag (DdManager*, DdNode*, DdNode*);
+LddNode* lddCacheLookup (LddManager*, LddNode*, LddNode*, LddNode*, 
+			 LddNode*);
+void lddCacheInsert (LddManager*, LddNode*, LddNode*, LddNode*, 
+		     LddNode*, LddNode*);
 
 #endif
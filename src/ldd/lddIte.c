@@ -101,6 +101,176 @@ Ldd_Xor (LddManager * ldd,
 }
 
 
+/**
+   \brief An operand of Ldd_AndN() with its size.
+ */
+typedef struct 
+{
+  LddNode *f;
+  int size;
+} lddSizedNode;
+
+/**
+   \brief Adds f to a binary min-heap of n operands ordered by size.
+ */
+static void
+lddHeapPush (lddSizedNode *heap, size_t *n, LddNode *f, int size)
+{
+  size_t i, p;
+
+  for (i = (*n)++; i > 0; i = p)
+    {
+      p = (i - 1) / 2;
+      if (heap [p].size <= size) break;
+      heap [i] = heap [p];
+    }
+  heap [i].f = f;
+  heap [i].size = size;
+}
+
+/**
+   \brief Removes and returns the smallest operand of a binary
+   min-heap of n > 0 operands.
+ */
+static LddNode *
+lddHeapPop (lddSizedNode *heap, size_t *n)
+{
+  LddNode *res;
+  lddSizedNode last;
+  size_t i, c;
+
+  res = heap [0].f;
+  last = heap [--(*n)];
+  for (i = 0; (c = 2 * i + 1) < *n; i = c)
+    {
+      if (c + 1 < *n && heap [c + 1].size < heap [c].size) c++;
+      if (last.size <= heap [c].size) break;
+      heap [i] = heap [c];
+    }
+  heap [i] = last;
+  return res;
+}
+
+/**
+   \brief Common part of Ldd_AndN() and Ldd_OrN(). Conjoins the
+   operands, complemented if neg is set, and complements the result if
+   neg is set.
+ */
+static LddNode *
+lddAndN (LddManager *ldd, LddNode **fs, size_t n, int neg)
+{
+  DdNode *one, *zero;
+  LddNode *f, *g, *res;
+  lddSizedNode *heap;
+  size_t hsize, i;
+
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+
+  /* short-circuit before computing any sizes */
+  for (i = 0; i < n; i++)
+    {
+      if (fs [i] == NULL) return NULL;
+      if (Cudd_NotCond (fs [i], neg) == zero) 
+	return Cudd_NotCond (zero, neg);
+    }
+
+  heap = ALLOC (lddSizedNode, n + 1);
+  if (heap == NULL)
+    {
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+
+  hsize = 0;
+  for (i = 0; i < n; i++)
+    {
+      f = Cudd_NotCond (fs [i], neg);
+      if (f == one) continue;
+      cuddRef (f);
+      lddHeapPush (heap, &hsize, f, Cudd_DagSize (f));
+    }
+
+  /* conjoin the two smallest operands until one is left */
+  res = one;
+  while (hsize > 1)
+    {
+      f = lddHeapPop (heap, &hsize);
+      g = lddHeapPop (heap, &hsize);
+
+      do {
+	CUDD->reordered = 0;
+	res = lddAndRecur (ldd, f, g);
+      } while (CUDD->reordered == 1);
+
+      if (res != NULL) cuddRef (res);
+      Cudd_IterDerefBdd (CUDD, f);
+      Cudd_IterDerefBdd (CUDD, g);
+      if (res == NULL || res == zero) break;
+
+      if (res == one)
+	cuddDeref (res);
+      else
+	lddHeapPush (heap, &hsize, res, Cudd_DagSize (res));
+    }
+
+  if (res == NULL || res == zero)
+    {
+      if (res == zero) cuddDeref (res);
+      for (i = 0; i < hsize; i++)
+	Cudd_IterDerefBdd (CUDD, heap [i].f);
+    }
+  else if (hsize == 1)
+    {
+      res = heap [0].f;
+      cuddDeref (res);
+    }
+  FREE (heap);
+
+  return Cudd_NotCond (res, res != NULL && neg);
+}
+
+/**
+   \brief Computes the conjunction of n LDDs.
+
+   Folding Ldd_And() left to right can build intermediate results much
+   larger than the operands and the result. Instead, the two smallest
+   operands (by Cudd_DagSize()) are conjoined repeatedly, and the
+   result is put back with the remaining operands. A false operand or
+   intermediate result ends the computation early. The conjunctions
+   share the computed table of Ldd_And().
+
+   \param ldd LDD manager
+   \param fs array of LDDs
+   \param n the size of fs
+
+   \return a pointer to the resulting LDD (true if n is 0) if
+   successful; NULL if the intermediate result blows up.
+
+   \sa Ldd_And(), Ldd_OrN()
+ */
+LddNode *
+Ldd_AndN (LddManager *ldd, LddNode **fs, size_t n)
+{
+  return lddAndN (ldd, fs, n, 0);
+}
+
+/**
+   \brief Computes the disjunction of n LDDs, smallest first like
+   Ldd_AndN(). A true operand ends the computation early.
+
+   \return a pointer to the resulting LDD (false if n is 0) if
+   successful; NULL if the intermediate result blows up.
+
+   \sa Ldd_Or(), Ldd_AndN()
+ */
+LddNode *
+Ldd_OrN (LddManager *ldd, LddNode **fs, size_t n)
+{
+  return lddAndN (ldd, fs, n, 1);
+}
+
+
 
 
 /**
@@ -161,11 +331,8 @@ lddUniqueInter (LddManager *ldd, unsigned int index,
 
   if (f != DD_ONE(CUDD))
     {
-      lincons_t vCons = ldd->ddVars [v->index];
-      lincons_t fCons = ldd->ddVars [f->index];
-      
-      /* if vCons implies fCons, then fCons is redundant! */
-      if (THEORY->is_stronger_cons (vCons, fCons))
+      /* if cons(v) implies cons(f), then cons(f) is redundant! */
+      if (lddIsStronger (ldd, v->index, f->index))
 	f = cuddT (f); /* by assumption, no need to check cons of cuddT(f) */
     }
 
@@ -207,10 +374,7 @@ lddUniqueInter (LddManager *ldd, unsigned int index,
       if (f == cuddT(G))
 	{
 	  /* now need to check the constraints */
-	  lincons_t vCons = ldd->ddVars [v->index];
-	  lincons_t gCons = ldd->ddVars [G->index];
-	  
-	  if (THEORY->is_stronger_cons (vCons, gCons))
+	  if (lddIsStronger (ldd, v->index, G->index))
 	    {
 	      /* Apply simplification, get rid of v */
 	      cuddRef (g);
@@ -252,8 +416,6 @@ lddIteRecur (LddManager * ldd,
   int		 index = 0;
   int		 comple;
   
-  lincons_t vCons;
-  
   statLine(CUDD);
   /* Terminal cases. */
 
@@ -345,27 +507,21 @@ lddIteRecur (LddManager * ldd,
     Hv = Hnv = h;
   }
 
-  vCons = ldd->ddVars [index];
-
   /** Ldd part of the cofactor */
   if (Fv == f)
     {
-      lincons_t fCons = ldd->ddVars [f->index];
-      
-      if (THEORY->is_stronger_cons (vCons, fCons))
+      if (lddIsStronger (ldd, index, f->index))
 	Fv = cuddT (Fv);
     }
   if (Gv == g)
     {
-      lincons_t gCons = ldd->ddVars [g->index];
-      if (THEORY->is_stronger_cons (vCons, gCons))
+      if (lddIsStronger (ldd, index, g->index))
 	Gv = cuddT (Gv);
     }
   if (Hv == h)
     {
       H = Cudd_Regular (h);
-      lincons_t hCons = ldd->ddVars [H->index];
-      if (THEORY->is_stronger_cons (vCons, hCons))
+      if (lddIsStronger (ldd, index, H->index))
 	{
 	  Hv = cuddT (H);
 	  if (Cudd_IsComplement (h))
@@ -424,8 +580,6 @@ lddAndRecur (LddManager * ldd,
   DdNode *one, *r, *t, *e;
   unsigned int topf, topg, index;
 
-  lincons_t vCons;
-  
 
   manager = CUDD;
   statLine(manager);
@@ -496,11 +650,6 @@ lddAndRecur (LddManager * ldd,
   }
 
 
-  /** 
-   * Get the constraint of the root node 
-   */
-  vCons = ldd->ddVars [index];
-
   /** 
    *
    * Ldd part of the cofactor
@@ -512,15 +661,13 @@ lddAndRecur (LddManager * ldd,
    * 
    * We check whether f and g have the same constraint using the
    * following facts: 
-   *   vInfo is the constraint of the root diagram
+   *   index is the index of the root diagram
    *   gv == g iff g is not the root diagram
    *   fv == f iff f is not the root diagram
    */
   if (gv == g)
     {
-      lincons_t gCons = ldd->ddVars [G->index];
-      
-      if (THEORY->is_stronger_cons (vCons, gCons))
+      if (lddIsStronger (ldd, index, G->index))
 	{
 	  gv = cuddT (G);
 	  if (Cudd_IsComplement (g))
@@ -529,9 +676,7 @@ lddAndRecur (LddManager * ldd,
     }
   else if (fv == f)
     {
-      lincons_t fCons = ldd->ddVars [F->index];
-      
-      if (THEORY->is_stronger_cons (vCons, fCons))
+      if (lddIsStronger (ldd, index, F->index))
 	{
 	  fv = cuddT (F);
 	  if (Cudd_IsComplement (f))
@@ -608,8 +753,6 @@ lddXorRecur (LddManager * ldd,
   DdNode *one, *zero, *r, *t, *e;
   unsigned int topf, topg, index;
   
-  lincons_t vCons;
-
   manager = CUDD;
   statLine(manager);
   one = DD_ONE(manager);
@@ -674,11 +817,6 @@ lddXorRecur (LddManager * ldd,
   }
 
 
-  /** 
-   * Get the constraint of the root node 
-   */
-  vCons = ldd->ddVars [index];
-
   /** 
    * Ldd part of the cofactor
 
@@ -687,15 +825,13 @@ lddXorRecur (LddManager * ldd,
    * 
    * We check whether f and g have the same constraint using the
    * following facts: 
-   *   vInfo is the constraint of the root diagram
+   *   index is the index of the root diagram
    *   gv == g iff g is not the root diagram
    *   fv == f iff f is not the root diagram
    */
   if (gv == g)
     {
-      lincons_t gCons = ldd->ddVars [G->index];
-      
-      if (THEORY->is_stronger_cons (vCons, gCons))
+      if (lddIsStronger (ldd, index, G->index))
 	{
 	  gv = cuddT (G);
 	  if (Cudd_IsComplement (g))
@@ -704,10 +840,7 @@ lddXorRecur (LddManager * ldd,
     }
   else if (fv == f)
     {
-      lincons_t fCons;
-      
-      fCons = ldd->ddVars[f->index];
-      if (THEORY->is_stronger_cons (vCons, fCons))
+      if (lddIsStronger (ldd, index, f->index))
 	{
 	  fv = cuddT (f);
 	}
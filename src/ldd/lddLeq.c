@@ -0,0 +1,328 @@
+/**
+   Semantic containment and equivalence of LDDs.
+
+   Ldd_TermLeq() compares the diagrams as BDDs, and fails whenever a
+   path of f && !g is unsatisfiable only in the theory. Ldd_Leq() and
+   Ldd_Equiv() walk both diagrams in the same way, but keep the
+   constraints of the current path in an incremental theory context,
+   skip the branches that contradict it, and stop at the first
+   satisfiable path that separates f from g. No nodes are created.
+
+   A result that did not depend on the context holds under every
+   context, and is cached. Containment shares its cache entries with
+   Ldd_TermLeq().
+ */
+#include "util.h"
+#include "lddInt.h"
+
+
+/**
+   \brief Tag of the results of Ldd_TermLeq() and Ldd_Leq() in the
+   computed table of CUDD. It is never called.
+ */
+DdNode *
+lddTermLeqTag (DdManager *dd, DdNode *f, DdNode *g)
+{
+  (void) dd;
+  (void) f;
+  (void) g;
+  return NULL;
+}
+
+/**
+   \brief Tag of the results of Ldd_Equiv() in the computed table of
+   CUDD. It is never called.
+ */
+static DdNode *
+lddEquivTag (DdManager *dd, DdNode *f, DdNode *g)
+{
+  (void) dd;
+  (void) f;
+  /* unlike lddTermLeqTag(), so that the two are never folded into
+     one function */
+  return g;
+}
+
+/**
+   \brief Decides f <= g (f == g if equiv) without the theory, and
+   normalizes the operands for the cache.
+
+   \return 1 if it holds, 0 if it does not hold under a satisfiable
+   context, and -1 if the operands must be expanded
+ */
+static int
+lddLeqTerminal (LddManager *ldd, LddNode **pf, LddNode **pg, int equiv)
+{
+  LddNode *f, *g, *tmp, *one, *zero;
+
+  f = *pf;
+  g = *pg;
+  if (f == g) return 1;
+
+  if (equiv)
+    {
+      if (f == Cudd_Not (g)) return 0;
+      /* f == g iff !f == !g: make f regular and below g */
+      if (Cudd_Regular (g) < Cudd_Regular (f))
+	{
+	  tmp = f;
+	  f = g;
+	  g = tmp;
+	}
+      if (Cudd_IsComplement (f))
+	{
+	  f = Cudd_Not (f);
+	  g = Cudd_Not (g);
+	}
+      *pf = f;
+      *pg = g;
+      return -1;
+    }
+
+  /* f <= g iff !g <= !f: normalize as Ldd_TermLeq() does */
+  if (Cudd_IsComplement (g) && Cudd_IsComplement (f))
+    {
+      tmp = g;
+      g = Cudd_Not (f);
+      f = Cudd_Not (tmp);
+    }
+  else if (!Cudd_IsComplement (g) && Cudd_IsComplement (f) && g < f)
+    {
+      tmp = g;
+      g = Cudd_Not (f);
+      f = Cudd_Not (tmp);
+    }
+  *pf = f;
+  *pg = g;
+
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+  if (g == one || f == zero) return 1;
+  if (f == one && g == zero) return 0;
+  return -1;
+}
+
+/**
+   \brief Recursive step of Ldd_Leq() and Ldd_Equiv().
+
+   ctx holds the constraints of the current path, and is
+   satisfiable. pruned is set if a branch was skipped because it
+   contradicts the context, i.e., if the result depends on the
+   context.
+
+   \return 1 if f <= g (f == g if equiv) under ctx; 0 otherwise; -1
+   if qelim_solve() of the theory failed
+ */
+static int
+lddLeqRecur (LddManager *ldd, LddNode *f, LddNode *g, int equiv,
+	     qelim_context_t *ctx, int *pruned)
+{
+  LddNode *one, *zero, *tmp, *F, *G, *fv, *fnv, *gv, *gnv, *a, *b;
+  unsigned int topf, topg, index;
+  lincons_t vCons, nvCons;
+  int res, thenUnsat, p;
+  DD_CTFP tag;
+
+  res = lddLeqTerminal (ldd, &f, &g, equiv);
+  if (res >= 0) return res;
+
+  one = DD_ONE (CUDD);
+  zero = Cudd_Not (one);
+
+  /* a cached result holds under every context */
+  tag = equiv ? lddEquivTag : lddTermLeqTag;
+  tmp = cuddCacheLookup2 (CUDD, tag, f, g);
+  if (tmp == one) return 1;
+
+  F = Cudd_Regular (f);
+  G = Cudd_Regular (g);
+  topf = cuddIsConstant (F) ?
+    CUDD_CONST_INDEX : (unsigned int) CUDD->perm [F->index];
+  topg = cuddIsConstant (G) ?
+    CUDD_CONST_INDEX : (unsigned int) CUDD->perm [G->index];
+
+  if (topf <= topg)
+    {
+      index = F->index;
+      fv = Cudd_NotCond (cuddT (F), f != F);
+      fnv = Cudd_NotCond (cuddE (F), f != F);
+    }
+  else
+    {
+      index = G->index;
+      fv = fnv = f;
+    }
+
+  if (topg <= topf)
+    {
+      gv = Cudd_NotCond (cuddT (G), g != G);
+      gnv = Cudd_NotCond (cuddE (G), g != G);
+    }
+  else
+    gv = gnv = g;
+
+  vCons = lddC (ldd, index);
+
+  /* LDD cofactor: the constraint of the root implies the one of the
+     other operand */
+  if (gv == g && !cuddIsConstant (G))
+    {
+      if (lddIsStronger (ldd, index, G->index))
+	gv = Cudd_NotCond (cuddT (G), g != G);
+    }
+  else if (fv == f && !cuddIsConstant (F))
+    {
+      if (lddIsStronger (ldd, index, F->index))
+	fv = Cudd_NotCond (cuddT (F), f != F);
+    }
+
+  p = 0;
+  thenUnsat = 0;
+
+  /* THEN branch, unless it holds without the theory */
+  a = fv;
+  b = gv;
+  if (lddLeqTerminal (ldd, &a, &b, equiv) != 1)
+    {
+      THEORY->qelim_push (ctx, vCons);
+      tmp = THEORY->qelim_solve (ctx);
+      if (tmp == NULL)
+	{
+	  THEORY->qelim_pop (ctx);
+	  return -1;
+	}
+      if (tmp == zero)
+	{
+	  /* the context implies !vCons */
+	  THEORY->qelim_pop (ctx);
+	  thenUnsat = 1;
+	  p = 1;
+	}
+      else
+	{
+	  assert (tmp == one);
+	  res = lddLeqRecur (ldd, fv, gv, equiv, ctx, &p);
+	  THEORY->qelim_pop (ctx);
+	  if (res <= 0) return res;
+	}
+    }
+
+  /* ELSE branch */
+  a = fnv;
+  b = gnv;
+  if (lddLeqTerminal (ldd, &a, &b, equiv) != 1)
+    {
+      if (thenUnsat)
+	res = lddLeqRecur (ldd, fnv, gnv, equiv, ctx, &p);
+      else
+	{
+	  nvCons = THEORY->negate_cons (vCons);
+	  THEORY->qelim_push (ctx, nvCons);
+	  tmp = THEORY->qelim_solve (ctx);
+	  if (tmp == NULL)
+	    res = -1;
+	  else if (tmp == zero)
+	    {
+	      res = 1;
+	      p = 1;
+	    }
+	  else
+	    {
+	      assert (tmp == one);
+	      res = lddLeqRecur (ldd, fnv, gnv, equiv, ctx, &p);
+	    }
+	  THEORY->qelim_pop (ctx);
+	  THEORY->destroy_lincons (nvCons);
+	}
+      if (res <= 0) return res;
+    }
+
+  if (p)
+    *pruned = 1;
+  else
+    cuddCacheInsert2 (CUDD, tag, f, g, one);
+  return 1;
+}
+
+/**
+   \brief Creates a context with every variable quantified, so that
+   qelim_solve() only decides satisfiability.
+ */
+static qelim_context_t *
+lddLeqContext (LddManager *ldd)
+{
+  qelim_context_t *ctx;
+  bool *vars;
+  int i, n;
+
+  n = THEORY->num_of_vars (THEORY);
+  vars = ALLOC (bool, n);
+  if (vars == NULL) return NULL;
+
+  for (i = 0; i < n; i++)
+    vars [i] = 1;
+
+  ctx = THEORY->qelim_init (ldd, vars);
+  FREE (vars);
+  return ctx;
+}
+
+static int
+lddLeq (LddManager *ldd, LddNode *f, LddNode *g, int equiv)
+{
+  qelim_context_t *ctx;
+  LddNode *a, *b;
+  int res, pruned;
+
+  /* no context is needed for the trivial cases */
+  a = f;
+  b = g;
+  res = lddLeqTerminal (ldd, &a, &b, equiv);
+  if (res >= 0) return res;
+
+  ctx = lddLeqContext (ldd);
+  if (ctx == NULL) return -1;
+
+  pruned = 0;
+  res = lddLeqRecur (ldd, f, g, equiv, ctx, &pruned);
+
+  THEORY->qelim_destroy_context (ctx);
+  return res;
+}
+
+
+/**
+   \brief Determines whether f implies g in the theory, i.e., whether
+   f && !g is unsatisfiable.
+
+   Unlike Ldd_TermLeq(), paths that are unsatisfiable in the theory
+   are ignored. No new nodes are created, so reordering does not
+   happen. The answer is as precise as qelim_solve() of the theory:
+   where the theory only approximates satisfiability, 0 may be
+   returned for an f that implies g.
+
+   \return 1 if f implies g; 0 if it does not; -1 if out of memory
+   or if qelim_solve() of the theory failed
+
+   \sa Ldd_Equiv(), Ldd_TermLeq(), Ldd_IsSat()
+ */
+int
+Ldd_Leq (LddManager *ldd, LddNode *f, LddNode *g)
+{
+  return lddLeq (ldd, f, g, 0);
+}
+
+/**
+   \brief Determines whether f and g are equivalent in the theory,
+   i.e., whether f xor g is unsatisfiable. The LDDs may differ.
+
+   \return 1 if f is equivalent to g; 0 if it is not; -1 if out of
+   memory or if qelim_solve() of the theory failed
+
+   \sa Ldd_Leq()
+ */
+int
+Ldd_Equiv (LddManager *ldd, LddNode *f, LddNode *g)
+{
+  return lddLeq (ldd, f, g, 1);
+}
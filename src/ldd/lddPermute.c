@@ -0,0 +1,273 @@
+/**
+   Renaming of the theory variables of an LDD by a permutation.
+
+   Every constraint in the support of the LDD is renamed once, with
+   theory_t::subst_vec, and interned by the theory. The diagram is
+   then rebuilt in a single pass. When the renamed constraints are in
+   the same order as the original ones, e.g., when renaming next-state
+   variables to current-state variables whose constraints were created
+   in the same order, the rebuild is a structural copy. Otherwise, the
+   nodes are combined with lddIteRecur(). The rebuild is shared with
+   Ldd_Transfer().
+ */
+#include "util.h"
+#include "lddInt.h"
+
+static LddNode *lddPermuteInter (LddManager *, LddNode *, int *,
+				 linterm_t *, constant_t *, size_t);
+
+
+/**
+   \brief Renames the variables of f: variable x is replaced by
+   perm[x], simultaneously for all variables. perm must be a
+   permutation of the variables of the theory.
+
+   \return the renamed LDD if successful; NULL if out of memory, if
+   the theory has no subst_vec, or if perm is not a permutation
+
+   \sa Ldd_VectorSubst(), Cudd_bddPermute()
+ */
+LddNode *
+Ldd_Permute (LddManager *ldd, LddNode *f, int *perm)
+{
+  LddNode *res;
+  int *vars, *coeff;
+  linterm_t *terms;
+  constant_t *csts;
+  size_t i, n, nvars;
+
+  if (THEORY->subst_vec == NULL)
+    {
+      (void) fprintf (CUDD->err, "Ldd_Permute: theory has no subst_vec\n");
+      CUDD->errorCode = CUDD_INVALID_ARG;
+      return NULL;
+    }
+
+  nvars = THEORY->num_of_vars (THEORY);
+  vars = ALLOC (int, nvars);
+  coeff = ALLOC (int, nvars);
+  terms = ALLOC (linterm_t, nvars);
+  csts = ALLOC (constant_t, nvars);
+  if (vars == NULL || coeff == NULL || terms == NULL || csts == NULL)
+    {
+      FREE (vars);
+      FREE (coeff);
+      FREE (terms);
+      FREE (csts);
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+
+  /* perm must be a permutation, coeff marks the targets seen */
+  for (i = 0; i < nvars; i++)
+    coeff [i] = 0;
+  for (i = 0; i < nvars; i++)
+    {
+      if (perm [i] < 0 || (size_t) perm [i] >= nvars || coeff [perm [i]])
+	{
+	  (void) fprintf (CUDD->err,
+			  "Ldd_Permute: perm is not a permutation\n");
+	  FREE (vars);
+	  FREE (coeff);
+	  FREE (terms);
+	  FREE (csts);
+	  CUDD->errorCode = CUDD_INVALID_ARG;
+	  return NULL;
+	}
+      coeff [perm [i]] = 1;
+    }
+
+  /* the substitution x := perm[x] for the variables that move */
+  for (i = 0; i < nvars; i++)
+    coeff [i] = 0;
+  for (i = 0, n = 0; i < nvars; i++)
+    {
+      if (perm [i] == (int) i) continue;
+      coeff [perm [i]] = 1;
+      vars [n] = i;
+      terms [n] = THEORY->create_linterm (coeff, nvars);
+      csts [n] = NULL;
+      coeff [perm [i]] = 0;
+      n++;
+    }
+
+  res = f;
+  if (n > 0)
+    do
+      {
+	CUDD->reordered = 0;
+	res = lddPermuteInter (ldd, f, vars, terms, csts, n);
+      }
+    while (CUDD->reordered == 1);
+
+  for (i = 0; i < n; i++)
+    THEORY->destroy_term (terms [i]);
+  FREE (vars);
+  FREE (coeff);
+  FREE (terms);
+  FREE (csts);
+  return res;
+}
+
+/**
+   \brief Renames the constraints in the support of f, and rebuilds f.
+
+   \return the result (not referenced), or NULL if out of memory or
+   reordering took place
+ */
+static LddNode *
+lddPermuteInter (LddManager *ldd, LddNode *f, int *vars,
+		 linterm_t *terms, constant_t *csts, size_t n)
+{
+  LddNode **map, *res;
+  DdHashTable *table;
+  int *support;
+  int i, size, copy;
+
+  size = CUDD->size;
+  support = Cudd_SupportIndex (CUDD, f);
+  if (support == NULL) return NULL;
+
+  map = ALLOC (LddNode*, size);
+  if (map == NULL)
+    {
+      FREE (support);
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+  for (i = 0; i < size; i++)
+    map [i] = NULL;
+
+  /* the renamed literal of every constraint of f */
+  res = DD_ONE (CUDD);
+  for (i = 0; i < size && res != NULL; i++)
+    {
+      if (!support [i]) continue;
+      map [i] = THEORY->subst_vec (ldd, lddC (ldd, i), vars, terms, csts, n);
+      if (map [i] == NULL)
+	res = NULL;
+      else
+	cuddRef (map [i]);
+    }
+
+  if (res != NULL)
+    {
+      copy = lddMapIsCopy (ldd, CUDD, support, map, size);
+      table = cuddHashTableInit (CUDD, 1, 2);
+      if (table == NULL)
+	res = NULL;
+      else
+	{
+	  res = lddMapRecur (ldd, f, map, copy, table);
+	  if (res != NULL) cuddRef (res);
+	  cuddHashTableQuit (table);
+	}
+    }
+
+  for (i = 0; i < size; i++)
+    if (map [i] != NULL)
+      Cudd_IterDerefBdd (CUDD, map [i]);
+  FREE (map);
+  FREE (support);
+
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Checks whether the literals in map are positive and in the
+   same order as the DD variables of src they replace.
+
+   \param ldd the manager of the literals
+   \param src the manager of the replaced DD variables; may be the
+   CUDD manager of ldd
+   \param support the DD variables to check, indexed as map
+   \param size the size of support and map
+
+   \return 1 if lddMapRecur() can rebuild by a structural copy
+ */
+int
+lddMapIsCopy (LddManager *ldd, DdManager *src, int *support,
+	      LddNode **map, int size)
+{
+  int i, level, last;
+
+  last = -1;
+  for (level = 0; level < src->size; level++)
+    {
+      /* interning may have added variables, and moved the old ones */
+      i = src->invperm [level];
+      if (i >= size || !support [i]) continue;
+      if (Cudd_IsComplement (map [i]) || cuddIsConstant (map [i]) ||
+	  CUDD->perm [map [i]->index] <= last)
+	return 0;
+      last = CUDD->perm [map [i]->index];
+    }
+  return 1;
+}
+
+/**
+   \brief Rebuilds f in ldd with DD variable i replaced by map[i]. f
+   may belong to another manager. If copy is set (see lddMapIsCopy()),
+   nodes are created directly, otherwise they are combined with
+   lddIteRecur().
+
+   \return the result (not referenced), or NULL if out of memory or
+   reordering took place
+ */
+LddNode *
+lddMapRecur (LddManager *ldd, LddNode *f, LddNode **map, int copy,
+	     DdHashTable *table)
+{
+  LddNode *F, *t, *e, *res;
+
+  F = Cudd_Regular (f);
+  if (cuddIsConstant (F)) return Cudd_NotCond (DD_ONE (CUDD), f != F);
+
+  if (F->ref != 1 && ((res = cuddHashTableLookup1 (table, F)) != NULL))
+    return Cudd_NotCond (res, f != F);
+
+  t = lddMapRecur (ldd, cuddT (F), map, copy, table);
+  if (t == NULL) return NULL;
+  cuddRef (t);
+
+  e = lddMapRecur (ldd, cuddE (F), map, copy, table);
+  if (e == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, t);
+      return NULL;
+    }
+  cuddRef (e);
+
+  if (!copy)
+    res = lddIteRecur (ldd, map [F->index], t, e);
+  else if (t == e)
+    res = t;
+  else if (Cudd_IsComplement (t))
+    {
+      res = lddUniqueInter (ldd, map [F->index]->index,
+			    Cudd_Not (t), Cudd_Not (e));
+      res = Cudd_NotCond (res, res != NULL);
+    }
+  else
+    res = lddUniqueInter (ldd, map [F->index]->index, t, e);
+
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, t);
+  Cudd_IterDerefBdd (CUDD, e);
+  if (res == NULL) return NULL;
+
+  if (F->ref != 1)
+    {
+      ptrint fanout = (ptrint) F->ref;
+      cuddSatDec (fanout);
+      if (!cuddHashTableInsert1 (table, F, res, fanout))
+	{
+	  Cudd_IterDerefBdd (CUDD, res);
+	  return NULL;
+	}
+    }
+
+  cuddDeref (res);
+  return Cudd_NotCond (res, f != F);
+}
@@ -7,12 +7,43 @@
 #include <limits.h>
 
 
+/**
+ * Occurrences of variables in the support of an LDD, maintained
+ * incrementally while the LDD changes. Every internal node of the
+ * DAG is kept with the number of its references within the DAG, so
+ * that replacing the LDD only visits the nodes that are added and the
+ * nodes that are dropped.
+ */
+typedef struct occur_summary
+{
+  /** regular node -> number of references within the DAG */
+  st_table *nodes;
+  /** number of nodes of the DAG, by DD index. This is the support
+      passed to the elimination order */
+  int *idxCount;
+  size_t idxSize;
+  /** number of DD indices in the support, by term group */
+  int *termCount;
+  size_t termSize;
+  /** number of terms in the support that have a variable, by
+      variable. Same as computed by Ldd_SupportVarOccurrences() */
+  int *occur;
+  size_t occurSize;
+  /** number of reorderings when the nodes were counted. Reordering
+      rewrites nodes in place. */
+  int reorderings;
+} occur_summary_t;
+
+static int occur_init (LddManager *, occur_summary_t *, size_t);
+static void occur_quit (occur_summary_t *);
+static int occur_replace (LddManager *, occur_summary_t *, 
+			  LddNode *, LddNode *);
+
 /** multiple-variable eliminations strategy */
 static LddNode *drop_single_use_constraints (LddManager *,
 					      LddNode *, 
 					      int * , size_t, 
 					      int *, int *);
-static int choose_var_idx (int *, size_t , int *);
 
 
 /**
@@ -64,25 +95,36 @@ Ldd_MvExistAbstract (LddManager* ldd,
   LddNode * res;
 
   size_t t_vsize;
+  /* occurrences of variables in res */
+  occur_summary_t occur;
   int *occurlist;
   int *varlist;
   
   if (n == NULL) return n;
 
+  /* all variables in one pass */
+  if (ldd->existsAbstract == Ldd_ExistsAbstractBox)
+    return Ldd_MvExistAbstractBox (ldd, n, qvars, qsize);
+
   t_vsize = THEORY->num_of_vars (THEORY);
-  occurlist = ALLOC(int, t_vsize);
-  if (occurlist == NULL) return NULL;
+  if (!occur_init (ldd, &occur, t_vsize)) return NULL;
+  occurlist = occur.occur;
   varlist = ALLOC(int, t_vsize);
   if (varlist == NULL)
     {
-      FREE (occurlist);
+      occur_quit (&occur);
       return NULL;
     }
 
   res = n;
   cuddRef (res);
+  if (!occur_replace (ldd, &occur, NULL, res))
+    {
+      Cudd_IterDerefBdd (CUDD, res);
+      res = NULL;
+    }
   
-  while (1)
+  while (res != NULL)
     {
       /* itermediate result */
       LddNode * tmp;
@@ -92,9 +134,6 @@ Ldd_MvExistAbstract (LddManager* ldd,
       /* nothing left to eliminate, break out */
       if (Cudd_IsConstant (res)) break;
 
-      memset (occurlist, 0, sizeof (int) * t_vsize);
-      Ldd_SupportVarOccurrences (ldd, res, occurlist); 
-      
       memset (varlist, 0, sizeof (int) * t_vsize);
       tmp = drop_single_use_constraints (ldd, res, qvars, qsize,
       					 occurlist, varlist);
@@ -103,7 +142,8 @@ Ldd_MvExistAbstract (LddManager* ldd,
       if (tmp == NULL)
 	{
 	  Cudd_IterDerefBdd (CUDD, res);
-	  return NULL;
+	  res = NULL;
+	  break;
 	}
       cuddRef (tmp);
 
@@ -112,6 +152,11 @@ Ldd_MvExistAbstract (LddManager* ldd,
        */
       if (tmp != res)
 	{
+	  if (!occur_replace (ldd, &occur, res, tmp))
+	    {
+	      Cudd_IterDerefBdd (CUDD, tmp);
+	      tmp = NULL;
+	    }
 	  Cudd_IterDerefBdd (CUDD, res);
 	  res = tmp;
 	  tmp = NULL;
@@ -124,7 +169,7 @@ Ldd_MvExistAbstract (LddManager* ldd,
 	  tmp = NULL;
 	}
       
-      v = choose_var_idx (qvars, qsize, occurlist);
+      v = ldd->elimOrder (ldd, occur.idxCount, qvars, qsize, occurlist);
 
       /* no more variables to eliminate, break out */
       if (v < 0) break;
@@ -133,9 +178,15 @@ Ldd_MvExistAbstract (LddManager* ldd,
       if (tmp == NULL)
 	{
 	  Cudd_IterDerefBdd (CUDD, res);
-	  return NULL;
+	  res = NULL;
+	  break;
 	}
       cuddRef (tmp);
+      if (!occur_replace (ldd, &occur, res, tmp))
+	{
+	  Cudd_IterDerefBdd (CUDD, tmp);
+	  tmp = NULL;
+	}
       Cudd_IterDerefBdd (CUDD, res);
       res = tmp;
       
@@ -143,12 +194,274 @@ Ldd_MvExistAbstract (LddManager* ldd,
     }
 
   FREE (varlist);
-  FREE (occurlist);
+  occur_quit (&occur);
   
-  cuddDeref (res);
+  if (res != NULL) cuddDeref (res);
   return res;
 }
 
+/**
+   \brief Existentially quantifies out multiple variables from the
+   conjunction of two LDDs (relational product).
+
+   In theories where every term has one variable, all variables are
+   eliminated while the conjunction is computed. Otherwise, the
+   variable with the least number of occurrences in f and g is
+   eliminated by Fourier-Motzkin while the conjunction is computed,
+   and the rest by Ldd_MvExistAbstract() on the result. Eliminating
+   several variables during the conjunction is unsound when a
+   constraint has more than one of them.
+
+   \param ldd Ldd manager
+   \param f, g LDDs whose conjunction is quantified
+   \param qvars list of quantified variables
+   \param qsize the size of qvars
+
+   \sa Ldd_AndExistsAbstractFM(), Ldd_AndExistsAbstractBox()
+ */
+LddNode *
+Ldd_AndExistsAbstract (LddManager *ldd,
+		       LddNode *f,
+		       LddNode *g,
+		       int *qvars,
+		       size_t qsize)
+{
+  LddNode *res, *tmp;
+  int *occurlist;
+  int *rest;
+  size_t t_vsize, i, k;
+  int v;
+
+  if (f == NULL || g == NULL) return NULL;
+  
+  if (ldd->existsAbstract == Ldd_ExistsAbstractBox)
+    return Ldd_AndExistsAbstractBox (ldd, f, g, qvars, qsize);
+
+  t_vsize = THEORY->num_of_vars (THEORY);
+  occurlist = ALLOC(int, t_vsize);
+  rest = ALLOC(int, qsize + 1);
+  if (occurlist == NULL || rest == NULL)
+    {
+      FREE (occurlist);
+      FREE (rest);
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+  memset (occurlist, 0, sizeof (int) * t_vsize);
+  Ldd_SupportVarOccurrences (ldd, f, occurlist);
+  Ldd_SupportVarOccurrences (ldd, g, occurlist);
+
+  /* variables that occur in neither f nor g are not quantified */
+  for (i = 0, k = 0; i < qsize; i++)
+    if (qvars [i] >= 0 && (size_t) qvars [i] < t_vsize &&
+	occurlist [qvars [i]] > 0)
+      rest [k++] = qvars [i];
+
+  /* the order does not look at the support */
+  v = Ldd_ElimOrderMinOccur (ldd, NULL, rest, k, occurlist);
+  FREE (occurlist);
+
+  if (v < 0)
+    {
+      FREE (rest);
+      return Ldd_And (ldd, f, g);
+    }
+
+  res = Ldd_AndExistsAbstractFM (ldd, f, g, rest [v]);
+  if (res == NULL || k == 1)
+    {
+      FREE (rest);
+      return res;
+    }
+  cuddRef (res);
+  
+  rest [v] = rest [k - 1];
+  tmp = Ldd_MvExistAbstract (ldd, res, rest, k - 1);
+  FREE (rest);
+  if (tmp != NULL) cuddRef (tmp);
+  Cudd_IterDerefBdd (CUDD, res);
+  if (tmp != NULL) cuddDeref (tmp);
+  return tmp;
+}
+
+
+/**
+   \brief Allocates an empty summary with nvars variables.
+ */
+static int
+occur_init (LddManager *ldd, occur_summary_t *s, size_t nvars)
+{
+  s->nodes = st_init_table (st_ptrcmp, st_ptrhash);
+  s->idxCount = NULL;
+  s->idxSize = 0;
+  s->termCount = NULL;
+  s->termSize = 0;
+  s->occurSize = nvars;
+  s->occur = ALLOC(int, nvars);
+  s->reorderings = Cudd_ReadReorderings (CUDD);
+  if (s->nodes == NULL || s->occur == NULL)
+    {
+      occur_quit (s);
+      return 0;
+    }
+  memset (s->occur, 0, sizeof (int) * nvars);
+  return 1;
+}
+
+static void
+occur_quit (occur_summary_t *s)
+{
+  if (s->nodes != NULL) st_free_table (s->nodes);
+  s->nodes = NULL;
+  FREE (s->idxCount);
+  FREE (s->termCount);
+  FREE (s->occur);
+}
+
+/**
+   \brief Grows an array of counters to at least size elements, and
+   clears the new elements.
+ */
+static int
+occur_grow (int **a, size_t *asize, size_t size)
+{
+  int *na;
+
+  if (size <= *asize) return 1;
+  
+  na = REALLOC(int, *a, size);
+  if (na == NULL) return 0;
+  memset (na + *asize, 0, sizeof (int) * (size - *asize));
+  *a = na;
+  *asize = size;
+  return 1;
+}
+
+/**
+   \brief Adds delta to the number of nodes with DD index idx, and
+   updates the counts of terms and variables when idx enters or
+   leaves the support.
+ */
+static void
+occur_count_index (LddManager *ldd, occur_summary_t *s, 
+		   unsigned int idx, int delta)
+{
+  linterm_t t;
+  int g, i, n;
+
+  /* not a constraint */
+  if (lddC (ldd, idx) == NULL) return;
+
+  s->idxCount [idx] += delta;
+  if (s->idxCount [idx] != (delta > 0 ? 1 : 0)) return;
+
+  g = ldd->ddTerm [idx];
+  s->termCount [g] += delta;
+  if (s->termCount [g] != (delta > 0 ? 1 : 0)) return;
+  
+  t = THEORY->get_term (ldd->ddVars [idx]);
+  n = THEORY->term_size (t);
+  for (i = 0; i < n; i++)
+    {
+      int x = THEORY->term_get_var (t, i);
+      assert ((size_t) x < s->occurSize);
+      s->occur [x] += delta;
+    }
+}
+
+/**
+   \brief Adds a reference to N. If N is new to the DAG, counts it
+   and adds references to its children.
+ */
+static int
+occur_add (LddManager *ldd, occur_summary_t *s, LddNode *N)
+{
+  char **slot;
+  int r;
+
+  if (cuddIsConstant (N)) return 1;
+
+  r = st_find_or_add (s->nodes, (char*) N, &slot);
+  if (r == ST_OUT_OF_MEM) return 0;
+  if (r == 1)
+    {
+      *slot = (char*) ((ptrint) *slot + 1);
+      return 1;
+    }
+  *slot = (char*) (ptrint) 1;
+
+  occur_count_index (ldd, s, N->index, 1);
+  
+  return occur_add (ldd, s, cuddT (N)) && 
+    occur_add (ldd, s, Cudd_Regular (cuddE (N)));
+}
+
+/**
+   \brief Removes a reference to N. If it was the last one, N leaves
+   the DAG and references to its children are removed.
+ */
+static void
+occur_remove (LddManager *ldd, occur_summary_t *s, LddNode *N)
+{
+  char **slot;
+  ptrint count;
+
+  if (cuddIsConstant (N)) return;
+
+  if (!st_find (s->nodes, (char*) N, &slot)) 
+    {
+      assert (0 && "node is not in the summary");
+      return;
+    }
+  count = (ptrint) *slot - 1;
+  if (count > 0)
+    {
+      *slot = (char*) count;
+      return;
+    }
+  st_delete (s->nodes, &N, NULL);
+
+  occur_count_index (ldd, s, N->index, -1);
+
+  occur_remove (ldd, s, cuddT (N));
+  occur_remove (ldd, s, Cudd_Regular (cuddE (N)));
+}
+
+/**
+   \brief Updates the summary of f to be the summary of g. f must be
+   alive. If f is NULL, the summary must be empty.
+
+   \return 1 if successful; 0 if out of memory
+ */
+static int
+occur_replace (LddManager *ldd, occur_summary_t *s, LddNode *f, LddNode *g)
+{
+  /* new constraints and terms may have been created */
+  if (!occur_grow (&s->idxCount, &s->idxSize, 
+		   ddMax (ldd->varsSize, (size_t) CUDD->size)) ||
+      !occur_grow (&s->termCount, &s->termSize, ldd->numTerms))
+    return 0;
+
+  /* nodes of f may have been rewritten, start over */
+  if (Cudd_ReadReorderings (CUDD) != s->reorderings)
+    {
+      st_free_table (s->nodes);
+      s->nodes = st_init_table (st_ptrcmp, st_ptrhash);
+      if (s->nodes == NULL) return 0;
+      memset (s->idxCount, 0, sizeof (int) * s->idxSize);
+      memset (s->termCount, 0, sizeof (int) * s->termSize);
+      memset (s->occur, 0, sizeof (int) * s->occurSize);
+      s->reorderings = Cudd_ReadReorderings (CUDD);
+      f = NULL;
+    }
+
+  /* add first, so that nodes shared by f and g stay */
+  if (!occur_add (ldd, s, Cudd_Regular (g))) return 0;
+  if (f != NULL) 
+    occur_remove (ldd, s, Cudd_Regular (f));
+  return 1;
+}
+
 
 /**
    \brief Drops all single-use constraints by Boolean existential
@@ -182,19 +495,34 @@ drop_single_use_constraints (LddManager *ldd,
 }
 
 /**
-   \brief A heuristic to pick a variable to be quantified out next
+   \brief Picks the quantified variable with the least number of
+   occurrences. This is the default elimination order of
+   Ldd_MvExistAbstract().
 
-   \sa Ldd_MvExistAbstract()
+   An elimination order is called with the support of the current LDD
+   (nonzero for the DD indices of constraints in the support, with at
+   least Cudd_ReadSize() entries), the quantified variables, and the
+   number of terms in the support that have each variable (see
+   Ldd_SupportVarOccurrences()).
+
+   \return an index into qvars, or -1 if no quantified variable
+   occurs
+   
+   \sa Ldd_SetElimOrder(), Ldd_MvExistAbstract()
  */
-static int 
-choose_var_idx (int * qvars, 
-		size_t qsize, 
-		int *occurlist)
+int
+Ldd_ElimOrderMinOccur (LddManager *ldd,
+		       int *support,
+		       int *qvars,
+		       size_t qsize,
+		       int *occurlist)
 {
   int res = -1;
   int min = INT_MAX;
   size_t i;
 
+  (void) ldd;
+  (void) support;
   
   /* pick a varialbe with the least number of occurrences */
   for (i = 0; i < qsize; i++)
@@ -213,3 +541,290 @@ choose_var_idx (int * qvars,
 
   return res;
 }
+
+/**
+   \brief Picks the quantified variable whose Fourier-Motzkin
+   elimination is estimated to add the fewest constraints.
+
+   Both polarities of a constraint occur in an LDD, so any two
+   constraints on a variable x with different terms may be resolved,
+   while constraints with the same term only give constants. If the
+   support has c_1, ..., c_k constraints for the terms with x, the
+   estimate is the sum of c_i*c_j for i < j, less the c_1 + ... + c_k
+   constraints that are removed. Ties are broken by the number of
+   occurrences. Falls back to Ldd_ElimOrderMinOccur() if out of
+   memory.
+
+   \sa Ldd_ElimOrderMinOccur()
+ */
+int
+Ldd_ElimOrderMinResolvents (LddManager *ldd,
+			    int *support,
+			    int *qvars,
+			    size_t qsize,
+			    int *occurlist)
+{
+  size_t nvars, i;
+  /* sum of c_i and of c_i^2 for the terms with a variable */
+  long long *sum, *sumsq;
+  /* constraints in the support, and a DD index, by term group */
+  int *count, *rep;
+  int res = -1;
+  long long min = 0;
+  int idx, g;
+
+  nvars = THEORY->num_of_vars (THEORY);
+  sum = ALLOC(long long, nvars);
+  sumsq = ALLOC(long long, nvars);
+  count = ALLOC(int, ldd->numTerms + 1);
+  rep = ALLOC(int, ldd->numTerms + 1);
+  if (sum == NULL || sumsq == NULL || count == NULL || rep == NULL)
+    {
+      FREE (sum);
+      FREE (sumsq);
+      FREE (count);
+      FREE (rep);
+      return Ldd_ElimOrderMinOccur (ldd, support, qvars, qsize, occurlist);
+    }
+  memset (sum, 0, sizeof (long long) * nvars);
+  memset (sumsq, 0, sizeof (long long) * nvars);
+  memset (count, 0, sizeof (int) * (ldd->numTerms + 1));
+
+  for (idx = 0; idx < CUDD->size; idx++)
+    {
+      if (support [idx] == 0 || lddC (ldd, idx) == NULL) continue;
+      count [ldd->ddTerm [idx]]++;
+      rep [ldd->ddTerm [idx]] = idx;
+    }
+
+  for (g = 0; g < ldd->numTerms; g++)
+    {
+      linterm_t t;
+      int k, n;
+
+      if (count [g] == 0) continue;
+      
+      t = THEORY->get_term (lddC (ldd, rep [g]));
+      n = THEORY->term_size (t);
+      for (k = 0; k < n; k++)
+	{
+	  int x = THEORY->term_get_var (t, k);
+	  sum [x] += count [g];
+	  sumsq [x] += (long long) count [g] * count [g];
+	}
+    }
+
+  for (i = 0; i < qsize; i++)
+    {
+      int v;
+      long long cost;
+      
+      v = qvars [i];
+      if (occurlist [v] <= 0) continue;
+
+      cost = (sum [v] * sum [v] - sumsq [v]) / 2 - sum [v];
+      if (res < 0 || cost < min ||
+	  (cost == min && occurlist [v] <= occurlist [qvars [res]]))
+	{
+	  res = i;
+	  min = cost;
+	}
+    }
+
+  FREE (sum);
+  FREE (sumsq);
+  FREE (count);
+  FREE (rep);
+  return res;
+}
+
+static int
+int_cmp (const void *a, const void *b)
+{
+  return *(const int*) a - *(const int*) b;
+}
+
+/**
+   \brief Picks the quantified variable with the least fill on the
+   interaction graph of the support: variables are adjacent if they
+   occur in the same term, and the fill of a variable is the number of
+   pairs of its neighbours that are not adjacent. Ties are broken by
+   the number of occurrences. Falls back to Ldd_ElimOrderMinOccur() if
+   out of memory.
+
+   \sa Ldd_ElimOrderMinOccur()
+ */
+int
+Ldd_ElimOrderMinFill (LddManager *ldd,
+		      int *support,
+		      int *qvars,
+		      size_t qsize,
+		      int *occurlist)
+{
+  size_t nvars, i;
+  /* adjacency lists of the interaction graph */
+  int **adj;
+  int *adjSize, *adjCap;
+  /* term groups already added to the graph */
+  char *seen;
+  int res = -1;
+  long min = 0;
+  int idx, ok;
+
+  nvars = THEORY->num_of_vars (THEORY);
+  adj = ALLOC(int*, nvars);
+  adjSize = ALLOC(int, nvars);
+  adjCap = ALLOC(int, nvars);
+  seen = ALLOC(char, ldd->numTerms + 1);
+  ok = adj != NULL && adjSize != NULL && adjCap != NULL && seen != NULL;
+  if (ok)
+    {
+      memset (adj, 0, sizeof (int*) * nvars);
+      memset (adjSize, 0, sizeof (int) * nvars);
+      memset (adjCap, 0, sizeof (int) * nvars);
+      memset (seen, 0, ldd->numTerms + 1);
+    }
+
+  /* every pair of variables of a term is an edge */
+  for (idx = 0; ok && idx < CUDD->size; idx++)
+    {
+      lincons_t l;
+      linterm_t t;
+      int j, k, n;
+
+      if (support [idx] == 0 || (l = lddC (ldd, idx)) == NULL) continue;
+      if (seen [ldd->ddTerm [idx]]) continue;
+      seen [ldd->ddTerm [idx]] = 1;
+      
+      t = THEORY->get_term (l);
+      n = THEORY->term_size (t);
+      for (j = 0; ok && j < n; j++)
+	for (k = 0; ok && k < n; k++)
+	  {
+	    int x = THEORY->term_get_var (t, j);
+	    
+	    if (j == k) continue;
+	    if (adjSize [x] == adjCap [x])
+	      {
+		int *a;
+		adjCap [x] = adjCap [x] == 0 ? 4 : 2 * adjCap [x];
+		a = REALLOC(int, adj [x], adjCap [x]);
+		if (a == NULL)
+		  {
+		    ok = 0;
+		    break;
+		  }
+		adj [x] = a;
+	      }
+	    adj [x][adjSize [x]++] = THEORY->term_get_var (t, k);
+	  }
+    }
+
+  /* sort and remove duplicates */
+  for (i = 0; ok && i < nvars; i++)
+    {
+      int j, n;
+
+      if (adjSize [i] == 0) continue;
+      qsort (adj [i], adjSize [i], sizeof (int), int_cmp);
+      for (j = 1, n = 1; j < adjSize [i]; j++)
+	if (adj [i][j] != adj [i][n - 1])
+	  adj [i][n++] = adj [i][j];
+      adjSize [i] = n;
+    }
+
+  for (i = 0; ok && i < qsize; i++)
+    {
+      int v, j, k;
+      long fill;
+      
+      v = qvars [i];
+      if (occurlist [v] <= 0) continue;
+
+      fill = 0;
+      for (j = 0; j < adjSize [v]; j++)
+	for (k = j + 1; k < adjSize [v]; k++)
+	  {
+	    int x = adj [v][j];
+	    int y = adj [v][k];
+	    if (bsearch (&y, adj [x], adjSize [x], sizeof (int), 
+			 int_cmp) == NULL)
+	      fill++;
+	  }
+
+      if (res < 0 || fill < min ||
+	  (fill == min && occurlist [v] <= occurlist [qvars [res]]))
+	{
+	  res = i;
+	  min = fill;
+	}
+    }
+
+  if (adj != NULL)
+    for (i = 0; i < nvars; i++)
+      FREE (adj [i]);
+  FREE (adj);
+  FREE (adjSize);
+  FREE (adjCap);
+  FREE (seen);
+
+  if (!ok) 
+    return Ldd_ElimOrderMinOccur (ldd, support, qvars, qsize, occurlist);
+  return res;
+}
+
+/**
+   \brief Picks a quantified variable that only occurs in constraints
+   on one variable, if there is one, and otherwise defers to
+   Ldd_ElimOrderMinOccur(). Eliminating such a variable creates no
+   resolvents.
+
+   \sa Ldd_ElimOrderMinOccur()
+ */
+int
+Ldd_ElimOrderBoxFirst (LddManager *ldd,
+		       int *support,
+		       int *qvars,
+		       size_t qsize,
+		       int *occurlist)
+{
+  size_t nvars, i;
+  /* nonzero if a variable occurs in a term with other variables */
+  char *shared;
+  int res = -1;
+  int idx;
+
+  nvars = THEORY->num_of_vars (THEORY);
+  shared = ALLOC(char, nvars);
+  if (shared == NULL)
+    return Ldd_ElimOrderMinOccur (ldd, support, qvars, qsize, occurlist);
+  memset (shared, 0, nvars);
+
+  for (idx = 0; idx < CUDD->size; idx++)
+    {
+      lincons_t l;
+      linterm_t t;
+      int k, n;
+
+      if (support [idx] == 0 || (l = lddC (ldd, idx)) == NULL) continue;
+      
+      t = THEORY->get_term (l);
+      n = THEORY->term_size (t);
+      if (n < 2) continue;
+      for (k = 0; k < n; k++)
+	shared [THEORY->term_get_var (t, k)] = 1;
+    }
+
+  for (i = 0; i < qsize; i++)
+    {
+      int v = qvars [i];
+      
+      if (occurlist [v] <= 0 || shared [v]) continue;
+      if (res < 0 || occurlist [v] <= occurlist [qvars [res]])
+	res = i;
+    }
+  FREE (shared);
+
+  if (res >= 0) return res;
+  return Ldd_ElimOrderMinOccur (ldd, support, qvars, qsize, occurlist);
+}
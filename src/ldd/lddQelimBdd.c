@@ -19,6 +19,392 @@ Ldd_BddExistAbstract (LddManager * ldd,
 }
 
 
+/**
+ * \brief Existentially quantifies out the variables in qvars from an
+ * LDD over a theory in which every term has one variable (see
+ * theory_t::is_box).
+ *
+ * In such a theory, constraints on different variables are
+ * independent, and the constraints on one variable are kept
+ * consistent along every path of an LDD. Thus, dropping all
+ * constraints on the quantified variables in one BDD-style pass is
+ * exact.
+ *
+ * \sa Ldd_ExistsAbstractBox(), Ldd_MvExistAbstract()
+ */
+LddNode *
+Ldd_MvExistAbstractBox (LddManager *ldd,
+			LddNode *f,
+			int *qvars,
+			size_t qsize)
+{
+  LddNode *res;
+  DdHashTable *table;
+  bool *vars;
+  uint64_t mask;
+  size_t nvars, i;
+
+  nvars = THEORY->num_of_vars (THEORY);
+  vars = ALLOC(bool, nvars);
+  if (vars == NULL)
+    {
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+  memset (vars, 0, sizeof (bool) * nvars);
+
+  /* variables the theory does not know do not occur in f */
+  mask = 0;
+  for (i = 0; i < qsize; i++)
+    if (qvars [i] >= 0 && (size_t) qvars [i] < nvars)
+      {
+	vars [qvars [i]] = 1;
+	mask |= LDD_VAR_BIT (qvars [i]);
+      }
+
+  if (mask == 0) 
+    {
+      FREE (vars);
+      return f;
+    }
+
+  do
+    {
+      CUDD->reordered = 0;
+      table = cuddHashTableInit (CUDD, 1, 2);
+      if (table == NULL)
+	{
+	  res = NULL;
+	  break;
+	}
+      
+      res = lddBoxExistAbstractRecur (ldd, f, vars, mask, table);
+      if (res != NULL)
+	cuddRef (res);
+      cuddHashTableQuit (table);
+    }
+  while (CUDD->reordered == 1);
+
+  FREE (vars);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+ * \brief Existentially quantifies out a variable from an LDD over a
+ * theory in which every term has one variable. This is the default
+ * strategy of a manager over such a theory.
+ *
+ * \sa Ldd_MvExistAbstractBox(), Ldd_SetExistsAbstract()
+ */
+LddNode *
+Ldd_ExistsAbstractBox (LddManager *ldd,
+		       LddNode *f,
+		       int var)
+{
+  return Ldd_MvExistAbstractBox (ldd, f, &var, 1);
+}
+
+/**
+ * \brief Recursive step of Ldd_MvExistAbstractBox. 
+
+   vars is indexed by theory variables, and mask is the union of
+   LDD_VAR_BIT of the quantified variables. Based on
+   lddBddExistAbstractRecur, deciding whether a node is quantified by
+   its variables instead of a cube.
+ */
+LddNode *
+lddBoxExistAbstractRecur (LddManager *ldd,
+			  LddNode *f,
+			  bool *vars,
+			  uint64_t mask,
+			  DdHashTable *table)
+{
+  LddNode *F, *T, *E, *res, *res1, *res2, *one;
+  int elim;
+
+  one = DD_ONE (CUDD);
+  F = Cudd_Regular (f);
+
+  if (F == one) return f;
+
+  /* the results for f and for its negation are not related, use f as
+     the key */
+  if (F->ref != 1 && (res = cuddHashTableLookup1 (table, f)) != NULL)
+    return res;
+
+  /* the constraint has a quantified variable. Bits below 63 are
+     exact */
+  elim = (ldd->ddVarMask [F->index] & mask) != 0 &&
+    ((mask & LDD_VAR_BIT (63)) == 0 ||
+     THEORY->term_has_vars (THEORY->get_term (lddC (ldd, F->index)), vars));
+
+  T = cuddT (F);
+  E = cuddE (F);
+  if (f != F)
+    {
+      T = Cudd_Not (T);
+      E = Cudd_Not (E);
+    }
+
+  if (elim && (T == one || E == one || T == Cudd_Not (E)))
+    return one;
+  
+  res1 = lddBoxExistAbstractRecur (ldd, T, vars, mask, table);
+  if (res1 == NULL) return NULL;
+  cuddRef (res1);
+
+  if (elim && res1 == one)
+    {
+      res = one;
+      cuddRef (res);
+    }
+  else
+    {
+      res2 = lddBoxExistAbstractRecur (ldd, E, vars, mask, table);
+      if (res2 == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, res1);
+	  return NULL;
+	}
+      cuddRef (res2);
+      
+      if (elim)
+	{
+	  res = lddAndRecur (ldd, Cudd_Not (res1), Cudd_Not (res2));
+	  res = Cudd_NotCond (res, res != NULL);
+	}
+      else
+	res = lddIteRecur (ldd, CUDD->vars [F->index], res1, res2);
+      
+      if (res == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, res1);
+	  Cudd_IterDerefBdd (CUDD, res2);
+	  return NULL;
+	}
+      cuddRef (res);
+      Cudd_IterDerefBdd (CUDD, res2);
+    }
+  Cudd_IterDerefBdd (CUDD, res1);
+
+  if (F->ref != 1)
+    {
+      ptrint fanout = (ptrint) F->ref;
+      cuddSatDec (fanout);
+      if (!cuddHashTableInsert1 (table, f, res, fanout))
+	{
+	  Cudd_IterDerefBdd (CUDD, res);
+	  return NULL;
+	}
+    }
+  
+  cuddDeref (res);
+  return res;
+}
+
+/**
+ * \brief Existentially quantifies out the variables in qvars from the
+ * conjunction of f and g, without constructing the conjunction, in a
+ * theory in which every term has one variable.
+ *
+ * \sa Ldd_MvExistAbstractBox(), Ldd_AndExistsAbstract()
+ */
+LddNode *
+Ldd_AndExistsAbstractBox (LddManager *ldd,
+			  LddNode *f,
+			  LddNode *g,
+			  int *qvars,
+			  size_t qsize)
+{
+  LddNode *res;
+  DdHashTable *table;
+  bool *vars;
+  uint64_t mask;
+  size_t nvars, i;
+
+  nvars = THEORY->num_of_vars (THEORY);
+  vars = ALLOC(bool, nvars);
+  if (vars == NULL)
+    {
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+  memset (vars, 0, sizeof (bool) * nvars);
+
+  mask = 0;
+  for (i = 0; i < qsize; i++)
+    if (qvars [i] >= 0 && (size_t) qvars [i] < nvars)
+      {
+	vars [qvars [i]] = 1;
+	mask |= LDD_VAR_BIT (qvars [i]);
+      }
+
+  do
+    {
+      CUDD->reordered = 0;
+      table = cuddHashTableInit (CUDD, 2, 2);
+      if (table == NULL)
+	{
+	  res = NULL;
+	  break;
+	}
+      
+      res = lddBoxAndExistAbstractRecur (ldd, f, g, vars, mask, table);
+      if (res != NULL)
+	cuddRef (res);
+      cuddHashTableQuit (table);
+    }
+  while (CUDD->reordered == 1);
+
+  FREE (vars);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+/**
+ * \brief Recursive step of Ldd_AndExistsAbstractBox. 
+
+   Follows lddAndRecur(), and drops the root constraint when it has a
+   quantified variable, like lddBoxExistAbstractRecur(). One operand
+   may be the one constant.
+ */
+LddNode *
+lddBoxAndExistAbstractRecur (LddManager *ldd,
+			     LddNode *f,
+			     LddNode *g,
+			     bool *vars,
+			     uint64_t mask,
+			     DdHashTable *table)
+{
+  DdManager *manager;
+  LddNode *F, *G, *fv, *fnv, *gv, *gnv;
+  LddNode *one, *zero, *res, *res1, *res2;
+  int topf, topg;
+  unsigned int index;
+  int elim;
+
+  manager = CUDD;
+  one = DD_ONE (manager);
+  zero = Cudd_Not (one);
+
+  /* terminal cases */
+  F = Cudd_Regular (f);
+  G = Cudd_Regular (g);
+  if (f == zero || g == zero) return zero;
+  if (F == G)
+    {
+      if (f != g) return zero;
+      g = one;
+      G = one;
+    }
+  if (f == one && g == one) return one;
+  
+  if (f > g)
+    {
+      LddNode *tmp = f;
+      f = g;
+      g = tmp;
+      F = Cudd_Regular (f);
+      G = Cudd_Regular (g);
+    }
+
+  if ((F->ref != 1 || G->ref != 1) &&
+      (res = cuddHashTableLookup2 (table, f, g)) != NULL)
+    return res;
+
+  /* compute cofactors, as in lddAndRecur */
+  topf = cuddI (manager, F->index);
+  topg = cuddI (manager, G->index);
+
+  if (topf <= topg)
+    {
+      index = F->index;
+      fv = Cudd_NotCond (cuddT (F), f != F);
+      fnv = Cudd_NotCond (cuddE (F), f != F);
+    }
+  else
+    {
+      index = G->index;
+      fv = fnv = f;
+    }
+
+  if (topg <= topf)
+    {
+      gv = Cudd_NotCond (cuddT (G), g != G);
+      gnv = Cudd_NotCond (cuddE (G), g != G);
+    }
+  else
+    gv = gnv = g;
+
+  if (gv == g)
+    {
+      if (G != one && lddIsStronger (ldd, index, G->index))
+	gv = Cudd_NotCond (cuddT (G), g != G);
+    }
+  else if (fv == f)
+    {
+      if (F != one && lddIsStronger (ldd, index, F->index))
+	fv = Cudd_NotCond (cuddT (F), f != F);
+    }
+
+  elim = (ldd->ddVarMask [index] & mask) != 0 &&
+    ((mask & LDD_VAR_BIT (63)) == 0 ||
+     THEORY->term_has_vars (THEORY->get_term (lddC (ldd, index)), vars));
+
+  res1 = lddBoxAndExistAbstractRecur (ldd, fv, gv, vars, mask, table);
+  if (res1 == NULL) return NULL;
+  cuddRef (res1);
+
+  if (elim && res1 == one)
+    {
+      res = one;
+      cuddRef (res);
+    }
+  else
+    {
+      res2 = lddBoxAndExistAbstractRecur (ldd, fnv, gnv, vars, mask, table);
+      if (res2 == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, res1);
+	  return NULL;
+	}
+      cuddRef (res2);
+      
+      if (elim)
+	{
+	  res = lddAndRecur (ldd, Cudd_Not (res1), Cudd_Not (res2));
+	  res = Cudd_NotCond (res, res != NULL);
+	}
+      else
+	res = lddIteRecur (ldd, manager->vars [index], res1, res2);
+      
+      if (res == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, res1);
+	  Cudd_IterDerefBdd (manager, res2);
+	  return NULL;
+	}
+      cuddRef (res);
+      Cudd_IterDerefBdd (manager, res2);
+    }
+  Cudd_IterDerefBdd (manager, res1);
+
+  if (F->ref != 1 || G->ref != 1)
+    {
+      ptrint fanout = (ptrint) ddMax (F->ref, G->ref);
+      cuddSatDec (fanout);
+      if (!cuddHashTableInsert2 (table, f, g, res, fanout))
+	{
+	  Cudd_IterDerefBdd (manager, res);
+	  return NULL;
+	}
+    }
+  
+  cuddDeref (res);
+  return res;
+}
+
 /**
  * \brief Over-approximates existential quantification of all
   variables in Boolean array vars by eliminating all terms with those
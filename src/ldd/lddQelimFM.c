@@ -13,24 +13,69 @@ Ldd_ExistsAbstractFM (LddManager * ldd,
 		      int var)
 {
   LddNode *res;
-  DdLocalCache *cache;
+  LddNode *tag;
 
+  /* all intermediate constraints are released at the end */
+  if (THEORY->scratch_begin != NULL)
+    THEORY->scratch_begin (THEORY);
+
+  do 
+    {
+      CUDD->reordered = 0;
+
+      tag = lddCacheTag (ldd, LDD_FM_TAG, var);
+      if (tag == NULL) 
+	{
+	  res = NULL;
+	  break;
+	}
+      
+      res = lddExistsAbstractFMRecur (ldd, f, var, tag);
+    } while (CUDD->reordered == 1);
   
+  if (THEORY->scratch_end != NULL)
+    THEORY->scratch_end (THEORY);
+
+  return res;
+}
+
+
+/**
+   \brief Existential quantification of var from the conjunction of f
+   and g using Fourier-Motzkin, without constructing the conjunction.
+
+   \sa Ldd_AndExistsAbstract(), Ldd_ExistsAbstractFM()
+ */
+LddNode *
+Ldd_AndExistsAbstractFM (LddManager * ldd,
+			 LddNode * f,
+			 LddNode * g,
+			 int var)
+{
+  LddNode *res;
+  LddNode *tag, *fmTag;
+
+  /* all intermediate constraints are released at the end */
+  if (THEORY->scratch_begin != NULL)
+    THEORY->scratch_begin (THEORY);
 
   do 
     {
       CUDD->reordered = 0;
 
-      cache = cuddLocalCacheInit (CUDD, 1, 2, CUDD->maxCacheHard);
-      if (cache == NULL) return NULL;
+      tag = lddCacheTag (ldd, LDD_AND_EXISTS_TAG, var);
+      fmTag = lddCacheTag (ldd, LDD_FM_TAG, var);
+      if (tag == NULL || fmTag == NULL) 
+	{
+	  res = NULL;
+	  break;
+	}
       
-      res = lddExistsAbstractFMRecur (ldd, f, var, cache);
-      if (res != NULL)
-	cuddRef (res);
-      cuddLocalCacheQuit (cache);
+      res = lddAndExistsAbstractFMRecur (ldd, f, g, var, tag, fmTag);
     } while (CUDD->reordered == 1);
   
-  if (res != NULL) cuddDeref (res);
+  if (THEORY->scratch_end != NULL)
+    THEORY->scratch_end (THEORY);
 
   return res;
 }
@@ -48,21 +93,17 @@ Ldd_ExistsAbstractSFM (LddManager * ldd,
 		       int var)
 {
   LddNode *res;
-  DdLocalCache *cache;
+  LddNode *tag;
   
   do 
     {
       CUDD->reordered = 0;
-      cache = cuddLocalCacheInit (CUDD, 1, 2, CUDD->maxCacheHard);
-      if (cache == NULL) return NULL;
+      tag = lddCacheTag (ldd, LDD_SFM_TAG, var);
+      if (tag == NULL) return NULL;
       
-      res = lddExistsAbstractSFMRecur (ldd, f, var, cache);
-      if (res != NULL)
-	cuddRef (res);
-      cuddLocalCacheQuit (cache);
+      res = lddExistsAbstractSFMRecur (ldd, f, var, tag);
     } while (CUDD->reordered == 1);
   
-  if (res != NULL) cuddDeref (res);
   return res;
 }
 
@@ -88,21 +129,47 @@ Ldd_Resolve (LddManager * ldd,
 	     int var)
 {
   LddNode *res;
-  DdHashTable *table;
+  LddNode *tag;
+  /* the constraints as LDDs, the keys of the computed table */
+  LddNode *negLit, *posLit;
+
+  negLit = DD_ONE (CUDD);
+  posLit = DD_ONE (CUDD);
+  if (negCons != NULL)
+    {
+      negLit = THEORY->to_ldd (ldd, negCons);
+      if (negLit == NULL) return NULL;
+    }
+  cuddRef (negLit);
+  if (posCons != NULL)
+    {
+      posLit = THEORY->to_ldd (ldd, posCons);
+      if (posLit == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, negLit);
+	  return NULL;
+	}
+    }
+  cuddRef (posLit);
 
   do
     {
       CUDD->reordered = 0;
-      table = cuddHashTableInit (CUDD, 1, 2);
-      if (table == NULL) return NULL;
+      tag = lddCacheTag (ldd, LDD_RESOLVE_TAG, var);
+      if (tag == NULL) 
+	{
+	  res = NULL;
+	  break;
+	}
       
-      res = lddResolveRecur (ldd, f, t, negCons, posCons, var, table);
-      if (res != NULL)
-	cuddRef (res);
-      cuddHashTableQuit (table);
+      res = lddResolveRecur (ldd, f, t, negCons, posCons, var, 
+			     negLit, posLit, tag);
     } 
   while (CUDD->reordered == 1);
   
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, negLit);
+  Cudd_IterDerefBdd (CUDD, posLit);
   if (res != NULL) cuddDeref (res);
   return res;
 
@@ -129,13 +196,22 @@ Ldd_ResolveElim (LddManager * ldd, LddNode * f,
 		 linterm_t t, lincons_t cons, int var)
 {
   LddNode *res;
+  LddNode *lit;
+
+  lit = THEORY->to_ldd (ldd, cons);
+  if (lit == NULL) return NULL;
+  cuddRef (lit);
+
   do
     {
       CUDD->reordered = 0;
-      res = lddResolveElimInter (ldd, f, t, cons, var);
+      res = lddResolveElimInter (ldd, f, t, cons, lit, var);
     } 
   while (CUDD->reordered == 1);
   
+  if (res != NULL) cuddRef (res);
+  Cudd_IterDerefBdd (CUDD, lit);
+  if (res != NULL) cuddDeref (res);
   return res;
 
 }
@@ -143,7 +219,8 @@ Ldd_ResolveElim (LddManager * ldd, LddNode * f,
 
 
 /**
-   \brief DVO unaware version of Ldd_ResolveElim().
+   \brief DVO unaware version of Ldd_ResolveElim(). lit is the LDD of
+   cons.
 
  * \sa Ldd_ResolveElim()
  */
@@ -152,6 +229,7 @@ lddResolveElimInter (LddManager * ldd,
 		     LddNode * f, 
 		     linterm_t t, 
 		     lincons_t cons, 
+		     LddNode * lit,
 		     int var)
 {
   LddNode *res;
@@ -167,7 +245,9 @@ lddResolveElimInter (LddManager * ldd,
 				t, 
 				isNeg ? cons : NULL, 
 				isNeg ? NULL : cons, 
-				var);
+				var,
+				isNeg ? lit : DD_ONE (CUDD),
+				isNeg ? DD_ONE (CUDD) : lit);
   return res;
 }
 
@@ -177,8 +257,10 @@ lddResolveElimInter (LddManager * ldd,
    
  * Recursive part of Ldd_resolve. Resolves negCons and posCons with
  * LDD f.  t is the term of posCons and -t is the term of negCons. var
- * is the resolution variable. table is the hashtable to keep computed
- * results.
+ * is the resolution variable. negLit and posLit are the LDDs of
+ * negCons and posCons, or the one constant if the constraint is
+ * NULL. Together with tag, they key the results in the computed
+ * table.
  
  \sa lddResolveElimRecur()
  */
@@ -189,7 +271,9 @@ lddResolveRecur (LddManager * ldd,
 		   lincons_t negCons,
 		   lincons_t posCons,
 		   int var,
-		   DdHashTable *table)
+		   LddNode *negLit,
+		   LddNode *posLit,
+		   LddNode *tag)
 {
 
   DdNode *one, *zero;
@@ -231,7 +315,7 @@ lddResolveRecur (LddManager * ldd,
   if (negCons == NULL && posCons == NULL) return (f);
 
   /* check cache */
-  if (F->ref != 1 && ((res = cuddHashTableLookup1(table,f)) != NULL))
+  if ((res = lddCacheLookup (ldd, f, negLit, posLit, tag)) != NULL)
     return res;
 
 
@@ -249,13 +333,15 @@ lddResolveRecur (LddManager * ldd,
   fnv = Cudd_NotCond (fnv, f != F);
 
   /** recursive call */
-  T = lddResolveRecur (ldd, fv, t, negCons, posCons, var, table);
+  T = lddResolveRecur (ldd, fv, t, negCons, posCons, var, 
+		       negLit, posLit, tag);
 
   if (T == NULL) return NULL;
   cuddRef (T);
 
   /* recursive call */
-  E = lddResolveRecur (ldd, fnv, t, negCons, posCons, var, table);
+  E = lddResolveRecur (ldd, fnv, t, negCons, posCons, var, 
+		       negLit, posLit, tag);
 
   if (E == NULL) 
     {
@@ -404,17 +490,7 @@ lddResolveRecur (LddManager * ldd,
   E = NULL;
       
       
-  /* save result in a hashtable, but only if it will be needed */
-  if (F->ref != 1)
-    {
-      ptrint fanout = (ptrint) F->ref;
-      cuddSatDec (fanout);
-      if (!cuddHashTableInsert1 (table, f, res, fanout))
-	{
-	  Cudd_IterDerefBdd (manager, res);
-	  return NULL;
-	}
-    }
+  lddCacheInsert (ldd, f, negLit, posLit, tag, res);
 
   /* return the result */
   cuddDeref (res);
@@ -432,6 +508,8 @@ lddResolveRecur (LddManager * ldd,
    \param negCons   constraint being resolved with of the form -t <= k or NULL
    \param posCons   constraint being resolved with of the form t <= k or NULL
    \param var   variable being resolved on
+   \param negLit   the LDD of negCons, or the one constant
+   \param posLit   the LDD of posCons, or the one constant
 
  */
 LddNode *
@@ -440,7 +518,9 @@ lddResolveElimRecur (LddManager * ldd,
 		     linterm_t t,
 		     lincons_t negCons,
 		     lincons_t posCons,
-		     int var)
+		     int var,
+		     LddNode * negLit,
+		     LddNode * posLit)
 {
 
   DdManager * manager;
@@ -451,9 +531,12 @@ lddResolveElimRecur (LddManager * ldd,
   DdNode *fv, *fnv;
   unsigned int v;
 
-  /* constraint at the root of f */
+  /* constraint at the root of f, and its LDD */
   lincons_t vCons;
   linterm_t vTerm;
+  LddNode *vLit;
+
+  LddNode *tag;
 
   manager = CUDD;
   F = Cudd_Regular (f);
@@ -465,19 +548,11 @@ lddResolveElimRecur (LddManager * ldd,
   /* terminal case. upper bound cannot be overwritten. */
   if (posCons != NULL)
     {
-      DdHashTable *table;
-      LddNode * r;
-      
-      table = cuddHashTableInit (CUDD, 1, 2);
-      if (table == NULL) return NULL;
+      tag = lddCacheTag (ldd, LDD_RESOLVE_TAG, var);
+      if (tag == NULL) return NULL;
 
-      r = lddResolveRecur (ldd, f, t, negCons, posCons, var, table);
-
-      if (r != NULL) cuddRef (r);
-      cuddHashTableQuit (table);
-      if (r != NULL) cuddDeref (r);
-
-      return r;
+      return lddResolveRecur (ldd, f, t, negCons, posCons, var, 
+			      negLit, posLit, tag);
     }
   
 
@@ -494,24 +569,24 @@ lddResolveElimRecur (LddManager * ldd,
   /* terminal case. bounds cannot change. */
   if (!THEORY->term_equals (vTerm, t))
     {
-      DdHashTable* table;
-      LddNode * r;
-
-      table = cuddHashTableInit (CUDD, 1, 2);
-      if (table == NULL) return NULL;      
+      tag = lddCacheTag (ldd, LDD_RESOLVE_TAG, var);
+      if (tag == NULL) return NULL;
 
-      r = lddResolveRecur (ldd, f, t, negCons, posCons, var, table);
-
-      if (r != NULL) cuddRef (r);
-      cuddHashTableQuit (table);
-      if (r != NULL) cuddDeref (r);
-
-      return r;
+      return lddResolveRecur (ldd, f, t, negCons, posCons, var, 
+			      negLit, posLit, tag);
     }
   
   
 
   /* assert: vTerm == t */
+
+  /* check cache */
+  tag = lddCacheTag (ldd, LDD_RESOLVE_ELIM_TAG, var);
+  if (tag == NULL) return NULL;
+  if ((res = lddCacheLookup (ldd, f, negLit, posLit, tag)) != NULL)
+    return res;
+
+  vLit = Cudd_bddIthVar (manager, v);
   
   /* for the THEN branch let posCons = vCons.
      for the ELSE branch let negCons = negate (vCons), posCons = NULL
@@ -528,13 +603,14 @@ lddResolveElimRecur (LddManager * ldd,
 
 
   /** recursive call */
-  T = lddResolveElimRecur (ldd, fv, t, negCons, vCons, var);
+  T = lddResolveElimRecur (ldd, fv, t, negCons, vCons, var, negLit, vLit);
   if (T == NULL) return NULL;
   cuddRef (T);
   
   {
     lincons_t nvCons = THEORY->negate_cons (vCons);
-    E = lddResolveElimRecur (ldd, fnv, t, nvCons, (lincons_t)NULL, var);  
+    E = lddResolveElimRecur (ldd, fnv, t, nvCons, (lincons_t)NULL, var,
+			     Cudd_Not (vLit), DD_ONE (CUDD));
     THEORY->destroy_lincons (nvCons);
   }
   
@@ -560,6 +636,8 @@ lddResolveElimRecur (LddManager * ldd,
   Cudd_IterDerefBdd (manager, E);
   E = NULL;
 
+  lddCacheInsert (ldd, f, negLit, posLit, tag, res);
+
   /* return the result */
   cuddDeref (res);
 
@@ -574,7 +652,7 @@ LddNode *
 lddExistsAbstractFMRecur (LddManager * ldd, 
 			  LddNode * f, 
 			  int var, 
-			  DdLocalCache * cache)
+			  LddNode * tag)
 {
   DdNode *F, *T, *E;
   
@@ -582,6 +660,7 @@ lddExistsAbstractFMRecur (LddManager * ldd,
   
   lincons_t vCons;
   linterm_t vTerm;
+  LddNode *vLit;
   
   DdNode *fv, *fnv;
   unsigned int v;
@@ -600,7 +679,8 @@ lddExistsAbstractFMRecur (LddManager * ldd,
   if (F == DD_ONE(CUDD)) return f;
 
   /* check cache */
-  if (F->ref != 1 && ((res = cuddLocalCacheLookup (cache, &f)) != NULL))
+  if ((res = lddCacheLookup (ldd, f, DD_ONE (manager), DD_ONE (manager), 
+			     tag)) != NULL)
     return res;
 
 
@@ -608,6 +688,7 @@ lddExistsAbstractFMRecur (LddManager * ldd,
   v = F->index;
   vCons = ldd->ddVars [v];
   vTerm = THEORY->get_term (vCons);
+  vLit = Cudd_bddIthVar (manager, v);
   
   fv = cuddT (F);
   fnv = cuddE (F);
@@ -619,7 +700,7 @@ lddExistsAbstractFMRecur (LddManager * ldd,
      otherwise, top constraint is removed and propagated to children
      before recursing to children
   */
-  if (!THEORY->term_has_var (vTerm, var))
+  if (!lddHasVar (ldd, v, var))
     {
       /* keep the root constraint */
       fElimRoot = 0;
@@ -636,7 +717,7 @@ lddExistsAbstractFMRecur (LddManager * ldd,
       fElimRoot = 1;
 
       /* resolve root constraint with THEN branch */
-      tmp = lddResolveElimInter (ldd, fv, vTerm, vCons, var);
+      tmp = lddResolveElimInter (ldd, fv, vTerm, vCons, vLit, var);
       if (tmp == NULL)
 	{
 	  return NULL;
@@ -647,7 +728,8 @@ lddExistsAbstractFMRecur (LddManager * ldd,
       
       /* resolve negation of the root constraint with ELSE branch */
       nvCons = THEORY->negate_cons (vCons);
-      tmp = lddResolveElimInter (ldd, fnv, vTerm, nvCons, var);
+      tmp = lddResolveElimInter (ldd, fnv, vTerm, nvCons, Cudd_Not (vLit), 
+				 var);
       THEORY->destroy_lincons (nvCons);
       
       if (tmp == NULL)
@@ -661,7 +743,7 @@ lddExistsAbstractFMRecur (LddManager * ldd,
   
 
   /* recurse to THEN and ELSE branches*/
-  T = lddExistsAbstractFMRecur (ldd, fv, var, cache);
+  T = lddExistsAbstractFMRecur (ldd, fv, var, tag);
   if (T == NULL)
     {
       Cudd_IterDerefBdd (manager, fv);
@@ -672,7 +754,7 @@ lddExistsAbstractFMRecur (LddManager * ldd,
   Cudd_IterDerefBdd (manager, fv);
   fv = NULL;
   
-  E = lddExistsAbstractFMRecur (ldd, fnv, var, cache);
+  E = lddExistsAbstractFMRecur (ldd, fnv, var, tag);
   if (E == NULL)
     {
       Cudd_IterDerefBdd (manager, T);
@@ -727,8 +809,229 @@ lddExistsAbstractFMRecur (LddManager * ldd,
   Cudd_IterDerefBdd (manager, E);
   E = NULL;
 
-  if (F->ref != 1)
-    cuddLocalCacheInsert (cache, &f, res);
+  lddCacheInsert (ldd, f, DD_ONE (manager), DD_ONE (manager), tag, res);
+
+  cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Recursive part of Ldd_AndExistsAbstractFM(). tag keys the
+   results in the computed table, and fmTag the results of
+   lddExistsAbstractFMRecur() on var.
+
+   Follows lddAndRecur(). When the new root constraint has var, it is
+   resolved into the cofactors of both operands, like
+   lddExistsAbstractSFMRecur() does for a single LDD, and the results
+   of the two branches are joined. Constraints of the same term are
+   not eliminated with the root as in lddResolveElimRecur(): the
+   tightest bound on a path may come from the other operand.
+ */
+LddNode *
+lddAndExistsAbstractFMRecur (LddManager * ldd,
+			     LddNode * f,
+			     LddNode * g,
+			     int var,
+			     LddNode * tag,
+			     LddNode * fmTag)
+{
+  DdManager * manager;
+  DdNode *F, *fv, *fnv, *G, *gv, *gnv;
+  DdNode *one, *zero, *res, *T, *E;
+  unsigned int topf, topg, index;
+
+  manager = CUDD;
+  one = DD_ONE (manager);
+  zero = Cudd_Not (one);
+
+  /* terminal cases */
+  F = Cudd_Regular (f);
+  G = Cudd_Regular (g);
+  if (f == zero || g == zero) return zero;
+  if (F == G)
+    {
+      if (f == g) return lddExistsAbstractFMRecur (ldd, f, var, fmTag);
+      else return zero;
+    }
+  if (f == one) return lddExistsAbstractFMRecur (ldd, g, var, fmTag);
+  if (g == one) return lddExistsAbstractFMRecur (ldd, f, var, fmTag);
+
+  if (f > g)
+    {
+      DdNode *tmp = f;
+      f = g;
+      g = tmp;
+      F = Cudd_Regular (f);
+      G = Cudd_Regular (g);
+    }
+
+  /* check cache */
+  if ((res = lddCacheLookup (ldd, f, g, one, tag)) != NULL)
+    return res;
+
+  /* compute cofactors, as in lddAndRecur */
+  topf = manager->perm [F->index];
+  topg = manager->perm [G->index];
+
+  if (topf <= topg)
+    {
+      index = F->index;
+      fv = Cudd_NotCond (cuddT (F), f != F);
+      fnv = Cudd_NotCond (cuddE (F), f != F);
+    }
+  else
+    {
+      index = G->index;
+      fv = fnv = f;
+    }
+
+  if (topg <= topf)
+    {
+      gv = Cudd_NotCond (cuddT (G), g != G);
+      gnv = Cudd_NotCond (cuddE (G), g != G);
+    }
+  else
+    gv = gnv = g;
+
+  /* the root constraint implies the top constraint of the other
+     operand on the THEN branch */
+  if (gv == g)
+    {
+      if (lddIsStronger (ldd, index, G->index))
+	gv = Cudd_NotCond (cuddT (G), g != G);
+    }
+  else if (fv == f)
+    {
+      if (lddIsStronger (ldd, index, F->index))
+	fv = Cudd_NotCond (cuddT (F), f != F);
+    }
+
+  if (!lddHasVar (ldd, index, var))
+    {
+      DdNode *root;
+
+      T = lddAndExistsAbstractFMRecur (ldd, fv, gv, var, tag, fmTag);
+      if (T == NULL) return NULL;
+      cuddRef (T);
+
+      E = lddAndExistsAbstractFMRecur (ldd, fnv, gnv, var, tag, fmTag);
+      if (E == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, T);
+	  return NULL;
+	}
+      cuddRef (E);
+
+      root = Cudd_bddIthVar (manager, index);
+      if (root == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, T);
+	  Cudd_IterDerefBdd (manager, E);
+	  return NULL;
+	}
+      cuddRef (root);
+
+      res = lddIteRecur (ldd, root, T, E);
+      if (res == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, T);
+	  Cudd_IterDerefBdd (manager, E);
+	  Cudd_IterDerefBdd (manager, root);
+	  return NULL;
+	}
+      cuddRef (res);
+      Cudd_IterDerefBdd (manager, root);
+      Cudd_IterDerefBdd (manager, T);
+      Cudd_IterDerefBdd (manager, E);
+    }
+  else
+    {
+      lincons_t vCons, nvCons;
+      linterm_t vTerm;
+      LddNode *vLit, *a, *b, *resolveTag;
+
+      resolveTag = lddCacheTag (ldd, LDD_RESOLVE_TAG, var);
+      if (resolveTag == NULL) return NULL;
+
+      vCons = lddC (ldd, index);
+      vTerm = THEORY->get_term (vCons);
+      vLit = Cudd_bddIthVar (manager, index);
+
+      /* resolve the root constraint with the THEN branches */
+      a = lddResolveRecur (ldd, fv, vTerm, NULL, vCons, var, 
+			   one, vLit, resolveTag);
+      if (a == NULL) return NULL;
+      cuddRef (a);
+      b = lddResolveRecur (ldd, gv, vTerm, NULL, vCons, var, 
+			   one, vLit, resolveTag);
+      if (b == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, a);
+	  return NULL;
+	}
+      cuddRef (b);
+
+      T = lddAndExistsAbstractFMRecur (ldd, a, b, var, tag, fmTag);
+      if (T != NULL) cuddRef (T);
+      Cudd_IterDerefBdd (manager, a);
+      Cudd_IterDerefBdd (manager, b);
+      if (T == NULL) return NULL;
+
+      if (T == one)
+	{
+	  lddCacheInsert (ldd, f, g, one, tag, one);
+	  Cudd_IterDerefBdd (manager, T);
+	  return one;
+	}
+
+      /* resolve the negation of the root constraint with the ELSE
+	 branches */
+      nvCons = THEORY->negate_cons (vCons);
+      a = lddResolveRecur (ldd, fnv, vTerm, nvCons, NULL, var, 
+			   Cudd_Not (vLit), one, resolveTag);
+      if (a == NULL)
+	{
+	  THEORY->destroy_lincons (nvCons);
+	  Cudd_IterDerefBdd (manager, T);
+	  return NULL;
+	}
+      cuddRef (a);
+      b = lddResolveRecur (ldd, gnv, vTerm, nvCons, NULL, var, 
+			   Cudd_Not (vLit), one, resolveTag);
+      THEORY->destroy_lincons (nvCons);
+      if (b == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, a);
+	  Cudd_IterDerefBdd (manager, T);
+	  return NULL;
+	}
+      cuddRef (b);
+
+      E = lddAndExistsAbstractFMRecur (ldd, a, b, var, tag, fmTag);
+      if (E != NULL) cuddRef (E);
+      Cudd_IterDerefBdd (manager, a);
+      Cudd_IterDerefBdd (manager, b);
+      if (E == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, T);
+	  return NULL;
+	}
+
+      /* do an OR */
+      res = lddAndRecur (ldd, Cudd_Not (T), Cudd_Not (E));
+      if (res == NULL)
+	{
+	  Cudd_IterDerefBdd (manager, T);
+	  Cudd_IterDerefBdd (manager, E);
+	  return NULL;
+	}
+      res = Cudd_Not (res);
+      cuddRef (res);
+      Cudd_IterDerefBdd (manager, T);
+      Cudd_IterDerefBdd (manager, E);
+    }
+
+  lddCacheInsert (ldd, f, g, one, tag, res);
 
   cuddDeref (res);
   return res;
@@ -741,7 +1044,7 @@ LddNode *
 lddExistsAbstractSFMRecur (LddManager * ldd, 
 			     LddNode * f, 
 			     int var, 
-			  DdLocalCache * cache)
+			   LddNode * tag)
 {
   DdNode *F, *T, *E;
   
@@ -749,6 +1052,7 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
   
   lincons_t vCons;
   linterm_t vTerm;
+  LddNode *vLit;
   
   DdNode *fv, *fnv;
   unsigned int v;
@@ -767,7 +1071,8 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
   if (F == DD_ONE(CUDD)) return f;
 
   /* check cache */
-  if (F->ref != 1 && ((res = cuddLocalCacheLookup (cache, &f)) != NULL))
+  if ((res = lddCacheLookup (ldd, f, DD_ONE (manager), DD_ONE (manager), 
+			     tag)) != NULL)
     return res;
 
 
@@ -775,6 +1080,7 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
   v = F->index;
   vCons = lddC(ldd,v);
   vTerm = THEORY->get_term (vCons);
+  vLit = Cudd_bddIthVar (manager, v);
   
   fv = cuddT (F);
   fnv = cuddE (F);
@@ -786,7 +1092,7 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
      otherwise, top constraint is removed and propagated to children
      before recursing to children
   */
-  fElimRoot = THEORY->term_has_var (vTerm, var);
+  fElimRoot = lddHasVar (ldd, v, var);
   if (!fElimRoot)
     {
       /* keep the root constraint */
@@ -799,49 +1105,41 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
       DdNode *tmp;
       lincons_t nvCons;
       
-      DdHashTable * resolveTable;
+      LddNode *resolveTag;
 
-      resolveTable = cuddHashTableInit (CUDD, 1, 2);
-      if (resolveTable == NULL) return NULL;
+      resolveTag = lddCacheTag (ldd, LDD_RESOLVE_TAG, var);
+      if (resolveTag == NULL) return NULL;
 
       /* root constraint is eliminated */
 
       /* resolve root constraint with THEN branch */
-      tmp = lddResolveRecur (ldd, fv, vTerm, NULL, vCons, var, resolveTable);
-      if (tmp != NULL) cuddRef (tmp);
-      cuddHashTableQuit (resolveTable);
-      resolveTable = NULL;
+      tmp = lddResolveRecur (ldd, fv, vTerm, NULL, vCons, var, 
+			     DD_ONE (manager), vLit, resolveTag);
       if (tmp == NULL) return NULL;
+      cuddRef (tmp);
 
       fv = tmp;
       
       
       /* resolve negation of the root constraint with ELSE branch */
-      resolveTable = cuddHashTableInit (CUDD, 1, 2);
-      if (resolveTable == NULL)
-	{
-	  Cudd_IterDerefBdd (manager, fv);
-	  return NULL;
-	}
-      
       nvCons = THEORY->negate_cons (vCons);
       tmp = lddResolveRecur (ldd, fnv, vTerm, nvCons, NULL, 
-			       var, resolveTable);
+			     var, Cudd_Not (vLit), DD_ONE (manager), 
+			     resolveTag);
       THEORY->destroy_lincons (nvCons);
 
-      if (tmp != NULL) cuddRef (tmp);
-      cuddHashTableQuit (resolveTable);
       if (tmp == NULL)
 	{
 	  Cudd_IterDerefBdd (manager, fv);
 	  return NULL;
 	}
+      cuddRef (tmp);
       fnv = tmp;
     }
   
 
   /* recurse to THEN and ELSE branches*/
-  T = lddExistsAbstractSFMRecur (ldd, fv, var, cache);
+  T = lddExistsAbstractSFMRecur (ldd, fv, var, tag);
   if (T == NULL)
     {
       Cudd_IterDerefBdd (manager, fv);
@@ -852,7 +1150,7 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
   Cudd_IterDerefBdd (manager, fv);
   fv = NULL;
   
-  E = lddExistsAbstractSFMRecur (ldd, fnv, var, cache);
+  E = lddExistsAbstractSFMRecur (ldd, fnv, var, tag);
   if (E == NULL)
     {
       Cudd_IterDerefBdd (manager, T);
@@ -907,8 +1205,7 @@ lddExistsAbstractSFMRecur (LddManager * ldd,
   Cudd_IterDerefBdd (manager, E);
   E = NULL;
 
-  if (F->ref != 1)
-    cuddLocalCacheInsert (cache, &f, res);
+  lddCacheInsert (ldd, f, DD_ONE (manager), DD_ONE (manager), tag, res);
 
   cuddDeref (res);
   return res;
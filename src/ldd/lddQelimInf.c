@@ -22,6 +22,15 @@ lddSubstFnForVarRecur (LddManager *ldd,
 		       constant_t c,
 		       DdHashTable *table);
 
+static LddNode *
+lddVectorSubstRecur (LddManager *ldd,
+		     LddNode *f,
+		     int *occurs,
+		     int *vars,
+		     linterm_t *terms,
+		     constant_t *csts,
+		     size_t n,
+		     DdHashTable *table);
 
 
 LddNode *
@@ -30,21 +39,18 @@ Ldd_SubstNinfForVar (LddManager *ldd,
 		    int var)
 {
   LddNode *res;
-  DdHashTable *table;
+  LddNode *tag;
   
   do
     {
       CUDD->reordered = 0;
-      table = cuddHashTableInit (CUDD, 1, 2);
+      tag = lddCacheTag (ldd, LDD_SUBST_NINF_TAG, var);
+      if (tag == NULL) return NULL;
       
-      res = lddSubstNinfForVarRecur (ldd, f, var, table);
-      if (res != NULL)
-	cuddRef (res);
-      cuddHashTableQuit (table);
+      res = lddSubstNinfForVarRecur (ldd, f, var, tag);
     }
   while (CUDD->reordered == 1);
 
-  if (res != NULL) cuddDeref (res);
   return res;
 }
 
@@ -68,6 +74,86 @@ Ldd_SubstTermPlusForVar (LddManager *ldd,
 }
 
 
+/**
+   \brief Substitutes terms[i] + csts[i] for vars[i] in f, for all i <
+   n simultaneously, e.g., for the parallel assignment x, y := y, x.
+
+   Every constraint is rewritten once by theory_t::subst_vec, and the
+   diagram is rebuilt in a single pass. terms[i] and csts[i] may be
+   NULL. The variables in vars must be distinct.
+
+   \return the result if successful; NULL if out of memory, if the
+   theory has no subst_vec, or if a variable of vars is not a variable
+   of the theory
+
+   \sa Ldd_SubstTermForVar()
+ */
+LddNode *
+Ldd_VectorSubst (LddManager *ldd,
+		 LddNode *f,
+		 int *vars,
+		 linterm_t *terms,
+		 constant_t *csts,
+		 size_t n)
+{
+  LddNode *res;
+  DdHashTable *table;
+  int *occurs;
+  size_t i, nvars;
+
+  if (THEORY->subst_vec == NULL)
+    {
+      (void) fprintf (CUDD->err,
+		      "Ldd_VectorSubst: theory has no subst_vec\n");
+      CUDD->errorCode = CUDD_INVALID_ARG;
+      return NULL;
+    }
+
+  nvars = THEORY->num_of_vars (THEORY);
+  for (i = 0; i < n; i++)
+    if (vars [i] < 0 || (size_t) vars [i] >= nvars)
+      {
+	(void) fprintf (CUDD->err,
+			"Ldd_VectorSubst: variable %d out of range\n",
+			vars [i]);
+	CUDD->errorCode = CUDD_INVALID_ARG;
+	return NULL;
+      }
+
+  occurs = ALLOC (int, nvars);
+  if (occurs == NULL)
+    {
+      CUDD->errorCode = CUDD_MEMORY_OUT;
+      return NULL;
+    }
+  for (i = 0; i < nvars; i++)
+    occurs [i] = 0;
+  for (i = 0; i < n; i++)
+    occurs [vars [i]] = 1;
+
+  do
+    {
+      CUDD->reordered = 0;
+      table = cuddHashTableInit (CUDD, 1, 2);
+      if (table == NULL)
+	{
+	  res = NULL;
+	  break;
+	}
+
+      res = lddVectorSubstRecur (ldd, f, occurs, vars, terms, csts, n,
+				 table);
+      if (res != NULL)
+	cuddRef (res);
+      cuddHashTableQuit (table);
+    }
+  while (CUDD->reordered == 1);
+
+  FREE (occurs);
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
 static LddNode *
 lddSubstFnForVar (LddManager *ldd,
 		  LddNode *f,
@@ -194,7 +280,7 @@ LddNode *
 lddSubstNinfForVarRecur (LddManager * ldd, 
 			 LddNode * f, 
 			 int var, 
-			 DdHashTable *table)
+			 LddNode *tag)
 {
   DdNode *F;
   DdNode *res;
@@ -205,7 +291,8 @@ lddSubstNinfForVarRecur (LddManager * ldd,
   
   if (F == DD_ONE(CUDD)) return f;
 
-  if (F->ref != 1 && ((res = cuddHashTableLookup1 (table, F)) != NULL))
+  if ((res = lddCacheLookup (ldd, F, DD_ONE (CUDD), DD_ONE (CUDD), 
+			     tag)) != NULL)
     return Cudd_NotCond (res, f != F);
 
 
@@ -214,20 +301,20 @@ lddSubstNinfForVarRecur (LddManager * ldd,
   if (THEORY->term_has_var (THEORY->get_term (lCons), var))
     {
       if (THEORY->subst_ninf (ldd, lCons, var) == DD_ONE(CUDD))
-	res = lddSubstNinfForVarRecur (ldd, cuddT (F), var, table);
+	res = lddSubstNinfForVarRecur (ldd, cuddT (F), var, tag);
       else
-	res = lddSubstNinfForVarRecur (ldd, cuddE (F), var, table);
+	res = lddSubstNinfForVarRecur (ldd, cuddE (F), var, tag);
       if (res == NULL) return NULL;
       cuddRef (res);
     }
   else 
     {
       DdNode *t, *e;
-      t = lddSubstNinfForVarRecur (ldd, cuddT (F), var, table);
+      t = lddSubstNinfForVarRecur (ldd, cuddT (F), var, tag);
       if (t == NULL) return NULL;
       cuddRef (t);
       
-      e = lddSubstNinfForVarRecur (ldd, cuddE (F), var, table);
+      e = lddSubstNinfForVarRecur (ldd, cuddE (F), var, tag);
       if (e == NULL)
 	{
 	  Cudd_IterDerefBdd (CUDD, t);
@@ -268,16 +355,7 @@ lddSubstNinfForVarRecur (LddManager * ldd,
     }
   
   
-  if (F->ref != 1)
-    {
-      ptrint fanout = (ptrint) F->ref;
-      cuddSatDec (fanout);
-      if (!cuddHashTableInsert1 (table, F, res, fanout))
-	{
-	  Cudd_IterDerefBdd (CUDD, res);
-	  return NULL;
-	}
-    }
+  lddCacheInsert (ldd, F, DD_ONE (CUDD), DD_ONE (CUDD), tag, res);
 
   cuddDeref (res);
   return Cudd_NotCond (res, f != F);
@@ -382,3 +460,97 @@ lddSubstFnForVarRecur (LddManager *ldd,
   return Cudd_NotCond (res, f != F);
 }
 
+
+static LddNode *
+lddVectorSubstRecur (LddManager *ldd,
+		     LddNode *f,
+		     int *occurs,
+		     int *vars,
+		     linterm_t *terms,
+		     constant_t *csts,
+		     size_t n,
+		     DdHashTable *table)
+{
+  DdNode *F, *res, *one, *zero, *root, *fi, *t, *e;
+  lincons_t lCons;
+
+  one = DD_ONE(CUDD);
+  zero = Cudd_Not (one);
+
+  F = Cudd_Regular (f);
+  if (F == one) return f;
+
+  if (F->ref != 1 && ((res = cuddHashTableLookup1 (table, F)) != NULL))
+    return Cudd_NotCond (res, f != F);
+
+  lCons = lddC (ldd, F->index);
+  if (THEORY->term_has_vars (THEORY->get_term (lCons), occurs))
+    root = THEORY->subst_vec (ldd, lCons, vars, terms, csts, n);
+  else
+    root = Cudd_bddIthVar (CUDD, F->index);
+
+  if (root == NULL) return NULL;
+  cuddRef (root);
+
+  if (root == one || root == zero)
+    {
+      fi = root == one ? cuddT (F) : cuddE (F);
+      res = lddVectorSubstRecur (ldd, fi, occurs, vars, terms, csts, n,
+				 table);
+      if (res == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, root);
+	  return NULL;
+	}
+      cuddRef (res);
+    }
+  else
+    {
+      t = lddVectorSubstRecur (ldd, cuddT (F), occurs, vars, terms, csts,
+			       n, table);
+      if (t == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, root);
+	  return NULL;
+	}
+      cuddRef (t);
+
+      e = lddVectorSubstRecur (ldd, cuddE (F), occurs, vars, terms, csts,
+			       n, table);
+      if (e == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, root);
+	  Cudd_IterDerefBdd (CUDD, t);
+	  return NULL;
+	}
+      cuddRef (e);
+
+      res = lddIteRecur (ldd, root, t, e);
+      if (res == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, root);
+	  Cudd_IterDerefBdd (CUDD, t);
+	  Cudd_IterDerefBdd (CUDD, e);
+	  return NULL;
+	}
+      cuddRef (res);
+
+      Cudd_IterDerefBdd (CUDD, t);
+      Cudd_IterDerefBdd (CUDD, e);
+    }
+  Cudd_IterDerefBdd (CUDD, root);
+
+  if (F->ref != 1)
+    {
+      ptrint fanout = (ptrint) F->ref;
+      cuddSatDec (fanout);
+      if (!cuddHashTableInsert1 (table, F, res, fanout))
+	{
+	  Cudd_IterDerefBdd (CUDD, res);
+	  return NULL;
+	}
+    }
+
+  cuddDeref (res);
+  return Cudd_NotCond (res, f != F);
+}
@@ -116,6 +116,7 @@ lddExistAbstractPATRecur (LddManager * ldd,
 
   /* XXX uqly way to check for satisfiability */
   res = THEORY->qelim_solve (qelimCtx);
+  if (res == NULL) return NULL;
   if (res == zero) 
     {
 /*       printf ("EARLY TERMINATION:\n"); */
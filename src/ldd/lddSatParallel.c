@@ -0,0 +1,515 @@
+/**
+   Parallel satisfiability check of an LDD.
+
+   Ldd_IsSatParallel() expands the top levels of f into paths and hands
+   them out as tasks to worker threads. Every worker has its own qelim
+   context. The theory interface cannot copy a context, so a worker
+   brings its context to the start of a task by pushing the
+   constraints of the path, and then explores the rest of the diagram
+   as lddIsSatRecur() does. The first worker that finds a satisfiable
+   path cancels the others.
+
+   The workers only read the diagram, the constraints of the manager
+   and the theory. The negated constraints are created before the
+   workers start. Every worker runs its context over a private CUDD
+   manager, so that the constants returned by qelim_solve() are not
+   referenced concurrently. This requires that qelim_solve() creates
+   no nodes when all variables are quantified, as is the case for the
+   TVPI theories. The private managers are created and destroyed by
+   the calling thread, since Cudd_Init() is not reentrant. A result of
+   qelim_solve() that is not a constant is reported as an error.
+
+   Nodes with a known satisfiability are kept in a memo shared by the
+   workers. Its keys are fixed before the workers start, and its values
+   are read and written without locks. The calling thread fills it from
+   the computed table of CUDD, and records the nodes that the workers
+   found to be SAT back in the computed table when they are done.
+ */
+#include "util.h"
+#include "lddInt.h"
+
+#ifdef LDD_HAVE_THREADS
+#include <pthread.h>
+
+/* shared flags and counters of a job, see the build option
+   LDD_ENABLE_THREADS */
+#define LDD_ATOMIC_LOAD(p) __atomic_load_n ((p), __ATOMIC_RELAXED)
+#define LDD_ATOMIC_STORE(p, v) __atomic_store_n ((p), (v), __ATOMIC_RELAXED)
+#define LDD_ATOMIC_INC(p) __atomic_fetch_add ((p), 1, __ATOMIC_RELAXED)
+
+/* paths are at most this long */
+#define LDD_SAT_FORK_DEPTH 10
+/* tasks per thread, so that the threads are kept busy */
+#define LDD_SAT_TASKS 8
+
+/* values of the memo */
+#define LDD_SAT_UNKNOWN 0
+#define LDD_SAT_SAT 1
+#define LDD_SAT_UNSAT 2
+
+/* a path from the root to f */
+typedef struct lddSatTask
+{
+  LddNode *f;
+  int n;
+  /* literal i is (index << 1) | 1 if negated */
+  int lit [LDD_SAT_FORK_DEPTH];
+} lddSatTask;
+
+typedef struct lddSatJob
+{
+  LddManager *ldd;
+  bool *vars;
+  /* the negation of the constraint of every index */
+  lincons_t *neg;
+
+  lddSatTask *tasks;
+  int ntasks;
+  /* the next task to hand out */
+  int next;
+
+  /* open addressing by node, with complement bit */
+  LddNode **keys;
+  char *vals;
+  size_t mask;
+
+  /* set once the answer is known, or on error */
+  int done;
+  int sat;
+  int error;
+} lddSatJob;
+
+typedef struct lddSatWorker
+{
+  lddSatJob *job;
+  DdManager *cudd;
+  LddManager *ldd;
+  qelim_context_t *ctx;
+  pthread_t thread;
+} lddSatWorker;
+
+
+static size_t
+lddSatSlot (lddSatJob *job, LddNode *f)
+{
+  ptruint h;
+  size_t i;
+
+  h = ((ptruint) f >> 4) * DD_P1 + ((ptruint) f & 1);
+  for (i = (h ^ (h >> 16)) & job->mask;
+       job->keys [i] != NULL && job->keys [i] != f;
+       i = (i + 1) & job->mask);
+  return i;
+}
+
+static int
+lddSatMemoLookup (lddSatJob *job, LddNode *f)
+{
+  size_t i;
+
+  i = lddSatSlot (job, f);
+  if (job->keys [i] == NULL) return LDD_SAT_UNKNOWN;
+  return LDD_ATOMIC_LOAD (&job->vals [i]);
+}
+
+static void
+lddSatMemoInsert (lddSatJob *job, LddNode *f, int val)
+{
+  size_t i;
+
+  i = lddSatSlot (job, f);
+  if (job->keys [i] != NULL)
+    LDD_ATOMIC_STORE (&job->vals [i], (char) val);
+}
+
+
+/**
+   \brief Adds every node of f that is not below a node known to be
+   UNSAT to the memo, and negates the constraints of their indices.
+
+   \return 1 if successful; 0 otherwise
+ */
+static int
+lddSatPrepare (lddSatJob *job, LddNode *f)
+{
+  LddManager *ldd;
+  LddNode *F;
+  size_t i;
+  int v;
+
+  ldd = job->ldd;
+  if (Cudd_IsConstant (f)) return 1;
+
+  i = lddSatSlot (job, f);
+  if (job->keys [i] != NULL) return 1;
+  job->keys [i] = f;
+
+  v = lddSatLookup (ldd, f);
+  job->vals [i] = v < 0 ? LDD_SAT_UNKNOWN : v ? LDD_SAT_SAT : LDD_SAT_UNSAT;
+  if (v == 0) return 1;
+
+  F = Cudd_Regular (f);
+  if (job->neg [F->index] == NULL)
+    {
+      job->neg [F->index] = THEORY->negate_cons (ldd->ddVars [F->index]);
+      if (job->neg [F->index] == NULL) return 0;
+    }
+
+  return lddSatPrepare (job, Cudd_NotCond (cuddT (F), f != F)) &&
+    lddSatPrepare (job, Cudd_NotCond (cuddE (F), f != F));
+}
+
+/**
+   \brief Expands the top levels of f into at least target paths,
+   unless f is shallower. Paths that end in false or in a node known
+   to be UNSAT are dropped.
+
+   \return 1 if successful; 0 otherwise
+ */
+static int
+lddSatExpand (lddSatJob *job, LddNode *f, int target)
+{
+  LddManager *ldd;
+  lddSatTask *cur, *nxt, *t, *u;
+  LddNode *F, *c, *zero;
+  int d, i, b, n, split;
+
+  ldd = job->ldd;
+  zero = Cudd_Not (DD_ONE (CUDD));
+
+  cur = ALLOC (lddSatTask, 1);
+  if (cur == NULL) return 0;
+  cur [0].f = f;
+  cur [0].n = 0;
+  n = 1;
+
+  for (d = 0; d < LDD_SAT_FORK_DEPTH && n < target; d++)
+    {
+      nxt = ALLOC (lddSatTask, 2 * n);
+      if (nxt == NULL)
+	{
+	  FREE (cur);
+	  return 0;
+	}
+
+      split = 0;
+      for (i = 0, u = nxt; i < n; i++)
+	{
+	  t = &cur [i];
+	  if (Cudd_IsConstant (t->f))
+	    {
+	      *u++ = *t;
+	      continue;
+	    }
+
+	  F = Cudd_Regular (t->f);
+	  for (b = 0; b < 2; b++)
+	    {
+	      c = Cudd_NotCond (b == 0 ? cuddT (F) : cuddE (F), t->f != F);
+	      if (c == zero || lddSatMemoLookup (job, c) == LDD_SAT_UNSAT)
+		continue;
+	      *u = *t;
+	      u->f = c;
+	      u->lit [u->n++] = (F->index << 1) | b;
+	      u++;
+	    }
+	  split = 1;
+	}
+
+      FREE (cur);
+      cur = nxt;
+      n = u - nxt;
+      if (!split) break;
+    }
+
+  job->tasks = cur;
+  job->ntasks = n;
+  return 1;
+}
+
+/**
+   \brief Recursive step of a worker. ctx holds the constraints of the
+   current path, and is satisfiable. zero is the false constant of the
+   manager of ctx.
+
+   \return 1 if f is SAT in ctx, 0 if it is not or if the job is done,
+   and -1 on error
+ */
+static int
+lddSatParRecur (lddSatJob *job, LddNode *f, qelim_context_t *ctx,
+		LddNode *zero)
+{
+  LddManager *ldd;
+  LddNode *F, *fv, *fnv, *tmp;
+  unsigned int v;
+  int res;
+
+  ldd = job->ldd;
+  if (LDD_ATOMIC_LOAD (&job->done)) return 0;
+  if (Cudd_IsConstant (f)) return f == DD_ONE (CUDD);
+  if (lddSatMemoLookup (job, f) == LDD_SAT_UNSAT) return 0;
+
+  F = Cudd_Regular (f);
+  v = F->index;
+  fv = Cudd_NotCond (cuddT (F), f != F);
+  fnv = Cudd_NotCond (cuddE (F), f != F);
+
+  THEORY->qelim_push (ctx, ldd->ddVars [v]);
+  tmp = THEORY->qelim_solve (ctx);
+  if (tmp == NULL || !Cudd_IsConstant (tmp))
+    {
+      THEORY->qelim_pop (ctx);
+      return -1;
+    }
+
+  /* ctx implies !vCons, only the ELSE branch is left */
+  if (tmp == zero)
+    {
+      THEORY->qelim_pop (ctx);
+      res = lddSatParRecur (job, fnv, ctx, zero);
+      if (res > 0) lddSatMemoInsert (job, f, LDD_SAT_SAT);
+      return res;
+    }
+
+  res = lddSatParRecur (job, fv, ctx, zero);
+  THEORY->qelim_pop (ctx);
+  if (res != 0)
+    {
+      if (res > 0) lddSatMemoInsert (job, f, LDD_SAT_SAT);
+      return res;
+    }
+
+  THEORY->qelim_push (ctx, job->neg [v]);
+  tmp = THEORY->qelim_solve (ctx);
+  if (tmp == NULL || !Cudd_IsConstant (tmp) || tmp == zero)
+    {
+      THEORY->qelim_pop (ctx);
+      return tmp == zero ? 0 : -1;
+    }
+
+  res = lddSatParRecur (job, fnv, ctx, zero);
+  THEORY->qelim_pop (ctx);
+  if (res > 0) lddSatMemoInsert (job, f, LDD_SAT_SAT);
+  return res;
+}
+
+/**
+   \brief Creates the private manager and the context of a worker.
+
+   \return 1 if successful; 0 otherwise
+ */
+static int
+lddSatWorkerInit (lddSatWorker *w, lddSatJob *job)
+{
+  LddManager *ldd;
+
+  ldd = job->ldd;
+  w->job = job;
+  w->ldd = NULL;
+  w->ctx = NULL;
+  w->cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 256, 0);
+  if (w->cudd == NULL) return 0;
+  w->ldd = Ldd_Init (w->cudd, THEORY);
+  if (w->ldd == NULL) return 0;
+  w->ctx = THEORY->qelim_init (w->ldd, job->vars);
+  return w->ctx != NULL;
+}
+
+static void
+lddSatWorkerQuit (lddSatWorker *w)
+{
+  LddManager *ldd;
+
+  ldd = w->job->ldd;
+  if (w->ctx != NULL) THEORY->qelim_destroy_context (w->ctx);
+  if (w->ldd != NULL) Ldd_Quit (w->ldd);
+  if (w->cudd != NULL) Cudd_Quit (w->cudd);
+}
+
+/**
+   \brief Runs the tasks of the job of a worker until there are none
+   left, or until the job is done.
+ */
+static void *
+lddSatRun (void *arg)
+{
+  lddSatWorker *w;
+  lddSatJob *job;
+  LddManager *ldd;
+  qelim_context_t *ctx;
+  lddSatTask *t;
+  LddNode *zero, *tmp;
+  int i, j, res;
+
+  w = (lddSatWorker*) arg;
+  job = w->job;
+  ldd = job->ldd;
+  ctx = w->ctx;
+  zero = Cudd_Not (DD_ONE (w->cudd));
+
+  while (!LDD_ATOMIC_LOAD (&job->done))
+    {
+      i = LDD_ATOMIC_INC (&job->next);
+      if (i >= job->ntasks) break;
+      t = &job->tasks [i];
+
+      /* bring the context to the end of the path */
+      res = 1;
+      for (j = 0; j < t->n && res > 0; j++)
+	{
+	  THEORY->qelim_push (ctx, (t->lit [j] & 1) ?
+			      job->neg [t->lit [j] >> 1] :
+			      ldd->ddVars [t->lit [j] >> 1]);
+	  tmp = THEORY->qelim_solve (ctx);
+	  if (tmp == NULL || !Cudd_IsConstant (tmp)) res = -1;
+	  else if (tmp == zero) res = 0;
+	}
+      if (res > 0) res = lddSatParRecur (job, t->f, ctx, zero);
+      while (j-- > 0)
+	THEORY->qelim_pop (ctx);
+
+      if (res < 0)
+	LDD_ATOMIC_STORE (&job->error, 1);
+      else if (res > 0)
+	LDD_ATOMIC_STORE (&job->sat, 1);
+      if (res != 0)
+	LDD_ATOMIC_STORE (&job->done, 1);
+    }
+  return NULL;
+}
+
+
+/**
+   \brief Decides whether f is satisfiable in nthreads threads, the
+   calling thread included.
+
+   \return 1 if f is satisfiable, 0 if it is not, and -1 on failure
+ */
+static int
+lddIsSatThreads (LddManager *ldd, LddNode *f, int nthreads)
+{
+  lddSatJob job;
+  lddSatWorker *workers;
+  size_t i, size;
+  int n, started, res;
+
+  job.ldd = ldd;
+  job.tasks = NULL;
+  job.ntasks = 0;
+  job.next = 0;
+  job.done = 0;
+  job.sat = 0;
+  job.error = 0;
+
+  /* every node appears at most twice, once per polarity */
+  size = 4 * (size_t) Cudd_DagSize (f);
+  for (i = 1; i < size; i <<= 1);
+  job.mask = i - 1;
+
+  res = -1;
+  workers = NULL;
+  n = 0;
+  job.keys = ALLOC (LddNode*, job.mask + 1);
+  job.vals = ALLOC (char, job.mask + 1);
+  job.neg = ALLOC (lincons_t, CUDD->size);
+  if (job.neg != NULL)
+    for (i = 0; i < (size_t) CUDD->size; i++)
+      job.neg [i] = NULL;
+  job.vars = ALLOC (bool, THEORY->num_of_vars (THEORY));
+  if (job.keys == NULL || job.vals == NULL || job.neg == NULL ||
+      job.vars == NULL)
+    goto cleanup;
+
+  for (i = 0; i <= job.mask; i++)
+    {
+      job.keys [i] = NULL;
+      job.vals [i] = LDD_SAT_UNKNOWN;
+    }
+  for (i = 0; i < (size_t) THEORY->num_of_vars (THEORY); i++)
+    job.vars [i] = 1;
+
+  if (!lddSatPrepare (&job, f) ||
+      !lddSatExpand (&job, f, LDD_SAT_TASKS * nthreads))
+    goto cleanup;
+
+  workers = ALLOC (lddSatWorker, nthreads);
+  if (workers == NULL) goto cleanup;
+  for (n = 0; n < nthreads; n++)
+    if (!lddSatWorkerInit (&workers [n], &job))
+      {
+	n++;
+	goto cleanup;
+      }
+
+  /* worker 0 is the calling thread */
+  for (started = 1; started < nthreads; started++)
+    if (pthread_create (&workers [started].thread, NULL, lddSatRun,
+			&workers [started]) != 0)
+      break;
+  lddSatRun (&workers [0]);
+  while (--started > 0)
+    pthread_join (workers [started].thread, NULL);
+
+  if (job.error) goto cleanup;
+  res = job.sat;
+
+  /* a node that is SAT in some context is SAT on its own */
+  if (res)
+    {
+      for (i = 0; i <= job.mask; i++)
+	if (job.keys [i] != NULL && job.vals [i] == LDD_SAT_SAT)
+	  lddSatInsert (ldd, job.keys [i], 1);
+    }
+  else
+    lddSatInsert (ldd, f, 0);
+
+ cleanup:
+  while (n-- > 0)
+    lddSatWorkerQuit (&workers [n]);
+  if (job.neg != NULL)
+    for (i = 0; i < (size_t) CUDD->size; i++)
+      if (job.neg [i] != NULL)
+	THEORY->destroy_lincons (job.neg [i]);
+  FREE (workers);
+  FREE (job.tasks);
+  FREE (job.keys);
+  FREE (job.vals);
+  FREE (job.neg);
+  FREE (job.vars);
+  return res;
+}
+#endif
+
+
+/**
+   \brief Decides whether f is satisfiable, using nthreads threads.
+
+   The calling thread takes part in the work. Other threads only read
+   the manager, which must not be used elsewhere until the function
+   returns. Unlike Ldd_IsSat(), requires the theory to create no nodes
+   in qelim_solve() when all variables are quantified.
+
+   Without thread support, see the build option LDD_ENABLE_THREADS,
+   the check is done by Ldd_IsSat() in the calling thread.
+
+   Every node of f is visited once before the workers start, to share
+   what the computed table knows about it. When f has a satisfiable
+   path that is found quickly, Ldd_IsSat() is cheaper.
+
+   \return 1 if f is satisfiable, 0 if it is not, and -1 on failure
+
+   \sa Ldd_IsSat()
+ */
+int
+Ldd_IsSatParallel (LddManager *ldd, LddNode *f, int nthreads)
+{
+  int res;
+
+  if (Cudd_IsConstant (f)) return f == DD_ONE (CUDD);
+  res = lddSatLookup (ldd, f);
+  if (res >= 0) return res;
+#ifdef LDD_HAVE_THREADS
+  if (nthreads > 1) return lddIsSatThreads (ldd, f, nthreads);
+#endif
+  return Ldd_IsSat (ldd, f);
+}
@@ -6,10 +6,40 @@ static int Ldd_unsat_size_recur (LddManager *ldd, LddNode *f);
 static void lddClearFlag (LddNode *f);
 
 
+/**
+   \brief Tag of the results of Ldd_SatReduce() in the computed table
+   of CUDD. It is never called.
+ */
+static DdNode *
+lddSatReduceTag (DdManager *dd, DdNode *f)
+{
+  (void) dd;
+  (void) f;
+  return NULL;
+}
+
+/**
+   \brief Tag of the satisfiability of nodes, as recorded by
+   lddSatInsert(), in the computed table of CUDD. It is never called.
+ */
+static DdNode *
+lddIsSatTag (DdManager *dd, DdNode *f)
+{
+  (void) dd;
+  /* unlike lddSatReduceTag(), so that the two are never folded into
+     one function */
+  return f;
+}
+
 /**
  * Reduces a LDD by removing all unsatisfiable paths of length less
  * than or equal to 'depth'. When depth is less than 0, removes paths
  * of arbitrary length.
+ *
+ * Whether a node is satisfiable does not depend on the path it is
+ * reached by, so nodes found to be satisfiable, or unsatisfiable on
+ * their own, are remembered in the computed table and are not
+ * explored again by this function or by Ldd_IsSat().
  */
 LddNode *
 Ldd_SatReduce (LddManager *ldd, 
@@ -22,6 +52,13 @@ Ldd_SatReduce (LddManager *ldd,
   int i, n;
   
 
+  if (lddSatLookup (ldd, f) == 0) return Ldd_GetFalse (ldd);
+  if (depth < 0 && Cudd_Regular (f)->ref != 1)
+    {
+      res = cuddCacheLookup1 (CUDD, lddSatReduceTag, f);
+      if (res != NULL) return res;
+    }
+
   n = THEORY->num_of_vars (THEORY);
   vars = ALLOC (bool, n);
   if (vars == NULL) return NULL;
@@ -52,6 +89,13 @@ Ldd_SatReduce (LddManager *ldd,
   vars = NULL;
   
 
+  if (res != NULL && depth < 0)
+    {
+      lddSatInsert (ldd, f, res != Ldd_GetFalse (ldd));
+      if (Cudd_Regular (f)->ref != 1)
+	cuddCacheInsert1 (CUDD, lddSatReduceTag, f, res);
+    }
+
   if (res != NULL)
     cuddDeref (res);
   return res;
@@ -70,6 +114,10 @@ Ldd_IsSat (LddManager *ldd,
   int i, n;
   
 
+  if (Cudd_IsConstant (f)) return f == DD_ONE (CUDD);
+  i = lddSatLookup (ldd, f);
+  if (i >= 0) return i;
+
   n = THEORY->num_of_vars (THEORY);
   vars = ALLOC (bool, n);
   if (vars == NULL) return 0;
@@ -87,6 +135,8 @@ Ldd_IsSat (LddManager *ldd,
     }
 
   res = lddIsSatRecur (ldd, f, ctx);
+  /* the context is empty, so UNSAT is known for f on its own */
+  if (!res) lddSatInsert (ldd, f, 0);
   
   THEORY->qelim_destroy_context (ctx);
   ctx = NULL;
@@ -128,6 +178,10 @@ lddSatReduceRecur (LddManager *ldd,
 
 
   zero = Cudd_Not (DD_ONE (CUDD));
+
+  /* f is UNSAT on its own, hence in any context */
+  if (lddSatLookup (ldd, f) == 0) return zero;
+
   v = F->index;
   vCons = ldd->ddVars [v];
 
@@ -227,6 +281,11 @@ lddSatReduceRecur (LddManager *ldd,
       Cudd_IterDerefBdd (CUDD, root);
       root = NULL;
     }
+
+  /* with no depth limit, a path to ONE survives only if it is SAT in
+     the context */
+  if (res != NULL && depth < 0 && res != zero)
+    lddSatInsert (ldd, f, 1);
   
   if (res != NULL)
     cuddDeref (res);
@@ -255,6 +314,9 @@ lddIsSatRecur (LddManager *ldd,
 
   if (Cudd_IsConstant (f)) return f == DD_ONE (CUDD);
 
+  /* f is UNSAT on its own, hence in any context */
+  if (lddSatLookup (ldd, f) == 0) return 0;
+
   F = Cudd_Regular (f);
   v = F->index;
   vCons = ldd->ddVars [v];
@@ -273,7 +335,9 @@ lddIsSatRecur (LddManager *ldd,
   if (tmp == zero)
     {
       THEORY->qelim_pop (ctx);
-      return lddIsSatRecur (ldd, fnv, ctx);
+      res = lddIsSatRecur (ldd, fnv, ctx);
+      if (res) lddSatInsert (ldd, f, 1);
+      return res;
     }
 
   assert (tmp == DD_ONE (CUDD));
@@ -282,7 +346,11 @@ lddIsSatRecur (LddManager *ldd,
   THEORY->qelim_pop (ctx);
   
   /* THEN branch is SAT, we are done */
-  if (res) return res;
+  if (res)
+    {
+      lddSatInsert (ldd, f, 1);
+      return res;
+    }
   
   /* check ELSE branch */
   nvCons = THEORY->negate_cons (vCons);
@@ -303,9 +371,39 @@ lddIsSatRecur (LddManager *ldd,
   THEORY->qelim_pop (ctx);
   THEORY->destroy_lincons (nvCons);
 
+  if (res) lddSatInsert (ldd, f, 1);
   return res;
 }
 
+/**
+   \brief Looks up what is known about the satisfiability of f on its
+   own.
+
+   \return 1 if f is SAT, 0 if it is UNSAT, and -1 if unknown
+ */
+int
+lddSatLookup (LddManager *ldd, LddNode *f)
+{
+  LddNode *r;
+
+  if (Cudd_Regular (f)->ref == 1) return -1;
+  r = cuddCacheLookup1 (CUDD, lddIsSatTag, f);
+  if (r == NULL) return -1;
+  return r == DD_ONE (CUDD);
+}
+
+/**
+   \brief Records whether f is satisfiable on its own. f is SAT if it
+   is SAT in some context.
+ */
+void
+lddSatInsert (LddManager *ldd, LddNode *f, bool sat)
+{
+  if (Cudd_Regular (f)->ref == 1) return;
+  cuddCacheInsert1 (CUDD, lddIsSatTag, f,
+		    sat ? DD_ONE (CUDD) : Cudd_Not (DD_ONE (CUDD)));
+}
+
 int
 Ldd_UnsatSize(LddManager *ldd, 
 		LddNode *f)
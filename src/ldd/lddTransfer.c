@@ -0,0 +1,170 @@
+/**
+   Transfer of LDDs between managers.
+
+   Every constraint in the support of the LDDs is interned once in the
+   destination manager with theory_t::to_ldd, and the LDDs are rebuilt
+   there with lddMapRecur(), sharing one memo table. When the
+   constraints are in the same order in both managers, e.g., because
+   the destination has received them from the source before, the
+   rebuild is a structural copy.
+ */
+#include "util.h"
+#include "lddInt.h"
+
+static int lddTransferInter (LddManager *, LddManager *, LddNode **,
+			     LddNode **, int);
+
+
+/**
+   \brief Transfers f from the manager src to the manager dst.
+
+   The theories of src and dst must share the representation of
+   constraints, e.g., two TVPI theories of the same kind. Only dst is
+   modified, so a worker can hand its results to a coordinator while
+   it keeps running, as long as the coordinator does not use dst
+   concurrently.
+
+   \return a pointer to the result (not referenced) if successful;
+   NULL otherwise
+
+   \sa Ldd_TransferN(), Cudd_bddTransfer()
+ */
+LddNode *
+Ldd_Transfer (LddManager *src, LddManager *dst, LddNode *f)
+{
+  LddNode *res;
+
+  if (!Ldd_TransferN (src, dst, &f, &res, 1)) return NULL;
+  cuddDeref (res);
+  return res;
+}
+
+/**
+   \brief Transfers the n LDDs in fs from src to dst, sharing the work
+   between LDDs that share nodes.
+
+   \param src the manager of fs
+   \param dst the destination manager
+   \param fs array of LDDs of src
+   \param res array of size n that receives the results, which are
+   referenced
+   \param n the size of fs and res
+
+   \return 1 if successful; 0 otherwise, and res is unchanged
+
+   \sa Ldd_Transfer()
+ */
+int
+Ldd_TransferN (LddManager *src, LddManager *dst, LddNode **fs,
+	       LddNode **res, int n)
+{
+  LddNode **tmp;
+  int i, ok;
+
+  if (src == dst)
+    {
+      for (i = 0; i < n; i++)
+	{
+	  res [i] = fs [i];
+	  cuddRef (res [i]);
+	}
+      return 1;
+    }
+
+  /* the results are only copied to res on success */
+  tmp = ALLOC (LddNode*, n);
+  if (tmp == NULL)
+    {
+      dst->cudd->errorCode = CUDD_MEMORY_OUT;
+      return 0;
+    }
+
+  do
+    {
+      dst->cudd->reordered = 0;
+      ok = lddTransferInter (src, dst, fs, tmp, n);
+    }
+  while (!ok && dst->cudd->reordered == 1);
+
+  if (ok)
+    for (i = 0; i < n; i++)
+      res [i] = tmp [i];
+  FREE (tmp);
+  return ok;
+}
+
+/**
+   \brief Transfers fs to dst.
+
+   \return 1 if successful, and the results in res are referenced; 0
+   if out of memory or reordering took place
+ */
+static int
+lddTransferInter (LddManager *src, LddManager *dst, LddNode **fs,
+		  LddNode **res, int n)
+{
+  LddNode **map, *r;
+  DdHashTable *table;
+  int *support;
+  int i, size, copy, ok;
+
+  size = src->cudd->size;
+  support = Cudd_VectorSupportIndex (src->cudd, fs, n);
+  if (support == NULL) return 0;
+
+  map = ALLOC (LddNode*, size);
+  if (map == NULL)
+    {
+      FREE (support);
+      dst->cudd->errorCode = CUDD_MEMORY_OUT;
+      return 0;
+    }
+  for (i = 0; i < size; i++)
+    map [i] = NULL;
+
+  /* the literal of every constraint of fs in dst */
+  ok = 1;
+  for (i = 0; i < size && ok; i++)
+    {
+      if (!support [i]) continue;
+      map [i] = dst->theory->to_ldd (dst, lddC (src, i));
+      if (map [i] == NULL)
+	ok = 0;
+      else
+	cuddRef (map [i]);
+    }
+
+  table = NULL;
+  if (ok)
+    {
+      copy = lddMapIsCopy (dst, src->cudd, support, map, size);
+      table = cuddHashTableInit (dst->cudd, 1, 2);
+      if (table == NULL) ok = 0;
+    }
+
+  for (i = 0; i < n && ok; i++)
+    {
+      r = lddMapRecur (dst, fs [i], map, copy, table);
+      if (r == NULL)
+	{
+	  /* release the results so far */
+	  while (--i >= 0)
+	    Cudd_IterDerefBdd (dst->cudd, res [i]);
+	  ok = 0;
+	}
+      else
+	{
+	  cuddRef (r);
+	  res [i] = r;
+	}
+    }
+
+  if (table != NULL)
+    cuddHashTableQuit (table);
+  for (i = 0; i < size; i++)
+    if (map [i] != NULL)
+      Cudd_IterDerefBdd (dst->cudd, map [i]);
+  FREE (map);
+  FREE (support);
+  return ok;
+}
@@ -1,7 +1,8 @@
 #include "util.h"
 #include "lddInt.h"
 
-static LddNode * lddAssocNode (LddManager *, LddNode *, lincons_t);
+static LddNode * lddAssocNode (LddManager *, LddNode *, lincons_t, 
+				LddNode *, int);
 static void lddUpdateCuddMtrTree (DdManager *, LddNode *, LddNode * );
 
 /* static void lddDebugPrintMtr (MtrNode* tree);*/
@@ -42,7 +43,8 @@ Ldd_NewVar (LddManager * ldd, lincons_t l)
   if (n == NULL)
     return NULL;
   
-  n = lddAssocNode (ldd, n, l);
+  n = lddAssocNode (ldd, n, l, NULL, 0);
+  if (n == NULL) return NULL;
 
 #ifdef MTR_DEBUG_FINE
   fprintf (stderr, "Create a new mtr with index %d and level %d\n", n->index, 
@@ -97,7 +99,8 @@ Ldd_NewVarAtTop (LddManager* ldd, lincons_t l)
 
   if (n == NULL) return NULL;
   
-  n = lddAssocNode (ldd, n, l);
+  n = lddAssocNode (ldd, n, l, NULL, 0);
+  if (n == NULL) return NULL;
   Cudd_MakeTreeNode (CUDD, n->index, 1, MTR_FIXED);
   
   return n;
@@ -147,7 +150,8 @@ Ldd_NewVarBefore (LddManager * ldd, LddNode * v, lincons_t l)
   if (n == NULL) return NULL;
 
 
-  n = lddAssocNode (ldd, n, l);
+  n = lddAssocNode (ldd, n, l, v, 1);
+  if (n == NULL) return NULL;
 
 
 #ifdef MTR_DEBUG_FINE
@@ -201,7 +205,8 @@ Ldd_NewVarAfter (LddManager * ldd, LddNode *v, lincons_t l)
   
   if (n == NULL) return NULL;
   
-  n = lddAssocNode (ldd, n, l);
+  n = lddAssocNode (ldd, n, l, v, 0);
+  if (n == NULL) return NULL;
 
 #ifdef MTR_DEBUG_FINE
   fprintf (stderr, "new_varAfter: update with level %d from index %d\n", 
@@ -215,31 +220,78 @@ Ldd_NewVarAfter (LddManager * ldd, LddNode *v, lincons_t l)
 }
 
 
+/**
+ * Associates constraint l with the variable of node n, and fills in
+ * the metadata of n. If v is not NULL, n is placed right before
+ * (before != 0) or right after v in the variable order, and joins the
+ * term group of v if the theory confirms that the two constraints
+ * are ordered by implication.
+ */
 LddNode * 
-lddAssocNode (LddManager * ldd, LddNode *n, lincons_t l)
+lddAssocNode (LddManager * ldd, LddNode *n, lincons_t l, 
+	      LddNode *v, int before)
 {
   int idx;
   int i;
+  size_t k;
+  linterm_t t;
+  uint64_t mask;
   
   idx = n->index;
   
-  if (idx >= ldd->varsSize)
+  if ((size_t) idx >= ldd->varsSize)
     {
       lincons_t* newDdVars = ALLOC (lincons_t, CUDD->maxSize);
-      if (newDdVars == NULL) return NULL;
+      int* newDdTerm = ALLOC (int, CUDD->maxSize);
+      uint64_t* newDdVarMask = ALLOC (uint64_t, CUDD->maxSize);
+      if (newDdVars == NULL || newDdTerm == NULL || newDdVarMask == NULL)
+	{
+	  FREE (newDdVars);
+	  FREE (newDdTerm);
+	  FREE (newDdVarMask);
+	  return NULL;
+	}
       
-      for (i = 0; i < ldd->varsSize; i++)
-	newDdVars [i] = ldd->ddVars [i];
-      for (i = ldd->varsSize; i < CUDD->maxSize; i++)
-	newDdVars [i] = NULL;
+      for (k = 0; k < ldd->varsSize; k++)
+	{
+	  newDdVars [k] = ldd->ddVars [k];
+	  newDdTerm [k] = ldd->ddTerm [k];
+	  newDdVarMask [k] = ldd->ddVarMask [k];
+	}
+      for (k = ldd->varsSize; k < (size_t) CUDD->maxSize; k++)
+	{
+	  newDdVars [k] = NULL;
+	  newDdTerm [k] = -1;
+	  newDdVarMask [k] = 0;
+	}
       
       FREE (ldd->ddVars);
+      FREE (ldd->ddTerm);
+      FREE (ldd->ddVarMask);
       ldd->varsSize = CUDD->maxSize;
       ldd->ddVars = newDdVars;
+      ldd->ddTerm = newDdTerm;
+      ldd->ddVarMask = newDdVarMask;
     }
   
   ldd->ddVars [idx] = THEORY->dup_lincons (l);
 
+  /* variables of l */
+  t = THEORY->get_term (l);
+  mask = 0;
+  for (i = 0; i < THEORY->term_size (t); i++)
+    mask |= LDD_VAR_BIT (THEORY->term_get_var (t, i));
+  ldd->ddVarMask [idx] = mask;
+
+  /* term group of l */
+  if (v != NULL && 
+      (before ? 
+       THEORY->is_stronger_cons (l, ldd->ddVars [v->index]) :
+       THEORY->is_stronger_cons (ldd->ddVars [v->index], l)))
+    ldd->ddTerm [idx] = ldd->ddTerm [v->index];
+  else
+    ldd->ddTerm [idx] = ldd->numTerms++;
+
   return n;
 }
 
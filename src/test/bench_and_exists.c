@@ -0,0 +1,230 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks image computation, exists x . S(x) && T(x, x'), with
+ * Ldd_And() followed by Ldd_MvExistAbstract() and with the fused
+ * Ldd_AndExistsAbstract(). S is a disjunction of random boxes over
+ * the current-state variables x0..x(n-1), and T a disjunction of
+ * guarded transitions to the next-state variables xn..x(2n-1). Reports
+ * the size of the conjunction (only built by the first method), the
+ * largest intermediate LDD after a single-variable elimination by
+ * Ldd_MvExistAbstract(), the size of the image, and time, in the TVPI
+ * and the Box theories.
+ *
+ * usage: bench_and_exists [nvars [ntrans [nboxes [seed]]]]
+ */
+
+static int nvars = 6;
+static int ntrans = 8;
+static int nboxes = 8;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* creates an LDD for a*xi + b*xj <= k, and conjoins it to *r */
+static void
+and_cons (LddManager *ldd, theory_t *t, LddNode **r,
+	  int i, int a, int j, int b, int k)
+{
+  int *coeff;
+  lincons_t l;
+  LddNode *d, *tmp;
+
+  coeff = (int*) calloc (2 * nvars, sizeof (int));
+  coeff [i] = a;
+  if (b != 0) coeff [j] = b;
+  l = t->create_cons (t->create_linterm (coeff, 2 * nvars), 0,
+		      t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+
+  tmp = Ldd_And (ldd, *r, d);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, *r);
+  Ldd_RecursiveDeref (ldd, d);
+  *r = tmp;
+}
+
+static void
+or_accum (LddManager *ldd, LddNode **r, LddNode *n)
+{
+  LddNode *tmp;
+
+  tmp = Ldd_Or (ldd, *r, n);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, *r);
+  Ldd_RecursiveDeref (ldd, n);
+  *r = tmp;
+}
+
+/* a disjunction of boxes lo <= xi <= lo + 10 on all current-state
+   variables */
+static LddNode *
+rnd_states (LddManager *ldd, theory_t *t)
+{
+  LddNode *s, *c;
+  int i, j, lo;
+
+  s = Ldd_GetFalse (ldd);
+  Ldd_Ref (s);
+  for (i = 0; i < nboxes; i++)
+    {
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      for (j = 0; j < nvars; j++)
+	{
+	  lo = rnd (41) - 20;
+	  and_cons (ldd, t, &c, j, -1, 0, 0, -lo);
+	  and_cons (ldd, t, &c, j, 1, 0, 0, lo + 10);
+	}
+      or_accum (ldd, &s, c);
+    }
+  return s;
+}
+
+/* a disjunction of transitions guarded by xj <= k. In the TVPI
+   theory, a transition sets xi' := xj + d and keeps the other
+   variables, and in the Box theory it puts every xi' into an
+   interval. */
+static LddNode *
+rnd_trans (LddManager *ldd, theory_t *t, int box)
+{
+  LddNode *tr, *c;
+  int i, j, k, x, d, lo;
+
+  tr = Ldd_GetFalse (ldd);
+  Ldd_Ref (tr);
+  for (i = 0; i < ntrans; i++)
+    {
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      j = rnd (nvars);
+      and_cons (ldd, t, &c, j, 1, 0, 0, rnd (41) - 20);
+      x = rnd (nvars);
+      for (k = 0; k < nvars; k++)
+	if (box)
+	  {
+	    lo = rnd (41) - 20;
+	    and_cons (ldd, t, &c, nvars + k, -1, 0, 0, -lo);
+	    and_cons (ldd, t, &c, nvars + k, 1, 0, 0, lo + 5);
+	  }
+	else
+	  {
+	    /* xk' - xj = d when k == x, and xk' - xk = 0 otherwise */
+	    d = k == x ? rnd (11) - 5 : 0;
+	    j = k == x ? rnd (nvars) : k;
+	    and_cons (ldd, t, &c, nvars + k, 1, j, -1, d);
+	    and_cons (ldd, t, &c, nvars + k, -1, j, 1, -d);
+	  }
+      or_accum (ldd, &tr, c);
+    }
+  return tr;
+}
+
+/* largest result of a single-variable elimination */
+static int peak;
+
+static LddNode *
+exists_peak (LddManager *ldd, LddNode *f, int var)
+{
+  LddNode *res;
+  int size;
+
+  res = Ldd_ExistsAbstractFM (ldd, f, var);
+  if (res != NULL)
+    {
+      size = Cudd_DagSize (res);
+      if (size > peak) peak = size;
+    }
+  return res;
+}
+
+static void
+run (int box, int fused)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *s, *tr, *c, *r;
+  int *qvars;
+  long start, elapsed;
+  int i, conj = 0;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = box ? tvpi_create_box_theory (2 * nvars) :
+    tvpi_create_theory (2 * nvars);
+  ldd = Ldd_Init (cudd, t);
+  /* the Box theory eliminates without intermediate results */
+  if (!box) Ldd_SetExistsAbstract (ldd, exists_peak);
+
+  rnd_state = seed;
+  s = rnd_states (ldd, t);
+  tr = rnd_trans (ldd, t, box);
+
+  qvars = (int*) malloc (nvars * sizeof (int));
+  for (i = 0; i < nvars; i++)
+    qvars [i] = i;
+
+  peak = 0;
+  start = util_cpu_time ();
+  if (fused)
+    {
+      r = Ldd_AndExistsAbstract (ldd, s, tr, qvars, nvars);
+      Ldd_Ref (r);
+    }
+  else
+    {
+      c = Ldd_And (ldd, s, tr);
+      Ldd_Ref (c);
+      conj = Cudd_DagSize (c);
+      r = Ldd_MvExistAbstract (ldd, c, qvars, nvars);
+      Ldd_Ref (r);
+      Ldd_RecursiveDeref (ldd, c);
+    }
+  elapsed = util_cpu_time () - start;
+
+  fprintf (stdout, "%-4s %-10s conj=%d peak=%d image=%d nodes "
+	   "time=%ldms\n", box ? "box" : "tvpi",
+	   fused ? "and-exists" : "and+mv", conj, peak, Cudd_DagSize (r),
+	   elapsed);
+
+  free (qvars);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, tr);
+  Ldd_RecursiveDeref (ldd, s);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) ntrans = atoi (argv [2]);
+  if (argc > 3) nboxes = atoi (argv [3]);
+  if (argc > 4) seed = strtoul (argv [4], NULL, 10);
+
+  fprintf (stdout, "Image: %d vars, %d transitions, %d boxes\n",
+	   nvars, ntrans, nboxes);
+  run (0, 0);
+  run (0, 1);
+  run (1, 0);
+  run (1, 1);
+  return 0;
+}
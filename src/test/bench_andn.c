@@ -0,0 +1,130 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks Ldd_AndN against folding Ldd_And left to right on the
+ * same random guards, each a disjunction of two constraints. Reports
+ * the size of the conjunction and time. The same is done for Ldd_OrN
+ * and Ldd_Or on the negated guards.
+ *
+ * usage: bench_andn [nvars [nguards [seed]]]
+ */
+
+static int nvars = 16;
+static int nguards = 60;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* a random constraint +-x +-y <= c or +-x <= c */
+static LddNode *
+rnd_cons (LddManager *ldd, theory_t *t)
+{
+  int *coeff;
+  int x, y;
+  lincons_t l;
+  LddNode *d;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  x = rnd (nvars);
+  y = rnd (nvars);
+  coeff [x] = rnd (2) ? 1 : -1;
+  if (y != x && rnd (2))
+    coeff [y] = rnd (2) ? 1 : -1;
+
+  l = t->create_cons (t->create_linterm (coeff, nvars), rnd (4) == 0,
+		      t->create_int_cst (rnd (201) - 40));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+  return d;
+}
+
+static void
+run (int n_ary, int or)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode **fs, *a, *b, *r, *tmp;
+  long start, elapsed;
+  int i;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+
+  rnd_state = seed;
+  fs = (LddNode**) malloc (nguards * sizeof (LddNode*));
+  for (i = 0; i < nguards; i++)
+    {
+      a = rnd_cons (ldd, t);
+      b = rnd_cons (ldd, t);
+      fs [i] = Ldd_Or (ldd, a, b);
+      Ldd_Ref (fs [i]);
+      Ldd_RecursiveDeref (ldd, a);
+      Ldd_RecursiveDeref (ldd, b);
+      if (or) fs [i] = Ldd_Not (fs [i]);
+    }
+
+  start = util_cpu_time ();
+  if (n_ary)
+    {
+      r = or ? Ldd_OrN (ldd, fs, nguards) : Ldd_AndN (ldd, fs, nguards);
+      Ldd_Ref (r);
+    }
+  else
+    {
+      r = or ? Ldd_GetFalse (ldd) : Ldd_GetTrue (ldd);
+      Ldd_Ref (r);
+      for (i = 0; i < nguards; i++)
+	{
+	  tmp = or ? Ldd_Or (ldd, r, fs [i]) : Ldd_And (ldd, r, fs [i]);
+	  Ldd_Ref (tmp);
+	  Ldd_RecursiveDeref (ldd, r);
+	  r = tmp;
+	}
+    }
+  elapsed = util_cpu_time () - start;
+
+  fprintf (stdout, "%-8s result=%d nodes time=%ldms\n",
+	   n_ary ? (or ? "OrN" : "AndN") : (or ? "Or fold" : "And fold"),
+	   Cudd_DagSize (r), elapsed);
+
+  Ldd_RecursiveDeref (ldd, r);
+  for (i = 0; i < nguards; i++)
+    Ldd_RecursiveDeref (ldd, fs [i]);
+  free (fs);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) nguards = atoi (argv [2]);
+  if (argc > 3) seed = strtoul (argv [3], NULL, 10);
+
+  fprintf (stdout, "Conjunction of %d guards over %d vars\n",
+	   nguards, nvars);
+  run (0, 0);
+  run (1, 0);
+  run (0, 1);
+  run (1, 1);
+  return 0;
+}
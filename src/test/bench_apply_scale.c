@@ -0,0 +1,233 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+/**
+ * Benchmarks how a batch of independent Ldd_And, Ldd_Or and Ldd_Ite
+ * jobs scales when sharded over 1 to N threads, each with its own
+ * manager and theory. Every job folds random guards into a
+ * conjunction, a disjunction and an if-then-else. Reports wall time
+ * and speedup for every number of threads, and checks that all runs
+ * compute the same total size.
+ *
+ * usage: bench_apply_scale [nthreads [njobs [nvars [nguards [seed]]]]]
+ */
+
+static int nthreads = 4;
+static int njobs = 32;
+static int nvars = 12;
+static int nguards = 40;
+static unsigned long seed = 1;
+
+static int
+rnd (unsigned long *state, int n)
+{
+  *state = *state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((*state >> 33) % (unsigned long) n);
+}
+
+/* a random constraint +-x +-y <= c or +-x <= c */
+static LddNode *
+rnd_cons (LddManager *ldd, theory_t *t, unsigned long *state)
+{
+  int *coeff;
+  int x, y;
+  lincons_t l;
+  LddNode *d;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  x = rnd (state, nvars);
+  y = rnd (state, nvars);
+  coeff [x] = rnd (state, 2) ? 1 : -1;
+  if (y != x && rnd (state, 2))
+    coeff [y] = rnd (state, 2) ? 1 : -1;
+
+  l = t->create_cons (t->create_linterm (coeff, nvars), 0,
+		      t->create_int_cst (rnd (state, 201) - 40));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+  return d;
+}
+
+/* a disjunction of two random constraints */
+static LddNode *
+rnd_guard (LddManager *ldd, theory_t *t, unsigned long *state)
+{
+  LddNode *a, *b, *r;
+
+  a = rnd_cons (ldd, t, state);
+  b = rnd_cons (ldd, t, state);
+  r = Ldd_Or (ldd, a, b);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, b);
+  return r;
+}
+
+/* runs job j in a fresh manager, returns the size of its results */
+static long
+job (int j)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *conj, *disj, *ite, *g, *r;
+  unsigned long state;
+  long size;
+  int i;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+  state = seed + j;
+
+  conj = Ldd_GetTrue (ldd);
+  Ldd_Ref (conj);
+  disj = Ldd_GetFalse (ldd);
+  Ldd_Ref (disj);
+  ite = Ldd_GetFalse (ldd);
+  Ldd_Ref (ite);
+  for (i = 0; i < nguards; i++)
+    {
+      g = rnd_guard (ldd, t, &state);
+
+      r = Ldd_And (ldd, conj, g);
+      Ldd_Ref (r);
+      Ldd_RecursiveDeref (ldd, conj);
+      conj = r;
+
+      r = Ldd_Or (ldd, disj, Ldd_Not (g));
+      Ldd_Ref (r);
+      Ldd_RecursiveDeref (ldd, disj);
+      disj = r;
+
+      r = Ldd_Ite (ldd, g, disj, ite);
+      Ldd_Ref (r);
+      Ldd_RecursiveDeref (ldd, ite);
+      ite = r;
+
+      Ldd_RecursiveDeref (ldd, g);
+    }
+
+  size = Cudd_DagSize (conj) + Cudd_DagSize (disj) + Cudd_DagSize (ite);
+
+  Ldd_RecursiveDeref (ldd, conj);
+  Ldd_RecursiveDeref (ldd, disj);
+  Ldd_RecursiveDeref (ldd, ite);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+  return size;
+}
+
+static double
+wall_time (void)
+{
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+typedef struct worker
+{
+  pthread_t thread;
+  /* takes jobs first, first + step, ... */
+  int first;
+  int step;
+  long size;
+} worker_t;
+
+static void *
+worker (void *arg)
+{
+  worker_t *w = (worker_t*) arg;
+  int j;
+
+  w->size = 0;
+  for (j = w->first; j < njobs; j += w->step)
+    w->size += job (j);
+  return NULL;
+}
+
+/* runs all jobs on k threads; returns the total size of the results,
+   or -1 on error */
+static long
+run (int k)
+{
+  worker_t *ws;
+  long total;
+  int w;
+
+  ws = (worker_t*) malloc (k * sizeof (worker_t));
+  total = 0;
+
+  for (w = 0; w < k; w++)
+    {
+      ws [w].first = w;
+      ws [w].step = k;
+      if (pthread_create (&ws [w].thread, NULL, worker, &ws [w]) != 0)
+	{
+	  k = w;
+	  total = -1;
+	}
+    }
+
+  for (w = 0; w < k; w++)
+    {
+      pthread_join (ws [w].thread, NULL);
+      if (total >= 0) total += ws [w].size;
+    }
+
+  free (ws);
+  return total;
+}
+
+int
+main (int argc, char **argv)
+{
+  double start, elapsed, base;
+  long size, expected;
+  int k;
+
+  if (argc > 1) nthreads = atoi (argv [1]);
+  if (argc > 2) njobs = atoi (argv [2]);
+  if (argc > 3) nvars = atoi (argv [3]);
+  if (argc > 4) nguards = atoi (argv [4]);
+  if (argc > 5) seed = strtoul (argv [5], NULL, 10);
+
+  fprintf (stdout, "%d jobs of %d guards over %d vars\n",
+	   njobs, nguards, nvars);
+  fflush (stdout);
+
+  base = 0;
+  expected = -1;
+  for (k = 1; k <= nthreads; k++)
+    {
+      start = wall_time ();
+      size = run (k);
+      elapsed = wall_time () - start;
+      if (size < 0 || (expected >= 0 && size != expected))
+	{
+	  fprintf (stderr, "threads=%d: wrong result\n", k);
+	  return 1;
+	}
+      expected = size;
+      if (k == 1) base = elapsed;
+
+      fprintf (stdout, "threads=%-3d result=%ld nodes time=%.0fms "
+	       "speedup=%.2f\n", k, size, elapsed,
+	       elapsed > 0 ? base / elapsed : 0.0);
+      fflush (stdout);
+    }
+
+  return 0;
+}
@@ -0,0 +1,274 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks the assignments on Boxes LDDs against their encoding by
+ * quantifier elimination and conjunction: x := e is computed as
+ * exists x. (f && x' = e), followed by renaming x' to x. The state is
+ * a random union of boxes, and every assignment is applied to it on
+ * random variables. x := x + y has no such encoding in the TVPI
+ * theory, and is only timed with the transformer. Reports the time
+ * and the total size of the results for every assignment.
+ *
+ * usage: bench_box_assign [nvars [nboxes [nreps [seed]]]]
+ */
+
+static int nvars = 10;
+static int nboxes = 30;
+static int nreps = 100;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static DdManager *cudd;
+static LddManager *ldd;
+static theory_t *t;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* a*x + b*y, over the variables and their primed copies */
+static linterm_t
+term (int x, int a, int y, int b)
+{
+  int *coeff;
+  linterm_t r;
+
+  coeff = (int*) calloc (2 * nvars, sizeof (int));
+  coeff [x] = a;
+  if (b != 0) coeff [y] = b;
+  r = t->create_linterm (coeff, 2 * nvars);
+  free (coeff);
+  return r;
+}
+
+/* f && g, releases f and g */
+static LddNode *
+and (LddNode *f, LddNode *g)
+{
+  LddNode *r;
+
+  r = Ldd_And (ldd, f, g);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, g);
+  return r;
+}
+
+/* a*x + b*y == k */
+static LddNode *
+equals (int x, int a, int y, int b, int k)
+{
+  lincons_t l;
+  LddNode *d1, *d2;
+
+  l = t->create_cons (term (x, a, y, b), 0, t->create_int_cst (k));
+  d1 = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d1);
+  t->destroy_lincons (l);
+  l = t->create_cons (term (x, -a, y, -b), 0, t->create_int_cst (-k));
+  d2 = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d2);
+  t->destroy_lincons (l);
+
+  return and (d1, d2);
+}
+
+/* sgn * x <= k */
+static LddNode *
+bound (int x, int sgn, int k)
+{
+  lincons_t l;
+  LddNode *d;
+
+  l = t->create_cons (term (x, sgn, 0, 0), 0, t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  return d;
+}
+
+/* a union of random boxes over the unprimed variables */
+static LddNode *
+rnd_state_ldd (void)
+{
+  LddNode *s, *b, *tmp;
+  int i, j, x, lo;
+
+  s = Ldd_GetFalse (ldd);
+  Ldd_Ref (s);
+  for (i = 0; i < nboxes; i++)
+    {
+      b = Ldd_GetTrue (ldd);
+      Ldd_Ref (b);
+      for (j = 0; j < 3; j++)
+	{
+	  x = rnd (nvars);
+	  lo = rnd (41) - 20;
+	  b = and (b, bound (x, -1, -lo));
+	  b = and (b, bound (x, 1, lo + rnd (10)));
+	}
+      tmp = Ldd_Or (ldd, s, b);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, s);
+      Ldd_RecursiveDeref (ldd, b);
+      s = tmp;
+    }
+  return s;
+}
+
+/* exists x. (s && x' = a*x + b*y + k), with x' renamed to x */
+static LddNode *
+qelim_assign (LddNode *s, int *perm, int x, int a, int y, int b, int k)
+{
+  LddNode *r, *tmp;
+
+  Ldd_Ref (s);
+  r = and (s, equals (nvars + x, 1, a != 0 ? x : y, -(a != 0 ? a : b), k));
+
+  tmp = Ldd_ExistsAbstract (ldd, r, x);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, r);
+
+  perm [x] = nvars + x;
+  perm [nvars + x] = x;
+  r = Ldd_Permute (ldd, tmp, perm);
+  Ldd_Ref (r);
+  perm [x] = x;
+  perm [nvars + x] = nvars + x;
+  Ldd_RecursiveDeref (ldd, tmp);
+  return r;
+}
+
+enum { HAVOC, XC, XY, XPC, XNEG, XPY, NOPS };
+static const char *names [NOPS] =
+  { "havoc x", "x := c", "x := y", "x := x + c", "x := -x", "x := x + y" };
+
+/* applies op nreps times to s; returns the total size of the
+   results */
+static long
+run (LddNode *s, int op, int qelim, int *perm)
+{
+  LddNode *r;
+  linterm_t tx, ty;
+  constant_t c;
+  long size;
+  int i, x, y, k;
+
+  size = 0;
+  for (i = 0; i < nreps; i++)
+    {
+      x = rnd (nvars);
+      y = (x + 1 + rnd (nvars - 1)) % nvars;
+      k = rnd (21) - 10;
+
+      if (qelim)
+	{
+	  switch (op)
+	    {
+	    case HAVOC:
+	      r = Ldd_ExistsAbstract (ldd, s, x);
+	      Ldd_Ref (r);
+	      break;
+	    case XC:
+	      r = Ldd_ExistsAbstract (ldd, s, x);
+	      Ldd_Ref (r);
+	      r = and (r, equals (x, 1, 0, 0, k));
+	      break;
+	    case XY:
+	      r = qelim_assign (s, perm, x, 0, y, 1, 0);
+	      break;
+	    case XPC:
+	      r = qelim_assign (s, perm, x, 1, 0, 0, k);
+	      break;
+	    default:
+	      r = qelim_assign (s, perm, x, -1, 0, 0, 0);
+	      break;
+	    }
+	}
+      else
+	{
+	  tx = term (x, 1, 0, 0);
+	  ty = term (y, 1, 0, 0);
+	  c = t->create_int_cst (k);
+	  switch (op)
+	    {
+	    case HAVOC: r = Ldd_BoxesHavoc (ldd, s, tx); break;
+	    case XC: r = Ldd_BoxesXc (ldd, s, tx, c); break;
+	    case XY: r = Ldd_BoxesXy (ldd, s, tx, ty); break;
+	    case XPC: r = Ldd_BoxesXpc (ldd, s, tx, c); break;
+	    case XNEG: r = Ldd_BoxesXneg (ldd, s, tx); break;
+	    default: r = Ldd_BoxesXpy (ldd, s, tx, ty); break;
+	    }
+	  Ldd_Ref (r);
+	  t->destroy_term (tx);
+	  t->destroy_term (ty);
+	  t->destroy_cst (c);
+	}
+
+      size += Cudd_DagSize (r);
+      Ldd_RecursiveDeref (ldd, r);
+    }
+  return size;
+}
+
+int
+main (int argc, char **argv)
+{
+  LddNode *s;
+  int *perm;
+  long start, elapsed, size;
+  int i, op, qelim;
+
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) nboxes = atoi (argv [2]);
+  if (argc > 3) nreps = atoi (argv [3]);
+  if (argc > 4) seed = strtoul (argv [4], NULL, 10);
+
+  perm = (int*) malloc (2 * nvars * sizeof (int));
+  for (i = 0; i < 2 * nvars; i++)
+    perm [i] = i;
+
+  fprintf (stdout, "Box assignments: %d vars, %d boxes, %d reps\n",
+	   nvars, nboxes, nreps);
+  for (op = 0; op < NOPS; op++)
+    for (qelim = 1; qelim >= 0; qelim--)
+      {
+	if (qelim && op == XPY) continue;
+
+	/* a fresh manager, so that no run reuses the computed table of
+	   another */
+	cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+	t = tvpi_create_theory (2 * nvars);
+	ldd = Ldd_Init (cudd, t);
+	rnd_state = seed;
+	s = rnd_state_ldd ();
+
+	/* both encodings see the same variables */
+	rnd_state = seed + op;
+	start = util_cpu_time ();
+	size = run (s, op, qelim, perm);
+	elapsed = util_cpu_time () - start;
+	fprintf (stdout, "%-11s %-8s time=%ldms results=%ld nodes "
+		 "(state %d nodes)\n", names [op], qelim ? "qe+and" : "boxes",
+		 elapsed, size, Cudd_DagSize (s));
+	fflush (stdout);
+
+	Ldd_RecursiveDeref (ldd, s);
+	Ldd_Quit (ldd);
+	tvpi_destroy_theory (t);
+	Cudd_Quit (cudd);
+      }
+
+  free (perm);
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks quantifier elimination in the Box theory on a random
+ * trace of a disjunctive abstract interpreter: assignments of
+ * intervals (havoc and assume), conditionals that assign in both
+ * branches and join, loop heads that join with earlier states, and
+ * projections of several variables at scope exits. The same trace
+ * is run with Fourier-Motzkin and with the Box fast path (the default
+ * for Box theories). Reports the time spent in elimination, the total
+ * time, and the size of the final state.
+ *
+ * usage: bench_box_qelim [nvars [nsteps [seed]]]
+ */
+
+static int nvars = 10;
+static int nsteps = 120;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+/* time spent in quantifier elimination */
+static long qelim_time;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* s := s && (sgn * x <= k), and releases s */
+static LddNode *
+assume (LddManager *ldd, theory_t *t, LddNode *s, int x, int sgn, int k)
+{
+  int *coeff;
+  lincons_t l;
+  LddNode *d, *res;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  coeff [x] = sgn;
+  l = t->create_cons (t->create_linterm (coeff, nvars), 0,
+		      t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+
+  res = Ldd_And (ldd, s, d);
+  Ldd_Ref (res);
+  Ldd_RecursiveDeref (ldd, d);
+  Ldd_RecursiveDeref (ldd, s);
+  return res;
+}
+
+/* s := (exists x . s) && lo <= x <= lo + 4, and releases s */
+static LddNode *
+assign (LddManager *ldd, theory_t *t, LddNode *s, int x, int lo)
+{
+  LddNode *r;
+  long start;
+
+  start = util_cpu_time ();
+  r = Ldd_ExistsAbstract (ldd, s, x);
+  qelim_time += util_cpu_time () - start;
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, s);
+  r = assume (ldd, t, r, x, -1, -lo);
+  return assume (ldd, t, r, x, 1, lo + 4);
+}
+
+/* replaces s by r, taking the reference of r */
+static LddNode *
+update (LddManager *ldd, LddNode *s, LddNode *r)
+{
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, s);
+  return r;
+}
+
+#define NSAVED 4
+
+static void
+run (int box)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *s, *s1, *s2, *saved [NSAVED];
+  int qvars [3];
+  long start, elapsed;
+  int i, k, x, y;
+  int nexists = 0;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_box_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+  if (!box) Ldd_SetExistsAbstract (ldd, Ldd_ExistsAbstractFM);
+
+  rnd_state = seed;
+  s = Ldd_GetTrue (ldd);
+  Ldd_Ref (s);
+  /* loop heads are not reached yet */
+  for (i = 0; i < NSAVED; i++)
+    {
+      saved [i] = Ldd_GetFalse (ldd);
+      Ldd_Ref (saved [i]);
+    }
+
+  qelim_time = 0;
+  elapsed = util_cpu_time ();
+  for (i = 0; i < nsteps; i++)
+    {
+      switch (rnd (8))
+	{
+	case 0: case 1:
+	  /* x := [lo, lo + 4] */
+	  s = assign (ldd, t, s, rnd (nvars), rnd (41) - 20);
+	  nexists++;
+	  break;
+	case 2: case 3: case 4:
+	  /* if (x <= k) y := [lo1, lo1 + 4] else y := [lo2, lo2 + 4] */
+	  x = rnd (nvars);
+	  y = rnd (nvars);
+	  k = rnd (41) - 20;
+	  /* both branches release s */
+	  Ldd_Ref (s);
+	  Ldd_Ref (s);
+	  s1 = assume (ldd, t, s, x, 1, k);
+	  s1 = assign (ldd, t, s1, y, rnd (41) - 20);
+	  s2 = assume (ldd, t, s, x, -1, -k - 1);
+	  s2 = assign (ldd, t, s2, y, rnd (41) - 20);
+	  nexists += 2;
+	  s = update (ldd, s, Ldd_Or (ldd, s1, s2));
+	  Ldd_RecursiveDeref (ldd, s1);
+	  Ldd_RecursiveDeref (ldd, s2);
+	  break;
+	case 5: case 6:
+	  /* join with an earlier state */
+	  k = rnd (NSAVED);
+	  s = update (ldd, s, Ldd_Or (ldd, s, saved [k]));
+	  Ldd_RecursiveDeref (ldd, saved [k]);
+	  saved [k] = s;
+	  Ldd_Ref (s);
+	  break;
+	default:
+	  /* scope exit */
+	  for (k = 0; k < 3; k++)
+	    qvars [k] = rnd (nvars);
+	  start = util_cpu_time ();
+	  s1 = Ldd_MvExistAbstract (ldd, s, qvars, 3);
+	  qelim_time += util_cpu_time () - start;
+	  s = update (ldd, s, s1);
+	  nexists += 3;
+	  break;
+	}
+    }
+  elapsed = util_cpu_time () - elapsed;
+
+  fprintf (stdout, "%-5s eliminations=%d qelim=%ldms total=%ldms "
+	   "state=%d nodes\n", box ? "box" : "fm", nexists, qelim_time,
+	   elapsed, Cudd_DagSize (s));
+
+  for (i = 0; i < NSAVED; i++)
+    Ldd_RecursiveDeref (ldd, saved [i]);
+  Ldd_RecursiveDeref (ldd, s);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) nsteps = atoi (argv [2]);
+  if (argc > 3) seed = strtoul (argv [3], NULL, 10);
+
+  fprintf (stdout, "Box trace: %d vars, %d steps\n", nvars, nsteps);
+  run (0);
+  run (1);
+  return 0;
+}
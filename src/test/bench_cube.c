@@ -0,0 +1,159 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks building an LDD from random cubes with Ldd_CubeBuilder
+ * against Ldd_FromCons, Ldd_And and Ldd_Or. Each cube bounds a few
+ * variables to small intervals, like a stored set of abstract states.
+ * Reports the size of the result and time.
+ *
+ * usage: bench_cube [nvars [ncubes [ncons [range [seed]]]]]
+ */
+
+static int nvars = 4;
+static int ncubes = 5000;
+static int ncons = 8;
+static int range = 10;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* a bound lo <= x (if upper is 0) or x <= lo + 2 on a variable */
+static lincons_t
+bound_cons (theory_t *t, int x, int lo, int upper)
+{
+  int *coeff;
+  lincons_t l;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  coeff [x] = upper ? 1 : -1;
+  l = t->create_cons (t->create_linterm (coeff, nvars), 0,
+		      t->create_int_cst (upper ? lo + 2 : -lo));
+  free (coeff);
+  return l;
+}
+
+/* a cube of ncons constraints that bounds ncons / 2 random variables
+   to an interval of width 2 */
+static void
+rnd_cube (theory_t *t, lincons_t *cube)
+{
+  int j, x, lo;
+
+  for (j = 0; j + 1 < ncons; j += 2)
+    {
+      x = rnd (nvars);
+      lo = rnd (2 * range + 1) - range;
+      cube [j] = bound_cons (t, x, lo, 0);
+      cube [j + 1] = bound_cons (t, x, lo, 1);
+    }
+  if (j < ncons)
+    cube [j] = bound_cons (t, rnd (nvars), rnd (2 * range + 1) - range, 1);
+}
+
+static void
+run (int builder)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddCubeBuilder *b = NULL;
+  lincons_t *cube;
+  LddNode *f, *c, *d, *tmp;
+  long start, elapsed;
+  int i, j;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+
+  rnd_state = seed;
+  cube = (lincons_t*) malloc (ncons * sizeof (lincons_t));
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  if (builder) b = Ldd_CubeBuilderInit (ldd);
+
+  elapsed = 0;
+  for (i = 0; i < ncubes; i++)
+    {
+      /* only the construction is timed */
+      rnd_cube (t, cube);
+
+      start = util_cpu_time ();
+      if (builder)
+	Ldd_CubeBuilderAddCube (b, cube, ncons);
+      else
+	{
+	  c = Ldd_GetTrue (ldd);
+	  Ldd_Ref (c);
+	  for (j = 0; j < ncons; j++)
+	    {
+	      d = Ldd_FromCons (ldd, cube [j]);
+	      Ldd_Ref (d);
+	      tmp = Ldd_And (ldd, c, d);
+	      Ldd_Ref (tmp);
+	      Ldd_RecursiveDeref (ldd, c);
+	      Ldd_RecursiveDeref (ldd, d);
+	      c = tmp;
+	    }
+	  tmp = Ldd_Or (ldd, f, c);
+	  Ldd_Ref (tmp);
+	  Ldd_RecursiveDeref (ldd, f);
+	  Ldd_RecursiveDeref (ldd, c);
+	  f = tmp;
+	}
+      elapsed += util_cpu_time () - start;
+
+      for (j = 0; j < ncons; j++)
+	t->destroy_lincons (cube [j]);
+    }
+
+  if (builder)
+    {
+      start = util_cpu_time ();
+      tmp = Ldd_CubeBuilderBuild (b);
+      Ldd_Ref (tmp);
+      elapsed += util_cpu_time () - start;
+      Ldd_RecursiveDeref (ldd, f);
+      f = tmp;
+      Ldd_CubeBuilderQuit (b);
+    }
+
+  fprintf (stdout, "%-8s result=%d nodes time=%ldms\n",
+	   builder ? "builder" : "and/or", Cudd_DagSize (f), elapsed);
+
+  free (cube);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) ncubes = atoi (argv [2]);
+  if (argc > 3) ncons = atoi (argv [3]);
+  if (argc > 4) range = atoi (argv [4]);
+  if (argc > 5) seed = strtoul (argv [5], NULL, 10);
+
+  fprintf (stdout, "DNF of %d cubes of %d constraints over %d vars\n",
+	   ncubes, ncons, nvars);
+  run (0);
+  run (1);
+  return 0;
+}
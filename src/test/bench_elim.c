@@ -0,0 +1,166 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks the elimination orders of Ldd_MvExistAbstract on the
+ * same random formulas. Reports, for each order, the largest
+ * intermediate LDD after a single-variable elimination, the size of
+ * the result, and time.
+ *
+ * usage: bench_elim [nvars [nqvars [ncubes [ncons [seed]]]]]
+ */
+
+static int nvars = 8;
+static int nqvars = 5;
+static int ncubes = 10;
+static int ncons = 5;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* a random constraint +-x +-k*y <= c with k in {0,1,2}, where one in
+   three has a single variable */
+static LddNode *
+rnd_cons (LddManager *ldd, theory_t *t)
+{
+  int *coeff;
+  int x, y;
+  lincons_t l;
+  LddNode *d;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  x = rnd (nvars);
+  y = rnd (nvars);
+  coeff [x] = rnd (2) ? 1 : -1;
+  if (y != x && rnd (3) != 0)
+    coeff [y] = (rnd (2) ? 1 : -1) * (rnd (2) + 1);
+
+  l = t->create_cons (t->create_linterm (coeff, nvars), rnd (4) == 0,
+		      t->create_int_cst (rnd (41) - 20));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+  return d;
+}
+
+static LddNode *
+rnd_formula (LddManager *ldd, theory_t *t)
+{
+  LddNode *f, *c, *d, *tmp;
+  int i, j;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < ncubes; i++)
+    {
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      for (j = 0; j < ncons; j++)
+	{
+	  d = rnd_cons (ldd, t);
+	  tmp = Ldd_And (ldd, c, d);
+	  Ldd_Ref (tmp);
+	  Ldd_RecursiveDeref (ldd, c);
+	  Ldd_RecursiveDeref (ldd, d);
+	  c = tmp;
+	}
+      tmp = Ldd_Or (ldd, f, c);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, f);
+      Ldd_RecursiveDeref (ldd, c);
+      f = tmp;
+    }
+  return f;
+}
+
+/* largest result of a single-variable elimination */
+static int peak;
+
+static LddNode *
+exists_peak (LddManager *ldd, LddNode *f, int var)
+{
+  LddNode *res;
+  int size;
+
+  res = Ldd_ExistsAbstractFM (ldd, f, var);
+  if (res != NULL)
+    {
+      size = Cudd_DagSize (res);
+      if (size > peak) peak = size;
+    }
+  return res;
+}
+
+static void
+run (const char *name, int (*order)(LddManager*,int*,int*,size_t,int*))
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *f, *r;
+  int *qvars;
+  long start, elapsed;
+  int i, size;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+  Ldd_SetExistsAbstract (ldd, exists_peak);
+  Ldd_SetElimOrder (ldd, order);
+
+  rnd_state = seed;
+  f = rnd_formula (ldd, t);
+  size = Cudd_DagSize (f);
+
+  qvars = (int*) malloc (nqvars * sizeof (int));
+  for (i = 0; i < nqvars; i++)
+    qvars [i] = i;
+
+  peak = 0;
+  start = util_cpu_time ();
+  r = Ldd_MvExistAbstract (ldd, f, qvars, nqvars);
+  Ldd_Ref (r);
+  elapsed = util_cpu_time () - start;
+
+  fprintf (stdout, "%-12s input=%d peak=%d result=%d nodes time=%ldms\n",
+	   name, size, peak, Cudd_DagSize (r), elapsed);
+
+  free (qvars);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) nqvars = atoi (argv [2]);
+  if (argc > 3) ncubes = atoi (argv [3]);
+  if (argc > 4) ncons = atoi (argv [4]);
+  if (argc > 5) seed = strtoul (argv [5], NULL, 10);
+  if (nqvars > nvars) nqvars = nvars;
+
+  fprintf (stdout, "Elimination of %d of %d vars, %d cubes of %d "
+	   "constraints\n", nqvars, nvars, ncubes, ncons);
+  run ("min-occur", Ldd_ElimOrderMinOccur);
+  run ("resolvents", Ldd_ElimOrderMinResolvents);
+  run ("min-fill", Ldd_ElimOrderMinFill);
+  run ("box-first", Ldd_ElimOrderBoxFirst);
+  return 0;
+}
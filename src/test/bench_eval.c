@@ -0,0 +1,207 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks the evaluation of an LDD on concrete points: by the
+ * satisfiability of the conjunction of the LDD with the cube of every
+ * point, by Ldd_Eval on every point, and by Ldd_EvalBatch on all the
+ * points at once. The LDD is a random union of boxes, each with a
+ * difference constraint, and the points are drawn from a range that
+ * covers the boxes. Reports the throughput of each method, in points
+ * per second, and the number of points that satisfy the LDD.
+ *
+ * usage: bench_eval [nvars [nboxes [npoints [seed]]]]
+ */
+
+static int nvars = 10;
+static int nboxes = 12;
+static int npoints = 1000000;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static DdManager *cudd;
+static LddManager *ldd;
+static theory_t *t;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* f && g, releases f and g */
+static LddNode *
+and (LddNode *f, LddNode *g)
+{
+  LddNode *r;
+
+  r = Ldd_And (ldd, f, g);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, g);
+  return r;
+}
+
+/* a*x + b*y <= k */
+static LddNode *
+cons (int x, int a, int y, int b, int k)
+{
+  int *coeff;
+  lincons_t l;
+  LddNode *d;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  coeff [x] = a;
+  if (b != 0) coeff [y] = b;
+  l = t->create_cons (t->create_linterm (coeff, nvars), 0,
+		      t->create_int_cst (k));
+  free (coeff);
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  return d;
+}
+
+/* a union of random boxes, each with a constraint x - y <= k */
+static LddNode *
+rnd_ldd (void)
+{
+  LddNode *s, *b, *tmp;
+  int i, j, x, lo;
+
+  s = Ldd_GetFalse (ldd);
+  Ldd_Ref (s);
+  for (i = 0; i < nboxes; i++)
+    {
+      b = Ldd_GetTrue (ldd);
+      Ldd_Ref (b);
+      for (j = 0; j < 3; j++)
+	{
+	  x = rnd (nvars);
+	  lo = rnd (41) - 20;
+	  b = and (b, cons (x, -1, 0, 0, -lo));
+	  b = and (b, cons (x, 1, 0, 0, lo + rnd (20)));
+	}
+      x = rnd (nvars);
+      b = and (b, cons (x, 1, (x + 1) % nvars, -1, rnd (11) - 5));
+
+      tmp = Ldd_Or (ldd, s, b);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, s);
+      Ldd_RecursiveDeref (ldd, b);
+      s = tmp;
+    }
+  return s;
+}
+
+/* s && the point p is satisfiable */
+static int
+eval_and (LddNode *s, int64_t **vals, int p)
+{
+  LddNode *r;
+  int x, res;
+
+  r = s;
+  Ldd_Ref (r);
+  for (x = 0; x < nvars && r != Ldd_GetFalse (ldd); x++)
+    {
+      r = and (r, cons (x, 1, 0, 0, (int) vals [x][p]));
+      r = and (r, cons (x, -1, 0, 0, (int) -vals [x][p]));
+    }
+  res = Ldd_IsSat (ldd, r);
+  Ldd_RecursiveDeref (ldd, r);
+  return res;
+}
+
+static void
+report (const char *name, int n, long elapsed, long sat)
+{
+  fprintf (stdout, "%-10s points=%d time=%ldms rate=%.0f points/s "
+	   "sat=%ld\n", name, n, elapsed,
+	   elapsed > 0 ? n * 1000.0 / elapsed : 0.0, sat);
+  fflush (stdout);
+}
+
+int
+main (int argc, char **argv)
+{
+  LddNode *s;
+  int64_t **vals, *p;
+  char *out;
+  long start, elapsed, sat;
+  int i, x, n;
+
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) nboxes = atoi (argv [2]);
+  if (argc > 3) npoints = atoi (argv [3]);
+  if (argc > 4) seed = strtoul (argv [4], NULL, 10);
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+  rnd_state = seed;
+  s = rnd_ldd ();
+
+  vals = (int64_t**) malloc (nvars * sizeof (int64_t*));
+  for (x = 0; x < nvars; x++)
+    {
+      vals [x] = (int64_t*) malloc (npoints * sizeof (int64_t));
+      for (i = 0; i < npoints; i++)
+	vals [x][i] = rnd (61) - 30;
+    }
+  p = (int64_t*) malloc (nvars * sizeof (int64_t));
+  out = (char*) malloc (npoints);
+
+  fprintf (stdout, "Evaluation: %d vars, %d boxes (%d nodes)\n",
+	   nvars, nboxes, Cudd_DagSize (s));
+
+  /* the conjunction is much slower, and only sees some of the
+     points */
+  n = npoints < 1000 ? npoints : 1000;
+  start = util_cpu_time ();
+  for (sat = 0, i = 0; i < n; i++)
+    sat += eval_and (s, vals, i);
+  elapsed = util_cpu_time () - start;
+  report ("and", n, elapsed, sat);
+
+  start = util_cpu_time ();
+  for (sat = 0, i = 0; i < npoints; i++)
+    {
+      for (x = 0; x < nvars; x++)
+	p [x] = vals [x][i];
+      sat += Ldd_Eval (ldd, s, p);
+    }
+  elapsed = util_cpu_time () - start;
+  report ("eval", npoints, elapsed, sat);
+
+  start = util_cpu_time ();
+  if (Ldd_EvalBatch (ldd, s, (const int64_t * const *) vals,
+		     npoints, out) != 1)
+    {
+      fprintf (stderr, "Ldd_EvalBatch failed\n");
+      return 1;
+    }
+  elapsed = util_cpu_time () - start;
+  for (sat = 0, i = 0; i < npoints; i++)
+    sat += out [i];
+  report ("evalbatch", npoints, elapsed, sat);
+
+  for (x = 0; x < nvars; x++)
+    free (vals [x]);
+  free (vals);
+  free (p);
+  free (out);
+
+  Ldd_RecursiveDeref (ldd, s);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+  return 0;
+}
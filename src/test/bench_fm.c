@@ -0,0 +1,149 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks Fourier-Motzkin elimination (Ldd_ExistsAbstractFM) with
+ * and without pooled allocation of TVPI objects. Reports the number
+ * of objects allocated, the number of calls to malloc, and time.
+ *
+ * usage: bench_fm [nvars [ncubes [ncons [seed]]]]
+ */
+
+static int nvars = 6;
+static int ncubes = 12;
+static int ncons = 4;
+static unsigned long seed = 1;
+
+/* a small deterministic generator, so that both runs see the same
+   input */
+static unsigned long rnd_state;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* a random constraint +-x +-k*y <= c with k in {0,1,2} */
+static LddNode *
+rnd_cons (LddManager *ldd, theory_t *t)
+{
+  int *coeff;
+  int x, y;
+  lincons_t l;
+  LddNode *d;
+
+  coeff = (int*) calloc (nvars, sizeof (int));
+  x = rnd (nvars);
+  y = rnd (nvars);
+  coeff [x] = rnd (2) ? 1 : -1;
+  if (y != x)
+    coeff [y] = (rnd (2) ? 1 : -1) * rnd (3);
+
+  l = t->create_cons (t->create_linterm (coeff, nvars), rnd (4) == 0,
+		      t->create_int_cst (rnd (41) - 20));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+  return d;
+}
+
+static LddNode *
+rnd_formula (LddManager *ldd, theory_t *t)
+{
+  LddNode *f, *c, *d, *tmp;
+  int i, j;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < ncubes; i++)
+    {
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      for (j = 0; j < ncons; j++)
+	{
+	  d = rnd_cons (ldd, t);
+	  tmp = Ldd_And (ldd, c, d);
+	  Ldd_Ref (tmp);
+	  Ldd_RecursiveDeref (ldd, c);
+	  Ldd_RecursiveDeref (ldd, d);
+	  c = tmp;
+	}
+      tmp = Ldd_Or (ldd, f, c);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, f);
+      Ldd_RecursiveDeref (ldd, c);
+      f = tmp;
+    }
+  return f;
+}
+
+static void
+run (int pooled)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *f, *tmp;
+  tvpi_pool_stats_t st;
+  long start, elapsed;
+  int x, size;
+
+  tvpi_pool_enable (pooled);
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (nvars);
+  ldd = Ldd_Init (cudd, t);
+
+  rnd_state = seed;
+  f = rnd_formula (ldd, t);
+
+  tvpi_pool_reset_stats ();
+  start = util_cpu_time ();
+  /* eliminate all but the last variable */
+  for (x = 0; x + 1 < nvars; x++)
+    {
+      tmp = Ldd_ExistsAbstractFM (ldd, f, x);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, f);
+      f = tmp;
+    }
+  elapsed = util_cpu_time () - start;
+  tvpi_pool_get_stats (&st);
+  size = Cudd_DagSize (f);
+
+  fprintf (stdout, "%-8s cons=%lu cst=%lu malloc=%lu scopes=%lu "
+	   "time=%ldms result=%d nodes\n",
+	   pooled ? "pool" : "malloc", st.cons_allocs, st.cst_allocs,
+	   st.mallocs, st.scratch_resets, elapsed, size);
+  fprintf (stdout, "%-8s cache lookups=%.0f hits=%.0f slots=%u\n", "",
+	   Ldd_ReadCacheLookUps (ldd), Ldd_ReadCacheHits (ldd),
+	   Ldd_ReadCacheSlots (ldd));
+
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (int argc, char **argv)
+{
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) ncubes = atoi (argv [2]);
+  if (argc > 3) ncons = atoi (argv [3]);
+  if (argc > 4) seed = strtoul (argv [4], NULL, 10);
+
+  fprintf (stdout, "FM elimination: %d vars, %d cubes of %d constraints\n",
+	   nvars, ncubes, ncons);
+  run (0);
+  run (1);
+  return 0;
+}
@@ -0,0 +1,177 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Benchmarks Ldd_Constrain, Ldd_Restrict and Ldd_Minimize on a random
+ * transition relation of guarded commands over x0..x(n-1) and their
+ * next state copies x(n)..x(2n-1), simplified against a care set of
+ * reachable states, a union of boxes over x0..x(n-1). Reports sizes
+ * and time.
+ *
+ * usage: bench_restrict [nvars [ncmds [nboxes [seed]]]]
+ */
+
+static int nvars = 6;
+static int ncmds = 24;
+static int nboxes = 12;
+static unsigned long seed = 1;
+
+static unsigned long rnd_state;
+
+static int
+rnd (int n)
+{
+  rnd_state = rnd_state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((rnd_state >> 33) % (unsigned long) n);
+}
+
+/* a x + b y <= k over the 2 * nvars variables */
+static LddNode *
+cons2 (LddManager *ldd, theory_t *t, int x, int a, int y, int b, int k)
+{
+  int *coeff;
+  lincons_t l;
+  LddNode *d;
+
+  coeff = (int*) calloc (2 * nvars, sizeof (int));
+  coeff [x] = a;
+  if (b != 0) coeff [y] = b;
+  l = t->create_cons (t->create_linterm (coeff, 2 * nvars), 0,
+		      t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  Ldd_Ref (d);
+  t->destroy_lincons (l);
+  free (coeff);
+  return d;
+}
+
+static LddNode *
+and_or (LddManager *ldd, LddNode *f, LddNode *g, int or)
+{
+  LddNode *r;
+
+  r = or ? Ldd_Or (ldd, f, g) : Ldd_And (ldd, f, g);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, g);
+  return r;
+}
+
+/* lo <= x <= hi */
+static LddNode *
+interval (LddManager *ldd, theory_t *t, int x, int lo, int hi)
+{
+  return and_or (ldd, cons2 (ldd, t, x, -1, 0, 0, -lo),
+		 cons2 (ldd, t, x, 1, 0, 0, hi), 0);
+}
+
+/* a guard on two variables, and x' = x + k for two variables, the
+   others are unconstrained */
+static LddNode *
+rnd_cmd (LddManager *ldd, theory_t *t)
+{
+  LddNode *c;
+  int i, x, lo, k;
+
+  c = Ldd_GetTrue (ldd);
+  Ldd_Ref (c);
+  for (i = 0; i < 2; i++)
+    {
+      x = rnd (nvars);
+      lo = rnd (16);
+      c = and_or (ldd, c, interval (ldd, t, x, lo, lo + rnd (8)), 0);
+    }
+  for (i = 0; i < 2; i++)
+    {
+      x = rnd (nvars);
+      k = rnd (3) - 1;
+      c = and_or (ldd, c, cons2 (ldd, t, nvars + x, 1, x, -1, k), 0);
+      c = and_or (ldd, c, cons2 (ldd, t, nvars + x, -1, x, 1, -k), 0);
+    }
+  return c;
+}
+
+/* a box of width 4 on every state variable */
+static LddNode *
+rnd_box (LddManager *ldd, theory_t *t)
+{
+  LddNode *c;
+  int x, lo;
+
+  c = Ldd_GetTrue (ldd);
+  Ldd_Ref (c);
+  for (x = 0; x < nvars; x++)
+    {
+      lo = rnd (20);
+      c = and_or (ldd, c, interval (ldd, t, x, lo, lo + 4), 0);
+    }
+  return c;
+}
+
+static void
+report (LddManager *ldd, const char *name,
+	LddNode *(*op)(LddManager*, LddNode*, LddNode*),
+	LddNode *f, LddNode *c)
+{
+  LddNode *r;
+  long start, elapsed;
+
+  start = util_cpu_time ();
+  r = op (ldd, f, c);
+  Ldd_Ref (r);
+  elapsed = util_cpu_time () - start;
+
+  fprintf (stdout, "%-10s result=%d nodes time=%ldms\n",
+	   name, Cudd_DagSize (r), elapsed);
+  Ldd_RecursiveDeref (ldd, r);
+}
+
+int
+main (int argc, char **argv)
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *f, *c;
+  int i;
+
+  if (argc > 1) nvars = atoi (argv [1]);
+  if (argc > 2) ncmds = atoi (argv [2]);
+  if (argc > 3) nboxes = atoi (argv [3]);
+  if (argc > 4) seed = strtoul (argv [4], NULL, 10);
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (2 * nvars);
+  ldd = Ldd_Init (cudd, t);
+  rnd_state = seed;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < ncmds; i++)
+    f = and_or (ldd, f, rnd_cmd (ldd, t), 1);
+
+  c = Ldd_GetFalse (ldd);
+  Ldd_Ref (c);
+  for (i = 0; i < nboxes; i++)
+    c = and_or (ldd, c, rnd_box (ldd, t), 1);
+
+  fprintf (stdout, "%d commands over %d vars, care set of %d boxes\n",
+	   ncmds, nvars, nboxes);
+  fprintf (stdout, "%-10s result=%d nodes\n", "relation", Cudd_DagSize (f));
+  fprintf (stdout, "%-10s result=%d nodes\n", "care set", Cudd_DagSize (c));
+  report (ldd, "constrain", Ldd_Constrain, f, c);
+  report (ldd, "restrict", Ldd_Restrict, f, c);
+  report (ldd, "minimize", Ldd_Minimize, f, c);
+
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, c);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+  return 0;
+}
@@ -0,0 +1,163 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+
+/**
+ * Tests Ldd_AndN and Ldd_OrN: they agree with folding Ldd_And and
+ * Ldd_Or, handle empty arrays and constant operands, and stop early
+ * on false (true) operands.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 4
+#define NOPS 12
+
+/* creates an LDD for c[0]*x0 + ... + c[NVARS-1]*x(NVARS-1) op k */
+LddNode *
+cons (int *c, int strict, int k)
+{
+  lincons_t l;
+  LddNode *d;
+
+  l = t->create_cons (t->create_linterm (c, NVARS), strict,
+		      t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  t->destroy_lincons (l);
+  Ldd_Ref (d);
+  return d;
+}
+
+/* (xi - x(i+1) <= i || x(i+2) < 3 - i), for i = 0, 1, ... */
+void
+guards (LddNode **fs, int n)
+{
+  LddNode *a, *b;
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      int c[NVARS] = {0, 0, 0, 0};
+      int d[NVARS] = {0, 0, 0, 0};
+
+      c [i % NVARS] = 1;
+      c [(i + 1) % NVARS] = -1;
+      d [(i + 2) % NVARS] = i % 2 ? 1 : -1;
+      a = cons (c, 0, i);
+      b = cons (d, 1, 3 - i);
+      fs [i] = Ldd_Or (ldd, a, b);
+      Ldd_Ref (fs [i]);
+      Ldd_RecursiveDeref (ldd, a);
+      Ldd_RecursiveDeref (ldd, b);
+    }
+}
+
+/* left-to-right fold of Ldd_And or Ldd_Or */
+LddNode *
+fold (LddNode **fs, int n, int or)
+{
+  LddNode *r, *tmp;
+  int i;
+
+  r = or ? Ldd_GetFalse (ldd) : Ldd_GetTrue (ldd);
+  Ldd_Ref (r);
+  for (i = 0; i < n; i++)
+    {
+      tmp = or ? Ldd_Or (ldd, r, fs [i]) : Ldd_And (ldd, r, fs [i]);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      r = tmp;
+    }
+  return r;
+}
+
+void
+test_fold (void)
+{
+  LddNode *fs [NOPS];
+  LddNode *r, *e;
+  int n, i;
+
+  guards (fs, NOPS);
+  for (n = 1; n <= NOPS; n++)
+    {
+      e = fold (fs, n, 0);
+      r = Ldd_AndN (ldd, fs, n);
+      assert (r == e);
+      Ldd_RecursiveDeref (ldd, e);
+
+      e = fold (fs, n, 1);
+      r = Ldd_OrN (ldd, fs, n);
+      assert (r == e);
+      Ldd_RecursiveDeref (ldd, e);
+    }
+
+  for (i = 0; i < NOPS; i++)
+    Ldd_RecursiveDeref (ldd, fs [i]);
+}
+
+void
+test_constants (void)
+{
+  LddNode *fs [4];
+  LddNode *one, *zero, *r;
+  int i;
+
+  one = Ldd_GetTrue (ldd);
+  zero = Ldd_GetFalse (ldd);
+
+  r = Ldd_AndN (ldd, fs, 0);
+  assert (r == one);
+  r = Ldd_OrN (ldd, fs, 0);
+  assert (r == zero);
+
+  guards (fs, 2);
+  fs [2] = one;
+  fs [3] = zero;
+  r = Ldd_AndN (ldd, fs, 4);
+  assert (r == zero);
+  r = Ldd_OrN (ldd, fs, 4);
+  assert (r == one);
+
+  /* true is the identity of conjunction, and false of disjunction */
+  fs [3] = fs [1];
+  fs [1] = one;
+  r = Ldd_AndN (ldd, fs, 2);
+  assert (r == fs [0]);
+  fs [1] = zero;
+  r = Ldd_OrN (ldd, fs, 2);
+  assert (r == fs [0]);
+
+  /* f && !f */
+  fs [1] = Ldd_Not (fs [0]);
+  r = Ldd_AndN (ldd, fs, 2);
+  assert (r == zero);
+  r = Ldd_OrN (ldd, fs, 2);
+  assert (r == one);
+
+  for (i = 0; i < 4; i += 3)
+    Ldd_RecursiveDeref (ldd, fs [i]);
+}
+
+int
+main (void)
+{
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  test_fold ();
+  test_constants ();
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,212 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Tests Ldd_GetBounds and Ldd_GetBoundsN on random unions of boxes.
+ * The interval of a variable must be the interval hull of the
+ * projection of the LDD on it, the interval of -x must be the
+ * negation of the interval of x, and Ldd_GetBoundsN must agree with
+ * Ldd_GetBounds on every variable. With relational constraints in
+ * the TVPI theory, the interval must contain the projection.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 3
+#define NCONS 8
+#define NFORMS 100
+
+/* a*x + b*y <= k, or < k if strict */
+static LddNode *
+cons (int x, int a, int y, int b, int strict, int k)
+{
+  return cons_xy (ldd, NVARS, x, a, y, b, strict, k);
+}
+
+/* a random combination of bounds, and of x - y <= k if rel */
+static LddNode *
+rnd_formula (int rel)
+{
+  LddNode *f, *c;
+  int i, x;
+
+  f = Ldd_GetTrue (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NCONS; i++)
+    {
+      x = rnd (NVARS);
+      if (rel && rnd (4) == 0)
+	c = cons (x, 1, (x + 1) % NVARS, -1, rnd (2), rnd (11) - 5);
+      else
+	c = cons (x, rnd (2) ? 1 : -1, 0, 0, rnd (2), rnd (21) - 10);
+      f = and_or (ldd, f, c, i > 0 && rnd (3) == 0);
+    }
+  return f;
+}
+
+/* the LDD of the interval of x */
+static LddNode *
+interval (int x, int sat, constant_t lo, constant_t hi, int slo, int shi)
+{
+  LddNode *r, *b;
+  lincons_t l;
+
+  r = sat ? Ldd_GetTrue (ldd) : Ldd_GetFalse (ldd);
+  Ldd_Ref (r);
+  if (hi != NULL)
+    {
+      l = t->create_cons (term_xy (t, NVARS, x, 1, 0, 0), shi,
+			  t->dup_cst (hi));
+      b = Ldd_FromCons (ldd, l);
+      Ldd_Ref (b);
+      t->destroy_lincons (l);
+      r = and_or (ldd, r, b, 0);
+    }
+  if (lo != NULL)
+    {
+      l = t->create_cons (term_xy (t, NVARS, x, -1, 0, 0), slo,
+			  t->negate_cst (lo));
+      b = Ldd_FromCons (ldd, l);
+      Ldd_Ref (b);
+      t->destroy_lincons (l);
+      r = and_or (ldd, r, b, 0);
+    }
+  return r;
+}
+
+/* exists all variables of f but x */
+static LddNode *
+project (LddNode *f, int x)
+{
+  LddNode *r, *tmp;
+  int i;
+
+  r = f;
+  Ldd_Ref (r);
+  for (i = 0; i < NVARS; i++)
+    {
+      if (i == x) continue;
+      tmp = Ldd_ExistsAbstract (ldd, r, i);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      r = tmp;
+    }
+  return r;
+}
+
+static void
+destroy (constant_t c)
+{
+  if (c != NULL) t->destroy_cst (c);
+}
+
+static int
+cst_eq (constant_t a, constant_t b)
+{
+  if (a == NULL || b == NULL) return a == b;
+  return t->cst_get_si_num (a) == t->cst_get_si_num (b) &&
+    t->cst_get_si_den (a) == t->cst_get_si_den (b);
+}
+
+static void
+test_bounds (theory_t *(*create) (size_t), int rel, int dyn)
+{
+  constant_t lo, hi, nlo, nhi, l, h, alo [NVARS], ahi [NVARS];
+  int slo, shi, snlo, snhi, aslo [NVARS], ashi [NVARS];
+  linterm_t tx, ntx;
+  LddNode *f, *p, *b, *tmp;
+  int i, x, sat, nsat, asat;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = create (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn) Cudd_AutodynEnable (cudd, CUDD_REORDER_GROUP_SIFT);
+
+  for (i = 0; i < NFORMS; i++)
+    {
+      f = rnd_formula (rel);
+      asat = Ldd_GetBoundsN (ldd, f, alo, ahi, aslo, ashi);
+      assert (asat >= 0);
+
+      for (x = 0; x < NVARS; x++)
+	{
+	  tx = term_xy (t, NVARS, x, 1, 0, 0);
+	  ntx = term_xy (t, NVARS, x, -1, 0, 0);
+	  sat = Ldd_GetBounds (ldd, f, tx, &lo, &hi, &slo, &shi);
+	  nsat = Ldd_GetBounds (ldd, f, ntx, &nlo, &nhi, &snlo, &snhi);
+	  assert (sat >= 0 && sat == nsat);
+	  assert (!sat || f != Ldd_GetFalse (ldd));
+	  t->destroy_term (tx);
+	  t->destroy_term (ntx);
+
+	  b = interval (x, sat, lo, hi, slo, shi);
+	  p = project (f, x);
+	  if (rel)
+	    assert (Ldd_Leq (ldd, p, b));
+	  else
+	    {
+	      tmp = Ldd_TermMinmaxApprox (ldd, p);
+	      Ldd_Ref (tmp);
+	      assert (Ldd_Equiv (ldd, tmp, b));
+	      Ldd_RecursiveDeref (ldd, tmp);
+	    }
+	  Ldd_RecursiveDeref (ldd, p);
+	  Ldd_RecursiveDeref (ldd, b);
+
+	  /* the bounds of -x are those of x, negated */
+	  l = nhi == NULL ? NULL : t->negate_cst (nhi);
+	  h = nlo == NULL ? NULL : t->negate_cst (nlo);
+	  b = interval (x, nsat, l, h, snhi, snlo);
+	  destroy (l);
+	  destroy (h);
+	  tmp = interval (x, sat, lo, hi, slo, shi);
+	  assert (!sat || tmp == b);
+	  Ldd_RecursiveDeref (ldd, tmp);
+	  Ldd_RecursiveDeref (ldd, b);
+
+	  /* Ldd_GetBoundsN agrees */
+	  if (sat && asat)
+	    {
+	      assert (cst_eq (lo, alo [x]) && cst_eq (hi, ahi [x]));
+	      assert (lo == NULL || slo == aslo [x]);
+	      assert (hi == NULL || shi == ashi [x]);
+	    }
+	  destroy (lo);
+	  destroy (hi);
+	  destroy (nlo);
+	  destroy (nhi);
+	  destroy (alo [x]);
+	  destroy (ahi [x]);
+	}
+      Ldd_RecursiveDeref (ldd, f);
+    }
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  int dyn;
+
+  for (dyn = 0; dyn < 2; dyn++)
+    {
+      test_bounds (tvpi_create_theory, 0, dyn);
+      test_bounds (tvpi_create_theory, 1, dyn);
+      test_bounds (tvpi_create_box_theory, 0, dyn);
+      test_bounds (tvpi_create_boxz_theory, 0, dyn);
+    }
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
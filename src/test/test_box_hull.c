@@ -0,0 +1,228 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Tests Ldd_BoxHull and Ldd_BoxJoinK on random unions of boxes. Both
+ * must contain the LDD, the hull must be a cube, and Ldd_BoxJoinK
+ * must lie between the LDD and its hull, be the hull for k = 1, and
+ * the LDD itself when k exceeds its number of paths. In the Box
+ * theories, the hull must also be the least box: its projection on
+ * every variable is the interval hull of the projection of the LDD.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 3
+#define NCONS 8
+#define NFORMS 100
+
+/* a*x <= k, or < k if strict */
+static LddNode *
+cons (int x, int a, int strict, int k)
+{
+  return cons_xy (ldd, NVARS, x, a, 0, 0, strict, k);
+}
+
+/* a random combination of bounds */
+static LddNode *
+rnd_box_formula (void)
+{
+  LddNode *f;
+  int i;
+
+  f = cons (rnd (NVARS), rnd (2) ? 1 : -1, rnd (2), rnd (21) - 10);
+  for (i = 1; i < NCONS; i++)
+    f = and_or (ldd, f, cons (rnd (NVARS), rnd (2) ? 1 : -1, rnd (2),
+			      rnd (21) - 10), rnd (3) == 0);
+  return f;
+}
+
+/* the number of paths of f to true */
+static int
+npaths (LddNode *f)
+{
+  LddNode *F;
+
+  F = Cudd_Regular (f);
+  if (F == Ldd_GetTrue (ldd)) return f == F;
+  return npaths (Cudd_NotCond (Cudd_T (F), F != f)) +
+    npaths (Cudd_NotCond (Cudd_E (F), F != f));
+}
+
+/* a distance that merges the first two boxes */
+static double
+zero_dist (LddManager *m, LddNode *a, LddNode *b)
+{
+  (void) m;
+  (void) a;
+  (void) b;
+  return 0.0;
+}
+
+static void
+test_distance (void)
+{
+  LddNode *a, *b, *r;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_box_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  /* [0,1] x [0,1] and [3,5] x [4,6] are 2 + 3 apart */
+  a = and_or (ldd, and_or (ldd, cons (0, 1, 0, 1), cons (0, -1, 0, 0), 0),
+	      and_or (ldd, cons (1, 1, 0, 1), cons (1, -1, 0, 0), 0), 0);
+  b = and_or (ldd, and_or (ldd, cons (0, 1, 0, 5), cons (0, -1, 0, -3), 0),
+	      and_or (ldd, cons (1, 1, 0, 6), cons (1, -1, 0, -4), 0), 0);
+  assert (Ldd_BoxDistance (ldd, a, b) == 5.0);
+  assert (Ldd_BoxDistance (ldd, b, a) == 5.0);
+  assert (Ldd_BoxDistance (ldd, a, a) == 0.0);
+  Ldd_RecursiveDeref (ldd, b);
+
+  /* x >= 1 touches [0,1], and bounds y in no box */
+  b = cons (0, -1, 0, -1);
+  assert (Ldd_BoxDistance (ldd, a, b) == 0.0);
+  Ldd_RecursiveDeref (ldd, b);
+  Ldd_RecursiveDeref (ldd, a);
+
+  /* the closest of [0,1], [3,4] and [10,11] are joined */
+  a = and_or (ldd, cons (0, 1, 0, 1), cons (0, -1, 0, 0), 0);
+  a = and_or (ldd, a,
+	      and_or (ldd, cons (0, 1, 0, 4), cons (0, -1, 0, -3), 0), 1);
+  a = and_or (ldd, a,
+	      and_or (ldd, cons (0, 1, 0, 11), cons (0, -1, 0, -10), 0), 1);
+  r = Ldd_BoxJoinK (ldd, a, 2, NULL);
+  Ldd_Ref (r);
+  b = and_or (ldd, cons (0, 1, 0, 4), cons (0, -1, 0, 0), 0);
+  b = and_or (ldd, b,
+	      and_or (ldd, cons (0, 1, 0, 11), cons (0, -1, 0, -10), 0), 1);
+  assert (r == b);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, b);
+
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+static void
+test_hull (theory_t *(*create) (size_t), int box, int dyn)
+{
+  LddNode *f, *h, *r, *p, *q, *tmp, *H;
+  int i, k, x, n;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = create (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn) Cudd_AutodynEnable (cudd, CUDD_REORDER_GROUP_SIFT);
+
+  for (i = 0; i < NFORMS; i++)
+    {
+      f = rnd_box_formula ();
+
+      h = Ldd_BoxHull (ldd, f);
+      Ldd_Ref (h);
+      assert (Ldd_Leq (ldd, f, h));
+
+      /* a cube */
+      for (tmp = h; Cudd_Regular (tmp) != Ldd_GetTrue (ldd);)
+	{
+	  H = Cudd_Regular (tmp);
+	  if (Cudd_NotCond (Cudd_E (H), H != tmp) == Ldd_GetFalse (ldd))
+	    tmp = Cudd_NotCond (Cudd_T (H), H != tmp);
+	  else
+	    {
+	      assert (Cudd_NotCond (Cudd_T (H), H != tmp) ==
+		      Ldd_GetFalse (ldd));
+	      tmp = Cudd_NotCond (Cudd_E (H), H != tmp);
+	    }
+	}
+      assert (f == Ldd_GetFalse (ldd) || tmp == Ldd_GetTrue (ldd));
+
+      /* the least box */
+      for (x = 0; box && x < NVARS; x++)
+	{
+	  p = f;
+	  q = h;
+	  Ldd_Ref (p);
+	  Ldd_Ref (q);
+	  for (k = 0; k < NVARS; k++)
+	    {
+	      if (k == x) continue;
+	      tmp = Ldd_ExistsAbstractBox (ldd, p, k);
+	      Ldd_Ref (tmp);
+	      Ldd_RecursiveDeref (ldd, p);
+	      p = tmp;
+	      tmp = Ldd_ExistsAbstractBox (ldd, q, k);
+	      Ldd_Ref (tmp);
+	      Ldd_RecursiveDeref (ldd, q);
+	      q = tmp;
+	    }
+	  tmp = Ldd_TermMinmaxApprox (ldd, p);
+	  Ldd_Ref (tmp);
+	  assert (Ldd_Equiv (ldd, tmp, q));
+	  Ldd_RecursiveDeref (ldd, tmp);
+	  Ldd_RecursiveDeref (ldd, p);
+	  Ldd_RecursiveDeref (ldd, q);
+	}
+
+      r = Ldd_BoxJoinK (ldd, f, 1, NULL);
+      Ldd_Ref (r);
+      assert (r == h);
+      Ldd_RecursiveDeref (ldd, r);
+
+      n = npaths (f);
+      for (k = 2; k <= 5; k++)
+	{
+	  r = Ldd_BoxJoinK (ldd, f, k, NULL);
+	  Ldd_Ref (r);
+	  assert (Ldd_Leq (ldd, f, r));
+	  assert (Ldd_Leq (ldd, r, h));
+	  if (k >= n) assert (Ldd_Equiv (ldd, r, f));
+	  Ldd_RecursiveDeref (ldd, r);
+
+	  r = Ldd_BoxJoinK (ldd, f, k, zero_dist);
+	  Ldd_Ref (r);
+	  assert (Ldd_Leq (ldd, f, r));
+	  assert (Ldd_Leq (ldd, r, h));
+	  Ldd_RecursiveDeref (ldd, r);
+	}
+
+      r = Ldd_BoxJoinK (ldd, f, n, NULL);
+      Ldd_Ref (r);
+      assert (Ldd_Equiv (ldd, r, f));
+      Ldd_RecursiveDeref (ldd, r);
+
+      Ldd_RecursiveDeref (ldd, h);
+      Ldd_RecursiveDeref (ldd, f);
+    }
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  int dyn;
+
+  test_distance ();
+  for (dyn = 0; dyn < 2; dyn++)
+    {
+      test_hull (tvpi_create_theory, 0, dyn);
+      test_hull (tvpi_create_box_theory, 1, dyn);
+      test_hull (tvpi_create_boxz_theory, 1, dyn);
+    }
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -332,6 +332,175 @@ void test3 ()
   
 }
 
+void test4 ()
+{
+  /* widening with the landmarks -10, 0, 10, 100 of x */
+  int x[3] = {0, 1, 0};
+  int nx[3] = {0, -1, 0};
+
+  constant_t lm[4];
+  constant_t *th[3] = {NULL, lm, NULL};
+  int n[3] = {0, 4, 0};
+
+  LddNode *up3, *up5, *up10, *up20, *up100, *up200;
+  LddNode *lo1, *lom2, *lo10;
+  LddNode *box1, *box2, *box3, *box4, *r;
+
+  fprintf (stdout, "\n\nTEST 4\n");
+
+  lm[0] = C(-10);
+  lm[1] = C(0);
+  lm[2] = C(10);
+  lm[3] = C(100);
+
+  up3 = Ldd_FromCons (tdd, CONS (x, 3, 3));
+  Ldd_Ref (up3);
+  up5 = Ldd_FromCons (tdd, CONS (x, 3, 5));
+  Ldd_Ref (up5);
+  up10 = Ldd_FromCons (tdd, CONS (x, 3, 10));
+  Ldd_Ref (up10);
+  up20 = Ldd_FromCons (tdd, CONS (x, 3, 20));
+  Ldd_Ref (up20);
+  up100 = Ldd_FromCons (tdd, CONS (x, 3, 100));
+  Ldd_Ref (up100);
+  up200 = Ldd_FromCons (tdd, CONS (x, 3, 200));
+  Ldd_Ref (up200);
+  /* -x <= -1, -x <= 2, -x <= 10 */
+  lo1 = Ldd_FromCons (tdd, CONS (nx, 3, -1));
+  Ldd_Ref (lo1);
+  lom2 = Ldd_FromCons (tdd, CONS (nx, 3, 2));
+  Ldd_Ref (lom2);
+  lo10 = Ldd_FromCons (tdd, CONS (nx, 3, 10));
+  Ldd_Ref (lo10);
+
+  /* [1,3] widened by [1,5] is [1,10] */
+  box1 = Ldd_And (tdd, up3, lo1);
+  Ldd_Ref (box1);
+  box2 = Ldd_And (tdd, up5, lo1);
+  Ldd_Ref (box2);
+  box3 = Ldd_And (tdd, up10, lo1);
+  Ldd_Ref (box3);
+
+  r = Ldd_BoxWidenThresholds (tdd, box1, box2, th, n, 3);
+  Ldd_Ref (r);
+  Ldd_PrintMinterm (tdd, r);
+  assert (r == box3);
+  Ldd_RecursiveDeref (tdd, r);
+
+  r = Ldd_BoxWiden2Thresholds (tdd, box1, box2, th, n, 3);
+  Ldd_Ref (r);
+  assert (r == box3);
+  Ldd_RecursiveDeref (tdd, r);
+
+  r = Ldd_IntervalWidenThresholds (tdd, box1, box2, th, n, 3);
+  Ldd_Ref (r);
+  assert (r == box3);
+  Ldd_RecursiveDeref (tdd, r);
+
+  /* without landmarks, the bound goes to infinity */
+  r = Ldd_BoxWidenThresholds (tdd, box1, box2, NULL, NULL, 0);
+  Ldd_Ref (r);
+  assert (r == Ldd_BoxWiden (tdd, box1, box2));
+  assert (r == lo1);
+  Ldd_RecursiveDeref (tdd, r);
+
+  /* [1,10] widened by [1,20] is [1,100], and [1,100] widened by
+     [1,200] is [1,oo) */
+  box4 = Ldd_And (tdd, up20, lo1);
+  Ldd_Ref (box4);
+  r = Ldd_BoxWidenThresholds (tdd, box3, box4, th, n, 3);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (tdd, box4);
+  box4 = Ldd_And (tdd, up100, lo1);
+  Ldd_Ref (box4);
+  assert (r == box4);
+  Ldd_RecursiveDeref (tdd, r);
+
+  Ldd_RecursiveDeref (tdd, box2);
+  box2 = Ldd_And (tdd, up200, lo1);
+  Ldd_Ref (box2);
+  r = Ldd_BoxWidenThresholds (tdd, box4, box2, th, n, 3);
+  Ldd_Ref (r);
+  assert (r == lo1);
+  Ldd_RecursiveDeref (tdd, r);
+  Ldd_RecursiveDeref (tdd, box4);
+
+  /* [1,3] widened by [-2,3] is [-10,3] */
+  Ldd_RecursiveDeref (tdd, box2);
+  box2 = Ldd_And (tdd, up3, lom2);
+  Ldd_Ref (box2);
+  box4 = Ldd_And (tdd, up3, lo10);
+  Ldd_Ref (box4);
+
+  r = Ldd_BoxWidenThresholds (tdd, box1, box2, th, n, 3);
+  Ldd_Ref (r);
+  Ldd_PrintMinterm (tdd, r);
+  assert (r == box4);
+  Ldd_RecursiveDeref (tdd, r);
+
+  r = Ldd_BoxWiden2Thresholds (tdd, box1, box2, th, n, 3);
+  Ldd_Ref (r);
+  assert (r == box4);
+  Ldd_RecursiveDeref (tdd, r);
+
+  r = Ldd_IntervalWidenThresholds (tdd, box1, box2, th, n, 3);
+  Ldd_Ref (r);
+  assert (r == box4);
+  Ldd_RecursiveDeref (tdd, r);
+
+  /* a union of boxes: only the unstable bound of the last box moves */
+  {
+    LddNode *f, *g, *h, *b;
+
+    /* f = [1,3], g = [1,3] || [5,20], h = [1,3] || [5,100] */
+    f = box1;
+    Ldd_Ref (f);
+    b = Ldd_FromCons (tdd, CONS (nx, 3, -5));
+    Ldd_Ref (b);
+    g = Ldd_And (tdd, b, up20);
+    Ldd_Ref (g);
+    h = Ldd_And (tdd, b, up100);
+    Ldd_Ref (h);
+    Ldd_RecursiveDeref (tdd, b);
+
+    b = Ldd_Or (tdd, f, g);
+    Ldd_Ref (b);
+    Ldd_RecursiveDeref (tdd, g);
+    g = b;
+    b = Ldd_Or (tdd, f, h);
+    Ldd_Ref (b);
+    Ldd_RecursiveDeref (tdd, h);
+    h = b;
+
+    r = Ldd_BoxWidenThresholds (tdd, f, g, th, n, 3);
+    Ldd_Ref (r);
+    Ldd_PrintMinterm (tdd, r);
+    assert (Ldd_TermLeq (tdd, g, r));
+    assert (r == h);
+
+    Ldd_RecursiveDeref (tdd, r);
+    Ldd_RecursiveDeref (tdd, f);
+    Ldd_RecursiveDeref (tdd, g);
+    Ldd_RecursiveDeref (tdd, h);
+  }
+
+  Ldd_RecursiveDeref (tdd, box1);
+  Ldd_RecursiveDeref (tdd, box2);
+  Ldd_RecursiveDeref (tdd, box3);
+  Ldd_RecursiveDeref (tdd, box4);
+  Ldd_RecursiveDeref (tdd, up3);
+  Ldd_RecursiveDeref (tdd, up5);
+  Ldd_RecursiveDeref (tdd, up10);
+  Ldd_RecursiveDeref (tdd, up20);
+  Ldd_RecursiveDeref (tdd, up100);
+  Ldd_RecursiveDeref (tdd, up200);
+  Ldd_RecursiveDeref (tdd, lo1);
+  Ldd_RecursiveDeref (tdd, lom2);
+  Ldd_RecursiveDeref (tdd, lo10);
+  for (n[1] = 0; n[1] < 4; n[1]++)
+    t->destroy_cst (lm[n[1]]);
+}
+
 
 int t_type = 2;
 
@@ -354,5 +523,6 @@ int main(int argc, char** argv)
   test2 ();
   /* ---------------------------------------- */
   test3 ();
+  test4 ();
   return 0;
 }
@@ -0,0 +1,359 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Tests the assignments on Boxes LDDs. In the TVPI theory, x := c,
+ * x := x + c, x := -x, x := x + x and havoc x must agree with
+ * existential quantification of a copy of x, and x := y and x := x + y
+ * must agree with the box hulls of the post-images of the paths of
+ * the LDD. In the Box theories, havoc and x := c must agree with
+ * Ldd_ExistsAbstractBox, x := x + c and x := -x must be invertible,
+ * and x := y and x := x + y must only change x.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+/* x, y, w, and z, the copy of x */
+#define X 0
+#define Y 1
+#define Z 3
+#define NVARS 4
+#define NCONS 8
+#define NFORMS 100
+
+/* a*x + b*y <= k, or < k if strict */
+static LddNode *
+cons (int x, int a, int y, int b, int strict, int k)
+{
+  return cons_xy (ldd, NVARS, x, a, y, b, strict, k);
+}
+
+/* takes the reference of r */
+static void
+check_equiv (LddNode *r, LddNode *expected)
+{
+  assert (Ldd_Equiv (ldd, r, expected) == 1);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, expected);
+}
+
+/* a random combination of bounds on x, y and w */
+static LddNode *
+rnd_box_formula (int strict)
+{
+  LddNode *f;
+  int i;
+
+  f = cons (rnd (3), rnd (2) ? 1 : -1, 0, 0, strict && rnd (2),
+	    rnd (11) - 5);
+  for (i = 1; i < NCONS; i++)
+    f = and_or (ldd, f, cons (rnd (3), rnd (2) ? 1 : -1, 0, 0,
+			      strict && rnd (2), rnd (11) - 5), rnd (3) == 0);
+  return f;
+}
+
+/* exists z. f[x/z] && rel, releases rel */
+static LddNode *
+post (LddNode *f, LddNode *rel)
+{
+  int perm [NVARS] = {Z, 1, 2, X};
+  LddNode *g, *r;
+
+  g = Ldd_Permute (ldd, f, perm);
+  Ldd_Ref (g);
+  g = and_or (ldd, g, rel, 0);
+  r = Ldd_ExistsAbstractFM (ldd, g, Z);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, g);
+  return r;
+}
+
+/* exists all variables of f but x */
+static LddNode *
+project (LddNode *f, int x)
+{
+  LddNode *r, *tmp;
+  int i;
+
+  r = f;
+  Ldd_Ref (r);
+  for (i = 0; i < NVARS; i++)
+    {
+      if (i == x) continue;
+      tmp = Ldd_ExistsAbstractFM (ldd, r, i);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      r = tmp;
+    }
+  return r;
+}
+
+/* the box hull of the post-image of x := y (xpy = 0) or x := x + y
+   (xpy = 1) on the path given by cube */
+static LddNode *
+hull (int *cube, int size, int xpy)
+{
+  LddNode *e, *r;
+  lincons_t l, nl;
+  linterm_t tm;
+  int i, a;
+
+  /* the exact post-image: the bounds of x become bounds of x - y, or
+     x = y */
+  e = xpy ? Ldd_GetTrue (ldd) : cons (X, 1, Y, -1, 0, 0);
+  Ldd_Ref (e);
+  if (!xpy)
+    e = and_or (ldd, e, cons (X, -1, Y, 1, 0, 0), 0);
+  for (i = 0; i < size; i++)
+    {
+      if (cube [i] == 2) continue;
+      l = Ldd_GetCons (ldd, Cudd_bddIthVar (cudd, i));
+      l = cube [i] ? t->dup_lincons (l) : t->negate_cons (l);
+      if (t->term_has_var (t->get_term (l), X))
+	{
+	  if (xpy)
+	    {
+	      tm = term_xy (t, NVARS, X, 1, 0, 0);
+	      a = t->term_equals (t->get_term (l), tm) ? 1 : -1;
+	      t->destroy_term (tm);
+	      nl = t->create_cons (term_xy (t, NVARS, X, a, Y, -a),
+				   t->is_strict (l),
+				   t->dup_cst (t->get_constant (l)));
+	      r = Ldd_FromCons (ldd, nl);
+	      Ldd_Ref (r);
+	      t->destroy_lincons (nl);
+	      e = and_or (ldd, e, r, 0);
+	    }
+	}
+      else
+	{
+	  r = Ldd_FromCons (ldd, l);
+	  Ldd_Ref (r);
+	  e = and_or (ldd, e, r, 0);
+	}
+      t->destroy_lincons (l);
+    }
+
+  /* its box hull in x and y */
+  r = Ldd_ExistsAbstractFM (ldd, e, X);
+  Ldd_Ref (r);
+  r = and_or (ldd, r, project (e, X), 0);
+  Ldd_RecursiveDeref (ldd, e);
+  return r;
+}
+
+/* the union of the hulls of the paths of f */
+static LddNode *
+path_hulls (LddNode *f, int xpy)
+{
+  DdGen *gen;
+  int *cube, **cubes;
+  CUDD_VALUE_TYPE value;
+  int i, j, n, size;
+  LddNode *r;
+
+  size = Cudd_ReadSize (cudd);
+  n = 0;
+  cubes = NULL;
+  Cudd_ForeachCube (cudd, f, gen, cube, value)
+    {
+      cubes = (int**) realloc (cubes, (n + 1) * sizeof (int*));
+      cubes [n] = (int*) malloc (size * sizeof (int));
+      for (j = 0; j < size; j++)
+	cubes [n][j] = cube [j];
+      n++;
+    }
+
+  r = Ldd_GetFalse (ldd);
+  Ldd_Ref (r);
+  for (i = 0; i < n; i++)
+    {
+      r = and_or (ldd, r, hull (cubes [i], size, xpy), 1);
+      free (cubes [i]);
+    }
+  free (cubes);
+  return r;
+}
+
+static void
+test_tvpi (int dyn)
+{
+  linterm_t x, y;
+  constant_t c;
+  LddNode *f, *r, *tmp;
+  int i, k;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn) Cudd_AutodynEnable (cudd, CUDD_REORDER_GROUP_SIFT);
+
+  x = term_xy (t, NVARS, X, 1, 0, 0);
+  y = term_xy (t, NVARS, Y, 1, 0, 0);
+
+  for (i = 0; i < NFORMS; i++)
+    {
+      f = rnd_box_formula (1);
+      k = rnd (7) - 3;
+      c = t->create_int_cst (k);
+
+      r = Ldd_BoxesHavoc (ldd, f, x);
+      Ldd_Ref (r);
+      check_equiv (r, post (f, Ldd_GetTrue (ldd)));
+
+      r = Ldd_BoxesXc (ldd, f, x, c);
+      Ldd_Ref (r);
+      check_equiv (r, post (f, and_or (ldd, cons (X, 1, 0, 0, 0, k),
+				       cons (X, -1, 0, 0, 0, -k), 0)));
+
+      r = Ldd_BoxesXpc (ldd, f, x, c);
+      Ldd_Ref (r);
+      check_equiv (r, post (f, and_or (ldd, cons (X, 1, Z, -1, 0, k),
+				       cons (X, -1, Z, 1, 0, -k), 0)));
+
+      r = Ldd_BoxesXneg (ldd, f, x);
+      Ldd_Ref (r);
+      check_equiv (r, post (f, and_or (ldd, cons (X, 1, Z, 1, 0, 0),
+				       cons (X, -1, Z, -1, 0, 0), 0)));
+
+      /* x := x + x is x := 2x, which maps boxes to boxes */
+      r = Ldd_BoxesXpy (ldd, f, x, x);
+      Ldd_Ref (r);
+      check_equiv (r, post (f, and_or (ldd, cons (X, 1, Z, -2, 0, 0),
+				       cons (X, -1, Z, 2, 0, 0), 0)));
+
+      /* the hulls depend on the paths, which reordering may change */
+      if (!dyn)
+	{
+	  r = Ldd_BoxesXy (ldd, f, x, y);
+	  Ldd_Ref (r);
+	  /* contains the exact post-image */
+	  tmp = post (f, and_or (ldd, cons (X, 1, Y, -1, 0, 0),
+				 cons (X, -1, Y, 1, 0, 0), 0));
+	  assert (Ldd_Leq (ldd, tmp, r) == 1);
+	  Ldd_RecursiveDeref (ldd, tmp);
+	  check_equiv (r, path_hulls (f, 0));
+
+	  r = Ldd_BoxesXpy (ldd, f, x, y);
+	  Ldd_Ref (r);
+	  check_equiv (r, path_hulls (f, 1));
+	}
+
+      t->destroy_cst (c);
+      Ldd_RecursiveDeref (ldd, f);
+    }
+
+  t->destroy_term (x);
+  t->destroy_term (y);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+static void
+test_box (theory_t *(*create) (size_t), int dyn)
+{
+  linterm_t x, y;
+  constant_t c, nc;
+  LddNode *f, *r, *tmp;
+  int i, k;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = create (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn) Cudd_AutodynEnable (cudd, CUDD_REORDER_GROUP_SIFT);
+
+  x = term_xy (t, NVARS, X, 1, 0, 0);
+  y = term_xy (t, NVARS, Y, 1, 0, 0);
+
+  for (i = 0; i < NFORMS; i++)
+    {
+      f = rnd_box_formula (1);
+      k = rnd (7) - 3;
+      c = t->create_int_cst (k);
+      nc = t->create_int_cst (-k);
+
+      r = Ldd_BoxesHavoc (ldd, f, x);
+      Ldd_Ref (r);
+      tmp = Ldd_ExistsAbstractBox (ldd, f, X);
+      Ldd_Ref (tmp);
+      check_equiv (r, tmp);
+
+      r = Ldd_BoxesXc (ldd, f, x, c);
+      Ldd_Ref (r);
+      tmp = Ldd_ExistsAbstractBox (ldd, f, X);
+      Ldd_Ref (tmp);
+      tmp = and_or (ldd, tmp, and_or (ldd, cons (X, 1, 0, 0, 0, k),
+					 cons (X, -1, 0, 0, 0, -k), 0), 0);
+      check_equiv (r, tmp);
+
+      r = Ldd_BoxesXpc (ldd, f, x, c);
+      Ldd_Ref (r);
+      tmp = Ldd_BoxesXpc (ldd, r, x, nc);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      Ldd_Ref (f);
+      check_equiv (tmp, f);
+
+      r = Ldd_BoxesXneg (ldd, f, x);
+      Ldd_Ref (r);
+      tmp = Ldd_BoxesXneg (ldd, r, x);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      Ldd_Ref (f);
+      check_equiv (tmp, f);
+
+      /* havoc x after x := y or x := x + y is havoc x */
+      r = Ldd_BoxesXy (ldd, f, x, y);
+      Ldd_Ref (r);
+      tmp = Ldd_BoxesHavoc (ldd, r, x);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      r = Ldd_ExistsAbstractBox (ldd, f, X);
+      Ldd_Ref (r);
+      check_equiv (tmp, r);
+
+      r = Ldd_BoxesXpy (ldd, f, x, y);
+      Ldd_Ref (r);
+      tmp = Ldd_BoxesHavoc (ldd, r, x);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, r);
+      r = Ldd_ExistsAbstractBox (ldd, f, X);
+      Ldd_Ref (r);
+      check_equiv (tmp, r);
+
+      t->destroy_cst (c);
+      t->destroy_cst (nc);
+      Ldd_RecursiveDeref (ldd, f);
+    }
+
+  t->destroy_term (x);
+  t->destroy_term (y);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  int dyn;
+
+  for (dyn = 0; dyn < 2; dyn++)
+    {
+      test_tvpi (dyn);
+      test_box (tvpi_create_box_theory, dyn);
+      test_box (tvpi_create_boxz_theory, dyn);
+    }
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
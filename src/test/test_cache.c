@@ -0,0 +1,205 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+
+/**
+ * Tests the computed table of the LDD manager: quantification gives
+ * the same results when they come from the table and after
+ * reordering, and repeated calls hit the table.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 4
+
+/* creates an LDD for c[0]*x0 + ... + c[NVARS-1]*x(NVARS-1) op k */
+LddNode *
+cons (int *c, int strict, int k)
+{
+  lincons_t l;
+  LddNode *d;
+
+  l = t->create_cons (t->create_linterm (c, NVARS), strict,
+		      t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  t->destroy_lincons (l);
+  Ldd_Ref (d);
+  return d;
+}
+
+void
+and_accum (LddNode **r, LddNode *n)
+{
+  LddNode *tmp;
+
+  tmp = Ldd_And (ldd, *r, n);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, *r);
+  Ldd_RecursiveDeref (ldd, n);
+  *r = tmp;
+}
+
+void
+or_accum (LddNode **r, LddNode *n)
+{
+  LddNode *tmp;
+
+  tmp = Ldd_Or (ldd, *r, n);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, *r);
+  Ldd_RecursiveDeref (ldd, n);
+  *r = tmp;
+}
+
+/* true if f and g are semantically equivalent */
+int
+equiv (LddNode *f, LddNode *g)
+{
+  LddNode *x;
+  int res;
+
+  x = Ldd_Xor (ldd, f, g);
+  Ldd_Ref (x);
+  res = !Ldd_IsSat (ldd, x);
+  Ldd_RecursiveDeref (ldd, x);
+  return res;
+}
+
+/* (x0 - x1 <= 0 && x1 - x2 <= i && x2 <= 3) for i in 0..2, or
+   (x1 - x0 < 0 && x3 - x1 <= 1) */
+LddNode *
+formula (void)
+{
+  int c01[NVARS] = {1, -1, 0, 0};
+  int c10[NVARS] = {-1, 1, 0, 0};
+  int c12[NVARS] = {0, 1, -1, 0};
+  int c31[NVARS] = {0, -1, 0, 1};
+  int c2[NVARS] = {0, 0, 1, 0};
+  LddNode *f, *g;
+  int i;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < 3; i++)
+    {
+      g = cons (c01, 0, 0);
+      and_accum (&g, cons (c12, 0, i));
+      and_accum (&g, cons (c2, 0, 3));
+      or_accum (&f, g);
+    }
+  g = cons (c10, 1, 0);
+  and_accum (&g, cons (c31, 0, 1));
+  or_accum (&f, g);
+  return f;
+}
+
+/* every way to eliminate a variable agrees, from scratch and from
+   the table */
+void
+test_agree (void)
+{
+  LddNode *f, *r [3], *s;
+  int x, i;
+
+  f = formula ();
+  for (x = 0; x < NVARS; x++)
+    {
+      r [0] = Ldd_ExistsAbstractFM (ldd, f, x);
+      Ldd_Ref (r [0]);
+      r [1] = Ldd_ExistsAbstractSFM (ldd, f, x);
+      Ldd_Ref (r [1]);
+      r [2] = Ldd_ExistsAbstractLW (ldd, f, x);
+      Ldd_Ref (r [2]);
+      assert (equiv (r [0], r [1]));
+      assert (equiv (r [0], r [2]));
+
+      /* the same results again */
+      s = Ldd_ExistsAbstractFM (ldd, f, x);
+      assert (s == r [0]);
+      s = Ldd_ExistsAbstractSFM (ldd, f, x);
+      assert (s == r [1]);
+
+      for (i = 0; i < 3; i++)
+	Ldd_RecursiveDeref (ldd, r [i]);
+    }
+  Ldd_RecursiveDeref (ldd, f);
+}
+
+/* a repeated elimination is answered by the table */
+void
+test_hits (void)
+{
+  LddNode *f, *r, *s;
+  double lookups, hits;
+
+  f = formula ();
+  r = Ldd_ExistsAbstractFM (ldd, f, 1);
+  Ldd_Ref (r);
+
+  lookups = Ldd_ReadCacheLookUps (ldd);
+  hits = Ldd_ReadCacheHits (ldd);
+  s = Ldd_ExistsAbstractFM (ldd, f, 1);
+  assert (s == r);
+  /* one lookup at the root, and it hits */
+  assert (Ldd_ReadCacheLookUps (ldd) == lookups + 1);
+  assert (Ldd_ReadCacheHits (ldd) == hits + 1);
+  assert (Ldd_ReadCacheSlots (ldd) > 0);
+
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, f);
+}
+
+/* dead results are collected, and the table is flushed by
+   reordering */
+void
+test_gc (void)
+{
+  LddNode *f, *r, *s;
+  int x, ok;
+
+  f = formula ();
+  for (x = 0; x < NVARS; x++)
+    {
+      r = Ldd_ExistsAbstractFM (ldd, f, x);
+      Ldd_Ref (r);
+      Ldd_RecursiveDeref (ldd, r);
+    }
+
+  ok = Cudd_ReduceHeap (cudd, CUDD_REORDER_SIFT, 0);
+  assert (ok);
+  for (x = 0; x < NVARS; x++)
+    {
+      r = Ldd_ExistsAbstractFM (ldd, f, x);
+      Ldd_Ref (r);
+      s = Ldd_ExistsAbstractLW (ldd, f, x);
+      Ldd_Ref (s);
+      assert (equiv (r, s));
+      Ldd_RecursiveDeref (ldd, s);
+      Ldd_RecursiveDeref (ldd, r);
+    }
+  Ldd_RecursiveDeref (ldd, f);
+}
+
+int
+main (void)
+{
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  test_agree ();
+  test_hits ();
+  test_gc ();
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,192 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+
+/**
+ * Tests the table of constraints of the TVPI theory: constraints with
+ * the same term are ordered by their constant in the variable order,
+ * variables beyond the declared number are accepted, and the
+ * per-index metadata of the manager is consistent with the theory.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 4
+#define NCONS 200
+
+/* x + k*y <= c, or x < c if y is negative */
+LddNode *
+cons2 (int x, int y, int k, int strict, int c)
+{
+  int var [2];
+  int coeff [2];
+  lincons_t l;
+  LddNode *d;
+
+  var [0] = x;
+  var [1] = y;
+  coeff [0] = 1;
+  coeff [1] = k;
+  l = t->create_cons (t->create_linterm_sparse_si (var, coeff, y < 0 ? 1 : 2),
+		      strict, t->create_int_cst (c));
+  d = Ldd_FromCons (ldd, l);
+  t->destroy_lincons (l);
+  return d;
+}
+
+/* level of the LDD variable of a constraint */
+int
+level (LddNode *d)
+{
+  return Cudd_ReadPerm (cudd, Cudd_NodeReadIndex (d));
+}
+
+void
+test_order (void)
+{
+  LddNode *d [NCONS];
+  LddNode *s [NCONS];
+  int i, k;
+
+  /* insert x0 - x1 <= c for c in a scrambled order */
+  for (i = 0; i < NCONS; i++)
+    {
+      k = (i * 37) % NCONS;
+      d [k] = cons2 (0, 1, -1, 0, k);
+      /* a different term over the same variables */
+      cons2 (0, 1, 2, 0, k);
+    }
+
+  /* the same constraint maps to the same node */
+  for (i = 0; i < NCONS; i++)
+    assert (cons2 (0, 1, -1, 0, i) == d [i]);
+
+  /* constraints with the same term are ordered by constant */
+  for (i = 0; i + 1 < NCONS; i++)
+    assert (level (d [i]) < level (d [i + 1]));
+
+  /* a strict constraint precedes the non-strict one */
+  for (i = 0; i < NCONS; i += 7)
+    {
+      s [i] = cons2 (0, 1, -1, 1, i);
+      assert (level (s [i]) < level (d [i]));
+      if (i > 0) assert (level (d [i - 1]) < level (s [i]));
+    }
+
+  /* x0 - x1 <= 3 implies x0 - x1 <= 5 */
+  assert (Ldd_And (ldd, d [3], Ldd_Not (d [5])) == Ldd_GetFalse (ldd));
+}
+
+/* constraints over variables beyond the declared number */
+void
+test_grow (void)
+{
+  LddNode *a, *b;
+  int i;
+
+  for (i = 0; i < 2000; i += 13)
+    {
+      a = cons2 (i, i + 1, 1, 0, i);
+      b = cons2 (i, -1, 0, 0, i);
+      assert (a != NULL && b != NULL);
+      assert (cons2 (i, i + 1, 1, 0, i) == a);
+      assert (cons2 (i, -1, 0, 0, i) == b);
+    }
+  assert (t->num_of_vars (t) >= 2000);
+}
+
+/* implication between constraints of the same term survives
+   reordering, and variables past 63 are eliminated correctly */
+void
+test_meta (void)
+{
+  LddNode *d [10], *f, *g, *r;
+  int i, ok;
+
+  for (i = 0; i < 10; i++)
+    {
+      d [i] = cons2 (2, 3, 1, 0, i);
+      Ldd_Ref (d [i]);
+    }
+  f = cons2 (1, -1, 0, 0, 0);
+  Ldd_Ref (f);
+
+  ok = Cudd_ReduceHeap (cudd, CUDD_REORDER_SIFT, 0);
+  assert (ok);
+
+  /* x2 + x3 <= 3 implies x2 + x3 <= 5 */
+  r = Ldd_And (ldd, d [3], Ldd_Not (d [5]));
+  assert (r == Ldd_GetFalse (ldd));
+  r = Ldd_Or (ldd, d [3], d [5]);
+  assert (r == d [5]);
+
+  /* exists x100 . (x100 <= 7 && x1 - x100 <= 0) is x1 <= 7 */
+  g = Ldd_And (ldd, cons2 (100, -1, 0, 0, 7), cons2 (1, 100, -1, 0, 0));
+  Ldd_Ref (g);
+  r = Ldd_ExistsAbstractFM (ldd, g, 100);
+  Ldd_Ref (r);
+  assert (r == cons2 (1, -1, 0, 0, 7));
+  Ldd_RecursiveDeref (ldd, r);
+  /* x100 does not occur in x1 <= 0 */
+  r = Ldd_ExistsAbstractFM (ldd, f, 100);
+  assert (r == f);
+
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, f);
+  for (i = 0; i < 10; i++)
+    Ldd_RecursiveDeref (ldd, d [i]);
+}
+
+/* constraints of the same term in different groups */
+void
+test_groups (void)
+{
+  int var [2] = { 2, 3 };
+  int coeff [2] = { 1, -1 };
+  lincons_t l;
+  LddNode *a, *b;
+
+  /* x2 - x3 <= 5, then x2 - x3 <= 3 above it in a new group */
+  l = t->create_cons (t->create_linterm_sparse_si (var, coeff, 2), 0,
+		      t->create_int_cst (5));
+  b = Ldd_NewVar (ldd, l);
+  t->destroy_lincons (l);
+  Ldd_Ref (b);
+  l = t->create_cons (t->create_linterm_sparse_si (var, coeff, 2), 0,
+		      t->create_int_cst (3));
+  a = Ldd_NewVarAtTop (ldd, l);
+  t->destroy_lincons (l);
+  Ldd_Ref (a);
+
+  assert (Ldd_And (ldd, a, Ldd_Not (b)) == Ldd_GetFalse (ldd));
+  assert (Ldd_And (ldd, a, b) == a);
+  assert (Ldd_Or (ldd, a, b) == b);
+
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, b);
+}
+
+int
+main (void)
+{
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  test_order ();
+  test_grow ();
+  test_meta ();
+  test_groups ();
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
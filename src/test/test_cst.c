@@ -0,0 +1,204 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+#include <limits.h>
+
+/**
+ * Tests arithmetic on TVPI constants on both sides of the boundary
+ * between machine integers and GMP rationals.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 2
+
+/* true if k is equal to the rational n/d */
+int
+cst_is (constant_t k, long n, unsigned long d)
+{
+  mpq_t a, b;
+  int res;
+
+  mpq_init (a);
+  mpq_init (b);
+  tvpi_cst_set_mpq (a, (tvpi_cst_t) k);
+  mpq_set_si (b, n, d);
+  mpq_canonicalize (b);
+  res = mpq_equal (a, b);
+  mpq_clear (a);
+  mpq_clear (b);
+  return res;
+}
+
+/* creates the constant 2^e */
+constant_t
+pow2 (unsigned long e)
+{
+  mpq_t q;
+  constant_t k;
+
+  mpq_init (q);
+  mpz_ui_pow_ui (mpq_numref (q), 2, e);
+  k = (constant_t) tvpi_create_cst (q);
+  mpq_clear (q);
+  return k;
+}
+
+/* the sum and product of large values leave the machine range and
+   come back */
+void
+test_overflow (void)
+{
+  constant_t big, k, r, n;
+  mpq_t q;
+
+  /* INT_MAX^2 and INT_MAX^4 do not fit in a machine word */
+  big = t->create_int_cst (INT_MAX);
+  k = t->mul_cst (big, big);
+  r = t->mul_cst (k, k);
+  mpq_init (q);
+  tvpi_cst_set_mpq (q, (tvpi_cst_t) r);
+  mpz_root (mpq_numref (q), mpq_numref (q), 4);
+  assert (mpz_cmp_si (mpq_numref (q), INT_MAX) == 0);
+  mpq_clear (q);
+
+  /* INT_MAX^4 - INT_MAX^4 is zero again */
+  n = t->negate_cst (r);
+  assert (t->sgn_cst (n) < 0);
+  t->destroy_cst (k);
+  k = t->add_cst (r, n);
+  assert (t->sgn_cst (k) == 0);
+  assert (cst_is (k, 0, 1));
+  t->destroy_cst (k);
+  t->destroy_cst (n);
+  t->destroy_cst (r);
+  t->destroy_cst (big);
+
+  /* 2^70 - 2^70 + 5 is a small integer again */
+  big = pow2 (70);
+  n = t->negate_cst (big);
+  k = t->add_cst (big, n);
+  r = t->add_cst (k, t->create_int_cst (5));
+  assert (cst_is (r, 5, 1));
+  assert (t->cst_get_si_num (r) == 5 && t->cst_get_si_den (r) == 1);
+  t->destroy_cst (r);
+  t->destroy_cst (k);
+  t->destroy_cst (n);
+
+  k = t->dup_cst (big);
+  assert (t->sgn_cst (k) > 0);
+  t->destroy_cst (k);
+  t->destroy_cst (big);
+}
+
+/* rationals are kept canonical and rounded correctly */
+void
+test_rational (void)
+{
+  constant_t k, r;
+
+  k = t->create_rat_cst (-7, 2);
+  r = t->floor_cst (k);
+  assert (cst_is (r, -4, 1));
+  t->destroy_cst (r);
+  r = t->ceil_cst (k);
+  assert (cst_is (r, -3, 1));
+  t->destroy_cst (r);
+
+  /* -7/2 + -7/2 == -7 */
+  r = t->add_cst (k, k);
+  assert (cst_is (r, -7, 1));
+  assert (t->cst_get_si_den (r) == 1);
+  t->destroy_cst (r);
+
+  /* -7/2 * 2 == -7 */
+  r = t->mul_cst (k, t->create_int_cst (2));
+  assert (cst_is (r, -7, 1));
+  t->destroy_cst (r);
+  t->destroy_cst (k);
+
+  k = t->create_rat_cst (6, 3);
+  assert (cst_is (k, 2, 1));
+  assert (t->cst_get_si_den (k) == 1);
+  t->destroy_cst (k);
+
+  k = t->create_double_cst (0.5);
+  assert (cst_is (k, 1, 2));
+  t->destroy_cst (k);
+}
+
+/* x0 <= 2^70 && x0 > 2^70 is UNSAT; resolving through a rational
+   coefficient gives a rational bound */
+void
+test_cons (void)
+{
+  int x0[NVARS] = {1, 0};
+  int nx0[NVARS] = {-1, 0};
+  int c01[NVARS] = {1, -2};
+  int x1[NVARS] = {0, 1};
+  lincons_t l1, l2, l3;
+  LddNode *f, *g, *h;
+
+  l1 = t->create_cons (t->create_linterm (x0, NVARS), 0, pow2 (70));
+  l2 = t->create_cons (t->create_linterm (nx0, NVARS), 1,
+		       t->negate_cst (t->get_constant (l1)));
+  f = Ldd_FromCons (ldd, l1);
+  Ldd_Ref (f);
+  g = Ldd_FromCons (ldd, l2);
+  Ldd_Ref (g);
+  h = Ldd_And (ldd, f, g);
+  Ldd_Ref (h);
+  assert (h == Ldd_GetFalse (ldd));
+  Ldd_RecursiveDeref (ldd, h);
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, f);
+  t->destroy_lincons (l2);
+
+  /* x0 - 2*x1 <= 2^70, x1 <= 1/3 resolves to x0 <= 2^70 + 2/3 */
+  l2 = t->create_cons (t->create_linterm (c01, NVARS), 0, pow2 (70));
+  l3 = t->create_cons (t->create_linterm (x1, NVARS), 0,
+		       t->create_rat_cst (1, 3));
+  t->destroy_lincons (l1);
+  l1 = t->resolve_cons (l2, l3, 1);
+  assert (l1 != NULL);
+  {
+    mpq_t a, b;
+    mpq_init (a);
+    mpq_init (b);
+    tvpi_cst_set_mpq (a, (tvpi_cst_t) t->get_constant (l1));
+    mpz_ui_pow_ui (mpq_numref (b), 2, 70);
+    mpz_mul_ui (mpq_numref (b), mpq_numref (b), 3);
+    mpz_add_ui (mpq_numref (b), mpq_numref (b), 2);
+    mpz_set_ui (mpq_denref (b), 3);
+    assert (mpq_equal (a, b));
+    mpq_clear (a);
+    mpq_clear (b);
+  }
+  t->destroy_lincons (l1);
+  t->destroy_lincons (l2);
+  t->destroy_lincons (l3);
+}
+
+int
+main (void)
+{
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  test_overflow ();
+  test_rational ();
+  test_cons ();
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
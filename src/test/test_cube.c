@@ -0,0 +1,172 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Tests Ldd_CubeBuilder: the LDD of random cubes is the one built by
+ * Ldd_And and Ldd_Or, with and without reordering, and constant
+ * cubes are handled.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 4
+#define NCUBES 40
+#define MAXLEN 6
+
+/* a random constraint over few terms, so that cubes have several
+   constraints of a term */
+lincons_t
+rnd_cons (int box)
+{
+  int c [NVARS];
+
+  rnd_row (c, NVARS, box, 1);
+  return t->create_cons (t->create_linterm (c, NVARS), rnd (3) == 0,
+			 t->create_int_cst (rnd (9) - 4));
+}
+
+/* random cubes, built by the builder and by folding */
+void
+test_random (theory_t *(*mk)(size_t), int box, int dyn)
+{
+  LddCubeBuilder *b;
+  lincons_t cube [MAXLEN];
+  LddNode *f, *c, *d, *tmp, *r;
+  size_t size;
+  int i, j, n, ok;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn)
+    {
+      Cudd_AutodynEnable (cudd, CUDD_REORDER_SIFT);
+      Cudd_SetNextReordering (cudd, 50);
+    }
+
+  b = Ldd_CubeBuilderInit (ldd);
+  assert (b != NULL);
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NCUBES; i++)
+    {
+      n = rnd (MAXLEN) + 1;
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      for (j = 0; j < n; j++)
+	{
+	  cube [j] = rnd_cons (box);
+	  d = Ldd_FromCons (ldd, cube [j]);
+	  Ldd_Ref (d);
+	  tmp = Ldd_And (ldd, c, d);
+	  Ldd_Ref (tmp);
+	  Ldd_RecursiveDeref (ldd, c);
+	  Ldd_RecursiveDeref (ldd, d);
+	  c = tmp;
+	}
+      tmp = Ldd_Or (ldd, f, c);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, f);
+      Ldd_RecursiveDeref (ldd, c);
+      f = tmp;
+
+      ok = Ldd_CubeBuilderAddCube (b, cube, n);
+      assert (ok);
+      for (j = 0; j < n; j++)
+	t->destroy_lincons (cube [j]);
+
+      /* build from the cubes so far every few cubes */
+      if (i % 8 == 7 || i + 1 == NCUBES)
+	{
+	  r = Ldd_CubeBuilderBuild (b);
+	  assert (r == f);
+	}
+    }
+  size = Ldd_CubeBuilderSize (b);
+  assert (size == NCUBES);
+
+  Ldd_CubeBuilderQuit (b);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* no cubes is false, an empty cube is true, and an unsatisfiable
+   cube drops out */
+void
+test_constants (void)
+{
+  LddCubeBuilder *b;
+  int x0[NVARS] = {1, 0, 0, 0};
+  int nx0[NVARS] = {-1, 0, 0, 0};
+  lincons_t cube [2];
+  LddNode *d, *r;
+  size_t size;
+  int ok;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  b = Ldd_CubeBuilderInit (ldd);
+  r = Ldd_CubeBuilderBuild (b);
+  assert (r == Ldd_GetFalse (ldd));
+
+  /* x0 <= 1 && x0 >= 2 */
+  cube [0] = t->create_cons (t->create_linterm (x0, NVARS), 0,
+			     t->create_int_cst (1));
+  cube [1] = t->create_cons (t->create_linterm (nx0, NVARS), 0,
+			     t->create_int_cst (-2));
+  ok = Ldd_CubeBuilderAddCube (b, cube, 2);
+  assert (ok);
+  r = Ldd_CubeBuilderBuild (b);
+  assert (r == Ldd_GetFalse (ldd));
+
+  /* x0 <= 1 */
+  ok = Ldd_CubeBuilderAddCube (b, cube, 1);
+  assert (ok);
+  d = Ldd_FromCons (ldd, cube [0]);
+  r = Ldd_CubeBuilderBuild (b);
+  assert (r == d);
+
+  ok = Ldd_CubeBuilderAddCube (b, cube, 0);
+  assert (ok);
+  r = Ldd_CubeBuilderBuild (b);
+  assert (r == Ldd_GetTrue (ldd));
+  size = Ldd_CubeBuilderSize (b);
+  assert (size == 3);
+
+  t->destroy_lincons (cube [0]);
+  t->destroy_lincons (cube [1]);
+  Ldd_CubeBuilderQuit (b);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  int dyn;
+
+  for (dyn = 0; dyn < 2; dyn++)
+    {
+      test_random (tvpi_create_theory, 0, dyn);
+      test_random (tvpi_create_utvpiz_theory, 0, dyn);
+      test_random (tvpi_create_box_theory, 1, dyn);
+    }
+  test_constants ();
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
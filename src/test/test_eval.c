@@ -0,0 +1,195 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Tests Ldd_Eval and Ldd_EvalBatch on random LDDs and random points.
+ * A point satisfies an LDD iff the conjunction of the LDD with the
+ * cube of the point is satisfiable, and Ldd_EvalBatch must agree with
+ * Ldd_Eval on every point of a batch. In the TVPI theory, the
+ * constraints have rational coefficients and constants.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 3
+#define NCONS 8
+#define NFORMS 50
+#define NPOINTS 200
+
+/* a*x + b*y <= k/d, or < k/d if strict */
+static LddNode *
+cons (int x, int a, int y, int b, int strict, int k, int d)
+{
+  return cons_xy_rat (ldd, NVARS, x, a, y, b, strict, k, d);
+}
+
+/* a random combination of bounds, and of a*x + b*y <= k/d if rel */
+static LddNode *
+rnd_formula (int rel)
+{
+  LddNode *f, *c;
+  int i, x;
+
+  f = Ldd_GetTrue (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NCONS; i++)
+    {
+      x = rnd (NVARS);
+      if (rel && rnd (2) == 0)
+	c = cons (x, rnd (3) + 1, (x + 1) % NVARS, rnd (5) - 2, rnd (2),
+		  rnd (21) - 10, rnd (3) + 1);
+      else
+	c = cons (x, rnd (2) ? 1 : -1, 0, 0, rnd (2), rnd (21) - 10, 1);
+      f = and_or (ldd, f, c, i > 0 && rnd (3) == 0);
+    }
+  return f;
+}
+
+/* f && the point p is satisfiable */
+static int
+eval (LddNode *f, int64_t *p)
+{
+  LddNode *r;
+  int x, res;
+
+  r = f;
+  Ldd_Ref (r);
+  for (x = 0; x < NVARS; x++)
+    {
+      r = and_or (ldd, r, cons (x, 1, 0, 0, 0, (int) p [x], 1), 0);
+      r = and_or (ldd, r, cons (x, -1, 0, 0, 0, (int) -p [x], 1), 0);
+    }
+  res = Ldd_IsSat (ldd, r);
+  Ldd_RecursiveDeref (ldd, r);
+  return res;
+}
+
+static void
+test_eval (theory_t *(*create) (size_t), int rel, int dyn)
+{
+  int64_t vals [NVARS][NPOINTS], p [NVARS];
+  const int64_t *cols [NVARS];
+  char out [NPOINTS];
+  LddNode *f;
+  int i, j, x, v, ok;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = create (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn) Cudd_AutodynEnable (cudd, CUDD_REORDER_GROUP_SIFT);
+
+  for (x = 0; x < NVARS; x++)
+    cols [x] = vals [x];
+
+  for (i = 0; i < NFORMS; i++)
+    {
+      f = rnd_formula (rel);
+
+      for (j = 0; j < NPOINTS; j++)
+	for (x = 0; x < NVARS; x++)
+	  vals [x][j] = rnd (25) - 12;
+      ok = Ldd_EvalBatch (ldd, f, cols, NPOINTS, out);
+      assert (ok == 1);
+
+      for (j = 0; j < NPOINTS; j++)
+	{
+	  for (x = 0; x < NVARS; x++)
+	    p [x] = vals [x][j];
+	  v = Ldd_Eval (ldd, f, p);
+	  assert (v == out [j]);
+	  if (j < NPOINTS / 10)
+	    assert (v == eval (f, p));
+	}
+
+      /* the complement */
+      ok = Ldd_EvalBatch (ldd, Ldd_Not (f), cols, NPOINTS, out);
+      assert (ok == 1);
+      for (j = 0; j < NPOINTS; j++)
+	{
+	  for (x = 0; x < NVARS; x++)
+	    p [x] = vals [x][j];
+	  assert (Ldd_Eval (ldd, Ldd_Not (f), p) == out [j]);
+	  assert (out [j] != Ldd_Eval (ldd, f, p));
+	}
+      Ldd_RecursiveDeref (ldd, f);
+    }
+
+  /* the constants */
+  assert (Ldd_Eval (ldd, Ldd_GetTrue (ldd), p) == 1);
+  assert (Ldd_Eval (ldd, Ldd_GetFalse (ldd), p) == 0);
+  ok = Ldd_EvalBatch (ldd, Ldd_GetFalse (ldd), cols, NPOINTS, out);
+  assert (ok == 1);
+  for (j = 0; j < NPOINTS; j++)
+    assert (out [j] == 0);
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* strict and rational bounds on the integers */
+static void
+test_bounds (void)
+{
+  int64_t p [NVARS] = {0, 0, 0};
+  LddNode *f;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  /* x < 3 */
+  f = cons (0, 1, 0, 0, 1, 3, 1);
+  p [0] = 2;
+  assert (Ldd_Eval (ldd, f, p) == 1);
+  p [0] = 3;
+  assert (Ldd_Eval (ldd, f, p) == 0);
+  Ldd_RecursiveDeref (ldd, f);
+
+  /* 2x - 3y <= 1/2 */
+  f = cons (0, 2, 1, -3, 0, 1, 2);
+  p [0] = 1;
+  p [1] = 1;
+  assert (Ldd_Eval (ldd, f, p) == 1);
+  p [0] = 2;
+  assert (Ldd_Eval (ldd, f, p) == 0);
+  Ldd_RecursiveDeref (ldd, f);
+
+  /* -x < -5/2, i.e., x > 5/2 */
+  f = cons (0, -1, 0, 0, 1, -5, 2);
+  p [0] = 2;
+  assert (Ldd_Eval (ldd, f, p) == 0);
+  p [0] = 3;
+  assert (Ldd_Eval (ldd, f, p) == 1);
+  Ldd_RecursiveDeref (ldd, f);
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  int dyn;
+
+  test_bounds ();
+  for (dyn = 0; dyn < 2; dyn++)
+    {
+      test_eval (tvpi_create_theory, 0, dyn);
+      test_eval (tvpi_create_theory, 1, dyn);
+      test_eval (tvpi_create_box_theory, 0, dyn);
+      test_eval (tvpi_create_boxz_theory, 0, dyn);
+    }
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,195 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+/**
+ * Tests that Ldd_IsSat, Ldd_IsSatParallel and Ldd_SatReduce agree
+ * with enumerating the integer points of a box, when the results for
+ * sub-formulas are already known, in either order of the calls, and
+ * when they are repeated. Ldd_IsSatParallel runs on 1 to 4 threads.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 3
+#define NCONS 8
+#define NFORMS 40
+/* the box 0 <= xi <= BOUND */
+#define BOUND 3
+
+/* number of calls to check() */
+static int nchecks = 0;
+
+/* the constraints of a formula, and how they are combined; prefix i
+   of the formula is ((c0 op1 c1) op2 c2) ... opi ci. Only bounds and
+   differences are used, so that a formula has a rational solution in
+   the box iff it has an integer one. */
+int coeffs [NCONS][NVARS];
+int csts [NCONS];
+int ors [NCONS];
+
+void
+rnd_formula (int box)
+{
+  int i;
+
+  for (i = 0; i < NCONS; i++)
+    {
+      rnd_row (coeffs [i], NVARS, box, 1);
+      csts [i] = rnd (7) - 3;
+      ors [i] = i > 0 && rnd (2);
+    }
+}
+
+/* the value of prefix n of the formula, negated if neg, at p */
+int
+eval (int n, int neg, int *p)
+{
+  int i, j, s, v;
+
+  v = 0;
+  for (i = 0; i <= n; i++)
+    {
+      s = 0;
+      for (j = 0; j < NVARS; j++)
+	s += coeffs [i][j] * p [j];
+      v = i == 0 ? s <= csts [i] :
+	ors [i] ? (v || s <= csts [i]) : (v && s <= csts [i]);
+    }
+  return neg ? !v : v;
+}
+
+/* is prefix n, negated if neg, satisfiable in the box */
+int
+brute (int n, int neg)
+{
+  int p [NVARS];
+  int i;
+
+  for (i = 0; i < NVARS; i++)
+    p [i] = 0;
+  while (1)
+    {
+      if (eval (n, neg, p)) return 1;
+      for (i = 0; i < NVARS && p [i] == BOUND; i++)
+	p [i] = 0;
+      if (i == NVARS) return 0;
+      p [i]++;
+    }
+}
+
+/* the box, as an LDD */
+LddNode *
+box (void)
+{
+  int c [NVARS];
+  LddNode *b;
+  int i, j;
+
+  b = Ldd_GetTrue (ldd);
+  Ldd_Ref (b);
+  for (i = 0; i < NVARS; i++)
+    {
+      for (j = 0; j < NVARS; j++)
+	c [j] = 0;
+      c [i] = 1;
+      b = and_or (ldd, b, cons_vec (ldd, c, NVARS, 0, BOUND), 0);
+      c [i] = -1;
+      b = and_or (ldd, b, cons_vec (ldd, c, NVARS, 0, 0), 0);
+    }
+  return b;
+}
+
+void
+check (LddNode *f, int expect, int reduce_first)
+{
+  LddNode *r;
+  int i, res;
+
+  /* before the other checks record what they find */
+  res = Ldd_IsSatParallel (ldd, f, 1 + nchecks++ % 4);
+  assert (res == expect);
+
+  for (i = 0; i < 2; i++)
+    {
+      if (reduce_first)
+	{
+	  r = Ldd_SatReduce (ldd, f, -1);
+	  assert ((r != Ldd_GetFalse (ldd)) == expect);
+	  Ldd_Ref (r);
+	  assert (Ldd_Equiv (ldd, r, f) == 1);
+	  Ldd_RecursiveDeref (ldd, r);
+	}
+      assert (Ldd_IsSat (ldd, f) == expect);
+      if (!reduce_first)
+	{
+	  r = Ldd_SatReduce (ldd, f, -1);
+	  assert ((r != Ldd_GetFalse (ldd)) == expect);
+	}
+    }
+}
+
+void
+test_random (theory_t *(*mk)(size_t), int is_box)
+{
+  LddNode *b, *f, *g;
+  int c [NVARS];
+  int i, j, n;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  b = box ();
+  for (n = 0; n < NFORMS; n++)
+    {
+      rnd_formula (is_box);
+
+      f = Ldd_GetFalse (ldd);
+      Ldd_Ref (f);
+      for (i = 0; i < NCONS; i++)
+	{
+	  for (j = 0; j < NVARS; j++)
+	    c [j] = coeffs [i][j];
+	  f = and_or (ldd, f, cons_vec (ldd, c, NVARS, 0, csts [i]),
+		      i == 0 || ors [i]);
+
+	  /* every other formula is checked prefix by prefix, so the
+	     results for its sub-formulas are known */
+	  if (n % 2 == 0 || i == NCONS - 1)
+	    {
+	      g = Ldd_And (ldd, b, f);
+	      Ldd_Ref (g);
+	      check (g, brute (i, 0), n % 4 < 2);
+	      Ldd_RecursiveDeref (ldd, g);
+
+	      g = Ldd_And (ldd, b, Ldd_Not (f));
+	      Ldd_Ref (g);
+	      check (g, brute (i, 1), n % 4 >= 2);
+	      Ldd_RecursiveDeref (ldd, g);
+	    }
+	}
+      Ldd_RecursiveDeref (ldd, f);
+    }
+
+  Ldd_RecursiveDeref (ldd, b);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  test_random (tvpi_create_utvpiz_theory, 0);
+  test_random (tvpi_create_boxz_theory, 1);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
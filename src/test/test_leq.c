@@ -0,0 +1,175 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+/**
+ * Tests Ldd_Leq and Ldd_Equiv: they agree with deciding f && !g and
+ * f xor g with Ldd_IsSat, and hold where Ldd_TermLeq fails because a
+ * path is unsatisfiable only in the theory.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 3
+#define NFORMS 24
+
+/* +-(x - y) <= k or +-x <= k, with few constants so that paths chain */
+LddNode *
+rnd_cons (int box)
+{
+  int c [NVARS];
+
+  rnd_row (c, NVARS, box, 1);
+  return cons_vec (ldd, c, NVARS, 0, rnd (5) - 2);
+}
+
+/* a disjunction of up to 3 cubes of up to 3 constraints */
+LddNode *
+rnd_dnf (int box)
+{
+  LddNode *f, *c;
+  int i, j, n, m;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  n = rnd (3) + 1;
+  for (i = 0; i < n; i++)
+    {
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      m = rnd (3) + 1;
+      for (j = 0; j < m; j++)
+	c = and_or (ldd, c, rnd_cons (box), 0);
+      f = and_or (ldd, f, c, 1);
+    }
+  return f;
+}
+
+/* f && !g is unsatisfiable */
+int
+leq_ref (LddNode *f, LddNode *g)
+{
+  LddNode *h;
+  int res;
+
+  h = Ldd_And (ldd, f, Ldd_Not (g));
+  Ldd_Ref (h);
+  res = !Ldd_IsSat (ldd, h);
+  Ldd_RecursiveDeref (ldd, h);
+  return res;
+}
+
+/* random pairs, and pairs where g is implied by construction */
+void
+test_random (theory_t *(*mk)(size_t), int box)
+{
+  LddNode *fs [NFORMS];
+  LddNode *g;
+  int i, j, leq, semantic;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  for (i = 0; i < NFORMS; i++)
+    fs [i] = rnd_dnf (box);
+
+  semantic = 0;
+  for (i = 0; i < NFORMS; i++)
+    for (j = 0; j < NFORMS; j++)
+      {
+	leq = leq_ref (fs [i], fs [j]);
+	assert (Ldd_Leq (ldd, fs [i], fs [j]) == leq);
+	assert (Ldd_Leq (ldd, Ldd_Not (fs [j]), Ldd_Not (fs [i])) == leq);
+	assert (Ldd_Equiv (ldd, fs [i], fs [j]) ==
+		(leq && leq_ref (fs [j], fs [i])));
+	if (Ldd_TermLeq (ldd, fs [i], fs [j]))
+	  assert (leq);
+	else if (leq)
+	  semantic++;
+
+	/* fs[i] && fs[j] implies fs[i] */
+	g = Ldd_And (ldd, fs [i], fs [j]);
+	Ldd_Ref (g);
+	assert (Ldd_Leq (ldd, g, fs [i]));
+	assert (Ldd_Leq (ldd, g, fs [j]));
+	assert (Ldd_Equiv (ldd, g, fs [i]) == leq);
+	Ldd_RecursiveDeref (ldd, g);
+      }
+  if (!box)
+    assert (semantic > 0);
+
+  for (i = 0; i < NFORMS; i++)
+    Ldd_RecursiveDeref (ldd, fs [i]);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* x0 - x1 <= 0 && x1 <= 0 implies x0 <= 0, but not as BDDs */
+void
+test_transitive (void)
+{
+  int d01[NVARS] = {1, -1, 0};
+  int x0[NVARS] = {1, 0, 0};
+  int x1[NVARS] = {0, 1, 0};
+  LddNode *a, *b, *c, *f, *g;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  a = cons_vec (ldd, d01, NVARS, 0, 0);
+  b = cons_vec (ldd, x1, NVARS, 0, 0);
+  c = cons_vec (ldd, x0, NVARS, 0, 0);
+
+  f = Ldd_And (ldd, a, b);
+  Ldd_Ref (f);
+  assert (!Ldd_TermLeq (ldd, f, c));
+  assert (Ldd_Leq (ldd, f, c));
+  assert (!Ldd_Leq (ldd, c, f));
+  assert (!Ldd_Equiv (ldd, f, c));
+
+  /* the conjunction with an implied constraint is a different LDD */
+  g = Ldd_And (ldd, f, c);
+  Ldd_Ref (g);
+  assert (g != f);
+  assert (Ldd_Equiv (ldd, f, g));
+  assert (Ldd_Equiv (ldd, Ldd_Not (g), Ldd_Not (f)));
+
+  /* and an infeasible path alone is false */
+  assert (Ldd_Leq (ldd, Ldd_And (ldd, f, Ldd_Not (c)),
+		   Ldd_GetFalse (ldd)));
+  assert (Ldd_Leq (ldd, Ldd_GetTrue (ldd), Ldd_Or (ldd, Ldd_Not (f), c)));
+  assert (!Ldd_Leq (ldd, Ldd_GetTrue (ldd), f));
+  assert (Ldd_Leq (ldd, Ldd_GetFalse (ldd), f));
+  assert (Ldd_Equiv (ldd, f, f));
+  assert (!Ldd_Equiv (ldd, f, Ldd_Not (f)));
+
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, b);
+  Ldd_RecursiveDeref (ldd, c);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  test_transitive ();
+  test_random (tvpi_create_theory, 0);
+  test_random (tvpi_create_utvpiz_theory, 0);
+  test_random (tvpi_create_box_theory, 1);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
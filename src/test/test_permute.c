@@ -0,0 +1,171 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+/**
+ * Tests Ldd_Permute: renaming by a random permutation is the same as
+ * the simultaneous substitution, and renaming next-state variables to
+ * current-state variables gives the LDD built over the current-state
+ * variables. A perm that is not a permutation is rejected.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+/* x0..x3 and their next-state copies x4..x7 */
+#define NSTATE 4
+#define NVARS (2 * NSTATE)
+#define NCONS 6
+#define NFORMS 20
+
+/* the constraints of a formula over x0..x3, and how they are combined */
+int coeffs [NCONS][NSTATE];
+int csts [NCONS];
+int ors [NCONS];
+
+void
+rnd_formula (int box)
+{
+  int i;
+
+  for (i = 0; i < NCONS; i++)
+    {
+      rnd_row (coeffs [i], NSTATE, box, 0);
+      csts [i] = rnd (9) - 4;
+      ors [i] = rnd (2);
+    }
+}
+
+/* the formula over x(off)..x(off+3) */
+LddNode *
+build (int off)
+{
+  LddNode *f;
+  int c [NVARS];
+  int i, j;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NCONS; i++)
+    {
+      for (j = 0; j < NVARS; j++)
+	c [j] = 0;
+      for (j = 0; j < NSTATE; j++)
+	c [off + j] = coeffs [i][j];
+      f = and_or (ldd, f, cons_vec (ldd, c, NVARS, 0, csts [i]), ors [i]);
+    }
+  return f;
+}
+
+void
+test_random (theory_t *(*mk)(size_t), int box, int dyn)
+{
+  int perm [NVARS], vars [NVARS];
+  int c [NVARS];
+  linterm_t terms [NVARS];
+  constant_t ks [NVARS];
+  LddNode *f, *g, *r, *s;
+  int i, j, n, tmp;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+  if (dyn)
+    {
+      Cudd_AutodynEnable (cudd, CUDD_REORDER_SIFT);
+      Cudd_SetNextReordering (cudd, 50);
+    }
+
+  for (n = 0; n < NFORMS; n++)
+    {
+      rnd_formula (box);
+
+      /* next-state to current-state: x(i+4) := xi */
+      g = build (0);
+      f = build (NSTATE);
+      for (i = 0; i < NVARS; i++)
+	perm [i] = i < NSTATE ? i + NSTATE : i - NSTATE;
+      r = Ldd_Permute (ldd, f, perm);
+      assert (r == g);
+      Ldd_RecursiveDeref (ldd, g);
+
+      /* a random permutation */
+      for (i = 0; i < NVARS; i++)
+	perm [i] = i;
+      for (i = NVARS - 1; i > 0; i--)
+	{
+	  j = rnd (i + 1);
+	  tmp = perm [i];
+	  perm [i] = perm [j];
+	  perm [j] = tmp;
+	}
+      for (i = 0; i < NVARS; i++)
+	{
+	  for (j = 0; j < NVARS; j++)
+	    c [j] = 0;
+	  c [perm [i]] = 1;
+	  vars [i] = i;
+	  terms [i] = t->create_linterm (c, NVARS);
+	  ks [i] = NULL;
+	}
+      r = Ldd_Permute (ldd, f, perm);
+      Ldd_Ref (r);
+      s = Ldd_VectorSubst (ldd, f, vars, terms, ks, NVARS);
+      assert (r == s);
+
+      /* and back */
+      for (i = 0; i < NVARS; i++)
+	c [perm [i]] = i;
+      s = Ldd_Permute (ldd, r, c);
+      assert (s == f);
+
+      Ldd_RecursiveDeref (ldd, r);
+      Ldd_RecursiveDeref (ldd, f);
+      for (i = 0; i < NVARS; i++)
+	t->destroy_term (terms [i]);
+    }
+
+  /* the identity */
+  for (i = 0; i < NVARS; i++)
+    perm [i] = i;
+  assert (Ldd_Permute (ldd, Ldd_GetTrue (ldd), perm) == Ldd_GetTrue (ldd));
+
+  /* not a permutation: a duplicate, a negative and a too large
+     target */
+  perm [1] = 0;
+  assert (Ldd_Permute (ldd, Ldd_GetTrue (ldd), perm) == NULL);
+  assert (Cudd_ReadErrorCode (cudd) == CUDD_INVALID_ARG);
+  Cudd_ClearErrorCode (cudd);
+  perm [1] = -1;
+  assert (Ldd_Permute (ldd, Ldd_GetTrue (ldd), perm) == NULL);
+  Cudd_ClearErrorCode (cudd);
+  perm [1] = NVARS;
+  assert (Ldd_Permute (ldd, Ldd_GetTrue (ldd), perm) == NULL);
+  assert (Cudd_ReadErrorCode (cudd) == CUDD_INVALID_ARG);
+  Cudd_ClearErrorCode (cudd);
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  int dyn;
+
+  for (dyn = 0; dyn < 2; dyn++)
+    {
+      test_random (tvpi_create_theory, 0, dyn);
+      test_random (tvpi_create_utvpiz_theory, 0, dyn);
+      test_random (tvpi_create_box_theory, 1, dyn);
+    }
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,513 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+
+#include <stdio.h>
+
+/**
+ * Tests the incremental quantifier elimination context of the TVPI
+ * theories through Ldd_IsSat, Ldd_SatReduce and Ldd_ExistAbstractPAT,
+ * the elimination of several variables by Ldd_MvExistAbstract, and
+ * its fusion with conjunction in Ldd_AndExistsAbstract.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 4
+
+/* creates an LDD for c[0]*x0 + ... + c[NVARS-1]*x(NVARS-1) op k */
+LddNode *
+cons (int *c, int strict, int k)
+{
+  lincons_t l;
+  LddNode *d;
+
+  l = t->create_cons (t->create_linterm (c, NVARS), strict,
+		      t->create_int_cst (k));
+  d = Ldd_FromCons (ldd, l);
+  t->destroy_lincons (l);
+  Ldd_Ref (d);
+  return d;
+}
+
+void
+and_accum (LddNode **r, LddNode *n)
+{
+  LddNode *tmp;
+
+  tmp = Ldd_And (ldd, *r, n);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, *r);
+  Ldd_RecursiveDeref (ldd, n);
+  *r = tmp;
+}
+
+void
+or_accum (LddNode **r, LddNode *n)
+{
+  LddNode *tmp;
+
+  tmp = Ldd_Or (ldd, *r, n);
+  Ldd_Ref (tmp);
+  Ldd_RecursiveDeref (ldd, *r);
+  Ldd_RecursiveDeref (ldd, n);
+  *r = tmp;
+}
+
+/* true if f and g are semantically equivalent */
+int
+equiv (LddNode *f, LddNode *g)
+{
+  LddNode *x;
+  int res;
+
+  x = Ldd_Xor (ldd, f, g);
+  Ldd_Ref (x);
+  res = !Ldd_IsSat (ldd, x);
+  Ldd_RecursiveDeref (ldd, x);
+  return res;
+}
+
+void
+setup (theory_t *(*mk)(size_t))
+{
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+}
+
+void
+teardown (void)
+{
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* cycle x0 <= x1 <= x2 < x0 is UNSAT, a chain is SAT */
+void
+test_cycle (theory_t *(*mk)(size_t))
+{
+  int c01[NVARS] = {1, -1, 0, 0};
+  int c12[NVARS] = {0, 1, -1, 0};
+  int c20[NVARS] = {-1, 0, 1, 0};
+  int x1[NVARS] = {0, 1, 0, 0};
+  LddNode *f, *g, *h, *r;
+
+  setup (mk);
+
+  f = cons (c01, 0, 0);
+  and_accum (&f, cons (c12, 0, 0));
+  and_accum (&f, cons (c20, 1, 0));
+  assert (!Ldd_IsSat (ldd, f));
+
+  g = cons (c01, 0, 0);
+  and_accum (&g, cons (x1, 0, 5));
+  assert (Ldd_IsSat (ldd, g));
+
+  /* SatReduce removes the UNSAT disjunct */
+  h = f;
+  Ldd_Ref (h);
+  Ldd_Ref (g);
+  or_accum (&h, g);
+
+  r = Ldd_SatReduce (ldd, f, -1);
+  assert (r == Ldd_GetFalse (ldd));
+
+  r = Ldd_SatReduce (ldd, h, -1);
+  Ldd_Ref (r);
+  assert (equiv (r, g));
+  assert (Ldd_UnsatSize (ldd, r) == 0);
+  Ldd_RecursiveDeref (ldd, r);
+
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, h);
+  teardown ();
+}
+
+/* x0 = x1 and x0 + x1 = 1 is SAT over Q, but UNSAT over Z */
+void
+test_tight (theory_t *(*mk)(size_t), int expect)
+{
+  int d01[NVARS] = {1, -1, 0, 0};
+  int nd01[NVARS] = {-1, 1, 0, 0};
+  int s01[NVARS] = {1, 1, 0, 0};
+  int ns01[NVARS] = {-1, -1, 0, 0};
+  LddNode *f;
+
+  setup (mk);
+
+  f = cons (d01, 0, 0);
+  and_accum (&f, cons (nd01, 0, 0));
+  and_accum (&f, cons (s01, 0, 1));
+  and_accum (&f, cons (ns01, 0, -1));
+  assert (Ldd_IsSat (ldd, f) == expect);
+
+  Ldd_RecursiveDeref (ldd, f);
+  teardown ();
+}
+
+/* exists x1 . (x0 <= x1 && x1 <= 5 && x2 - x1 <= 2) */
+void
+test_pat_oct (theory_t *(*mk)(size_t))
+{
+  int c01[NVARS] = {1, -1, 0, 0};
+  int x1[NVARS] = {0, 1, 0, 0};
+  int c21[NVARS] = {0, -1, 1, 0};
+  int x3[NVARS] = {0, 0, 0, 1};
+  int x0[NVARS] = {1, 0, 0, 0};
+  int x2[NVARS] = {0, 0, 1, 0};
+  int c12[NVARS] = {0, 1, -1, 0};
+  int c02[NVARS] = {1, 0, -1, 0};
+  int vars[NVARS] = {0, 1, 0, 0};
+  LddNode *f, *r, *e;
+
+  setup (mk);
+
+  f = cons (c01, 0, 0);
+  and_accum (&f, cons (x1, 0, 5));
+  and_accum (&f, cons (c21, 0, 2));
+  /* a constraint without x1 stays in the diagram */
+  or_accum (&f, cons (x3, 0, 7));
+
+  r = Ldd_ExistAbstractPAT (ldd, f, vars);
+  Ldd_Ref (r);
+
+  /* x0 <= 5 && x2 <= 7, or x3 <= 7 */
+  e = cons (x0, 0, 5);
+  and_accum (&e, cons (x2, 0, 7));
+  or_accum (&e, cons (x3, 0, 7));
+  assert (equiv (r, e));
+  Ldd_RecursiveDeref (ldd, e);
+
+  e = Ldd_ExistsAbstractFM (ldd, f, 1);
+  Ldd_Ref (e);
+  assert (equiv (r, e));
+  Ldd_RecursiveDeref (ldd, e);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, f);
+
+  /* exists x1 . (x0 <= x1 && x1 - x2 <= 3) is x0 - x2 <= 3 */
+  f = cons (c01, 0, 0);
+  and_accum (&f, cons (c12, 0, 3));
+  r = Ldd_ExistAbstractPAT (ldd, f, vars);
+  Ldd_Ref (r);
+  e = cons (c02, 0, 3);
+  assert (equiv (r, e));
+
+  Ldd_RecursiveDeref (ldd, e);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, f);
+  teardown ();
+}
+
+/* constraints with non-unit coefficients use the FM fallback */
+void
+test_general (void)
+{
+  int c01[NVARS] = {1, 2, 0, 0};
+  int nx0[NVARS] = {-1, 0, 0, 0};
+  int nx1[NVARS] = {0, -1, 0, 0};
+  int x0[NVARS] = {1, 0, 0, 0};
+  int vars[NVARS] = {0, 1, 0, 0};
+  int g01[NVARS] = {1, -2, 0, 0};
+  int g12[NVARS] = {0, 2, -1, 0};
+  int c20[NVARS] = {-1, 0, 1, 0};
+  int c3[NVARS] = {0, 0, 0, 1};
+  int nx3[NVARS] = {0, 0, 0, -1};
+  LddNode *f, *r, *e;
+
+  setup (tvpi_create_theory);
+
+  /* x0 + 2*x1 <= 4 && x1 >= 1 && x0 >= 3 is UNSAT */
+  f = cons (c01, 0, 4);
+  and_accum (&f, cons (nx1, 0, -1));
+  e = f;
+  Ldd_Ref (e);
+  and_accum (&e, cons (nx0, 0, -3));
+  assert (!Ldd_IsSat (ldd, e));
+  assert (Ldd_SatReduce (ldd, e, -1) == Ldd_GetFalse (ldd));
+  Ldd_RecursiveDeref (ldd, e);
+
+  /* exists x1 . (x0 + 2*x1 <= 4 && x1 >= 1) is x0 <= 2 */
+  r = Ldd_ExistAbstractPAT (ldd, f, vars);
+  Ldd_Ref (r);
+  e = cons (x0, 0, 2);
+  assert (equiv (r, e));
+
+  Ldd_RecursiveDeref (ldd, e);
+  Ldd_RecursiveDeref (ldd, r);
+  Ldd_RecursiveDeref (ldd, f);
+
+  /* x0 <= 2*x1 <= x2 < x0 is UNSAT. The bounds on x3 are set aside
+     while the cycle is resolved */
+  f = cons (c3, 0, 5);
+  and_accum (&f, cons (nx3, 0, 5));
+  and_accum (&f, cons (g01, 0, 0));
+  and_accum (&f, cons (g12, 0, 0));
+  and_accum (&f, cons (c20, 1, 0));
+  assert (!Ldd_IsSat (ldd, f));
+  Ldd_RecursiveDeref (ldd, f);
+  teardown ();
+}
+
+/* x0 <= 1 && x0 >= 2 is UNSAT in the box theories, and quantifier
+   elimination needs no resolvents */
+void
+test_box (theory_t *(*mk)(size_t))
+{
+  int x0[NVARS] = {1, 0, 0, 0};
+  int nx0[NVARS] = {-1, 0, 0, 0};
+  int x1[NVARS] = {0, 1, 0, 0};
+  int qvars[2] = {0, 1};
+  LddNode *f, *g, *r;
+
+  setup (mk);
+
+  f = cons (x0, 0, 1);
+  and_accum (&f, cons (nx0, 0, -2));
+  assert (!Ldd_IsSat (ldd, f));
+  assert (Ldd_SatReduce (ldd, f, -1) == Ldd_GetFalse (ldd));
+
+  g = cons (x1, 0, 3);
+  r = Ldd_Or (ldd, f, g);
+  Ldd_Ref (r);
+  assert (Ldd_IsSat (ldd, r));
+  assert (equiv (r, g));
+  Ldd_RecursiveDeref (ldd, r);
+
+  /* elimination drops the constraints on the variable, and agrees
+     with Fourier-Motzkin */
+  and_accum (&g, cons (nx0, 1, 0));
+  or_accum (&g, cons (x0, 0, 5));
+  r = Ldd_ExistsAbstract (ldd, g, 0);
+  Ldd_Ref (r);
+  assert (r == Ldd_ExistsAbstractFM (ldd, g, 0));
+  Ldd_RecursiveDeref (ldd, r);
+  r = Ldd_MvExistAbstract (ldd, g, qvars, 2);
+  assert (r == Ldd_GetTrue (ldd));
+  /* x0 <= 1 && x0 >= 2 has no solutions */
+  assert (Ldd_ExistsAbstract (ldd, f, 0) == Ldd_GetFalse (ldd));
+
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, f);
+  teardown ();
+}
+
+/* eliminates a variable after reordering the manager */
+LddNode *
+exists_reorder (LddManager *m, LddNode *f, int var)
+{
+  int ok;
+
+  ok = Cudd_ReduceHeap (cudd, CUDD_REORDER_SIFT, 0);
+  assert (ok);
+  return Ldd_ExistsAbstractFM (m, f, var);
+}
+
+/* Ldd_MvExistAbstract agrees with one elimination at a time, with and
+   without reordering between eliminations, and in every elimination
+   order */
+void
+test_mv (void)
+{
+  int c01[NVARS] = {1, -1, 0, 0};
+  int c12[NVARS] = {0, 1, -1, 0};
+  int c23[NVARS] = {0, 0, 1, -1};
+  int c30[NVARS] = {-1, 0, 0, 1};
+  int x1[NVARS] = {0, 1, 0, 0};
+  int nx2[NVARS] = {0, 0, -1, 0};
+  int qvars[3] = {1, 2, 3};
+  int (*orders[4])(LddManager*,int*,int*,size_t,int*) = 
+    {Ldd_ElimOrderMinOccur, Ldd_ElimOrderMinResolvents,
+     Ldd_ElimOrderMinFill, Ldd_ElimOrderBoxFirst};
+  LddNode *f, *g, *r, *e, *tmp;
+  int i, k;
+
+  setup (tvpi_create_theory);
+
+  /* a disjunction of chains x0 <= x1 + i <= x2 + 2i <= x3 ... */
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < 4; i++)
+    {
+      g = cons (c01, 0, i);
+      and_accum (&g, cons (c12, 0, i));
+      and_accum (&g, cons (c23, i % 2, 1 - i));
+      and_accum (&g, cons (i % 2 ? x1 : nx2, 0, 3 - i));
+      if (i == 3) and_accum (&g, cons (c30, 0, 0));
+      or_accum (&f, g);
+    }
+
+  e = f;
+  Ldd_Ref (e);
+  for (k = 0; k < 3; k++)
+    {
+      tmp = Ldd_ExistsAbstractFM (ldd, e, qvars [k]);
+      Ldd_Ref (tmp);
+      Ldd_RecursiveDeref (ldd, e);
+      e = tmp;
+    }
+
+  r = Ldd_MvExistAbstract (ldd, f, qvars, 3);
+  Ldd_Ref (r);
+  assert (equiv (r, e));
+  Ldd_RecursiveDeref (ldd, r);
+
+  Ldd_SetExistsAbstract (ldd, exists_reorder);
+  r = Ldd_MvExistAbstract (ldd, f, qvars, 3);
+  Ldd_Ref (r);
+  assert (equiv (r, e));
+  Ldd_SetExistsAbstract (ldd, Ldd_ExistsAbstractFM);
+  Ldd_RecursiveDeref (ldd, r);
+
+  /* every elimination order gives the same result */
+  for (k = 0; k < 4; k++)
+    {
+      Ldd_SetElimOrder (ldd, orders [k]);
+      r = Ldd_MvExistAbstract (ldd, f, qvars, 3);
+      Ldd_Ref (r);
+      assert (equiv (r, e));
+      Ldd_RecursiveDeref (ldd, r);
+    }
+  Ldd_SetElimOrder (ldd, Ldd_ElimOrderMinOccur);
+
+  Ldd_RecursiveDeref (ldd, e);
+  Ldd_RecursiveDeref (ldd, f);
+  teardown ();
+}
+
+/* Ldd_AndExistsAbstract agrees with the conjunction followed by
+   Ldd_MvExistAbstract. The bounds on x1 are split between f and g,
+   so that the tightest bound on a path may come from either. */
+void
+test_and_exists (theory_t *(*mk)(size_t), int box)
+{
+  int c01[NVARS] = {1, -1, 0, 0};
+  int c12[NVARS] = {0, 1, -1, 0};
+  int c31[NVARS] = {0, -1, 0, 1};
+  int c03[NVARS] = {-1, 0, 0, 1};
+  int x0[NVARS] = {1, 0, 0, 0};
+  int nx0[NVARS] = {-1, 0, 0, 0};
+  int x1[NVARS] = {0, 1, 0, 0};
+  int nx1[NVARS] = {0, -1, 0, 0};
+  int x2[NVARS] = {0, 0, 1, 0};
+  int x3[NVARS] = {0, 0, 0, 1};
+  int nx3[NVARS] = {0, 0, 0, -1};
+  int qvars[3] = {1, 2, 0};
+  LddNode *f, *g, *h, *r, *e;
+  int i, n;
+
+  setup (mk);
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  g = Ldd_GetFalse (ldd);
+  Ldd_Ref (g);
+  for (i = 0; i < 3; i++)
+    {
+      h = cons (box ? x0 : c01, 0, i);
+      and_accum (&h, cons (x1, 0, 3 - i));
+      and_accum (&h, cons (nx1, i % 2, i - 4));
+      or_accum (&f, h);
+
+      h = cons (box ? x2 : c12, i % 2, i - 1);
+      and_accum (&h, cons (nx1, 0, -i));
+      and_accum (&h, cons (x1, 0, 2 * i));
+      if (!box) and_accum (&h, cons (c31, 0, 1));
+      or_accum (&g, h);
+    }
+
+  h = Ldd_And (ldd, f, g);
+  Ldd_Ref (h);
+  for (n = 1; n <= 3; n++)
+    {
+      e = Ldd_MvExistAbstract (ldd, h, qvars, n);
+      Ldd_Ref (e);
+      r = Ldd_AndExistsAbstract (ldd, f, g, qvars, n);
+      Ldd_Ref (r);
+      assert (equiv (r, e));
+      Ldd_RecursiveDeref (ldd, r);
+      Ldd_RecursiveDeref (ldd, e);
+    }
+
+  /* single-variable Fourier-Motzkin on the conjunction */
+  if (!box)
+    {
+      e = Ldd_ExistsAbstractFM (ldd, h, 1);
+      Ldd_Ref (e);
+      r = Ldd_AndExistsAbstractFM (ldd, f, g, 1);
+      Ldd_Ref (r);
+      assert (equiv (r, e));
+      /* the same result again, from the computed table */
+      assert (Ldd_AndExistsAbstractFM (ldd, g, f, 1) == r);
+      Ldd_RecursiveDeref (ldd, r);
+      Ldd_RecursiveDeref (ldd, e);
+    }
+
+  /* no quantified variables is a conjunction */
+  r = Ldd_AndExistsAbstract (ldd, f, g, qvars, 0);
+  assert (r == h);
+
+  Ldd_RecursiveDeref (ldd, h);
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, f);
+
+  if (!box)
+    {
+      /* (x3 <= 5 || x3 <= x0) && (x3 <= 7 && x2 <= 0 || x3 > 7)
+	 projects x3 to x2 <= 0 || x0 > 7. The bounds on x3 come
+	 before x3 - x0 in the order, and on the path where x3 > 5 the
+	 tighter bound x3 > 7 from g is resolved with x3 <= x0 from
+	 f. */
+      f = cons (x3, 0, 5);
+      or_accum (&f, cons (c03, 0, 0));
+      g = cons (x3, 0, 7);
+      and_accum (&g, cons (x2, 0, 0));
+      or_accum (&g, cons (nx3, 1, -7));
+      e = cons (x2, 0, 0);
+      or_accum (&e, cons (nx0, 1, -7));
+
+      r = Ldd_AndExistsAbstractFM (ldd, f, g, 3);
+      Ldd_Ref (r);
+      assert (equiv (r, e));
+      Ldd_RecursiveDeref (ldd, r);
+
+      Ldd_RecursiveDeref (ldd, e);
+      Ldd_RecursiveDeref (ldd, g);
+      Ldd_RecursiveDeref (ldd, f);
+    }
+  teardown ();
+}
+
+int
+main (void)
+{
+  test_cycle (tvpi_create_theory);
+  test_cycle (tvpi_create_utvpiz_theory);
+  test_cycle (tvpi_create_tvpiz_theory);
+
+  test_tight (tvpi_create_theory, 1);
+  test_tight (tvpi_create_utvpiz_theory, 0);
+
+  test_pat_oct (tvpi_create_theory);
+  test_pat_oct (tvpi_create_utvpiz_theory);
+
+  test_general ();
+  test_mv ();
+
+  test_box (tvpi_create_box_theory);
+  test_box (tvpi_create_boxz_theory);
+
+  test_and_exists (tvpi_create_theory, 0);
+  test_and_exists (tvpi_create_tvpiz_theory, 0);
+  test_and_exists (tvpi_create_box_theory, 1);
+  test_and_exists (tvpi_create_boxz_theory, 1);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
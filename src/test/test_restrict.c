@@ -0,0 +1,261 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Tests Ldd_Constrain, Ldd_Restrict and Ldd_Minimize: the result
+ * agrees with f on the care set, Ldd_Restrict does not introduce
+ * constraints, Ldd_Minimize is never larger than f, and nodes implied
+ * or refuted by the care set are dropped. No references are lost or
+ * leaked.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 3
+#define NFORMS 16
+
+LddNode *
+rnd_cons (int box)
+{
+  int c [NVARS];
+
+  rnd_row (c, NVARS, box, 1);
+  return cons_vec (ldd, c, NVARS, 0, rnd (7) - 3);
+}
+
+/* a disjunction of up to 4 cubes of up to 3 constraints */
+LddNode *
+rnd_dnf (int box)
+{
+  LddNode *f, *c;
+  int i, j, n, m;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  n = rnd (4) + 1;
+  for (i = 0; i < n; i++)
+    {
+      c = Ldd_GetTrue (ldd);
+      Ldd_Ref (c);
+      m = rnd (3) + 1;
+      for (j = 0; j < m; j++)
+	c = and_or (ldd, c, rnd_cons (box), 0);
+      f = and_or (ldd, f, c, 1);
+    }
+  return f;
+}
+
+/* r && c is f && c */
+void
+check_agrees (LddNode *r, LddNode *f, LddNode *c)
+{
+  LddNode *a, *b;
+
+  a = Ldd_And (ldd, r, c);
+  Ldd_Ref (a);
+  b = Ldd_And (ldd, f, c);
+  Ldd_Ref (b);
+  assert (Ldd_Equiv (ldd, a, b) == 1);
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, b);
+}
+
+/* every DD variable of r is one of f */
+void
+check_support (LddNode *r, LddNode *f)
+{
+  int *sr, *sf;
+  int i;
+
+  sr = Cudd_SupportIndex (cudd, r);
+  sf = Cudd_SupportIndex (cudd, f);
+  for (i = 0; i < Cudd_ReadSize (cudd); i++)
+    assert (!sr [i] || sf [i]);
+  free (sr);
+  free (sf);
+}
+
+void
+test_random (theory_t *(*mk)(size_t), int box)
+{
+  LddNode *fs [NFORMS];
+  LddNode *f, *c, *r;
+  int i, j, size, live;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  for (i = 0; i < NFORMS; i++)
+    fs [i] = rnd_dnf (box);
+  live = Cudd_CheckZeroRef (cudd);
+
+  for (i = 0; i < NFORMS; i++)
+    for (j = 0; j < NFORMS; j++)
+      {
+	f = fs [i];
+	c = fs [j];
+	size = Cudd_DagSize (f);
+
+	r = Ldd_Constrain (ldd, f, c);
+	Ldd_Ref (r);
+	check_agrees (r, f, c);
+	Ldd_RecursiveDeref (ldd, r);
+
+	r = Ldd_Restrict (ldd, f, c);
+	Ldd_Ref (r);
+	check_agrees (r, f, c);
+	check_support (r, f);
+	assert (Cudd_DagSize (r) <= size);
+	Ldd_RecursiveDeref (ldd, r);
+
+	r = Ldd_Minimize (ldd, f, c);
+	Ldd_Ref (r);
+	check_agrees (r, f, c);
+	assert (Cudd_DagSize (r) <= size);
+	Ldd_RecursiveDeref (ldd, r);
+
+	/* the complement */
+	r = Ldd_Restrict (ldd, Ldd_Not (f), c);
+	Ldd_Ref (r);
+	check_agrees (r, Ldd_Not (f), c);
+	Ldd_RecursiveDeref (ldd, r);
+      }
+
+  /* the results are all gone, and no node is left referenced */
+  assert (Cudd_CheckZeroRef (cudd) == live);
+  for (i = 0; i < NFORMS; i++)
+    Ldd_RecursiveDeref (ldd, fs [i]);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* the operations keep the reference counts of their operands, also
+   when both cofactors of a node give the same result */
+void
+test_refs (void)
+{
+  int x0[NVARS] = {1, 0, 0};
+  int x1[NVARS] = {0, 1, 0};
+  int x2[NVARS] = {0, 0, 1};
+  LddNode *a, *b, *d, *c, *r;
+  DdHalfWord ref;
+  int i, live;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_box_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  a = cons_vec (ldd, x0, NVARS, 0, 1);
+  d = cons_vec (ldd, x1, NVARS, 0, 1);
+  b = cons_vec (ldd, x2, NVARS, 0, 1);
+  Ldd_Ref (a);
+  Ldd_Ref (d);
+  c = and_or (ldd, a, d, 1);
+
+  live = Cudd_CheckZeroRef (cudd);
+  ref = Cudd_Regular (b)->ref;
+  for (i = 0; i < 3; i++)
+    {
+      switch (i)
+	{
+	case 0: r = Ldd_Constrain (ldd, b, c); break;
+	case 1: r = Ldd_Restrict (ldd, b, c); break;
+	default: r = Ldd_Minimize (ldd, b, c); break;
+	}
+      assert (r == b);
+      assert (Cudd_Regular (b)->ref == ref);
+    }
+  assert (Cudd_CheckZeroRef (cudd) == live);
+
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, b);
+  Ldd_RecursiveDeref (ldd, c);
+  Ldd_RecursiveDeref (ldd, d);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* f = x0 <= 3 ? x1 <= 0 : x2 <= 0 */
+void
+test_implied (void)
+{
+  int x0[NVARS] = {1, 0, 0};
+  int x1[NVARS] = {0, 1, 0};
+  int x2[NVARS] = {0, 0, 1};
+  int d01[NVARS] = {1, -1, 0};
+  LddNode *a, *b, *c, *f, *g, *h, *r;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  a = cons_vec (ldd, x0, NVARS, 0, 3);
+  b = cons_vec (ldd, x1, NVARS, 0, 0);
+  c = cons_vec (ldd, x2, NVARS, 0, 0);
+  f = Ldd_Ite (ldd, a, b, c);
+  Ldd_Ref (f);
+
+  /* x0 > 5 refutes x0 <= 3 */
+  g = cons_vec (ldd, x0, NVARS, 0, 5);
+  r = Ldd_Restrict (ldd, f, Ldd_Not (g));
+  assert (r == c);
+  r = Ldd_Constrain (ldd, f, Ldd_Not (g));
+  assert (r == c);
+  Ldd_RecursiveDeref (ldd, g);
+
+  /* x0 <= 1 implies x0 <= 3 */
+  g = cons_vec (ldd, x0, NVARS, 0, 1);
+  r = Ldd_Restrict (ldd, f, g);
+  assert (r == b);
+  r = Ldd_Minimize (ldd, f, g);
+  assert (r == b);
+  Ldd_RecursiveDeref (ldd, g);
+
+  /* x0 - x1 <= 0 && x1 <= 0 && x0 > 0 is unsatisfiable in the
+     theory only, so nothing needs to be kept */
+  h = cons_vec (ldd, x0, NVARS, 0, 0);
+  g = and_or (ldd, cons_vec (ldd, d01, NVARS, 0, 0), Ldd_Not (h), 0);
+  Ldd_Ref (b);
+  g = and_or (ldd, g, b, 0);
+  assert (g != Ldd_GetFalse (ldd));
+  r = Ldd_Minimize (ldd, f, g);
+  assert (Cudd_IsConstant (r));
+  Ldd_RecursiveDeref (ldd, g);
+
+  /* no care set constraints, nothing changes */
+  assert (Ldd_Restrict (ldd, f, Ldd_GetTrue (ldd)) == f);
+  assert (Ldd_Constrain (ldd, f, f) == Ldd_GetTrue (ldd));
+  assert (Ldd_Constrain (ldd, f, Ldd_Not (f)) == Ldd_GetFalse (ldd));
+
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, b);
+  Ldd_RecursiveDeref (ldd, c);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  test_refs ();
+  test_implied ();
+  test_random (tvpi_create_theory, 0);
+  test_random (tvpi_create_utvpiz_theory, 0);
+  test_random (tvpi_create_box_theory, 1);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,246 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+/**
+ * Stress test for independent managers on separate threads. Every
+ * worker repeatedly creates a manager with its own TVPI theory, runs a
+ * fixed mix of Boolean operations, satisfiability checks and
+ * quantifier elimination, and records a digest of the results. The
+ * workers are run one at a time, and then all at once. Finally, if
+ * the TVPI pools support it (LDD_HAVE_THREADS), every manager is
+ * created on one thread and used and destroyed on another, in both
+ * directions. The digests must agree.
+ *
+ * usage: test_threads [nthreads [rounds]]
+ */
+
+#define NVARS 6
+#define NGUARDS 8
+
+static int nthreads = 8;
+static int rounds = 16;
+
+/* a manager, created by one thread and finished by another */
+typedef struct job
+{
+  DdManager *cudd;
+  LddManager *ldd;
+  theory_t *t;
+  LddNode *f;
+  int box;
+  unsigned long digest;
+} job_t;
+
+typedef struct worker
+{
+  int id;
+  pthread_t thread;
+  unsigned long digest;
+  /* the current round and its manager when the work is split */
+  int round;
+  job_t job;
+} worker_t;
+
+/* a random constraint +-x +-y <= c, or +-x <= c in a box theory */
+static LddNode *
+rnd_cons (LddManager *ldd, unsigned long *state, int box)
+{
+  int coeff [NVARS];
+  int i, x, y;
+
+  for (i = 0; i < NVARS; i++)
+    coeff [i] = 0;
+  x = rnd_r (state, NVARS);
+  y = rnd_r (state, NVARS);
+  coeff [x] = rnd_r (state, 2) ? 1 : -1;
+  if (!box && y != x)
+    coeff [y] = rnd_r (state, 2) ? 1 : -1;
+  return cons_vec (ldd, coeff, NVARS, 0, rnd_r (state, 41) - 20);
+}
+
+/* the first half of one round of worker id: creates the manager and
+   builds a formula */
+static void
+start (job_t *j, int id, int round)
+{
+  LddNode *f, *g;
+  unsigned long state;
+  int i;
+
+  j->box = (id + round) % 2;
+  j->cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  j->t = j->box ? tvpi_create_box_theory (NVARS) :
+    tvpi_create_theory (NVARS);
+  j->ldd = Ldd_Init (j->cudd, j->t);
+  state = 1000 * id + round + 1;
+  j->digest = 0;
+
+  /* a conjunction of guards, each a disjunction of two constraints */
+  f = Ldd_GetTrue (j->ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NGUARDS; i++)
+    {
+      g = and_or (j->ldd, rnd_cons (j->ldd, &state, j->box),
+		  rnd_cons (j->ldd, &state, j->box), 1);
+      f = and_or (j->ldd, f, g, 0);
+      j->digest = j->digest * 31 + Cudd_DagSize (f);
+      j->digest = j->digest * 2 + Ldd_IsSat (j->ldd, f);
+    }
+  j->f = f;
+}
+
+/* the second half: reduces and projects the formula, and destroys the
+   manager; returns a digest of the results */
+static unsigned long
+finish (job_t *j)
+{
+  LddManager *ldd = j->ldd;
+  LddNode *f = j->f, *r;
+  unsigned long digest = j->digest;
+  int i;
+
+  r = Ldd_SatReduce (ldd, f, -1);
+  Ldd_Ref (r);
+  digest = digest * 31 + Cudd_DagSize (r);
+  Ldd_RecursiveDeref (ldd, r);
+
+  for (i = 0; i < 2; i++)
+    {
+      r = j->box ? Ldd_ExistsAbstractBox (ldd, f, i) :
+	Ldd_ExistsAbstractFM (ldd, f, i);
+      Ldd_Ref (r);
+      Ldd_RecursiveDeref (ldd, f);
+      f = r;
+      digest = digest * 31 + Cudd_DagSize (f);
+    }
+
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (j->t);
+  Cudd_Quit (j->cudd);
+  return digest;
+}
+
+static void *
+run (void *arg)
+{
+  worker_t *w = (worker_t*) arg;
+  job_t j;
+  int round;
+
+  w->digest = 0;
+  for (round = 0; round < rounds; round++)
+    {
+      start (&j, w->id, round);
+      w->digest = w->digest * 131 + finish (&j);
+    }
+  return NULL;
+}
+
+#ifdef LDD_HAVE_THREADS
+static void *
+run_start (void *arg)
+{
+  worker_t *w = (worker_t*) arg;
+
+  start (&w->job, w->id, w->round);
+  return NULL;
+}
+
+static void *
+run_finish (void *arg)
+{
+  worker_t *w = (worker_t*) arg;
+
+  w->digest = w->digest * 131 + finish (&w->job);
+  return NULL;
+}
+#endif
+
+static void
+spawn (worker_t *ws, void *(*fn) (void*))
+{
+  int i;
+
+  for (i = 0; i < nthreads; i++)
+    if (pthread_create (&ws [i].thread, NULL, fn, &ws [i]) != 0)
+      {
+	fprintf (stderr, "pthread_create failed\n");
+	exit (1);
+      }
+  for (i = 0; i < nthreads; i++)
+    pthread_join (ws [i].thread, NULL);
+}
+
+int
+main (int argc, char **argv)
+{
+  worker_t *ws;
+  unsigned long *expected;
+  int i;
+#ifdef LDD_HAVE_THREADS
+  int round;
+#endif
+
+  if (argc > 1) nthreads = atoi (argv [1]);
+  if (argc > 2) rounds = atoi (argv [2]);
+
+  ws = (worker_t*) malloc (nthreads * sizeof (worker_t));
+  expected = (unsigned long*) malloc (nthreads * sizeof (unsigned long));
+
+  /* one at a time */
+  for (i = 0; i < nthreads; i++)
+    {
+      ws [i].id = i;
+      run (&ws [i]);
+      expected [i] = ws [i].digest;
+    }
+
+  /* all at once */
+  spawn (ws, run);
+  for (i = 0; i < nthreads; i++)
+    assert (ws [i].digest == expected [i]);
+
+#ifdef LDD_HAVE_THREADS
+  /* created by the workers, which exit, and destroyed by this thread */
+  for (i = 0; i < nthreads; i++)
+    ws [i].digest = 0;
+  for (round = 0; round < rounds; round++)
+    {
+      for (i = 0; i < nthreads; i++)
+	ws [i].round = round;
+      spawn (ws, run_start);
+      for (i = 0; i < nthreads; i++)
+	run_finish (&ws [i]);
+    }
+  for (i = 0; i < nthreads; i++)
+    assert (ws [i].digest == expected [i]);
+
+  /* created by this thread and destroyed by the workers */
+  for (i = 0; i < nthreads; i++)
+    ws [i].digest = 0;
+  for (round = 0; round < rounds; round++)
+    {
+      for (i = 0; i < nthreads; i++)
+	{
+	  ws [i].round = round;
+	  run_start (&ws [i]);
+	}
+      spawn (ws, run_finish);
+    }
+  for (i = 0; i < nthreads; i++)
+    assert (ws [i].digest == expected [i]);
+#endif
+
+  free (ws);
+  free (expected);
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
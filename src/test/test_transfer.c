@@ -0,0 +1,220 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+/**
+ * Tests Ldd_Transfer and Ldd_TransferN: an LDD transferred to another
+ * manager is the LDD built there from the same constraints, whether
+ * the destination orders the constraints as the source or not, and
+ * transferring it back gives the original. A failed transfer leaves
+ * its results unchanged, and no references behind.
+ */
+
+#define NVARS 4
+#define NCONS 6
+#define NFORMS 16
+
+/* the constraints of the formulas, and how they are combined */
+int coeffs [NFORMS][NCONS][NVARS];
+int csts [NFORMS][NCONS];
+int ors [NFORMS][NCONS];
+
+void
+rnd_formulas (int box)
+{
+  int n, i;
+
+  for (n = 0; n < NFORMS; n++)
+    for (i = 0; i < NCONS; i++)
+      {
+	rnd_row (coeffs [n][i], NVARS, box, 0);
+	csts [n][i] = rnd (9) - 4;
+	ors [n][i] = rnd (2);
+      }
+}
+
+/* formula n in ldd */
+LddNode *
+build (LddManager *ldd, int n)
+{
+  LddNode *f;
+  int i;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NCONS; i++)
+    f = and_or (ldd, f, cons_vec (ldd, coeffs [n][i], NVARS, 0, csts [n][i]),
+		ors [n][i]);
+  return f;
+}
+
+/* creates the constraints of all formulas in ldd, in reverse */
+void
+declare_rev (LddManager *ldd)
+{
+  int n, i;
+
+  for (n = NFORMS - 1; n >= 0; n--)
+    for (i = NCONS - 1; i >= 0; i--)
+      Ldd_RecursiveDeref (ldd, cons_vec (ldd, coeffs [n][i], NVARS, 0,
+					 csts [n][i]));
+}
+
+void
+test_random (theory_t *(*mk)(size_t), int box, int mode)
+{
+  DdManager *cudd1, *cudd2;
+  LddManager *src, *dst;
+  theory_t *t1, *t2;
+  LddNode *fs [NFORMS], *gs [NFORMS], *res [NFORMS];
+  LddNode *r;
+  int n, ok;
+
+  cudd1 = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t1 = mk (NVARS);
+  src = Ldd_Init (cudd1, t1);
+  cudd2 = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t2 = mk (NVARS);
+  dst = Ldd_Init (cudd2, t2);
+  if (mode == 2)
+    {
+      Cudd_AutodynEnable (cudd1, CUDD_REORDER_SIFT);
+      Cudd_SetNextReordering (cudd1, 50);
+      Cudd_AutodynEnable (cudd2, CUDD_REORDER_SIFT);
+      Cudd_SetNextReordering (cudd2, 50);
+    }
+
+  rnd_formulas (box);
+  for (n = 0; n < NFORMS; n++)
+    fs [n] = build (src, n);
+
+  /* mode 0: dst learns the constraints from the transfer; mode 1:
+     dst has them in reverse order; mode 2: reordering in both */
+  if (mode == 1) declare_rev (dst);
+  for (n = 0; n < NFORMS; n++)
+    gs [n] = mode == 0 ? NULL : build (dst, n);
+
+  for (n = 0; n < NFORMS; n++)
+    {
+      r = Ldd_Transfer (src, dst, fs [n]);
+      assert (r != NULL);
+      Ldd_Ref (r);
+      if (gs [n] == NULL) gs [n] = build (dst, n);
+      assert (r == gs [n]);
+      Ldd_RecursiveDeref (dst, r);
+    }
+
+  /* all at once, and back */
+  ok = Ldd_TransferN (src, dst, fs, res, NFORMS);
+  assert (ok);
+  for (n = 0; n < NFORMS; n++)
+    {
+      assert (res [n] == gs [n]);
+      Ldd_RecursiveDeref (dst, res [n]);
+    }
+  ok = Ldd_TransferN (dst, src, gs, res, NFORMS);
+  assert (ok);
+  for (n = 0; n < NFORMS; n++)
+    {
+      assert (res [n] == fs [n]);
+      Ldd_RecursiveDeref (src, res [n]);
+    }
+
+  /* complements, constants, and the same manager */
+  r = Ldd_Transfer (src, dst, Ldd_Not (fs [0]));
+  assert (r == Ldd_Not (gs [0]));
+  r = Ldd_Transfer (src, dst, Ldd_GetTrue (src));
+  assert (r == Ldd_GetTrue (dst));
+  r = Ldd_Transfer (src, dst, Ldd_GetFalse (src));
+  assert (r == Ldd_GetFalse (dst));
+  r = Ldd_Transfer (src, src, fs [0]);
+  assert (r == fs [0]);
+
+  for (n = 0; n < NFORMS; n++)
+    {
+      Ldd_RecursiveDeref (src, fs [n]);
+      Ldd_RecursiveDeref (dst, gs [n]);
+    }
+  Ldd_Quit (src);
+  Ldd_Quit (dst);
+  tvpi_destroy_theory (t1);
+  tvpi_destroy_theory (t2);
+  Cudd_Quit (cudd1);
+  Cudd_Quit (cudd2);
+}
+
+/* transfers new formulas to a manager that cannot grow, until a
+   transfer fails */
+void
+test_fail (void)
+{
+  DdManager *cudd1, *cudd2;
+  LddManager *src, *dst;
+  theory_t *t1, *t2;
+  LddNode *fs [NFORMS], *res [NFORMS];
+  int i, n, ok, live;
+
+  cudd1 = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t1 = tvpi_create_theory (NVARS);
+  src = Ldd_Init (cudd1, t1);
+  cudd2 = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t2 = tvpi_create_theory (NVARS);
+  dst = Ldd_Init (cudd2, t2);
+  /* only the nodes on the free list can be used */
+  Cudd_SetMaxLive (cudd2, 0);
+
+  ok = 1;
+  for (i = 0; i < 1000 && ok; i++)
+    {
+      rnd_formulas (0);
+      for (n = 0; n < NFORMS; n++)
+	{
+	  fs [n] = build (src, n);
+	  res [n] = NULL;
+	}
+
+      /* the literals of the constraints are referenced, one per
+	 variable */
+      live = Cudd_CheckZeroRef (cudd2) - Cudd_ReadSize (cudd2);
+      ok = Ldd_TransferN (src, dst, fs, res, NFORMS);
+      for (n = 0; n < NFORMS; n++)
+	{
+	  if (ok)
+	    Ldd_RecursiveDeref (dst, res [n]);
+	  else
+	    assert (res [n] == NULL);
+	  Ldd_RecursiveDeref (src, fs [n]);
+	}
+      assert (Cudd_CheckZeroRef (cudd2) - Cudd_ReadSize (cudd2) == live);
+    }
+  assert (!ok);
+  assert (Cudd_ReadErrorCode (cudd2) == CUDD_TOO_MANY_NODES);
+
+  Ldd_Quit (src);
+  Ldd_Quit (dst);
+  tvpi_destroy_theory (t1);
+  tvpi_destroy_theory (t2);
+  Cudd_Quit (cudd1);
+  Cudd_Quit (cudd2);
+}
+
+int
+main (void)
+{
+  int mode;
+
+  for (mode = 0; mode < 3; mode++)
+    {
+      test_random (tvpi_create_theory, 0, mode);
+      test_random (tvpi_create_utvpiz_theory, 0, mode);
+      test_random (tvpi_create_box_theory, 1, mode);
+    }
+  test_fail ();
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include "util.h"
+#include "test_util.h"
+
+static unsigned long rnd_state = 1;
+
+int
+rnd_r (unsigned long *state, int n)
+{
+  *state = *state * 6364136223846793005UL + 1442695040888963407UL;
+  return (int) ((*state >> 33) % (unsigned long) n);
+}
+
+int
+rnd (int n)
+{
+  return rnd_r (&rnd_state, n);
+}
+
+int
+rnd_row (int *c, int n, int box, int diff)
+{
+  int i, x, y;
+
+  for (i = 0; i < n; i++)
+    c [i] = 0;
+  x = rnd (n);
+  c [x] = rnd (2) ? 1 : -1;
+  if (!box && n > 1 && rnd (2))
+    {
+      y = (x + 1 + rnd (n - 1)) % n;
+      c [y] = diff ? -c [x] : (rnd (2) ? 1 : -1);
+    }
+  return x;
+}
+
+linterm_t
+term_xy (theory_t *t, int n, int x, int a, int y, int b)
+{
+  int c [TEST_MAXVARS];
+  int i;
+
+  assert (n <= TEST_MAXVARS);
+  for (i = 0; i < n; i++)
+    c [i] = 0;
+  c [x] = a;
+  if (b != 0) c [y] = b;
+  return t->create_linterm (c, n);
+}
+
+LddNode *
+cons_rat (LddManager *ldd, int *c, int n, int strict, int k, int d)
+{
+  theory_t *t = Ldd_GetTheory (ldd);
+  lincons_t l;
+  LddNode *r;
+  int i;
+
+  for (i = 0; i < n && c [i] == 0; i++);
+  if (i == n)
+    r = (strict ? k > 0 : k >= 0) ? Ldd_GetTrue (ldd) : Ldd_GetFalse (ldd);
+  else
+    {
+      l = t->create_cons (t->create_linterm (c, n), strict,
+			  d == 1 ? t->create_int_cst (k) :
+			  t->create_rat_cst (k, d));
+      r = Ldd_FromCons (ldd, l);
+      t->destroy_lincons (l);
+    }
+  Ldd_Ref (r);
+  return r;
+}
+
+LddNode *
+cons_vec (LddManager *ldd, int *c, int n, int strict, int k)
+{
+  return cons_rat (ldd, c, n, strict, k, 1);
+}
+
+LddNode *
+cons_xy_rat (LddManager *ldd, int n, int x, int a, int y, int b, int strict,
+	     int k, int d)
+{
+  int c [TEST_MAXVARS];
+  int i;
+
+  assert (n <= TEST_MAXVARS);
+  for (i = 0; i < n; i++)
+    c [i] = 0;
+  c [x] = a;
+  if (b != 0) c [y] = b;
+  return cons_rat (ldd, c, n, strict, k, d);
+}
+
+LddNode *
+cons_xy (LddManager *ldd, int n, int x, int a, int y, int b, int strict,
+	 int k)
+{
+  return cons_xy_rat (ldd, n, x, a, y, b, strict, k, 1);
+}
+
+LddNode *
+and_or (LddManager *ldd, LddNode *f, LddNode *g, int or)
+{
+  LddNode *r;
+
+  r = or ? Ldd_Or (ldd, f, g) : Ldd_And (ldd, f, g);
+  Ldd_Ref (r);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_RecursiveDeref (ldd, g);
+  return r;
+}
@@ -0,0 +1,46 @@
+/**
+ * Generators shared by the randomized tests: a deterministic
+ * pseudo-random number generator, and constructors of the LDDs of
+ * single constraints and of their combinations.
+ */
+
+#ifndef __TEST_UTIL__H_
+#define __TEST_UTIL__H_
+#include "cudd.h"
+#include "ldd.h"
+
+/* the largest number of variables of a constraint */
+#define TEST_MAXVARS 8
+
+/* a number in [0, n), from and updating *state */
+int rnd_r (unsigned long *state, int n);
+/* rnd_r on a state of the test, initially 1 */
+int rnd (int n);
+
+/* sets c[0..n-1] to +-x for a random x and, unless box, with
+   probability 1/2 adds +-y for a random y != x, or -c[x]*y if diff.
+   Returns x. */
+int rnd_row (int *c, int n, int box, int diff);
+
+/* the term a*x + b*y over n variables, or a*x if b is 0 */
+linterm_t term_xy (theory_t *t, int n, int x, int a, int y, int b);
+
+/* c[0]*x0 + ... + c[n-1]*x(n-1) <= k/d, or < k/d if strict, or a
+   constant if c is 0. The result is referenced. */
+LddNode *cons_rat (LddManager *ldd, int *c, int n, int strict, int k,
+		   int d);
+/* cons_rat with d = 1 */
+LddNode *cons_vec (LddManager *ldd, int *c, int n, int strict, int k);
+/* a*x + b*y <= k/d, or < k/d if strict, over n variables, or a*x
+   <= k/d if b is 0. The result is referenced. */
+LddNode *cons_xy_rat (LddManager *ldd, int n, int x, int a, int y, int b,
+		      int strict, int k, int d);
+/* cons_xy_rat with d = 1 */
+LddNode *cons_xy (LddManager *ldd, int n, int x, int a, int y, int b,
+		  int strict, int k);
+
+/* f && g, or f || g if or. Takes the references of f and g, and the
+   result is referenced. */
+LddNode *and_or (LddManager *ldd, LddNode *f, LddNode *g, int or);
+
+#endif
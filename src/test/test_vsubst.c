@@ -0,0 +1,219 @@
+#include "util.h"
+#include "cudd.h"
+#include "ldd.h"
+#include "tvpi.h"
+#include "test_util.h"
+
+#include <stdio.h>
+
+/**
+ * Tests Ldd_VectorSubst: a simultaneous substitution of +-x(p(i)) + c
+ * for xi is the LDD built from the substituted constraints, including
+ * swaps that cannot be done one variable at a time.
+ */
+
+DdManager *cudd;
+LddManager *ldd;
+theory_t *t;
+
+#define NVARS 4
+#define NCONS 6
+#define NFORMS 20
+
+/* the constraints of a formula, and how they are combined */
+int coeffs [NCONS][NVARS];
+int csts [NCONS];
+int ors [NCONS];
+
+/* the formula, after xi := s[i] * x(p[i]) + k[i] if p is not NULL */
+LddNode *
+build (int *p, int *s, int *k)
+{
+  LddNode *f;
+  int c [NVARS];
+  int i, j, d;
+
+  f = Ldd_GetFalse (ldd);
+  Ldd_Ref (f);
+  for (i = 0; i < NCONS; i++)
+    {
+      for (j = 0; j < NVARS; j++)
+	c [j] = 0;
+      d = csts [i];
+      for (j = 0; j < NVARS; j++)
+	if (p == NULL)
+	  c [j] = coeffs [i][j];
+	else
+	  {
+	    c [p [j]] += coeffs [i][j] * s [j];
+	    d -= coeffs [i][j] * k [j];
+	  }
+      f = and_or (ldd, f, cons_vec (ldd, c, NVARS, 0, d), ors [i]);
+    }
+  return f;
+}
+
+void
+rnd_formula (int box)
+{
+  int i;
+
+  for (i = 0; i < NCONS; i++)
+    {
+      rnd_row (coeffs [i], NVARS, box, 0);
+      csts [i] = rnd (9) - 4;
+      ors [i] = rnd (2);
+    }
+}
+
+void
+test_random (theory_t *(*mk)(size_t), int box)
+{
+  int vars [NVARS], p [NVARS], s [NVARS], k [NVARS];
+  linterm_t terms [NVARS];
+  constant_t ks [NVARS];
+  int c [NVARS];
+  LddNode *f, *g, *r;
+  int i, j, n, tmp;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = mk (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  for (n = 0; n < NFORMS; n++)
+    {
+      rnd_formula (box);
+
+      /* a random permutation, sign and offset */
+      for (i = 0; i < NVARS; i++)
+	p [i] = i;
+      for (i = NVARS - 1; i > 0; i--)
+	{
+	  j = rnd (i + 1);
+	  tmp = p [i];
+	  p [i] = p [j];
+	  p [j] = tmp;
+	}
+      for (i = 0; i < NVARS; i++)
+	{
+	  s [i] = rnd (2) ? 1 : -1;
+	  k [i] = rnd (5) - 2;
+
+	  for (j = 0; j < NVARS; j++)
+	    c [j] = 0;
+	  c [p [i]] = s [i];
+	  vars [i] = i;
+	  terms [i] = t->create_linterm (c, NVARS);
+	  ks [i] = k [i] != 0 ? t->create_int_cst (k [i]) : NULL;
+	}
+
+      f = build (NULL, NULL, NULL);
+      g = build (p, s, k);
+      r = Ldd_VectorSubst (ldd, f, vars, terms, ks, NVARS);
+      assert (r != NULL);
+      Ldd_Ref (r);
+      assert (Ldd_Equiv (ldd, r, g) == 1);
+
+      Ldd_RecursiveDeref (ldd, f);
+      Ldd_RecursiveDeref (ldd, g);
+      Ldd_RecursiveDeref (ldd, r);
+      for (i = 0; i < NVARS; i++)
+	{
+	  t->destroy_term (terms [i]);
+	  if (ks [i] != NULL) t->destroy_cst (ks [i]);
+	}
+    }
+
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+/* x0, x1 := x1, x0 and x0, x1 := x1, 3 */
+void
+test_swap (void)
+{
+  int d01[NVARS] = {1, -1, 0, 0};
+  int d10[NVARS] = {-1, 1, 0, 0};
+  int x0[NVARS] = {1, 0, 0, 0};
+  int x1[NVARS] = {0, 1, 0, 0};
+  int x2[NVARS] = {0, 0, 1, 0};
+  int vars [2] = {0, 1};
+  linterm_t terms [2];
+  constant_t ks [2];
+  LddNode *f, *g, *r, *a;
+
+  cudd = Cudd_Init (0, 0, CUDD_UNIQUE_SLOTS, 127, 0);
+  t = tvpi_create_theory (NVARS);
+  ldd = Ldd_Init (cudd, t);
+
+  /* x0 - x1 <= 2 && x0 <= 3 */
+  f = and_or (ldd, cons_vec (ldd, d01, NVARS, 0, 2),
+	      cons_vec (ldd, x0, NVARS, 0, 3), 0);
+
+  terms [0] = t->create_linterm (x1, NVARS);
+  terms [1] = t->create_linterm (x0, NVARS);
+  ks [0] = ks [1] = NULL;
+  r = Ldd_VectorSubst (ldd, f, vars, terms, ks, 2);
+  Ldd_Ref (r);
+  g = and_or (ldd, cons_vec (ldd, d10, NVARS, 0, 2),
+	      cons_vec (ldd, x1, NVARS, 0, 3), 0);
+  assert (r == g);
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, r);
+
+  /* one variable at a time, x0 := x1 makes the first constraint
+     true */
+  r = Ldd_SubstTermForVar (ldd, f, 0, terms [0], NULL);
+  Ldd_Ref (r);
+  a = cons_vec (ldd, x1, NVARS, 0, 3);
+  assert (r == a);
+  Ldd_RecursiveDeref (ldd, a);
+  Ldd_RecursiveDeref (ldd, r);
+
+  /* x0, x1 := x2 + 1, 3 is x2 + 1 - 3 <= 2 && x2 + 1 <= 3 */
+  t->destroy_term (terms [0]);
+  terms [0] = t->create_linterm (x2, NVARS);
+  ks [0] = t->create_int_cst (1);
+  ks [1] = t->create_int_cst (3);
+  t->destroy_term (terms [1]);
+  terms [1] = NULL;
+  r = Ldd_VectorSubst (ldd, f, vars, terms, ks, 2);
+  Ldd_Ref (r);
+  g = cons_vec (ldd, x2, NVARS, 0, 2);
+  assert (r == g);
+  Ldd_RecursiveDeref (ldd, g);
+  Ldd_RecursiveDeref (ldd, r);
+
+  /* substituting a variable the LDD has no constraints on */
+  vars [0] = 3;
+  r = Ldd_VectorSubst (ldd, f, vars, terms, ks, 1);
+  assert (r == f);
+
+  /* a variable the theory does not have */
+  vars [0] = NVARS;
+  r = Ldd_VectorSubst (ldd, f, vars, terms, ks, 1);
+  assert (r == NULL);
+  assert (Cudd_ReadErrorCode (cudd) == CUDD_INVALID_ARG);
+  Cudd_ClearErrorCode (cudd);
+
+  t->destroy_term (terms [0]);
+  t->destroy_cst (ks [0]);
+  t->destroy_cst (ks [1]);
+  Ldd_RecursiveDeref (ldd, f);
+  Ldd_Quit (ldd);
+  tvpi_destroy_theory (t);
+  Cudd_Quit (cudd);
+}
+
+int
+main (void)
+{
+  test_swap ();
+  test_random (tvpi_create_theory, 0);
+  test_random (tvpi_create_utvpiz_theory, 0);
+  test_random (tvpi_create_box_theory, 1);
+
+  fprintf (stdout, "All tests passed\n");
+  return 0;
+}
@@ -4,18 +4,17 @@
 #include "tdd-octInt.h" /* enable for debugging */
 #endif
 
-#define MAP(t,x,y) (x < y ? (t->map[x][y]) :				\
-		    (x == y ? (t->map[x][0]) : (t->map[x][y+1])) )
-#define SMAP(t,x,y,u) \
-  if (x < y) { t->map[x][y] = u; }		\
-  else if (x == y) { t->map[x][0] = u; }	\
-  else { t->map [x][y+1] = u; } 
+/* initial number of chains in the term table */
+#define TVPI_TAB_SIZE 64
 
-#define BOX_SIZE(t) (t->is_box ? 1 : t->size)
+/* replaces the constant in lvalue l by the result of expression e
+   that may refer to l */
+#define CST_SET(l,e) \
+  do { tvpi_cst_t _k = (e); tvpi_destroy_cst (l); (l) = _k; } while (0)
 
-static tvpi_cst_t one = NULL;
-static tvpi_cst_t none = NULL;
-static tvpi_cst_t zero = NULL;
+static const tvpi_cst_t one = TVPI_CST_MK_SMALL (1);
+static const tvpi_cst_t none = TVPI_CST_MK_SMALL (-1);
+static const tvpi_cst_t zero = TVPI_CST_MK_SMALL (0);
 
 /* forward declarations */
 LddNode* tvpi_to_ldd(LddManager *m, tvpi_cons_t c);
@@ -25,11 +24,76 @@ LddNode* tvpi_to_ldd(LddManager *m, tvpi_cons_t c);
 /* code */
 
 
+/**
+ * Converts q into a constant. q must be canonical. If q is not a
+ * small integer, its value is moved into a new heap constant and q
+ * is left in an unspecified state.
+ */
 static tvpi_cst_t 
-new_cst ()
+cst_from_mpq (mpq_t q)
+{
+  tvpi_cst_t r;
+  
+  if (mpz_cmp_ui (mpq_denref (q), 1) == 0 && 
+      mpz_fits_slong_p (mpq_numref (q)))
+    {
+      long v = mpz_get_si (mpq_numref (q));
+      if (TVPI_CST_FITS (v)) return TVPI_CST_MK_SMALL (v);
+    }
+
+  r = tvpi_pool_alloc_cst ();
+  if (r == NULL) return NULL;
+  mpq_swap (r->val, q);
+  return r;
+}
+
+/**
+ * Sets res to the value of k
+ */
+static void
+cst_get (mpq_t res, tvpi_cst_t k)
 {
-  mpq_t *r;
-  r = (mpq_t*) malloc (sizeof (mpq_t));
+  if (TVPI_CST_IS_SMALL (k))
+    mpq_set_si (res, TVPI_CST_SMALL_VAL (k), 1);
+  else
+    mpq_set (res, TVPI_CST_MPQ (k));
+}
+
+/**
+ * Computes op(k1,k2) using GMP. Slow path of binary arithmetic.
+ */
+static tvpi_cst_t
+cst_binop (void (*op)(mpq_ptr, mpq_srcptr, mpq_srcptr), 
+	   tvpi_cst_t k1, tvpi_cst_t k2)
+{
+  mpq_t a, b;
+  tvpi_cst_t r;
+  
+  mpq_init (a);
+  mpq_init (b);
+  cst_get (a, k1);
+  cst_get (b, k2);
+  op (a, a, b);
+  r = cst_from_mpq (a);
+  mpq_clear (a);
+  mpq_clear (b);
+  return r;
+}
+
+/**
+ * Computes op(k) using GMP. Slow path of unary arithmetic.
+ */
+static tvpi_cst_t
+cst_unop (void (*op)(mpq_ptr, mpq_srcptr), tvpi_cst_t k)
+{
+  mpq_t a;
+  tvpi_cst_t r;
+  
+  mpq_init (a);
+  cst_get (a, k);
+  op (a, a);
+  r = cst_from_mpq (a);
+  mpq_clear (a);
   return r;
 }
 
@@ -39,7 +103,7 @@ new_cons ()
   
   tvpi_cons_t c;
   
-  c = (tvpi_cons_t) malloc (sizeof (struct tvpi_cons));
+  c = tvpi_pool_alloc_cons ();
   c->fst_coeff = NULL;
   c->coeff = NULL;
   c->cst = NULL;
@@ -58,61 +122,67 @@ new_term ()
 tvpi_cst_t 
 tvpi_create_si_cst (int v)
 {
-  mpq_t *r = (mpq_t*)malloc (sizeof(mpq_t));
-  if (r == NULL) return NULL;
-  
-  mpq_init (*r);
-  mpq_set_si (*r, v, 1);
-  return r;
+  return TVPI_CST_MK_SMALL (v);
 }
 
 tvpi_cst_t 
 tvpi_create_si_rat_cst (long num, long den)
 {
-  mpq_t *r;
-  r = new_cst ();
-  if (r == NULL) return NULL;
+  mpq_t q;
+  tvpi_cst_t r;
 
-  mpq_init (*r);
-  mpq_set_si (*r, num, den);
-  mpq_canonicalize (*r);
+  if (den == 1 && TVPI_CST_FITS (num)) return TVPI_CST_MK_SMALL (num);
+  
+  mpq_init (q);
+  mpq_set_si (q, num, den);
+  mpq_canonicalize (q);
+  r = cst_from_mpq (q);
+  mpq_clear (q);
   return r;
 }
 
 tvpi_cst_t
 tvpi_create_d_cst (double d)
 {
-  mpq_t *r;
-  r = new_cst ();
-  if (r == NULL) return NULL;
+  mpq_t q;
+  tvpi_cst_t r;
   
-  mpq_init (*r);
-  mpq_set_d (*r, d);
-
+  mpq_init (q);
+  mpq_set_d (q, d);
+  r = cst_from_mpq (q);
+  mpq_clear (q);
   return r;
 }
 
 tvpi_cst_t
 tvpi_floor_cst (tvpi_cst_t c)
 {
-  mpq_t *r;
+  mpq_t q;
+  tvpi_cst_t r;
   
-  r = new_cst ();
-  if (r == NULL) return NULL;
-  mpq_init (*r);
-  mpz_fdiv_q (mpq_numref (*r), mpq_numref (*c), mpq_denref (*c));  
+  if (TVPI_CST_IS_SMALL (c)) return c;
+
+  mpq_init (q);
+  mpz_fdiv_q (mpq_numref (q), mpq_numref (TVPI_CST_MPQ (c)), 
+	      mpq_denref (TVPI_CST_MPQ (c)));  
+  r = cst_from_mpq (q);
+  mpq_clear (q);
   return r;
 }
 
 tvpi_cst_t
 tvpi_ceil_cst (tvpi_cst_t c)
 {
-  mpq_t *r;
+  mpq_t q;
+  tvpi_cst_t r;
   
-  r = new_cst ();
-  if (r == NULL) return NULL;
-  mpq_init (*r);
-  mpz_cdiv_q (mpq_numref (*r), mpq_numref (*c), mpq_denref (*c));  
+  if (TVPI_CST_IS_SMALL (c)) return c;
+
+  mpq_init (q);
+  mpz_cdiv_q (mpq_numref (q), mpq_numref (TVPI_CST_MPQ (c)), 
+	      mpq_denref (TVPI_CST_MPQ (c)));  
+  r = cst_from_mpq (q);
+  mpq_clear (q);
   return r;
 }
 
@@ -120,40 +190,90 @@ tvpi_ceil_cst (tvpi_cst_t c)
 tvpi_cst_t 
 tvpi_negate_cst (tvpi_cst_t c)
 {
-  mpq_t *r;
-  
-  r = new_cst ();
-  if (r == NULL) return NULL;
-  
-  mpq_init (*r);
-  mpq_neg (*r, *c);
-  return r;
+  if (TVPI_CST_IS_SMALL (c))
+    {
+      long v = -TVPI_CST_SMALL_VAL (c);
+      if (TVPI_CST_FITS (v)) return TVPI_CST_MK_SMALL (v);
+    }
+  return cst_unop (mpq_neg, c);
+}
+
+tvpi_cst_t 
+tvpi_abs_cst (tvpi_cst_t c)
+{
+  if (TVPI_CST_IS_SMALL (c))
+    {
+      long v = TVPI_CST_SMALL_VAL (c);
+      v = v < 0 ? -v : v;
+      if (TVPI_CST_FITS (v)) return TVPI_CST_MK_SMALL (v);
+    }
+  return cst_unop (mpq_abs, c);
 }
 
 tvpi_cst_t 
 tvpi_add_cst (tvpi_cst_t k1, tvpi_cst_t k2)
 {
-  mpq_t *r;
+  if (TVPI_CST_IS_SMALL (k1) && TVPI_CST_IS_SMALL (k2))
+    {
+      /* cannot overflow since small values have two spare bits */
+      long v = TVPI_CST_SMALL_VAL (k1) + TVPI_CST_SMALL_VAL (k2);
+      if (TVPI_CST_FITS (v)) return TVPI_CST_MK_SMALL (v);
+    }
+  return cst_binop (mpq_add, k1, k2);
+}
 
-  r = new_cst ();
-  if (r == NULL) return NULL;
-  
-  mpq_init (*r);
-  mpq_add (*r, *k1, *k2);
-  return r;
+tvpi_cst_t 
+tvpi_sub_cst (tvpi_cst_t k1, tvpi_cst_t k2)
+{
+  if (TVPI_CST_IS_SMALL (k1) && TVPI_CST_IS_SMALL (k2))
+    {
+      long v = TVPI_CST_SMALL_VAL (k1) - TVPI_CST_SMALL_VAL (k2);
+      if (TVPI_CST_FITS (v)) return TVPI_CST_MK_SMALL (v);
+    }
+  return cst_binop (mpq_sub, k1, k2);
 }
 
 tvpi_cst_t
 tvpi_mul_cst (tvpi_cst_t k1, tvpi_cst_t k2)
 {
-  mpq_t *r;
+  if (TVPI_CST_IS_SMALL (k1) && TVPI_CST_IS_SMALL (k2))
+    {
+      long v;
+#if defined(__GNUC__) && __GNUC__ >= 5 || defined(__clang__)
+      if (!__builtin_mul_overflow (TVPI_CST_SMALL_VAL (k1), 
+				   TVPI_CST_SMALL_VAL (k2), &v) &&
+	  TVPI_CST_FITS (v))
+	return TVPI_CST_MK_SMALL (v);
+#else
+      long a = TVPI_CST_SMALL_VAL (k1);
+      long b = TVPI_CST_SMALL_VAL (k2);
+      if (a > -32768 && a < 32768 && b > -32768 && b < 32768)
+	{
+	  v = a * b;
+	  return TVPI_CST_MK_SMALL (v);
+	}
+#endif
+    }
+  return cst_binop (mpq_mul, k1, k2);
+}
 
-  r = new_cst ();
-  if (r == NULL) return NULL;
-  
-  mpq_init (*r);
-  mpq_mul (*r, *k1, *k2);
-  return r;
+/**
+ * Returns k1/k2. Requires: k2 != 0
+ */
+tvpi_cst_t
+tvpi_div_cst (tvpi_cst_t k1, tvpi_cst_t k2)
+{
+  if (TVPI_CST_IS_SMALL (k1) && TVPI_CST_IS_SMALL (k2))
+    {
+      long a = TVPI_CST_SMALL_VAL (k1);
+      long b = TVPI_CST_SMALL_VAL (k2);
+
+      assert (b != 0 && "Division by zero");
+      if (b == 1) return k1;
+      if (a % b == 0 && TVPI_CST_FITS (a / b)) 
+	return TVPI_CST_MK_SMALL (a / b);
+    }
+  return cst_binop (mpq_div, k1, k2);
 }
 
 /**
@@ -162,7 +282,70 @@ tvpi_mul_cst (tvpi_cst_t k1, tvpi_cst_t k2)
 int 
 tvpi_sgn_cst (tvpi_cst_t k)
 {
-  return mpq_sgn (*k);
+  if (TVPI_CST_IS_SMALL (k))
+    {
+      long v = TVPI_CST_SMALL_VAL (k);
+      return v > 0 ? 1 : (v < 0 ? -1 : 0);
+    }
+  return mpq_sgn (TVPI_CST_MPQ (k));
+}
+
+/**
+ * Returns >0 if k1 > k2, 0 if k1 = k2, and <0 if k1 < k2
+ */
+int 
+tvpi_cmp_cst (tvpi_cst_t k1, tvpi_cst_t k2)
+{
+  if (TVPI_CST_IS_SMALL (k1))
+    {
+      long a = TVPI_CST_SMALL_VAL (k1);
+      if (TVPI_CST_IS_SMALL (k2))
+	{
+	  long b = TVPI_CST_SMALL_VAL (k2);
+	  return a < b ? -1 : (a > b ? 1 : 0);
+	}
+      return -mpq_cmp_si (TVPI_CST_MPQ (k2), a, 1);
+    }
+
+  if (TVPI_CST_IS_SMALL (k2))
+    return mpq_cmp_si (TVPI_CST_MPQ (k1), TVPI_CST_SMALL_VAL (k2), 1);
+  
+  return mpq_cmp (TVPI_CST_MPQ (k1), TVPI_CST_MPQ (k2));
+}
+
+/**
+ * Compares k with the integer v
+ */
+int 
+tvpi_cmp_si_cst (tvpi_cst_t k, long v)
+{
+  if (TVPI_CST_IS_SMALL (k))
+    {
+      long a = TVPI_CST_SMALL_VAL (k);
+      return a < v ? -1 : (a > v ? 1 : 0);
+    }
+  return mpq_cmp_si (TVPI_CST_MPQ (k), v, 1);
+}
+
+/**
+ * Returns true if k1 = k2
+ */
+bool
+tvpi_eq_cst (tvpi_cst_t k1, tvpi_cst_t k2)
+{
+  /* small constants are never equal to heap constants */
+  if (TVPI_CST_IS_SMALL (k1) || TVPI_CST_IS_SMALL (k2)) return k1 == k2;
+  return mpq_equal (TVPI_CST_MPQ (k1), TVPI_CST_MPQ (k2));
+}
+
+/**
+ * Returns true if k is an integer
+ */
+bool
+tvpi_is_int_cst (tvpi_cst_t k)
+{
+  return TVPI_CST_IS_SMALL (k) || 
+    mpz_cmp_ui (mpq_denref (TVPI_CST_MPQ (k)), 1) == 0;
 }
 
 
@@ -200,7 +383,7 @@ tvpi_terms_have_resolvent (tvpi_term_t t1, tvpi_term_t t2, int x)
   /* compute sign of x in t1 */
   if (t1->var[0] == x) sgn_x_in_t1 = t1->sgn;
   else if (IS_VAR(t1->var[1]) && t1->var [1] == x) 
-    sgn_x_in_t1 = mpq_sgn (*t1->coeff);
+    sgn_x_in_t1 = tvpi_sgn_cst (t1->coeff);
   
   /* no x in t1, can't resolve */
   if (sgn_x_in_t1 == 0) return 0;
@@ -208,7 +391,7 @@ tvpi_terms_have_resolvent (tvpi_term_t t1, tvpi_term_t t2, int x)
   /* compute sign of x in t2 */
   if (t2->var[0] == x) sgn_x_in_t2 = t2->sgn;
   else if (IS_VAR(t2->var[1]) && t2->var [1] == x) 
-    sgn_x_in_t2 = mpq_sgn (*t2->coeff);
+    sgn_x_in_t2 = tvpi_sgn_cst (t2->coeff);
   
   /* no x in t2, can't resolve */
   if (sgn_x_in_t2 == 0) return 0;
@@ -223,7 +406,7 @@ tvpi_terms_have_resolvent (tvpi_term_t t1, tvpi_term_t t2, int x)
   /* check whether t1 == t2 */
   if (t1->var [0] == t2->var[0] && 
       t1->var [1] == t2->var[1] &&
-      mpq_cmp (*t1->coeff, *t2->coeff) == 0) return 0;
+      tvpi_eq_cst (t1->coeff, t2->coeff)) return 0;
 
   return -1;
 }
@@ -232,11 +415,8 @@ tvpi_terms_have_resolvent (tvpi_term_t t1, tvpi_term_t t2, int x)
 void 
 tvpi_destroy_cst (tvpi_cst_t k)
 {
-  if (k != NULL)
-    {
-      mpq_clear (*k);
-      free (k);
-    }
+  if (k != NULL && !TVPI_CST_IS_SMALL (k))
+    tvpi_pool_free_cst (k);
 }
 
 /**
@@ -278,10 +458,7 @@ tvpi_create_term_sparse_si (int* var, int* coeff, size_t n)
   if (IS_VAR (t->var [1]))
     t->coeff = tvpi_create_si_cst (coeff [1]);
   else
-    {
-      t->coeff = new_cst ();
-      mpq_init (*t->coeff);
-    }
+    t->coeff = zero;
 
   return t;
 }
@@ -296,7 +473,7 @@ tvpi_term_t tvpi_create_term_sparse (int* var, tvpi_cst_t* coeff, size_t n)
 	  "More than 2 variables in inequality");
   assert ((n == 1 || (var [0] < var [1])) && "Variables must be ordered");
   assert (coeff [0] != NULL && "First coefficient cannot be NULL");
-  assert (mpz_cmpabs_ui (mpq_numref (*coeff[0]), 0) != 0 && 
+  assert (tvpi_sgn_cst (coeff[0]) != 0 && 
 	  "First coefficient must be non-zero");
 
   t = new_term ();
@@ -305,11 +482,10 @@ tvpi_term_t tvpi_create_term_sparse (int* var, tvpi_cst_t* coeff, size_t n)
   t->var [0] = var[0];
   t->var [1] = n == 2 ? var [1] : -1;
   
-  t->sgn = coeff [0] < 0 ? -1 : 1;
-  t->sgn = mpq_sgn (*coeff [0]);
+  t->sgn = tvpi_sgn_cst (coeff [0]);
 
-  mpq_abs (*coeff [0], *coeff [0]);
-  if (mpq_cmp_ui (*coeff [0], 1, 1) == 0)
+  CST_SET (coeff [0], tvpi_abs_cst (coeff [0]));
+  if (tvpi_cmp_si_cst (coeff [0], 1) == 0)
     {
       t->fst_coeff = NULL;
       tvpi_destroy_cst (coeff [0]);
@@ -320,10 +496,7 @@ tvpi_term_t tvpi_create_term_sparse (int* var, tvpi_cst_t* coeff, size_t n)
   if (IS_VAR (t->var [1]))
     t->coeff = coeff [1];
   else
-    {
-      t->coeff = new_cst ();
-      mpq_init (*t->coeff);
-    }
+    t->coeff = zero;
 
   return t;
 }
@@ -373,10 +546,7 @@ tvpi_create_term (int* coeff, size_t n)
 
   /* if no second variable, set coeff to 0 */
   if (v == 1) 
-    { 
-      t->coeff = new_cst ();
-      mpq_init (*(t->coeff));
-    }
+    t->coeff = zero;
   return t;
 }
 
@@ -431,9 +601,10 @@ tvpi_term_equals (tvpi_term_t t1, tvpi_term_t t2)
   return ((t1->sgn > 0 && t2->sgn > 0) || (t1->sgn < 0 && t2->sgn < 0)) &&
     t1->var [0] == t2->var [0] &&
     t1->var [1] == t2->var [1] &&
-    mpq_cmp (*t1->coeff, *t2->coeff) == 0 &&
+    tvpi_eq_cst (t1->coeff, t2->coeff) &&
     ((t1->fst_coeff == NULL && t2->fst_coeff == NULL) ||
-     (mpq_cmp (*t1->fst_coeff, *t2->fst_coeff) == 0));
+     (t1->fst_coeff != NULL && t2->fst_coeff != NULL &&
+      tvpi_eq_cst (t1->fst_coeff, t2->fst_coeff)));
 }
 
 
@@ -466,7 +637,10 @@ tvpi_num_of_vars (tvpi_theory_t *self)
 void
 tvpi_print_cst (FILE *f, tvpi_cst_t k)
 {
-  mpq_out_str (f, 10, *k);
+  if (TVPI_CST_IS_SMALL (k))
+    fprintf (f, "%ld", TVPI_CST_SMALL_VAL (k));
+  else
+    mpq_out_str (f, 10, TVPI_CST_MPQ (k));
 }
 
 void
@@ -481,12 +655,12 @@ tvpi_print_term (FILE *f, tvpi_term_t t)
   
   if (IS_VAR (t->var [1]))
     {
-      if (mpq_sgn (*t->coeff) >= 0)
+      if (tvpi_sgn_cst (t->coeff) >= 0)
 	fprintf (f, "+");
       
-      if (mpq_cmp_si (*t->coeff, 1, 1) == 0)
+      if (tvpi_cmp_si_cst (t->coeff, 1) == 0)
 	;
-      else if (mpq_cmp_si (*t->coeff, -1, 1) == 0)
+      else if (tvpi_cmp_si_cst (t->coeff, -1) == 0)
 	fprintf (f, "-");
       else
 	{   
@@ -506,10 +680,10 @@ tvpi_print_cons (FILE *f, tvpi_cons_t c)
   
   mpq_init (k1);
   if (IS_VAR (c->var [1]))
-    mpq_set (k1, *(c->coeff));
+    cst_get (k1, c->coeff);
 
   mpq_init (k2);
-  mpq_set (k2, *(c->cst));
+  cst_get (k2, c->cst);
 
   if (c->sgn < 0) 
     { 
@@ -584,19 +758,20 @@ tvpi_print_cons_smtlibv1 (FILE *fp,
 
       if (retval < 0) return 0;
       
-      if (mpq_sgn (*c->coeff) < 0)
+      if (tvpi_sgn_cst (c->coeff) < 0)
 	{
 	  retval = fprintf (fp, "(~ ");
 	  if (retval < 0) return 0;
 	}
 
       mpq_init (k);
-      mpq_abs (k, *c->coeff);
+      cst_get (k, c->coeff);
+      mpq_abs (k, k);
       retval = mpq_out_str (fp, 10, k);
       mpq_clear (k);
       if (retval == 0) return 0;
 
-      if (mpq_sgn (*c->coeff) < 0)
+      if (tvpi_sgn_cst (c->coeff) < 0)
 	{
 	  retval = fprintf (fp, ")");
 	  if (retval < 0) return 0;
@@ -610,18 +785,19 @@ tvpi_print_cons_smtlibv1 (FILE *fp,
     }
 
   /* print the constant */
-  if (mpq_sgn (*c->cst) < 0)
+  if (tvpi_sgn_cst (c->cst) < 0)
     {
       retval = fprintf (fp, "(~ ");
       if (retval < 0) return 0;
     }
   mpq_init (k);
-  mpq_abs (k, *c->cst);
+  cst_get (k, c->cst);
+  mpq_abs (k, k);
   retval = mpq_out_str (fp, 10, k);
   mpq_clear (k);
   if (retval == 0) return 0;
   
-  if (mpq_sgn (*c->cst) < 0)
+  if (tvpi_sgn_cst (c->cst) < 0)
     {
       retval = fprintf (fp, ")");
       if (retval < 0) return 0;
@@ -656,7 +832,7 @@ tvpi_dump_smtlibv1_prefix (tvpi_theory_t *theory,
 	    outputFlag = 1;
 	  }
 	
-	retval = fprintf (fp, "(v%d %s)\n", i, theory->smt_var_type);
+	retval = fprintf (fp, "(v%zu %s)\n", i, theory->smt_var_type);
 	if (retval < 0) return 0;
       }
   
@@ -677,16 +853,10 @@ tvpi_dup_term (tvpi_term_t t)
   r->var[0] = t->var[0];
   r->var[1] = t->var[1];
   
-  r->coeff = new_cst ();
-  mpq_init (*r->coeff);
-  mpq_set (*r->coeff, *t->coeff);
+  r->coeff = tvpi_dup_cst (t->coeff);
   
   if (t->fst_coeff != NULL)
-    {
-      r->fst_coeff = new_cst ();
-      mpq_init (*r->fst_coeff);
-      mpq_set (*r->fst_coeff, *t->fst_coeff);
-    }
+    r->fst_coeff = tvpi_dup_cst (t->fst_coeff);
 
   return r;
 }
@@ -702,7 +872,7 @@ tvpi_negate_term (tvpi_term_t t)
   assert (t->fst_coeff == NULL && "Cannot negate term with first coeff");
   r = tvpi_dup_term (t);
   r->sgn = -t->sgn;
-  if (IS_VAR (t->var [1])) mpq_neg (*r->coeff, *r->coeff);
+  if (IS_VAR (t->var [1])) CST_SET (r->coeff, tvpi_negate_cst (r->coeff));
   return r;
 }
 
@@ -714,7 +884,7 @@ tvpi_destroy_term (tvpi_term_t t)
     {
       tvpi_destroy_cst (t->fst_coeff);
       tvpi_destroy_cst (t->coeff);
-      free (t);
+      tvpi_pool_free_cons (t);
     }
 }
 
@@ -730,9 +900,9 @@ tvpi_create_cons (tvpi_term_t t, bool s, tvpi_cst_t k)
   /* divide everything by the coefficient of var[0], if there is one */
   if (t->fst_coeff != NULL)
     {
-      mpq_div (*t->cst, *t->cst, *t->fst_coeff);
+      CST_SET (t->cst, tvpi_div_cst (t->cst, t->fst_coeff));
       if (IS_VAR (t->var [1]))
-	mpq_div (*t->coeff, *t->coeff, *t->fst_coeff);
+	CST_SET (t->coeff, tvpi_div_cst (t->coeff, t->fst_coeff));
       tvpi_destroy_cst (t->fst_coeff);
       t->fst_coeff = NULL;
     }
@@ -792,15 +962,18 @@ tvpi_get_term (tvpi_cons_t c)
 void
 tvpi_cst_set_mpq (mpq_t res, tvpi_cst_t k) 
 {
-  mpq_set (res, *k); 
+  cst_get (res, k);
 }
 
 tvpi_cst_t tvpi_create_cst (mpq_t k)
 {
-  mpq_t *r = (mpq_t*) malloc (sizeof (mpq_t));
-  if (r == NULL) return NULL;
-  mpq_init (*r);
-  mpq_set (*r, k);
+  mpq_t q;
+  tvpi_cst_t r;
+
+  mpq_init (q);
+  mpq_set (q, k);
+  r = cst_from_mpq (q);
+  mpq_clear (q);
   return r;
 }
 
@@ -808,13 +981,15 @@ tvpi_cst_t tvpi_create_cst (mpq_t k)
 signed long int
 tvpi_cst_get_si_num (tvpi_cst_t c)
 {
-  return mpz_get_si (mpq_numref (*c));
+  if (TVPI_CST_IS_SMALL (c)) return TVPI_CST_SMALL_VAL (c);
+  return mpz_get_si (mpq_numref (TVPI_CST_MPQ (c)));
 }
 
 signed long int
 tvpi_cst_get_si_den (tvpi_cst_t c)
 {
-  return mpz_get_si (mpq_denref (*c));
+  if (TVPI_CST_IS_SMALL (c)) return 1;
+  return mpz_get_si (mpq_denref (TVPI_CST_MPQ (c)));
 }
 
 
@@ -822,10 +997,13 @@ tvpi_cst_get_si_den (tvpi_cst_t c)
 tvpi_cst_t 
 tvpi_dup_cst (tvpi_cst_t k)
 {
-  tvpi_cst_t r = new_cst ();
+  tvpi_cst_t r;
 
-  mpq_init (*r);
-  mpq_set (*r, *k);
+  if (k == NULL || TVPI_CST_IS_SMALL (k)) return k;
+
+  r = tvpi_pool_alloc_cst ();
+  if (r == NULL) return NULL;
+  mpq_set (r->val, TVPI_CST_MPQ (k));
   return r;
 }
 
@@ -842,9 +1020,7 @@ tvpi_dup_cons (tvpi_cons_t c)
 
   r = tvpi_dup_term (c);
   r->op = c->op;
-  r->cst = new_cst ();
-  mpq_init (*r->cst);
-  mpq_set (*(r->cst), *(c->cst));
+  r->cst = tvpi_dup_cst (c->cst);
 
   return r;
 }
@@ -885,7 +1061,7 @@ tvpi_is_stronger_cons (tvpi_cons_t c1, tvpi_cons_t c2)
        * t <= k DOES NOT IMPLY t < k
        */
       int i;
-      i = mpq_cmp (*c1->cst, *c2->cst);
+      i = tvpi_cmp_cst (c1->cst, c2->cst);
       if (i < 0) return 1;
       else if (i == 0) return c1->op == LT || c2->op == LEQ;
     }
@@ -948,12 +1124,8 @@ tvpi_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
   idx_x_c1 = 1 - idx_o_c1;
   idx_x_c2 = 1 - idx_o_c2;
 
-  /** allocate the new constraint and it's constants */
+  /** allocate the new constraint */
   c = new_cons ();
-  c->coeff = new_cst ();
-  mpq_init (*c->coeff);
-  c->cst = new_cst ();
-  mpq_init (*c->cst);
 
   /* the resolvent is LT if either one of the arguments is LT */
   c->op = (c1->op == LEQ && c2->op == LEQ) ? LEQ : LT;
@@ -962,10 +1134,13 @@ tvpi_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
   /* special case when !IS_VAR(c1->var[1]) */
   if (!IS_VAR (c1->var [1]))
     {
+      tvpi_cst_t k;
+
       /* c1 only has x, c2 has x and some other variable */
       c->var [0] = c2->var[idx_o_c2];
       c->var [1] = -1;
       c->fst_coeff = NULL;
+      c->coeff = zero;
       
       if (idx_o_c2 == 0)
 	{
@@ -974,33 +1149,27 @@ tvpi_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
 	  /* let c1: -x <= k, c2: z + n*x <= m 
 	   * resolvent is   z <= |n|*k+m 
 	   */
-	  mpq_abs (*c->cst, *c2->coeff);
-	  mpq_mul (*c->cst, *c->cst, *c1->cst);
-	  mpq_add (*c->cst, *c->cst, *c2->cst);
+	  k = tvpi_abs_cst (c2->coeff);
+	  CST_SET (k, tvpi_mul_cst (k, c1->cst));
+	  c->cst = tvpi_add_cst (k, c2->cst);
+	  tvpi_destroy_cst (k);
 	}
       else
 	{ 
 	  /* let c1: -x <= k, c2: x + n*y <= m
 	   * resolvent is:  sgn(n) * y <= (m+k)/|n|
 	   */
-	  mpq_t tmp;
-	  c->sgn = mpq_sgn (*c2->coeff);
+	  c->sgn = tvpi_sgn_cst (c2->coeff);
 	  
-	  mpq_abs (*c->cst, *c2->coeff);
-	  mpq_inv (*c->cst, *c->cst);
-
-	  mpq_init (tmp);
-	  mpq_add (tmp, *c1->cst, *c2->cst);
-	  mpq_mul (*c->cst, *c->cst, tmp);
-	  mpq_clear (tmp);
+	  k = tvpi_abs_cst (c2->coeff);
+	  c->cst = tvpi_add_cst (c1->cst, c2->cst);
+	  CST_SET (c->cst, tvpi_div_cst (c->cst, k));
+	  tvpi_destroy_cst (k);
 	}
       return c;
     }
   
   
-  c->fst_coeff = new_cst ();
-  mpq_init (*c->fst_coeff);
-  
   /* variables of the new constraint */
   c->var[0] = c1->var[idx_o_c1];
   c->var[1] = c2->var[idx_o_c2];
@@ -1013,24 +1182,22 @@ tvpi_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
       if (idx_x_c2 == 0) same_coeff = 1;
       else
 	/* note that we compare  c2->coeff with -coeff of x in c1 */
-	same_coeff = (mpq_cmp_si (*c2->coeff, c1->sgn < 0 ? 1 : -1, 1) == 0);
+	same_coeff = (tvpi_cmp_si_cst (c2->coeff, c1->sgn < 0 ? 1 : -1) == 0);
     }
   else 
     {
       if (idx_x_c2 == 0)
 	/* note that we compare c1->coeff with -coeff of x in c2 */
-	same_coeff = (mpq_cmp_si (*c1->coeff, c2->sgn < 0 ? 1 : -1, 1) == 0);
+	same_coeff = (tvpi_cmp_si_cst (c1->coeff, c2->sgn < 0 ? 1 : -1) == 0);
       else
 	{
-	  mpq_t v1,v2;
-	  mpq_init (v1);
-	  mpq_init (v2);
+	  tvpi_cst_t v1, v2;
 	  
-	  mpq_abs (v1, *c1->coeff);
-	  mpq_abs (v2, *c2->coeff);
-	  same_coeff = (mpq_cmp (v1, v2) == 0);
-	  mpq_clear (v1);
-	  mpq_clear (v2);
+	  v1 = tvpi_abs_cst (c1->coeff);
+	  v2 = tvpi_abs_cst (c2->coeff);
+	  same_coeff = tvpi_eq_cst (v1, v2);
+	  tvpi_destroy_cst (v1);
+	  tvpi_destroy_cst (v2);
 	}
     }
   
@@ -1042,45 +1209,42 @@ tvpi_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
    */
   
   if (idx_o_c1 == 0)
-    mpq_set_si (*c->fst_coeff, c1->sgn < 0 ? -1 : 1, 1);
+    c->fst_coeff = c1->sgn < 0 ? none : one;
   else
-    mpq_set (*c->fst_coeff, *c1->coeff);
+    c->fst_coeff = tvpi_dup_cst (c1->coeff);
   
-  mpq_set (*c->cst, *c1->cst);
+  c->cst = tvpi_dup_cst (c1->cst);
   
   if (!same_coeff && idx_x_c2 != 0)
     {
       /* multiply everything by coeff (c2->var[idx_x_c2]) */
-      mpq_t v;
-      mpq_init (v);
-      mpq_abs (v, *c2->coeff);
-      mpq_mul (*c->fst_coeff, *c->fst_coeff, v);
-      mpq_mul (*c->cst, *c->cst, v);
-      mpq_clear (v);
+      tvpi_cst_t v;
+      v = tvpi_abs_cst (c2->coeff);
+      CST_SET (c->fst_coeff, tvpi_mul_cst (c->fst_coeff, v));
+      CST_SET (c->cst, tvpi_mul_cst (c->cst, v));
+      tvpi_destroy_cst (v);
     }
   
   /* do the same thing for c->var[1] */
   if (idx_o_c2 == 0)
-    mpq_set_si (*c->coeff, c2->sgn < 0 ? -1 : 1, 1);
+    c->coeff = c2->sgn < 0 ? none : one;
   else
-    mpq_set (*c->coeff, *c2->coeff);
+    c->coeff = tvpi_dup_cst (c2->coeff);
   
   if (!same_coeff && idx_x_c1 != 0)
     {
-      mpq_t v, u;
-      mpq_init (v);
-      mpq_init (u);
+      tvpi_cst_t v, u;
 
-      mpq_abs (v, *c1->coeff);
-      mpq_mul (*c->coeff, *c->coeff, v);
+      v = tvpi_abs_cst (c1->coeff);
+      CST_SET (c->coeff, tvpi_mul_cst (c->coeff, v));
 
-      mpq_mul (u, v, *c2->cst);
-      mpq_add (*c->cst, *c->cst, u);
-      mpq_clear (u);
-      mpq_clear (v);
+      u = tvpi_mul_cst (v, c2->cst);
+      CST_SET (c->cst, tvpi_add_cst (c->cst, u));
+      tvpi_destroy_cst (u);
+      tvpi_destroy_cst (v);
     }
   else
-    mpq_add (*c->cst, *c->cst, *c2->cst);
+    CST_SET (c->cst, tvpi_add_cst (c->cst, c2->cst));
 
   /* normalize the constraint */
 
@@ -1088,25 +1252,26 @@ tvpi_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
      remove second occurrence of the variable */
   if (c->var [0] == c->var [1]) 
     { 
-      mpq_add (*c->fst_coeff, *c->fst_coeff, *c->coeff);
+      CST_SET (c->fst_coeff, tvpi_add_cst (c->fst_coeff, c->coeff));
 
-      assert (mpq_sgn (*c->fst_coeff) != 0 && "First coefficient becomes 0");
+      assert (tvpi_sgn_cst (c->fst_coeff) != 0 && 
+	      "First coefficient becomes 0");
       
       c->var [1] = -1; 
-      mpq_set_si (*c->coeff, 0, 1);
+      CST_SET (c->coeff, zero);
     }
   
   /* set the negative flag and absolute value of the first coefficient */
-  c->sgn = mpq_sgn (*c->fst_coeff);
+  c->sgn = tvpi_sgn_cst (c->fst_coeff);
   if (c->sgn < 0)
-    mpq_abs (*c->fst_coeff, *c->fst_coeff);
+    CST_SET (c->fst_coeff, tvpi_abs_cst (c->fst_coeff));
 
-  if (mpq_cmp_si (*c->fst_coeff, 1, 1) != 0)
+  if (tvpi_cmp_si_cst (c->fst_coeff, 1) != 0)
     {
       /* divide everything by first coefficient */
       if (IS_VAR (c->var [1]))
-	mpq_div (*c->coeff, *c->coeff, *c->fst_coeff);
-      mpq_div (*c->cst, *c->cst, *c->fst_coeff);
+	CST_SET (c->coeff, tvpi_div_cst (c->coeff, c->fst_coeff));
+      CST_SET (c->cst, tvpi_div_cst (c->cst, c->fst_coeff));
     }
   
   /* get rid of first coefficient, it is no longer needed */
@@ -1156,12 +1321,98 @@ tvpi_subst_ninf (LddManager *ldd,
     return tvpi_to_ldd (ldd, l);
   
   if ((l->var [0] == x && l->sgn > 0) || 
-      (l->var [1] == x && mpq_sgn (*l->coeff) > 0))
+      (l->var [1] == x && tvpi_sgn_cst (l->coeff) > 0))
     return Ldd_GetTrue (ldd);
 
   return Ldd_GetFalse (ldd);
 }
 
+/**
+   \brief Normalizes the result of a substitution and returns its LDD.
+   res has the coefficient of var[0] in fst_coeff (NULL for 1), and
+   the one of var[1] in coeff. Variables may be out of order. res is
+   destroyed.
+ */
+static LddNode*
+tvpi_subst_finish (LddManager *ldd, tvpi_cons_t res)
+{
+  LddNode *rn;
+
+  /* the coefficient of NEW variable is 0. This is possible  if
+     OTHER == NEW or when replacing a one-variable constraint with a constant*/
+  if (!IS_VAR (res->var [1]) && 
+      res->fst_coeff != NULL && 
+      tvpi_sgn_cst (res->fst_coeff) == 0)
+    {
+      /* result is reduced to a constant; compute '0 op cst', where 'op'
+	 and 'cst' come from res */
+      int sgn = tvpi_sgn_cst (res->cst);
+
+      /* the comparison depends on the operator of the result */
+      rn = (sgn > 0 || (sgn == 0 && res->op == LEQ)) ? 
+	Ldd_GetTrue (ldd) : Ldd_GetFalse (ldd);
+      tvpi_destroy_cons (res);
+      return rn;
+    }
+
+
+  /* if there are two variables, make sure they are ordered */
+  if (IS_VAR (res->var [0]) && IS_VAR (res->var [1]) && 
+      res->var [0] > res->var [1])
+    {
+      /* switch coefficients */
+      if (res->fst_coeff != NULL)
+	{
+	  tvpi_cst_t cst = res->coeff;
+	  res->coeff = res->fst_coeff;
+	  res->fst_coeff = cst;
+	}
+      else
+	{
+	  res->fst_coeff = res->coeff;
+	  res->coeff = tvpi_create_si_cst (1);
+	}
+
+      /* switch variables */
+      int v = res->var [0];
+      res->var [0] = res->var [1];
+      res->var [1] = v;
+    }
+
+  /* divide by fst_coeff */
+  if (res->fst_coeff != NULL)
+    {
+      res->sgn = tvpi_sgn_cst (res->fst_coeff);
+
+      assert (res->sgn != 0 && "first coefficient is 0");
+
+      if (res->sgn < 0)
+	CST_SET (res->fst_coeff, tvpi_abs_cst (res->fst_coeff));
+      
+      if (tvpi_cmp_si_cst (res->fst_coeff, 1) != 0)
+	{
+	  CST_SET (res->cst, tvpi_div_cst (res->cst, res->fst_coeff));
+	  if (IS_VAR (res->var [1]))
+	    CST_SET (res->coeff, tvpi_div_cst (res->coeff, res->fst_coeff));
+	}
+      tvpi_destroy_cst (res->fst_coeff);
+      res->fst_coeff = NULL;
+    }
+  else
+    /* first coefficient is +1 implicitly */
+    res->sgn = 1;
+
+  /* if var[1] is not a variable, set the coefficient to 0 */
+  if (!IS_VAR (res->var [1]))
+    res->coeff = zero;
+  
+  /* construct LDD */
+  rn = tvpi_to_ldd (ldd, res);
+  /* clear temporary constraint */
+  tvpi_destroy_cons (res);
+  return rn;
+}
+
 /**
    \brief substitutes a sum t + c, where t is a term and c a constant,
    for variable x in l. 
@@ -1231,14 +1482,12 @@ tvpi_subst_internal (LddManager *ldd,
   if (c != NULL)
     {
       if (l->var [0] == x)
-	res->cst = tvpi_dup_cst (c);
+	res->cst = tvpi_sub_cst (l->cst, c);
       else /* l->var [1] == x */
 	{
-	  res->cst = new_cst ();
-	  mpq_init (*res->cst);
-	  mpq_mul (*res->cst, *l->coeff, *c);
+	  res->cst = tvpi_mul_cst (l->coeff, c);
+	  CST_SET (res->cst, tvpi_sub_cst (l->cst, res->cst));
 	}
-      mpq_sub (*res->cst, *l->cst, *res->cst);
     }
   else
     res->cst = tvpi_dup_cst (l->cst);
@@ -1283,11 +1532,7 @@ tvpi_subst_internal (LddManager *ldd,
 	    res->fst_coeff = tvpi_dup_cst (l->coeff);
 	  /* multiply the coefficients */
 	  else
-	    {
-	      res->fst_coeff = new_cst ();
-	      mpq_init (*res->fst_coeff);
-	      mpq_mul (*res->fst_coeff, *t->fst_coeff, *l->coeff);
-	    }
+	    res->fst_coeff = tvpi_mul_cst (t->fst_coeff, l->coeff);
 	}
       /* x had no coefficients, but t did */
       else if (l->var [0] == x && t->fst_coeff != NULL)
@@ -1311,10 +1556,7 @@ tvpi_subst_internal (LddManager *ldd,
 	      else /* res->fst_coeff != NULL */
 		{
 		  /* only one implicit coefficient */
-		  /* using (n/d)+1 == (n+d)/d */
-		  mpz_add (mpq_numref (*res->fst_coeff), 
-			   mpq_numref (*res->fst_coeff),
-			   mpq_denref (*res->fst_coeff));
+		  CST_SET (res->fst_coeff, tvpi_add_cst (res->fst_coeff, one));
 		}
 	    }
 	  /* OTHER != NEW */
@@ -1334,16 +1576,11 @@ tvpi_subst_internal (LddManager *ldd,
 	    {
 	      /* implicit coefficient */
 	      if (res->fst_coeff == NULL)
-		{
-		  res->fst_coeff = tvpi_dup_cst (l->coeff);
-		  /* using (n/d)+1 == (n+d)/d */
-		  mpz_add (mpq_numref (*res->fst_coeff), 
-			   mpq_numref (*res->fst_coeff),
-			   mpq_denref (*res->fst_coeff));
-		}
+		res->fst_coeff = tvpi_add_cst (l->coeff, one);
 	      /* explicit coefficient */
 	      else
-		mpq_add (*res->fst_coeff, *res->fst_coeff, *l->coeff);
+		CST_SET (res->fst_coeff, 
+			 tvpi_add_cst (res->fst_coeff, l->coeff));
 	    }
 	  /* OTHER != NEW */
 	  else
@@ -1355,84 +1592,7 @@ tvpi_subst_internal (LddManager *ldd,
     }
 
   
-  LddNode *rn;
-  
-  /* the coefficient of NEW variable is 0. This is possible  if
-     OTHER == NEW or when replacing a one-variable constraint with a constant*/
-  if (!IS_VAR (res->var [1]) && 
-      res->fst_coeff != NULL && 
-      mpq_sgn (*res->fst_coeff) == 0)
-    {
-      /* result is reduced to a constant; compute '0 op cst', where 'op'
-	 and 'cst' come from res */
-      int sgn = mpq_sgn (*res->cst);
-
-      /* the comparison depends on the operator of the result */
-      rn = (sgn > 0 || (sgn == 0 && res->op == LEQ)) ? 
-	Ldd_GetTrue (ldd) : Ldd_GetFalse (ldd);
-      tvpi_destroy_cons (res);
-      return rn;
-    }
-
-
-  /* if there are two variables, make sure they are ordered */
-  if (IS_VAR (res->var [0]) && IS_VAR (res->var [1]) && 
-      res->var [0] > res->var [1])
-    {
-      /* switch coefficients */
-      if (res->fst_coeff != NULL)
-	{
-	  tvpi_cst_t cst = res->coeff;
-	  res->coeff = res->fst_coeff;
-	  res->fst_coeff = cst;
-	}
-      else
-	{
-	  res->fst_coeff = res->coeff;
-	  res->coeff = tvpi_create_si_cst (1);
-	}
-
-      /* switch variables */
-      int v = res->var [0];
-      res->var [0] = res->var [1];
-      res->var [1] = v;
-    }
-
-  /* divide by fst_coeff */
-  if (res->fst_coeff != NULL)
-    {
-      res->sgn = mpq_sgn (*res->fst_coeff);
-
-      assert (res->sgn != 0 && "first coefficient is 0");
-
-      if (res->sgn < 0)
-	mpq_abs (*res->fst_coeff, *res->fst_coeff);
-      
-      if (mpq_cmp_si (*res->fst_coeff, 1, 1) != 0)
-	{
-	  mpq_div (*res->cst, *res->cst, *res->fst_coeff);
-	  if (IS_VAR (res->var [1]))
-	    mpq_div (*res->coeff, *res->coeff, *res->fst_coeff);
-	}
-      tvpi_destroy_cst (res->fst_coeff);
-      res->fst_coeff = NULL;
-    }
-  else
-    /* first coefficient is +1 implicitly */
-    res->sgn = 1;
-
-  /* if var[1] is not a variable, set the coefficient to 0 */
-  if (!IS_VAR (res->var [1]))
-    {
-      res->coeff = new_cst ();
-      mpq_init (*res->coeff);
-    }
-  
-  /* construct LDD */
-  rn = tvpi_to_ldd (ldd, res);
-  /* clear temporary constraint */
-  tvpi_destroy_cons (res);
-  return rn;
+  return tvpi_subst_finish (ldd, res);
 }
 
 LddNode* 
@@ -1489,7 +1649,7 @@ tvpi_subst_pluse (LddManager *ldd,
   assert (l->sgn > 0 && "Substitution into negative constraint");
   
   /* compute the operator of the new constraint */
-  op = (l->var [1] == x && mpq_sgn (*l->coeff) < 0) ? LEQ : LT;
+  op = (l->var [1] == x && tvpi_sgn_cst (l->coeff) < 0) ? LEQ : LT;
 
   /* if (l->var [0] == x || l->var [1] == x) */
   /*   { */
@@ -1522,6 +1682,113 @@ tvpi_subst_pluse (LddManager *ldd,
   return r;
 }
 
+/**
+   \brief Substitutes t[i] + c[i] for x[i] in l, for all i < n
+   simultaneously.
+
+   \return an LDD for the new constraint if successful; NULL otherwise.
+
+   \param t terms with one variable each. t[i] can be NULL.
+   \param c constants. c[i] can be NULL.
+
+   \pre l is in a canonical form. The x[i] are distinct.
+ */
+LddNode*
+tvpi_subst_vec (LddManager *ldd,
+		tvpi_cons_t l,
+		int *x,
+		tvpi_term_t *t,
+		tvpi_cst_t *c,
+		size_t n)
+{
+  tvpi_cons_t res;
+  /* the new constraint is a[0]*v[0] + a[1]*v[1] op k */
+  int v[2];
+  tvpi_cst_t a[2], lc, tc, k;
+  int i, j, nv, changed;
+  size_t s;
+
+  assert (l->sgn > 0 && l->fst_coeff == NULL && "Constraint must be positive");
+
+  changed = 0;
+  nv = 0;
+  k = tvpi_dup_cst (l->cst);
+  for (i = 0; i < 2 && IS_VAR (l->var [i]); i++)
+    {
+      lc = i == 0 ? one : l->coeff;
+
+      for (s = 0; s < n && x [s] != l->var [i]; s++);
+
+      /* not substituted */
+      if (s == n)
+	{
+	  v [nv] = l->var [i];
+	  a [nv++] = tvpi_dup_cst (lc);
+	  continue;
+	}
+      changed = 1;
+
+      if (c [s] != NULL)
+	{
+	  tc = tvpi_mul_cst (lc, c [s]);
+	  CST_SET (k, tvpi_sub_cst (k, tc));
+	  tvpi_destroy_cst (tc);
+	}
+      if (t [s] == NULL) continue;
+
+      assert (!IS_VAR (t [s]->var [1]) && "Not a one-variable term");
+      tc = t [s]->fst_coeff != NULL ?
+	tvpi_abs_cst (t [s]->fst_coeff) : tvpi_dup_cst (one);
+      if (t [s]->sgn < 0)
+	CST_SET (tc, tvpi_negate_cst (tc));
+      CST_SET (tc, tvpi_mul_cst (tc, lc));
+
+      /* the same variable as before */
+      for (j = 0; j < nv && v [j] != t [s]->var [0]; j++);
+      if (j < nv)
+	{
+	  CST_SET (a [j], tvpi_add_cst (a [j], tc));
+	  tvpi_destroy_cst (tc);
+	}
+      else
+	{
+	  v [nv] = t [s]->var [0];
+	  a [nv++] = tc;
+	}
+    }
+
+  if (!changed)
+    {
+      for (j = 0; j < nv; j++)
+	tvpi_destroy_cst (a [j]);
+      tvpi_destroy_cst (k);
+      return tvpi_to_ldd (ldd, l);
+    }
+
+  /* drop the variables that cancel out */
+  for (i = 0, j = 0; i < nv; i++)
+    {
+      if (tvpi_sgn_cst (a [i]) == 0)
+	tvpi_destroy_cst (a [i]);
+      else
+	{
+	  v [j] = v [i];
+	  a [j++] = a [i];
+	}
+    }
+  nv = j;
+
+  res = new_cons ();
+  res->op = l->op;
+  res->cst = k;
+  res->var [0] = nv > 0 ? v [0] : -1;
+  res->fst_coeff = nv > 0 ? a [0] : tvpi_dup_cst (zero);
+  res->var [1] = nv > 1 ? v [1] : -1;
+  res->coeff = nv > 1 ? a [1] : NULL;
+
+  return tvpi_subst_finish (ldd, res);
+}
+
 
 void
 tvpi_var_bound (tvpi_cons_t l, 
@@ -1531,9 +1798,7 @@ tvpi_var_bound (tvpi_cons_t l,
   assert ((l->var [0] == x || l->var [1] == x) && "No variable to bound");
   if (l->var [1] == x)
     {
-      *dc = new_cst ();
-      mpq_init (**dc);
-      mpq_div (**dc, *l->cst, *l->coeff);
+      *dc = tvpi_div_cst (l->cst, l->coeff);
     }
   else
     *dc = tvpi_dup_cst (l->cst);
@@ -1543,8 +1808,7 @@ tvpi_var_bound (tvpi_cons_t l,
       *dt = new_term ();      
       (*dt)->var [0] = l->var [0];
       (*dt)->var [1] = -1;
-      (*dt)->fst_coeff = tvpi_create_si_cst (-1);
-      mpq_div (*(*dt)->fst_coeff, *(*dt)->fst_coeff, *l->coeff);
+      (*dt)->fst_coeff = tvpi_div_cst (none, l->coeff);
       
     }
   else if (IS_VAR (l->var [1]))
@@ -1553,9 +1817,7 @@ tvpi_var_bound (tvpi_cons_t l,
       (*dt)->sgn = 1;
       (*dt)->var [0] = l->var [1];
       (*dt)->var [1] = -1;
-      (*dt)->fst_coeff = new_cst ();  
-      mpq_init (*(*dt)->fst_coeff);
-      mpq_neg (*(*dt)->fst_coeff, *l->coeff);
+      (*dt)->fst_coeff = tvpi_negate_cst (l->coeff);
     }
   else
     *dt = NULL;
@@ -1571,7 +1833,7 @@ tvpi_cons_t
 tvpi_convert_q_to_z (tvpi_cons_t c)
 {
   /* new constant */
-  mpq_t k;
+  mpq_t k, d;
 
   /* input constraint is of the form 
    * +-x + (n/d)*y op z, where op is < or <=
@@ -1580,25 +1842,26 @@ tvpi_convert_q_to_z (tvpi_cons_t c)
    * +-x + (n/d)*y <= (floor(d*z)-s)/d, where s=0 if op is <= and s=1 otherwise
    */
 
-  /* k = 0/1 */
-  mpq_init (k);
-
-  /* if d != 1 */
-  if (mpz_cmp_ui (mpq_denref (*c->coeff), 1) != 0)
+  /* common case: d is 1 and z is an integer */
+  if (TVPI_CST_IS_SMALL (c->coeff) && TVPI_CST_IS_SMALL (c->cst))
     {
-      mpz_t tmp;
-     
-      mpz_init (tmp);
-      mpz_mul (tmp, mpq_denref (*c->coeff), mpq_numref (*c->cst));
-
-      /* k = (floor(d*c->cst))/1 */
-      mpz_fdiv_q (mpq_numref (k), tmp, mpq_denref (*c->cst));
-
-      mpz_clear (tmp);
+      if (c->op == LT)
+	{
+	  CST_SET (c->cst, tvpi_sub_cst (c->cst, one));
+	  c->op = LEQ;
+	}
+      return c;
     }
-  else
-    mpz_fdiv_q (mpq_numref (k), mpq_numref (*c->cst), mpq_denref (*c->cst));
 
+  mpq_init (k);
+  mpq_init (d);
+  cst_get (k, c->cst);
+  cst_get (d, c->coeff);
+
+  /* k = (floor(d*c->cst))/1 */
+  mpz_mul (mpq_numref (k), mpq_numref (k), mpq_denref (d));
+  mpz_fdiv_q (mpq_numref (k), mpq_numref (k), mpq_denref (k));
+  mpz_set_ui (mpq_denref (k), 1);
   
   if (c->op == LT)
     {
@@ -1607,17 +1870,19 @@ tvpi_convert_q_to_z (tvpi_cons_t c)
     }
   
   /* divide by d if we multiplied by it in the previous step */
-  if (mpz_cmp_ui (mpq_denref (*c->coeff), 1) != 0)
+  if (mpz_cmp_ui (mpq_denref (d), 1) != 0)
     {
-      mpz_set (mpq_denref (k), mpq_denref (*c->coeff));
+      mpz_set (mpq_denref (k), mpq_denref (d));
       /* if multiplied and divided by d, must canonicalize */
       mpq_canonicalize (k);
     }
   
   /* set the constant */
-  mpq_set (*c->cst, k);
+  tvpi_destroy_cst (c->cst);
+  c->cst = cst_from_mpq (k);
   /* clear temporary storage */
   mpq_clear (k);
+  mpq_clear (d);
 
   return c;
 }
@@ -1672,27 +1937,19 @@ tvpi_convert_uq_to_uz (tvpi_cons_t r)
 {
 
   assert (!IS_VAR (r->var[1]) || 
-	  (mpz_cmp_si (mpq_denref (*r->coeff), 1) == 0 &&
-	   mpz_cmpabs_ui (mpq_numref (*r->coeff), 1) == 0));
-  assert (mpz_cmp_si (mpq_denref (*r->cst), 1) == 0);
+	  tvpi_cmp_si_cst (r->coeff, 1) == 0 ||
+	  tvpi_cmp_si_cst (r->coeff, -1) == 0);
+  assert (tvpi_is_int_cst (r->cst));
 
   if (r->op == LT)
     {
-      /* using (n/d)-1 == (n-d)/d 
-       * no need to canonicalize because  gcd(n,d)==1 IMPLIES gcd (n-d,d)==1
-       */
-      mpz_sub (mpq_numref (*r->cst), mpq_numref (*r->cst), mpq_denref (*r->cst));
+      CST_SET (r->cst, tvpi_sub_cst (r->cst, one));
       r->op = LEQ;
     }
   
   /* floor fractional constants */
-  if (mpz_cmp_ui(mpq_denref (*r->cst), 1) != 0)
-    {
-      mpz_fdiv_q (mpq_numref (*r->cst), 
-		  mpq_numref (*r->cst),
-		  mpq_denref (*r->cst));
-      mpz_set_ui (mpq_denref (*r->cst), 1);
-    }
+  if (!tvpi_is_int_cst (r->cst))
+    CST_SET (r->cst, tvpi_floor_cst (r->cst));
   
   
   return r;
@@ -1750,244 +2007,193 @@ tvpi_uz_resolve_cons (tvpi_cons_t c1, tvpi_cons_t c2, int x)
 static void
 tvpi_ensure_capacity (tvpi_theory_t *t, int var)
 {
-  tvpi_list_node_t ***new_map;
-  size_t new_size, i, j;
-
   /** all is good */
   if (var < t->size) return;
 
-  /* need to re-allocate */
-  new_size = var + 10;
-  new_map = (tvpi_list_node_t***) 
-    malloc (sizeof (tvpi_list_node_t**) * new_size);
-  assert (new_map != NULL && "Unexpected out of memory");
-  
-  for (i = 0; i < new_size; i++)
+  t->size = 2 * t->size > var + 1 ? 2 * t->size : var + 1;
+}
+
+/**
+ * Hash of a normalized term. Only var[0], var[1] and coeff are used.
+ */
+static unsigned int
+tvpi_term_hash (tvpi_term_t t)
+{
+  unsigned long h;
+
+  h = (unsigned long) t->var [0] * 2654435761UL;
+  h = (h ^ (unsigned long) (t->var [1] + 1)) * 2654435761UL;
+
+  if (TVPI_CST_IS_SMALL (t->coeff))
+    h ^= (unsigned long) TVPI_CST_SMALL_VAL (t->coeff);
+  else
+    h ^= mpz_get_ui (mpq_numref (TVPI_CST_MPQ (t->coeff))) ^
+      (mpz_get_ui (mpq_denref (TVPI_CST_MPQ (t->coeff))) << 7);
+
+  return (unsigned int) (h ^ (h >> 17));
+}
+
+/**
+ * Returns the bucket of the term table for term c, or NULL if the
+ * theory has not seen a constraint with this term yet.
+ */
+static tvpi_bucket_t *
+tvpi_find_bucket (tvpi_theory_t *t, tvpi_term_t c, unsigned int h)
+{
+  tvpi_bucket_t *b;
+  tvpi_cons_t k;
+
+  for (b = t->tab [h & (t->tab_size - 1)]; b != NULL; b = b->next)
     {
-      new_map [i] = (tvpi_list_node_t**) 
-	malloc (new_size * sizeof (tvpi_list_node_t*));
-      assert (new_map [i] != NULL && "Unexpected out of memory");
-      for (j = 0; j < t->is_box ? 1 : new_size; j++)
-	{
-	  /* copy all the entries from the old map */
-	  if (i < t->size && j < (t->is_box ? 1 : t->size))
-	    new_map [i][j] = t->map [i][j];
-	  else
-	    /* set new entries to NULL */
-	    new_map [i][j] = NULL;
-	}
-      /* free row i from the old map */
-      if (i < t->size) free (t->map [i]);
+      if (b->hash != h) continue;
+      k = b->ent [0].cons;
+      if (k->var [0] == c->var [0] && k->var [1] == c->var [1] &&
+	  tvpi_eq_cst (k->coeff, c->coeff))
+	return b;
     }
+  return NULL;
+}
+
+/**
+ * Doubles the size of the term table.
+ */
+static int
+tvpi_grow_table (tvpi_theory_t *t)
+{
+  tvpi_bucket_t **ntab;
+  size_t nsize, i;
+
+  nsize = 2 * t->tab_size;
+  ntab = (tvpi_bucket_t**) calloc (nsize, sizeof (tvpi_bucket_t*));
+  if (ntab == NULL) return 0;
 
-  /* at this point, all rows are freed, just kill the container */
-  free (t->map);
+  for (i = 0; i < t->tab_size; i++)
+    while (t->tab [i] != NULL)
+      {
+	tvpi_bucket_t *b = t->tab [i];
+	t->tab [i] = b->next;
+	b->next = ntab [b->hash & (nsize - 1)];
+	ntab [b->hash & (nsize - 1)] = b;
+      }
 
-  /* install a new map */
-  t->map = new_map;
-  t->size = new_size;
+  free (t->tab);
+  t->tab = ntab;
+  t->tab_size = nsize;
+  return 1;
 }
 
+/**
+ * Compares constraint c with the interned constraint e that has the
+ * same term. Constraints are ordered by their constant, and a strict
+ * constraint precedes the non-strict one with the same constant.
+ */
+static int
+tvpi_entry_cmp (tvpi_cons_t e, tvpi_cons_t c)
+{
+  int j;
+
+  j = tvpi_cmp_cst (e->cst, c->cst);
+  if (j != 0) return j;
+  if (e->op == c->op) return 0;
+  return e->op == LT ? -1 : 1;
+}
 
 /**
- * Returns a DD representing a constraint.
+ * Returns the LDD variable of constraint c, creating it if this is
+ * the first time c is seen. Constraints with the same term are kept
+ * in one bucket of a hash table, sorted by constant, so that a new
+ * constraint is placed in the variable order right next to its
+ * neighbours.
+ *
+ * \pre c is normalized and positive
  */
 LddNode*
 tvpi_get_dd (LddManager *m, tvpi_theory_t* t, tvpi_cons_t c)
 {
-  tvpi_list_node_t *ln;
-  tvpi_list_node_t *p;
-  tvpi_list_node_t *o;
-  
-  /* keys into the map */
-  int var0, var1;
-  int i,j;
-  
+  tvpi_bucket_t *b;
+  tvpi_entry_t *e;
+  unsigned int h;
+  size_t lo, hi, mid;
+  int j;
 
   assert (c->sgn > 0 && "Negative constraint");
   assert (c->coeff != NULL && "Missing coefficient");
   assert (c->fst_coeff == NULL && "Not normalized first coefficient");
   
-  /* initialize j */
-  j = -1;
-  
-  var0 = c->var[0];
-  /* if there is no second variable, use var0 */
-  var1 = IS_VAR (c->var [1]) ? c->var[1] : var0;
+  tvpi_ensure_capacity (t, c->var [0] > c->var [1] ? c->var [0] : c->var [1]);
 
-  tvpi_ensure_capacity (t, var0 > var1 ? var0 : var1);
-  
-  /* get the head of a link list that holds all constraints with the
-     variables of c */
-  ln = MAP(t,var0,var1);
+  h = tvpi_term_hash (c);
+  b = tvpi_find_bucket (t, c, h);
 
-  /* first ever constraint with var0 and var1 */
-  if (ln == NULL)
+  /* first ever constraint with this term */
+  if (b == NULL)
     {
-      ln = (tvpi_list_node_t*) malloc (sizeof (tvpi_list_node_t));
-      if (ln == NULL) return NULL;
-      
-      ln->prev = ln->next = NULL;
-      ln->cons = tvpi_dup_cons (c);
-      ln->dd = Ldd_NewVar (m, (lincons_t)(ln->cons));
-      assert (ln->dd != NULL);
-      Ldd_Ref (ln->dd);
-      
-      /* wire into the map */
-      SMAP(t,var0,var1,ln);
-      return ln->dd;
-    }
-  
-  /* find a place to insert c */
-
-  /* find the first constraint with the same term as c */
+      if (t->nterms >= t->tab_size && !tvpi_grow_table (t)) return NULL;
 
-  /* p iterates over the list */
-  /* o is prev of p */
-  o = NULL;
-  p = ln;
-  while (p != NULL &&  (i = mpq_cmp (*(p->cons->coeff), *(c->coeff))) < 0)
-    {
-      o = p;
-      p = p->next;
-    }
-
-  /* nothing with same term as c. Insert after 'o' in the list */
-  if (p == NULL || i != 0)
-    {
-      tvpi_list_node_t *n;
-
-      assert ((p != NULL || o != NULL) && "Unexpected NULL");
-      /* insert after o */
-      if (o != NULL)
+      b = (tvpi_bucket_t*) malloc (sizeof (tvpi_bucket_t));
+      if (b == NULL) return NULL;
+      b->ent = (tvpi_entry_t*) malloc (sizeof (tvpi_entry_t));
+      if (b->ent == NULL)
 	{
-	  n = (tvpi_list_node_t*) malloc (sizeof (tvpi_list_node_t));
-	  if (n == NULL) return NULL;
-	  
-	  n->prev = o;
-	  n->next = o->next;
-	  o->next = n;
-
-	  if (n->next != NULL)
-	    n->next->prev = n;
+	  free (b);
+	  return NULL;
 	}
-      /* insert before p */
-      else
-	{
-	  n = (tvpi_list_node_t*) malloc (sizeof (tvpi_list_node_t));
-	  if (n == NULL) return NULL;
-      
-	  n->next = p;
-	  n->prev = p->prev;
-	  p->prev = n;
-      
-	  /* since o is NULL, n is the new head of the list */
-	  /* add n to the list */
-	  SMAP(t,var0,var1,n);
-	}
-      
-      
-      n->cons = tvpi_dup_cons (c);
-      n->dd = Ldd_NewVar (m, (lincons_t) n->cons);
-      
-      assert (n->dd != NULL);
-      Ldd_Ref (n->dd);
-      return n->dd;
+      b->hash = h;
+      b->cap = 1;
+      b->n = 1;
+
+      e = &b->ent [0];
+      e->cons = tvpi_dup_cons (c);
+      e->dd = Ldd_NewVar (m, (lincons_t) e->cons);
+      assert (e->dd != NULL);
+      Ldd_Ref (e->dd);
+
+      /* wire into the table */
+      b->next = t->tab [h & (t->tab_size - 1)];
+      t->tab [h & (t->tab_size - 1)] = b;
+      t->nterms++;
+      return e->dd;
     }
-  
 
-  /* p->cons has same term as c->cons. 
-     First check whether c->cons < p->cons
-  */
-  j = mpq_cmp (*(p->cons->cst), *(c->cst));
-  
-  /* found c in the list */
-  if (j == 0 && p->cons->op == c->op)
-    return p->dd;
-  
-  /* c->cons precedes p->cons */
-  if (j > 0 || (j == 0 && c->op == LT && p->cons->op == LEQ))
+  /* find the first entry that is not less than c */
+  lo = 0;
+  hi = b->n;
+  while (lo < hi)
     {
-      tvpi_list_node_t *n;
-      
-      n = (tvpi_list_node_t*) malloc (sizeof (tvpi_list_node_t));
-      if (n == NULL) return NULL;
-      
-      n->next = p;
-      n->prev = p->prev;
-      p->prev = n;
-      
-      /* add n to the list */
-      if (n->prev != NULL) /* mid list */
-	n->prev->next = n;
-      else /* head of the list */
-	SMAP(t,var0,var1,n);
-      
-      n->cons = tvpi_dup_cons (c);
-      n->dd = Ldd_NewVarBefore (m, p->dd, (lincons_t)n->cons);
-      assert (n->dd != NULL);
-      Ldd_Ref (n->dd);
-      return n->dd;
+      mid = lo + (hi - lo) / 2;
+      j = tvpi_entry_cmp (b->ent [mid].cons, c);
+      if (j == 0) return b->ent [mid].dd;
+      if (j < 0) lo = mid + 1;
+      else hi = mid;
     }
-  
-  /* LOOP INVARIANTS
-   *  p->cons NOT EQUALS c->cons
-   * TERM (p->cons) EQUALS (c->cons)
-   * p->cons LESS c->cons
-   *
-   * LOOP TERMINATES when 
-   *   p->next == NULL OR 
-   *   p->next->cons EQUALS c->cons OR
-   *   c->cons LESS p->next->cons 
-   */
-  /* iterate through the list to find an element to insert c after */
-  while (p->next != NULL)
-    {
-      /* REUSE o: now points to p->next */
-      o = p->next;
 
-      /* o has different term than c */
-      if (mpq_cmp (*o->cons->coeff, *c->coeff) != 0) break;
-      
-      /* check the constant */
-      j = mpq_cmp (*(o->cons->cst), *(c->cst));
-      /* o->cons->cst > c->cst */
-      if (j > 0) break;
-      
-      /* invariant: i == 0 */
-
-      /* found same constraint as c */
-      if (j == 0 && c->op == o->cons->op)
-	return o->dd;
-      /* same constant, but strict inequality precedes non-strict one */      
-      else if (j == 0 && c->op == LT && o->cons->op == LEQ) break;
+  if (b->n == b->cap)
+    {
+      tvpi_entry_t *nent;
       
-
-      p = p->next;
+      nent = (tvpi_entry_t*) realloc (b->ent, 
+				      2 * b->cap * sizeof (tvpi_entry_t));
+      if (nent == NULL) return NULL;
+      b->ent = nent;
+      b->cap *= 2;
     }
 
-  assert (p != NULL);
+  memmove (&b->ent [lo + 1], &b->ent [lo], 
+	   (b->n - lo) * sizeof (tvpi_entry_t));
+  b->n++;
 
-  {
-    tvpi_list_node_t *n;
-    
-    n = (tvpi_list_node_t*) malloc (sizeof (tvpi_list_node_t));
-    if (n == NULL) return NULL;
-      
-    n->prev = p;
-    n->next = p->next;
-    p->next = n;
+  e = &b->ent [lo];
+  e->cons = tvpi_dup_cons (c);
+  /* c precedes all constraints with its term */
+  if (lo == 0)
+    e->dd = Ldd_NewVarBefore (m, b->ent [1].dd, (lincons_t) e->cons);
+  /* c goes right after its predecessor */
+  else
+    e->dd = Ldd_NewVarAfter (m, b->ent [lo - 1].dd, (lincons_t) e->cons);
 
-    if (n->next != NULL)
-      n->next->prev = n;
-      
-    n->cons = tvpi_dup_cons (c);
-    n->dd = Ldd_NewVarAfter (m, p->dd, (lincons_t) n->cons);
-      
-    assert (n->dd != NULL);
-    Ldd_Ref (n->dd);
-    return n->dd;
-  }
+  assert (e->dd != NULL);
+  Ldd_Ref (e->dd);
+  return e->dd;
 }
 
 LddNode*
@@ -2000,12 +2206,16 @@ tvpi_to_ldd(LddManager *m, tvpi_cons_t c)
   tvpi_cons_t nc;
   
   LddNode *res;
+  int scope;
 
   theory = (tvpi_theory_t*) (m->theory);
 
   nc = c->sgn < 0 ? theory->base.negate_cons (c) : c;
 
+  /* the interned constraint outlives any scratch scope */
+  scope = tvpi_scratch_suspend ();
   res = tvpi_get_dd (m, theory, nc);
+  tvpi_scratch_resume (scope);
   
   if (c->sgn < 0)
     tvpi_destroy_cons (nc);
@@ -2019,37 +2229,13 @@ int
 tvpi_initialize_theory (tvpi_theory_t *t)
 {
   
-  int i, j;
-  
-  /* allocate and initialize the map */  
-  t->map = (tvpi_list_node_t***) 
-    malloc (sizeof (tvpi_list_node_t**) * t->size);
-  if (t->map == NULL)
-    {
-      free (t);
-      return 0;
-    }
-
-  for (i = 0; i < t->size; i++)
-    {
-      t->map [i] = 
-	(tvpi_list_node_t**) malloc (BOX_SIZE(t) * sizeof (tvpi_list_node_t*));
-      /* XXX: handle malloc == NULL */
-      for (j = 0; j < BOX_SIZE(t); j++)
-	t->map [i][j] = NULL;
-    }
+  /* allocate and initialize the term table */  
+  t->tab_size = TVPI_TAB_SIZE;
+  t->nterms = 0;
+  t->tab = (tvpi_bucket_t**) calloc (t->tab_size, sizeof (tvpi_bucket_t*));
+  if (t->tab == NULL) return 0;
   
 
-  if (one == NULL)
-    one = tvpi_create_si_cst (1);
-  
-  if (none == NULL)
-    none = tvpi_create_si_cst (-1);
-  
-  if (zero == NULL)
-    zero = tvpi_create_si_cst (0);
-  
-  
   t->base.create_int_cst =  (constant_t(*)(int)) tvpi_create_si_cst;
   t->base.create_rat_cst = (constant_t(*)(long,long)) tvpi_create_si_rat_cst;
   t->base.create_double_cst = (constant_t(*)(double)) tvpi_create_d_cst;
@@ -2128,14 +2314,31 @@ tvpi_initialize_theory (tvpi_theory_t *t)
     (int(*)(theory_t*,FILE*,int*))tvpi_dump_smtlibv1_prefix;
   
 
+  t->base.qelim_init = 
+    (qelim_context_t*(*)(LddManager*,int*))tvpi_qelim_init;
+  t->base.qelim_push = 
+    (void(*)(qelim_context_t*,lincons_t))tvpi_qelim_push;
+  t->base.qelim_pop = (lincons_t(*)(qelim_context_t*))tvpi_qelim_pop;
+  t->base.qelim_solve = (LddNode*(*)(qelim_context_t*))tvpi_qelim_solve;
+  t->base.qelim_destroy_context = 
+    (void(*)(qelim_context_t*))tvpi_qelim_destroy_context;
+
+  t->base.scratch_begin = (void(*)(theory_t*))tvpi_scratch_begin;
+  t->base.scratch_end = (void(*)(theory_t*))tvpi_scratch_end;
+  t->base.is_box = (int(*)(theory_t*))tvpi_is_box;
+  t->base.subst_vec =
+    (LddNode*(*)(LddManager*,lincons_t,int*,linterm_t*,constant_t*,size_t))
+    tvpi_subst_vec;
+
   /* unimplemented */
   t->base.theory_debug_dump = NULL;
-  t->base.qelim_init = NULL;
-  t->base.qelim_push = NULL;
-  t->base.qelim_pop = NULL;
-  t->base.qelim_solve = NULL;
-  t->base.qelim_destroy_context = NULL;
 
+  t->pools = tvpi_pool_ref ();
+  if (t->pools == NULL)
+    {
+      free (t->tab);
+      return 0;
+    }
   return 1;
 }
 
@@ -2148,6 +2351,7 @@ tvpi_create_theory (size_t vn)
   if (t == NULL) return NULL;
   
   t->is_box = 0;
+  t->is_int = 0;
   t->smt_var_type = "Real";
   t->size = vn;
   if (!tvpi_initialize_theory (t))
@@ -2164,34 +2368,25 @@ void
 tvpi_destroy_theory (theory_t *theory)
 {
   tvpi_theory_t* t;
-  int i, j;
+  size_t i, k;
   
   t = (tvpi_theory_t*)theory;
 
-  for (i = 0; i < t->size; i++)
-    {
-      for (j = 0; j < BOX_SIZE(t); j++)
-	{
-	  tvpi_list_node_t *p;
-	  
-	  p = t->map [i][j];
-
-	  while (p != NULL)
-	    {
-	      tvpi_list_node_t *next;
-	      
-	      next = p->next;
-	      tvpi_destroy_cons (p->cons);
-	      free (p);
-	      p = next;
-	    }
-	  t->map[i][j] = NULL;
-	}
-      free (t->map [i]);
-      t->map [i] = NULL;
-    }  
-  free (t->map);
-  t->map = NULL;
+  for (i = 0; i < t->tab_size; i++)
+    while (t->tab [i] != NULL)
+      {
+	tvpi_bucket_t *b;
+
+	b = t->tab [i];
+	t->tab [i] = b->next;
+	for (k = 0; k < b->n; k++)
+	  tvpi_destroy_cons (b->ent [k].cons);
+	free (b->ent);
+	free (b);
+      }
+  free (t->tab);
+  t->tab = NULL;
+  tvpi_pool_unref (t->pools);
   free (t);
 }
 
@@ -2209,6 +2404,7 @@ tvpi_create_utvpiz_theory (size_t vn)
   if (t == NULL) return NULL;
   
   t->is_box = 0;
+  t->is_int = 1;
   t->smt_var_type = "Int";
   t->size = vn;
   if (!tvpi_initialize_theory (t))
@@ -2246,6 +2442,7 @@ tvpi_create_tvpiz_theory (size_t vn)
   if (t == NULL) return NULL;
   
   t->is_box = 0;
+  t->is_int = 1;
   t->smt_var_type = "Int";
   t->size = vn;
   if (!tvpi_initialize_theory (t))
@@ -2266,6 +2463,15 @@ tvpi_create_tvpiz_theory (size_t vn)
   return (theory_t*)t;
 }
 
+/**
+ * Returns 1 if t is a Box theory, where every term has one variable
+ */
+int
+tvpi_is_box (tvpi_theory_t *t)
+{
+  return t->is_box;
+}
+
 theory_t*
 tvpi_create_box_theory (size_t vn)
 {
@@ -2275,6 +2481,7 @@ tvpi_create_box_theory (size_t vn)
   if (t == NULL) return NULL;
 
   t->is_box = 1;
+  t->is_int = 0;
   t->smt_var_type = "Real";
   t->size = vn;
   if (!tvpi_initialize_theory (t))
@@ -2296,6 +2503,7 @@ tvpi_create_boxz_theory (size_t vn)
 
   t->smt_var_type = "Int";
   t->is_box = 1;
+  t->is_int = 1;
   t->size = vn;
   if (!tvpi_initialize_theory (t))
     {
@@ -2336,15 +2544,15 @@ tvpi_to_oct (tvpi_cons_t c1)
   
   oct->term.coeff1 = c1->sgn < 0 ? -1 : 1;
   
-  if (mpq_cmp_si (*c1->coeff, 1, 1) == 0)
+  if (tvpi_cmp_si_cst (c1->coeff, 1) == 0)
     oct->term.coeff2 = 1;
-  else  if (mpq_cmp_si (*c1->coeff, -1, 1) == 0)
+  else  if (tvpi_cmp_si_cst (c1->coeff, -1) == 0)
     oct->term.coeff2 = -1;
   else
     assert (0 && "c1->coeff is not in {-1, 1}");
 
   oct->cst.type = OCT_INT;
-  oct->cst.int_val = (int) mpz_get_si (mpq_numref (*c1->cst));
+  oct->cst.int_val = (int) tvpi_cst_get_si_num (c1->cst);
 
   return oct;
 }
@@ -2360,12 +2568,12 @@ tvpi_oct_equals (tvpi_cons_t tvpi, oct_cons_t *oct)
     return 0;
 
 
-  if (mpq_cmp_si (*tvpi->coeff, oct->term.coeff2, 1) != 0) return 0;
+  if (tvpi_cmp_si_cst (tvpi->coeff, oct->term.coeff2) != 0) return 0;
   
   if ((tvpi->op == LT && !oct->strict) || (tvpi->op == LEQ && oct->strict))
     return 0;
   
-  return mpq_cmp_si (*tvpi->cst, oct->cst.int_val, 1) == 0;
+  return tvpi_cmp_si_cst (tvpi->cst, oct->cst.int_val) == 0;
 }
 
 
@@ -7,7 +7,8 @@
 #include "ldd.h"
 #include "gmp.h"
 
-typedef mpq_t* tvpi_cst_t;
+/* opaque; use tvpi_create_cst and tvpi_cst_set_mpq to convert */
+typedef struct tvpi_cst *tvpi_cst_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +25,23 @@ extern "C" {
   tvpi_cst_t tvpi_create_cst(mpq_t k);
   void tvpi_cst_set_mpq (mpq_t res, tvpi_cst_t k);
 
+  /** allocation statistics of the TVPI object pools of a thread */
+  typedef struct tvpi_pool_stats
+  {
+    /* constraints and terms handed out */
+    unsigned long cons_allocs;
+    /* heap (GMP) constants handed out */
+    unsigned long cst_allocs;
+    /* calls to malloc made on behalf of the above */
+    unsigned long mallocs;
+    /* scratch scopes released in bulk */
+    unsigned long scratch_resets;
+  } tvpi_pool_stats_t;
+
+  void tvpi_pool_get_stats (tvpi_pool_stats_t *stats);
+  void tvpi_pool_reset_stats (void);
+  void tvpi_pool_enable (int enable);
+
 #ifdef __cplusplus
 }
 #endif
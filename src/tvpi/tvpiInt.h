@@ -9,18 +9,61 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <limits.h>
 #include <float.h>
 #include <string.h>
 #include <assert.h>
 #include <gmp.h>
 #include "lddInt.h"
+#include "tvpi.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-  typedef mpq_t* tvpi_cst_t;
+  /**
+   * A constant is either a tagged small integer or a pointer to a
+   * heap allocated mpq_t. Small integers have the lowest bit set and
+   * are never allocated, so that the common case of integer
+   * coefficients and bounds never touches GMP. A value that fits is
+   * always kept small, so two constants are equal iff they are both
+   * small and identical, or both big and mpq_equal.
+   * tvpi_cst_t itself is declared in tvpi.h.
+   */
+
+#define TVPI_CST_IS_SMALL(k) (((intptr_t)(k)) & 1)
+  /* leave a spare bit so that adding two small values never overflows */
+#define TVPI_CST_SMALL_MAX \
+  ((INTPTR_MAX < LONG_MAX ? INTPTR_MAX : LONG_MAX) >> 2)
+#define TVPI_CST_SMALL_MIN (-TVPI_CST_SMALL_MAX - 1)
+#define TVPI_CST_FITS(v) \
+  ((v) >= TVPI_CST_SMALL_MIN && (v) <= TVPI_CST_SMALL_MAX)
+#define TVPI_CST_MK_SMALL(v) \
+  ((tvpi_cst_t)(((uintptr_t)(intptr_t)(long)(v) << 1) | 1))
+#define TVPI_CST_SMALL_VAL(k) ((long)(((intptr_t)(k)) >> 1))
+#define TVPI_CST_MPQ(k) ((k)->val)
+
+  /* owners of constraint and constant objects. See tvpiPool.c */
+  typedef struct tvpi_pool tvpi_pool_t;
+  typedef struct tvpi_pools tvpi_pools_t;
+
+  /* storage class of the per-thread pool state. See tvpiPool.c */
+#if defined (_MSC_VER)
+#define TVPI_THREAD_LOCAL __declspec (thread)
+#else
+#define TVPI_THREAD_LOCAL __thread
+#endif
+
+  /* a heap constant */
+  struct tvpi_cst
+  {
+    mpq_t val;
+    /* next free constant in the owning pool */
+    struct tvpi_cst *next;
+    /* the owning pool, NULL if malloc'ed */
+    tvpi_pool_t *pool;
+  };
 
   /* type of the comparison operator in a constraint */
   typedef enum {LT, LEQ} op_t;    
@@ -37,6 +80,8 @@ extern "C" {
     op_t op;
     /* the variables */
     int var[2];
+    /* the owning pool, NULL if malloc'ed */
+    tvpi_pool_t *pool;
     /* the coefficient of var[1] */
     tvpi_cst_t coeff;
     /* the constant */
@@ -58,14 +103,24 @@ extern "C" {
   /* Don't distinguish between terms and constraints */
   typedef tvpi_cons_t tvpi_term_t;
   
-  /* a link list element. Used to map constraints to nodes*/
-  typedef struct tvpi_list_node
+  /* a constraint known to the theory and its LDD variable */
+  typedef struct tvpi_entry
   {
     tvpi_cons_t cons;
     LddNode * dd;
-    struct tvpi_list_node *next;
-    struct tvpi_list_node *prev;
-  } tvpi_list_node_t;
+  } tvpi_entry_t;
+
+  /* all known constraints with the same term, sorted by constant */
+  typedef struct tvpi_bucket
+  {
+    tvpi_entry_t *ent;
+    size_t n;
+    size_t cap;
+    /* hash of the term */
+    unsigned int hash;
+    /* next bucket in the hash chain */
+    struct tvpi_bucket *next;
+  } tvpi_bucket_t;
     
   typedef struct tvpi_theory
   {
@@ -73,29 +128,55 @@ extern "C" {
     theory_t base;
     /* size in # of variables */
     size_t size;
-    /* maps a pair of variables to the list of constraints they appear in */
-    tvpi_list_node_t ***map;
+    /* hash table from a term to the constraints it appears in */
+    tvpi_bucket_t **tab;
+    /* number of chains in tab. A power of 2 */
+    size_t tab_size;
+    /* number of buckets in tab */
+    size_t nterms;
     
     /* SMT-LIB type of variables */
     char* smt_var_type;
 
     int is_box;
+
+    /* 1 if variables range over integers */
+    int is_int;
+
+    /* the pools of the thread that created the theory */
+    tvpi_pools_t *pools;
     
   } tvpi_theory_t;
+
+  /* incremental quantifier elimination context (see tvpiQelim.c) */
+  typedef struct tvpi_qelim_ctx tvpi_qelim_ctx_t;
   
 
   tvpi_cst_t tvpi_create_si_cst(int);
+  tvpi_cst_t tvpi_create_cst (mpq_t);
+  void tvpi_cst_set_mpq (mpq_t, tvpi_cst_t);
   tvpi_cst_t tvpi_negate_cst (tvpi_cst_t);
   tvpi_cst_t tvpi_dup_cst (tvpi_cst_t);
   tvpi_cst_t tvpi_add_cst (tvpi_cst_t,tvpi_cst_t);
+  tvpi_cst_t tvpi_sub_cst (tvpi_cst_t,tvpi_cst_t);
   tvpi_cst_t tvpi_mul_cst (tvpi_cst_t,tvpi_cst_t);
+  tvpi_cst_t tvpi_div_cst (tvpi_cst_t,tvpi_cst_t);
+  tvpi_cst_t tvpi_abs_cst (tvpi_cst_t);
+  tvpi_cst_t tvpi_floor_cst (tvpi_cst_t);
+  tvpi_cst_t tvpi_ceil_cst (tvpi_cst_t);
   int tvpi_sgn_cst (tvpi_cst_t);
+  int tvpi_cmp_cst (tvpi_cst_t,tvpi_cst_t);
+  int tvpi_cmp_si_cst (tvpi_cst_t,long);
+  int tvpi_eq_cst (tvpi_cst_t,tvpi_cst_t);
+  int tvpi_is_int_cst (tvpi_cst_t);
   void tvpi_destroy_cst (tvpi_cst_t);
   void tvpi_print_cst (FILE*, tvpi_cst_t);
 
   int tvpi_initialize_theory (tvpi_theory_t *);
   
   tvpi_term_t tvpi_create_linterm (int*, size_t);
+  tvpi_term_t tvpi_create_term_sparse_si (int*, int*, size_t);
+  tvpi_term_t tvpi_create_term_sparse (int*, tvpi_cst_t*, size_t);
   bool tvpi_term_equlas (tvpi_term_t, tvpi_term_t);
   bool tvpi_term_has_var (tvpi_term_t, int);
   bool tvpi_term_has_vars (tvpi_term_t t, int*);
@@ -120,6 +201,27 @@ extern "C" {
   
 
   size_t tvpi_num_of_vars (tvpi_theory_t *);
+
+  LddNode* tvpi_to_ldd (LddManager*, tvpi_cons_t);
+
+  tvpi_cons_t tvpi_pool_alloc_cons (void);
+  void tvpi_pool_free_cons (tvpi_cons_t);
+  tvpi_cst_t tvpi_pool_alloc_cst (void);
+  void tvpi_pool_free_cst (tvpi_cst_t);
+  tvpi_pools_t *tvpi_pool_ref (void);
+  void tvpi_pool_unref (tvpi_pools_t*);
+  void tvpi_scratch_begin (tvpi_theory_t*);
+  void tvpi_scratch_end (tvpi_theory_t*);
+
+  int tvpi_is_box (tvpi_theory_t*);
+  int tvpi_scratch_suspend (void);
+  void tvpi_scratch_resume (int);
+
+  tvpi_qelim_ctx_t* tvpi_qelim_init (LddManager*, int*);
+  void tvpi_qelim_push (tvpi_qelim_ctx_t*, tvpi_cons_t);
+  tvpi_cons_t tvpi_qelim_pop (tvpi_qelim_ctx_t*);
+  LddNode* tvpi_qelim_solve (tvpi_qelim_ctx_t*);
+  void tvpi_qelim_destroy_context (tvpi_qelim_ctx_t*);
   
   
   
@@ -0,0 +1,586 @@
+/**********************************************************************
+ * Slab allocator for TVPI constraints, terms and heap constants.
+ *
+ * Terms and constraints share struct tvpi_cons and are one size
+ * class; heap (GMP) constants are the other. Objects are carved out
+ * of chunks of TVPI_CHUNK_SLOTS slots and recycled through per-class
+ * free lists. A constant on a free list keeps its mpq_t initialized,
+ * so that its limbs are reused by the next constant.
+ *
+ * There are two pools. The persistent pool serves all allocations
+ * outside of a scratch scope. Inside a scratch scope (see
+ * tvpi_scratch_begin) allocations come from the scratch pool, which
+ * is reset in one shot when the outermost scope ends. Objects
+ * allocated in a scratch scope must not outlive it; constraints that
+ * are interned by tvpi_to_ldd are allocated with the scope suspended.
+ *
+ * The constructors of the theory interface do not take the theory as
+ * an argument, so the pools cannot live in the theory. Instead, every
+ * thread allocates from its own pair of pools (tvpi_pools_t), and
+ * every object records the pool it came from. A theory holds a
+ * reference to the pools of the thread that created it. An object
+ * freed by another thread is pushed on a lock-free list of its pool
+ * and taken back by the owner when it runs out of free slots. The
+ * pools are released when the last theory that uses them is
+ * destroyed and the owner no longer allocates from them, i.e., on the
+ * owner when no object is left, or when the owner exits. Independent
+ * theories can thus be used on separate threads without locking, and
+ * a theory may be destroyed by a thread other than its creator.
+ *
+ * Without LDD_HAVE_THREADS, a theory and its objects must stay on the
+ * thread that created them.
+ *********************************************************************/
+
+#include "tvpiInt.h"
+
+#ifdef LDD_HAVE_THREADS
+#include <pthread.h>
+#endif
+
+#define TVPI_CHUNK_SLOTS 256
+
+/* a constraint, or a link in the free list */
+typedef union tvpi_cons_slot
+{
+  struct tvpi_cons cons;
+  union tvpi_cons_slot *next;
+} tvpi_cons_slot_t;
+
+typedef struct tvpi_cons_chunk
+{
+  struct tvpi_cons_chunk *next;
+  tvpi_cons_slot_t slot [TVPI_CHUNK_SLOTS];
+} tvpi_cons_chunk_t;
+
+typedef struct tvpi_cst_chunk
+{
+  struct tvpi_cst_chunk *next;
+  struct tvpi_cst slot [TVPI_CHUNK_SLOTS];
+} tvpi_cst_chunk_t;
+
+struct tvpi_pool
+{
+  tvpi_cons_slot_t *cons_free;
+  struct tvpi_cst *cst_free;
+  tvpi_cons_chunk_t *cons_chunks;
+  tvpi_cst_chunk_t *cst_chunks;
+  /* number of objects handed out and not yet returned to the free
+     lists. Only the owner changes it. */
+  long live;
+  /* objects freed by other threads, not yet taken back */
+  tvpi_cons_slot_t *cons_remote;
+  struct tvpi_cst *cst_remote;
+};
+
+struct tvpi_pools
+{
+  tvpi_pool_t persist;
+  tvpi_pool_t scratch;
+  /* number of live theories created with the pools, plus one while
+     they are the pools of a thread */
+  int refs;
+};
+
+#ifdef LDD_HAVE_THREADS
+#define POOL_LOAD(p) __atomic_load_n ((p), __ATOMIC_RELAXED)
+#define POOL_STORE(p,v) __atomic_store_n ((p), (v), __ATOMIC_RELAXED)
+#define POOL_ADD(p,v) __atomic_add_fetch ((p), (v), __ATOMIC_ACQ_REL)
+#define POOL_TAKE(p) __atomic_exchange_n ((p), NULL, __ATOMIC_ACQUIRE)
+#define POOL_PUSH(p,old,new)						\
+  __atomic_compare_exchange_n ((p), (old), (new), 1,			\
+			       __ATOMIC_RELEASE, __ATOMIC_RELAXED)
+#else
+#define POOL_LOAD(p) (*(p))
+#define POOL_STORE(p,v) (*(p) = (v))
+#define POOL_ADD(p,v) (*(p) += (v))
+#define POOL_TAKE(p) pool_take ((void**) (p))
+#define POOL_PUSH(p,old,new) (*(p) = (new), 1)
+
+static void *
+pool_take (void **p)
+{
+  void *res = *p;
+  *p = NULL;
+  return res;
+}
+#endif
+
+/* the pools of this thread, or NULL */
+static TVPI_THREAD_LOCAL tvpi_pools_t *cur_pools = NULL;
+/* nesting depth of scratch scopes */
+static TVPI_THREAD_LOCAL int scratch_depth = 0;
+/* 0 if every object is malloc'ed individually; shared by all
+   threads */
+static int pool_enabled = 1;
+
+static TVPI_THREAD_LOCAL tvpi_pool_stats_t pool_stats;
+
+#ifdef LDD_HAVE_THREADS
+/* detaches the pools of a thread when it exits */
+static pthread_key_t pools_key;
+static pthread_once_t pools_key_once = PTHREAD_ONCE_INIT;
+#endif
+
+
+static int
+pool_grow_cons (tvpi_pool_t *p)
+{
+  tvpi_cons_chunk_t *ch;
+  int i;
+
+  ch = (tvpi_cons_chunk_t*) malloc (sizeof (tvpi_cons_chunk_t));
+  if (ch == NULL) return 0;
+  pool_stats.mallocs++;
+
+  ch->next = p->cons_chunks;
+  p->cons_chunks = ch;
+
+  for (i = 0; i < TVPI_CHUNK_SLOTS - 1; i++)
+    ch->slot [i].next = &ch->slot [i + 1];
+  ch->slot [TVPI_CHUNK_SLOTS - 1].next = p->cons_free;
+  p->cons_free = &ch->slot [0];
+  return 1;
+}
+
+static int
+pool_grow_cst (tvpi_pool_t *p)
+{
+  tvpi_cst_chunk_t *ch;
+  int i;
+
+  ch = (tvpi_cst_chunk_t*) malloc (sizeof (tvpi_cst_chunk_t));
+  if (ch == NULL) return 0;
+  pool_stats.mallocs++;
+
+  ch->next = p->cst_chunks;
+  p->cst_chunks = ch;
+
+  for (i = 0; i < TVPI_CHUNK_SLOTS; i++)
+    {
+      mpq_init (ch->slot [i].val);
+      ch->slot [i].pool = p;
+      ch->slot [i].next = i + 1 < TVPI_CHUNK_SLOTS ?
+	&ch->slot [i + 1] : p->cst_free;
+    }
+  p->cst_free = &ch->slot [0];
+  return 1;
+}
+
+/**
+ * Moves the objects freed by other threads to the free lists of p.
+ * Only the owner of p may call it.
+ */
+static void
+pool_drain (tvpi_pool_t *p)
+{
+  tvpi_cons_slot_t *s, *slast;
+  struct tvpi_cst *k, *klast;
+
+  s = (tvpi_cons_slot_t*) POOL_TAKE (&p->cons_remote);
+  if (s != NULL)
+    {
+      for (slast = s, p->live--; slast->next != NULL; slast = slast->next)
+	p->live--;
+      slast->next = p->cons_free;
+      p->cons_free = s;
+    }
+
+  k = (struct tvpi_cst*) POOL_TAKE (&p->cst_remote);
+  if (k != NULL)
+    {
+      for (klast = k, p->live--; klast->next != NULL; klast = klast->next)
+	p->live--;
+      klast->next = p->cst_free;
+      p->cst_free = k;
+    }
+}
+
+/**
+ * Puts every slot of p back on the free lists, regardless of whether
+ * it is in use. The chunks are kept for reuse.
+ */
+static void
+pool_reset (tvpi_pool_t *p)
+{
+  tvpi_cons_chunk_t *cch;
+  tvpi_cst_chunk_t *kch;
+  int i;
+
+  /* the slots on the remote lists are in the chunks too */
+  (void) POOL_TAKE (&p->cons_remote);
+  (void) POOL_TAKE (&p->cst_remote);
+
+  p->cons_free = NULL;
+  for (cch = p->cons_chunks; cch != NULL; cch = cch->next)
+    {
+      for (i = 0; i < TVPI_CHUNK_SLOTS - 1; i++)
+	cch->slot [i].next = &cch->slot [i + 1];
+      cch->slot [TVPI_CHUNK_SLOTS - 1].next = p->cons_free;
+      p->cons_free = &cch->slot [0];
+    }
+
+  p->cst_free = NULL;
+  for (kch = p->cst_chunks; kch != NULL; kch = kch->next)
+    {
+      for (i = 0; i < TVPI_CHUNK_SLOTS - 1; i++)
+	kch->slot [i].next = &kch->slot [i + 1];
+      kch->slot [TVPI_CHUNK_SLOTS - 1].next = p->cst_free;
+      p->cst_free = &kch->slot [0];
+    }
+
+  p->live = 0;
+}
+
+/**
+ * Returns all memory of p to the system.
+ */
+static void
+pool_release (tvpi_pool_t *p)
+{
+  int i;
+
+  while (p->cons_chunks != NULL)
+    {
+      tvpi_cons_chunk_t *ch = p->cons_chunks;
+      p->cons_chunks = ch->next;
+      free (ch);
+    }
+
+  while (p->cst_chunks != NULL)
+    {
+      tvpi_cst_chunk_t *ch = p->cst_chunks;
+      p->cst_chunks = ch->next;
+      for (i = 0; i < TVPI_CHUNK_SLOTS; i++)
+	mpq_clear (ch->slot [i].val);
+      free (ch);
+    }
+
+  p->cons_free = NULL;
+  p->cst_free = NULL;
+  p->cons_remote = NULL;
+  p->cst_remote = NULL;
+  p->live = 0;
+}
+
+/**
+ * Drops a reference to ps. The last reference releases the pools,
+ * unless some persistent object is still alive. Then the pools are
+ * leaked, so that the object stays valid.
+ */
+static void
+pools_put (tvpi_pools_t *ps)
+{
+  if (POOL_ADD (&ps->refs, -1) > 0) return;
+
+  /* nobody allocates from ps any more */
+  pool_drain (&ps->persist);
+  if (ps->persist.live != 0) return;
+
+  pool_release (&ps->persist);
+  pool_release (&ps->scratch);
+  free (ps);
+}
+
+/**
+ * Stops allocating from the pools of this thread. The scratch pool
+ * is released; objects in it do not outlive their scope.
+ */
+static void
+pools_detach (tvpi_pools_t *ps)
+{
+  cur_pools = NULL;
+#ifdef LDD_HAVE_THREADS
+  pthread_setspecific (pools_key, NULL);
+#endif
+  pool_release (&ps->scratch);
+  pools_put (ps);
+}
+
+#ifdef LDD_HAVE_THREADS
+static void
+pools_thread_exit (void *ps)
+{
+  pools_detach ((tvpi_pools_t*) ps);
+}
+
+static void
+pools_key_init (void)
+{
+  pthread_key_create (&pools_key, pools_thread_exit);
+}
+#endif
+
+/**
+ * Returns the pools of this thread, creating them if needed; NULL if
+ * out of memory.
+ */
+static tvpi_pools_t *
+pools_get (void)
+{
+  tvpi_pools_t *ps;
+
+  if (cur_pools != NULL) return cur_pools;
+
+  ps = (tvpi_pools_t*) calloc (1, sizeof (tvpi_pools_t));
+  if (ps == NULL) return NULL;
+  pool_stats.mallocs++;
+  ps->refs = 1;
+
+#ifdef LDD_HAVE_THREADS
+  pthread_once (&pools_key_once, pools_key_init);
+  if (pthread_setspecific (pools_key, ps) != 0)
+    {
+      free (ps);
+      return NULL;
+    }
+#endif
+  cur_pools = ps;
+  return ps;
+}
+
+#define CUR_POOL(ps) (scratch_depth > 0 ? &(ps)->scratch : &(ps)->persist)
+
+/**
+ * Allocates an uninitialized constraint.
+ */
+tvpi_cons_t
+tvpi_pool_alloc_cons (void)
+{
+  tvpi_pools_t *ps;
+  tvpi_pool_t *p;
+  tvpi_cons_slot_t *s;
+  tvpi_cons_t c;
+
+  pool_stats.cons_allocs++;
+
+  if (!POOL_LOAD (&pool_enabled))
+    {
+      c = (tvpi_cons_t) malloc (sizeof (struct tvpi_cons));
+      if (c == NULL) return NULL;
+      pool_stats.mallocs++;
+      c->pool = NULL;
+      return c;
+    }
+
+  ps = pools_get ();
+  if (ps == NULL) return NULL;
+  p = CUR_POOL (ps);
+  if (p->cons_free == NULL) pool_drain (p);
+  if (p->cons_free == NULL && !pool_grow_cons (p)) return NULL;
+
+  s = p->cons_free;
+  p->cons_free = s->next;
+  p->live++;
+
+  s->cons.pool = p;
+  return &s->cons;
+}
+
+void
+tvpi_pool_free_cons (tvpi_cons_t c)
+{
+  tvpi_pool_t *p;
+  tvpi_cons_slot_t *s, *head;
+
+  p = c->pool;
+  if (p == NULL)
+    {
+      free (c);
+      return;
+    }
+
+  s = (tvpi_cons_slot_t*) c;
+  if (cur_pools != NULL &&
+      (p == &cur_pools->persist || p == &cur_pools->scratch))
+    {
+      s->next = p->cons_free;
+      p->cons_free = s;
+      p->live--;
+      return;
+    }
+
+  /* a slot of another thread */
+  head = POOL_LOAD (&p->cons_remote);
+  do
+    s->next = head;
+  while (!POOL_PUSH (&p->cons_remote, &head, s));
+}
+
+/**
+ * Allocates a heap constant. The value of the constant is initialized
+ * but unspecified.
+ */
+tvpi_cst_t
+tvpi_pool_alloc_cst (void)
+{
+  tvpi_pools_t *ps;
+  tvpi_pool_t *p;
+  tvpi_cst_t k;
+
+  pool_stats.cst_allocs++;
+
+  if (!POOL_LOAD (&pool_enabled))
+    {
+      k = (tvpi_cst_t) malloc (sizeof (struct tvpi_cst));
+      if (k == NULL) return NULL;
+      pool_stats.mallocs++;
+      mpq_init (k->val);
+      k->pool = NULL;
+      return k;
+    }
+
+  ps = pools_get ();
+  if (ps == NULL) return NULL;
+  p = CUR_POOL (ps);
+  if (p->cst_free == NULL) pool_drain (p);
+  if (p->cst_free == NULL && !pool_grow_cst (p)) return NULL;
+
+  k = p->cst_free;
+  p->cst_free = k->next;
+  p->live++;
+  return k;
+}
+
+void
+tvpi_pool_free_cst (tvpi_cst_t k)
+{
+  tvpi_pool_t *p;
+  tvpi_cst_t head;
+
+  p = k->pool;
+  if (p == NULL)
+    {
+      mpq_clear (k->val);
+      free (k);
+      return;
+    }
+
+  if (cur_pools != NULL &&
+      (p == &cur_pools->persist || p == &cur_pools->scratch))
+    {
+      k->next = p->cst_free;
+      p->cst_free = k;
+      p->live--;
+      return;
+    }
+
+  /* a constant of another thread */
+  head = POOL_LOAD (&p->cst_remote);
+  do
+    k->next = head;
+  while (!POOL_PUSH (&p->cst_remote, &head, k));
+}
+
+
+/**
+ * Registers a new TVPI theory with the pools of this thread.
+ *
+ * \return the pools, to be passed to tvpi_pool_unref(); NULL if out
+ * of memory
+ */
+tvpi_pools_t *
+tvpi_pool_ref (void)
+{
+  tvpi_pools_t *ps;
+
+  ps = pools_get ();
+  if (ps != NULL) POOL_ADD (&ps->refs, 1);
+  return ps;
+}
+
+/**
+ * Unregisters a TVPI theory, on any thread. When the last theory of
+ * the pools is gone on the thread that owns them, they are released,
+ * unless some persistent object is still alive.
+ */
+void
+tvpi_pool_unref (tvpi_pools_t *ps)
+{
+  if (ps != cur_pools)
+    {
+      pools_put (ps);
+      return;
+    }
+
+  /* only this thread takes references to its pools */
+  if (POOL_ADD (&ps->refs, -1) > 1 || scratch_depth > 0) return;
+
+  pool_drain (&ps->persist);
+  if (ps->persist.live == 0)
+    pools_detach (ps);
+}
+
+/**
+ * \brief Opens a scratch scope. Until the matching
+ * tvpi_scratch_end(), new constraints, terms and constants are
+ * allocated from the scratch pool. Scopes nest.
+ */
+void
+tvpi_scratch_begin (tvpi_theory_t *t)
+{
+  (void) t;
+  scratch_depth++;
+}
+
+/**
+ * \brief Closes a scratch scope. When the outermost scope is closed,
+ * every object allocated inside it is released in one shot, whether
+ * or not it has been destroyed.
+ */
+void
+tvpi_scratch_end (tvpi_theory_t *t)
+{
+  (void) t;
+  assert (scratch_depth > 0);
+  if (--scratch_depth > 0) return;
+
+  /* if everything was destroyed, all slots are already free */
+  if (cur_pools != NULL && cur_pools->scratch.live != 0)
+    pool_reset (&cur_pools->scratch);
+  pool_stats.scratch_resets++;
+}
+
+/**
+ * Temporarily routes allocations to the persistent pool. Returns a
+ * value that must be passed to tvpi_scratch_resume().
+ */
+int
+tvpi_scratch_suspend (void)
+{
+  int d = scratch_depth;
+  scratch_depth = 0;
+  return d;
+}
+
+void
+tvpi_scratch_resume (int d)
+{
+  scratch_depth = d;
+}
+
+
+/**
+ * \brief Returns the statistics of the pools of the calling thread.
+ */
+void
+tvpi_pool_get_stats (tvpi_pool_stats_t *stats)
+{
+  *stats = pool_stats;
+}
+
+void
+tvpi_pool_reset_stats (void)
+{
+  memset (&pool_stats, 0, sizeof (pool_stats));
+}
+
+/**
+ * \brief Enables or disables pooling. When disabled, every object is
+ * allocated with its own malloc. Only affects future allocations. The
+ * setting is shared by all threads.
+ */
+void
+tvpi_pool_enable (int enable)
+{
+  POOL_STORE (&pool_enabled, enable);
+}
@@ -0,0 +1,1244 @@
+/**********************************************************************
+ * Incremental quantifier elimination context for the TVPI family of
+ * theories. Implements the qelim_* part of the theory interface that
+ * is used by Ldd_IsSat, Ldd_SatReduce, Ldd_UnsatSize and
+ * Ldd_ExistAbstractPAT.
+ *
+ * Octagonal constraints (+-x +-y op k and +-x op k) are kept in a
+ * strongly closed difference-bound matrix over the nodes x+ = 2*s and
+ * x- = 2*s+1 of every variable x (s is the slot of x in the
+ * matrix). Entry m[i][j] bounds v_j - v_i. A push closes the matrix
+ * incrementally in O(n^2) and records every entry it changes on a
+ * trail. A pop restores the recorded entries. Over the integers, the
+ * closure is tightened, which makes it exact for UTVPI(Z) and BOX(Z).
+ *
+ * Constraints with a non-unit coefficient do not fit in the
+ * matrix. While any of them is on the stack, qelim_solve falls back
+ * to Fourier-Motzkin elimination over the whole stack. Over the
+ * integers the fallback is a relaxation: it never reports a
+ * satisfiable conjunction as unsatisfiable.
+ *********************************************************************/
+
+#include "tvpiInt.h"
+
+
+/* a bound on v_j - v_i */
+typedef struct tvpi_bnd
+{
+  mpq_t val;
+  /* 0 if the bound is +oo */
+  char fin;
+  /* 1 if the bound is strict */
+  char strict;
+} tvpi_bnd_t;
+
+/* a matrix entry and its value before it was changed */
+typedef struct tvpi_undo
+{
+  unsigned int i;
+  unsigned int j;
+  tvpi_bnd_t old;
+} tvpi_undo_t;
+
+/* a constraint on the context stack */
+typedef struct tvpi_qframe
+{
+  tvpi_cons_t cons;
+  /* size of the trail before cons was pushed */
+  size_t trail;
+  /* 1 if cons is not octagonal */
+  int general;
+  /* 1 if cons could not be added to the matrix */
+  int failed;
+} tvpi_qframe_t;
+
+struct tvpi_qelim_ctx
+{
+  LddManager *ldd;
+  tvpi_theory_t *theory;
+  /* 1 if variables range over integers */
+  int is_int;
+
+  /* vars[x] != 0 iff x is quantified */
+  int *vars;
+  /* maps a variable to its slot in the matrix, or -1 */
+  int *slot;
+  size_t nvars;
+
+  /* maps a slot to its variable */
+  int *slot_var;
+  size_t nslots;
+  /* capacity in slots. The matrix is (2*cap) x (2*cap) */
+  size_t cap;
+  tvpi_bnd_t *m;
+
+  tvpi_undo_t *trail;
+  size_t trail_size;
+  size_t trail_cap;
+
+  tvpi_qframe_t *stack;
+  size_t depth;
+  size_t stack_cap;
+
+  /* index of the frame that made the matrix inconsistent, or -1 */
+  long unsat;
+  /* number of non-octagonal constraints on the stack */
+  int ngeneral;
+  /* number of failed frames on the stack, and of pushes on top of
+     the stack that could not be recorded, see tvpi_qelim_push() */
+  int nfailed;
+  size_t lost;
+
+  /* scratch space */
+  tvpi_bnd_t zero;
+  tvpi_bnd_t w;
+  tvpi_bnd_t s1;
+  tvpi_bnd_t s2;
+  mpq_t k;
+};
+
+/* a linear inequality with at most two variables, used by the
+   Fourier-Motzkin fallback */
+typedef struct tvpi_row
+{
+  int var [2];
+  mpq_t coeff [2];
+  mpq_t cst;
+  int strict;
+} tvpi_row_t;
+
+typedef struct tvpi_rows
+{
+  tvpi_row_t **r;
+  size_t n;
+  size_t cap;
+} tvpi_rows_t;
+
+
+#define M(ctx,i,j) (&(ctx)->m [(size_t)(i) * 2 * (ctx)->cap + (j)])
+/* node of variable in slot s with coefficient of sign sgn */
+#define NODE(s,sgn) (2 * (s) + ((sgn) > 0 ? 0 : 1))
+
+
+static void
+bnd_init (tvpi_bnd_t *b)
+{
+  mpq_init (b->val);
+  b->fin = 0;
+  b->strict = 0;
+}
+
+/**
+ * Returns true if a is a tighter bound than b
+ */
+static int
+bnd_lt (tvpi_bnd_t *a, tvpi_bnd_t *b)
+{
+  int c;
+
+  if (!a->fin) return 0;
+  if (!b->fin) return 1;
+
+  c = mpq_cmp (a->val, b->val);
+  return c < 0 || (c == 0 && a->strict && !b->strict);
+}
+
+/* r = a + b. Requires: a and b are finite */
+static void
+bnd_add (tvpi_bnd_t *r, tvpi_bnd_t *a, tvpi_bnd_t *b)
+{
+  mpq_add (r->val, a->val, b->val);
+  r->fin = 1;
+  r->strict = a->strict | b->strict;
+}
+
+
+/**
+ * Doubles the slot capacity of the matrix. New entries are +oo,
+ * except for the diagonal which is 0.
+ */
+static int
+qelim_grow (tvpi_qelim_ctx_t *ctx)
+{
+  size_t ncap, ndim, dim, i, j;
+  tvpi_bnd_t *nm;
+  int *nsv;
+
+  ncap = ctx->cap == 0 ? 8 : 2 * ctx->cap;
+  ndim = 2 * ncap;
+  dim = 2 * ctx->cap;
+
+  nm = (tvpi_bnd_t*) malloc (ndim * ndim * sizeof (tvpi_bnd_t));
+  if (nm == NULL) return 0;
+  nsv = (int*) realloc (ctx->slot_var, ncap * sizeof (int));
+  if (nsv == NULL)
+    {
+      free (nm);
+      return 0;
+    }
+  ctx->slot_var = nsv;
+
+  for (i = 0; i < ndim; i++)
+    for (j = 0; j < ndim; j++)
+      {
+	tvpi_bnd_t *e = &nm [i * ndim + j];
+
+	bnd_init (e);
+	if (i < dim && j < dim)
+	  {
+	    tvpi_bnd_t *o = M(ctx, i, j);
+	    mpq_swap (e->val, o->val);
+	    e->fin = o->fin;
+	    e->strict = o->strict;
+	    mpq_clear (o->val);
+	  }
+	else
+	  e->fin = (i == j);
+      }
+
+  free (ctx->m);
+  ctx->m = nm;
+  ctx->cap = ncap;
+  return 1;
+}
+
+/**
+ * Returns the slot of variable var, allocating a new one if needed.
+ * Returns -1 on failure.
+ */
+static int
+qelim_slot (tvpi_qelim_ctx_t *ctx, int var)
+{
+  int s;
+
+  if ((size_t)var >= ctx->nvars)
+    {
+      size_t n, i;
+      int *nv, *ns;
+
+      n = var + 10;
+      nv = (int*) realloc (ctx->vars, n * sizeof (int));
+      if (nv == NULL) return -1;
+      ctx->vars = nv;
+      ns = (int*) realloc (ctx->slot, n * sizeof (int));
+      if (ns == NULL) return -1;
+      ctx->slot = ns;
+
+      for (i = ctx->nvars; i < n; i++)
+	{
+	  ctx->vars [i] = 0;
+	  ctx->slot [i] = -1;
+	}
+      ctx->nvars = n;
+    }
+
+  if (ctx->slot [var] >= 0) return ctx->slot [var];
+
+  if (ctx->nslots == ctx->cap && !qelim_grow (ctx)) return -1;
+
+  s = ctx->nslots++;
+  ctx->slot [var] = s;
+  ctx->slot_var [s] = var;
+  return s;
+}
+
+/**
+ * Sets m[i][j] to b and records the old value on the trail. Returns
+ * 0 if the trail cannot grow, and leaves m[i][j] unchanged.
+ */
+static int
+qelim_set (tvpi_qelim_ctx_t *ctx, unsigned int i, unsigned int j,
+	   tvpi_bnd_t *b)
+{
+  tvpi_undo_t *u;
+  tvpi_bnd_t *e;
+
+  if (ctx->trail_size == ctx->trail_cap)
+    {
+      size_t n, k;
+      tvpi_undo_t *nt;
+
+      n = ctx->trail_cap == 0 ? 64 : 2 * ctx->trail_cap;
+      nt = (tvpi_undo_t*) realloc (ctx->trail, n * sizeof (tvpi_undo_t));
+      if (nt == NULL) return 0;
+      for (k = ctx->trail_cap; k < n; k++)
+	mpq_init (nt [k].old.val);
+      ctx->trail = nt;
+      ctx->trail_cap = n;
+    }
+
+  e = M(ctx, i, j);
+  u = &ctx->trail [ctx->trail_size++];
+  u->i = i;
+  u->j = j;
+  mpq_swap (u->old.val, e->val);
+  u->old.fin = e->fin;
+  u->old.strict = e->strict;
+
+  mpq_set (e->val, b->val);
+  e->fin = b->fin;
+  e->strict = b->strict;
+  return 1;
+}
+
+/**
+ * Restores the matrix to the state when the trail had mark entries
+ */
+static void
+qelim_undo (tvpi_qelim_ctx_t *ctx, size_t mark)
+{
+  while (ctx->trail_size > mark)
+    {
+      tvpi_undo_t *u;
+      tvpi_bnd_t *e;
+
+      u = &ctx->trail [--ctx->trail_size];
+      e = M(ctx, u->i, u->j);
+      mpq_swap (e->val, u->old.val);
+      e->fin = u->old.fin;
+      e->strict = u->old.strict;
+    }
+}
+
+/**
+ * Returns true if the diagonal of the matrix is negative
+ */
+static int
+qelim_neg_cycle (tvpi_qelim_ctx_t *ctx)
+{
+  size_t i, n;
+
+  n = 2 * ctx->nslots;
+  for (i = 0; i < n; i++)
+    if (bnd_lt (M(ctx, i, i), &ctx->zero)) return 1;
+  return 0;
+}
+
+/**
+ * Adds v_b - v_a <= w to a closed matrix and closes it again.
+ * Returns 0 if the matrix becomes inconsistent, -1 on failure, and 1
+ * otherwise. On failure, the matrix is restored by qelim_undo().
+ */
+static int
+qelim_add_edge (tvpi_qelim_ctx_t *ctx, unsigned int a, unsigned int b,
+		tvpi_bnd_t *w)
+{
+  unsigned int i, j, n;
+
+  /* implied by the matrix */
+  if (!bnd_lt (w, M(ctx, a, b))) return 1;
+
+  n = 2 * ctx->nslots;
+
+  /* a shortest path that uses the new edge is i -> a -> b -> j */
+  for (i = 0; i < n; i++)
+    {
+      tvpi_bnd_t *ia;
+
+      ia = M(ctx, i, a);
+      if (!ia->fin) continue;
+      bnd_add (&ctx->s1, ia, w);
+
+      for (j = 0; j < n; j++)
+	{
+	  tvpi_bnd_t *bj;
+
+	  bj = M(ctx, b, j);
+	  if (!bj->fin) continue;
+
+	  bnd_add (&ctx->s2, &ctx->s1, bj);
+	  if (bnd_lt (&ctx->s2, M(ctx, i, j)) &&
+	      !qelim_set (ctx, i, j, &ctx->s2))
+	    return -1;
+	}
+    }
+
+  return !qelim_neg_cycle (ctx);
+}
+
+/**
+ * Strengthens (and over integers, tightens) a closed matrix. Returns
+ * 0 if the matrix becomes inconsistent, -1 on failure, and 1
+ * otherwise.
+ */
+static int
+qelim_strengthen (tvpi_qelim_ctx_t *ctx)
+{
+  unsigned int i, j, n;
+
+  n = 2 * ctx->nslots;
+
+  /* m[i][i^1] bounds an even multiple of a variable. Over integers,
+     round it down to an even integer */
+  if (ctx->is_int)
+    for (i = 0; i < n; i++)
+      {
+	tvpi_bnd_t *e;
+
+	e = M(ctx, i, i ^ 1);
+	if (!e->fin) continue;
+
+	mpz_mul_2exp (mpq_denref (ctx->k), mpq_denref (e->val), 1);
+	mpz_fdiv_q (mpq_numref (ctx->s1.val), mpq_numref (e->val),
+		    mpq_denref (ctx->k));
+	mpz_set_ui (mpq_denref (ctx->s1.val), 1);
+	mpq_mul_2exp (ctx->s1.val, ctx->s1.val, 1);
+	ctx->s1.fin = 1;
+	ctx->s1.strict = 0;
+	if (bnd_lt (&ctx->s1, e) && !qelim_set (ctx, i, i ^ 1, &ctx->s1))
+	  return -1;
+      }
+
+  /* v_j - v_i <= (v_{i^1} - v_i)/2 + (v_j - v_{j^1})/2 */
+  for (i = 0; i < n; i++)
+    {
+      tvpi_bnd_t *ii;
+
+      ii = M(ctx, i, i ^ 1);
+      if (!ii->fin) continue;
+
+      for (j = 0; j < n; j++)
+	{
+	  tvpi_bnd_t *jj;
+
+	  jj = M(ctx, j ^ 1, j);
+	  if (!jj->fin) continue;
+
+	  bnd_add (&ctx->s2, ii, jj);
+	  mpq_div_2exp (ctx->s2.val, ctx->s2.val, 1);
+	  if (bnd_lt (&ctx->s2, M(ctx, i, j)) &&
+	      !qelim_set (ctx, i, j, &ctx->s2))
+	    return -1;
+	}
+    }
+
+  return !qelim_neg_cycle (ctx);
+}
+
+/**
+ * Returns true if c is octagonal, i.e., the coefficient of its
+ * second variable (if any) is +1 or -1
+ */
+static int
+qelim_is_oct (tvpi_qelim_ctx_t *ctx, tvpi_cons_t c)
+{
+  if (!IS_VAR (c->var [1])) return 1;
+
+  tvpi_cst_set_mpq (ctx->k, c->coeff);
+  return mpz_cmp_ui (mpq_denref (ctx->k), 1) == 0 &&
+    mpz_cmpabs_ui (mpq_numref (ctx->k), 1) == 0;
+}
+
+/**
+ * Adds an octagonal constraint to the matrix. Returns 0 if the
+ * matrix becomes inconsistent, -1 on failure, and 1 otherwise.
+ */
+static int
+qelim_add_oct (tvpi_qelim_ctx_t *ctx, tvpi_cons_t c)
+{
+  int s0, s1, res;
+  unsigned int p, q;
+  tvpi_bnd_t *w;
+  size_t mark;
+
+  s0 = qelim_slot (ctx, c->var [0]);
+  s1 = IS_VAR (c->var [1]) ? qelim_slot (ctx, c->var [1]) : 0;
+  if (s0 < 0 || s1 < 0) return -1;
+
+  w = &ctx->w;
+  tvpi_cst_set_mpq (w->val, c->cst);
+  w->fin = 1;
+  w->strict = c->op == LT;
+
+  /* over integers, t < k is t <= ceil(k)-1 and t <= k is t <= floor(k) */
+  if (ctx->is_int)
+    {
+      if (w->strict)
+	{
+	  mpz_cdiv_q (mpq_numref (w->val), mpq_numref (w->val),
+		      mpq_denref (w->val));
+	  mpz_sub_ui (mpq_numref (w->val), mpq_numref (w->val), 1);
+	}
+      else
+	mpz_fdiv_q (mpq_numref (w->val), mpq_numref (w->val),
+		    mpq_denref (w->val));
+      mpz_set_ui (mpq_denref (w->val), 1);
+      w->strict = 0;
+    }
+
+  mark = ctx->trail_size;
+  p = NODE(s0, c->sgn);
+
+  if (!IS_VAR (c->var [1]))
+    {
+      /* v_p <= k is v_p - v_{p^1} <= 2k */
+      mpq_mul_2exp (w->val, w->val, 1);
+      res = qelim_add_edge (ctx, p ^ 1, p, w);
+      if (res <= 0) return res;
+    }
+  else
+    {
+      /* v_p + v_q <= k is v_p - v_{q^1} <= k and v_q - v_{p^1} <= k */
+      tvpi_cst_set_mpq (ctx->k, c->coeff);
+      q = NODE(s1, mpq_sgn (ctx->k));
+      res = qelim_add_edge (ctx, q ^ 1, p, w);
+      if (res > 0) res = qelim_add_edge (ctx, p ^ 1, q, w);
+      if (res <= 0) return res;
+    }
+
+  /* nothing changed, the matrix is still strongly closed */
+  if (mark == ctx->trail_size) return 1;
+
+  return qelim_strengthen (ctx);
+}
+
+
+/**
+ * Creates a new quantifier elimination context. vars[x] != 0 iff x is
+ * quantified.
+ */
+tvpi_qelim_ctx_t *
+tvpi_qelim_init (LddManager *m, int *vars)
+{
+  tvpi_qelim_ctx_t *ctx;
+  size_t i;
+
+  ctx = (tvpi_qelim_ctx_t*) malloc (sizeof (tvpi_qelim_ctx_t));
+  if (ctx == NULL) return NULL;
+
+  ctx->ldd = m;
+  ctx->theory = (tvpi_theory_t*) m->theory;
+  ctx->is_int = ctx->theory->is_int;
+
+  ctx->nvars = ctx->theory->size;
+  ctx->vars = (int*) malloc (ctx->nvars * sizeof (int));
+  ctx->slot = (int*) malloc (ctx->nvars * sizeof (int));
+  if (ctx->vars == NULL || ctx->slot == NULL)
+    {
+      free (ctx->vars);
+      free (ctx->slot);
+      free (ctx);
+      return NULL;
+    }
+  for (i = 0; i < ctx->nvars; i++)
+    {
+      ctx->vars [i] = vars != NULL && vars [i];
+      ctx->slot [i] = -1;
+    }
+
+  ctx->slot_var = NULL;
+  ctx->nslots = 0;
+  ctx->cap = 0;
+  ctx->m = NULL;
+
+  ctx->trail = NULL;
+  ctx->trail_size = 0;
+  ctx->trail_cap = 0;
+
+  ctx->stack = NULL;
+  ctx->depth = 0;
+  ctx->stack_cap = 0;
+
+  ctx->unsat = -1;
+  ctx->ngeneral = 0;
+  ctx->nfailed = 0;
+  ctx->lost = 0;
+
+  bnd_init (&ctx->zero);
+  ctx->zero.fin = 1;
+  bnd_init (&ctx->w);
+  bnd_init (&ctx->s1);
+  bnd_init (&ctx->s2);
+  mpq_init (ctx->k);
+
+  return ctx;
+}
+
+/**
+ * Pushes c on the context. If memory runs out, the projection of the
+ * context is unchanged, and tvpi_qelim_solve() fails until c is
+ * popped.
+ */
+void
+tvpi_qelim_push (tvpi_qelim_ctx_t *ctx, tvpi_cons_t c)
+{
+  tvpi_qframe_t *f;
+  int res;
+
+  /* grow while a frame is still free, so that this push is recorded
+     even if the stack cannot grow */
+  if (ctx->depth + 1 >= ctx->stack_cap && ctx->lost == 0)
+    {
+      size_t n;
+      tvpi_qframe_t *ns;
+
+      n = ctx->stack_cap == 0 ? 32 : 2 * ctx->stack_cap;
+      ns = (tvpi_qframe_t*) realloc (ctx->stack, n * sizeof (tvpi_qframe_t));
+      if (ns != NULL)
+	{
+	  ctx->stack = ns;
+	  ctx->stack_cap = n;
+	}
+    }
+  if (ctx->depth == ctx->stack_cap || ctx->lost > 0)
+    {
+      ctx->lost++;
+      return;
+    }
+
+  f = &ctx->stack [ctx->depth++];
+  f->cons = c;
+  f->trail = ctx->trail_size;
+  f->general = 0;
+  f->failed = 0;
+
+  /* the context is already inconsistent */
+  if (ctx->unsat >= 0) return;
+
+  if (!qelim_is_oct (ctx, c))
+    {
+      f->general = 1;
+      ctx->ngeneral++;
+      return;
+    }
+
+  res = qelim_add_oct (ctx, c);
+  if (res == 0)
+    ctx->unsat = ctx->depth - 1;
+  else if (res < 0)
+    {
+      qelim_undo (ctx, f->trail);
+      f->failed = 1;
+      ctx->nfailed++;
+    }
+}
+
+/**
+ * Removes the last constraint from the context and returns it. Returns
+ * NULL for a constraint that tvpi_qelim_push() could not record.
+ */
+tvpi_cons_t
+tvpi_qelim_pop (tvpi_qelim_ctx_t *ctx)
+{
+  tvpi_qframe_t *f;
+
+  if (ctx->lost > 0)
+    {
+      ctx->lost--;
+      return NULL;
+    }
+
+  assert (ctx->depth > 0 && "Pop from an empty context");
+  f = &ctx->stack [--ctx->depth];
+
+  qelim_undo (ctx, f->trail);
+  if (f->general) ctx->ngeneral--;
+  if (f->failed) ctx->nfailed--;
+  if (ctx->unsat == (long)ctx->depth) ctx->unsat = -1;
+
+  return f->cons;
+}
+
+/**
+ * Conjoins 'sx*x + sy*y op k' to res, where the bound k is b (or b/2
+ * if y is not a variable). Consumes the reference to res and returns
+ * a referenced result, or NULL on failure.
+ */
+static LddNode *
+qelim_conjoin (tvpi_qelim_ctx_t *ctx, LddNode *res,
+	       int x, int sx, int y, int sy, tvpi_bnd_t *b)
+{
+  LddManager *ldd;
+  int var [2], coeff [2];
+  size_t n;
+  tvpi_term_t t;
+  tvpi_cons_t c;
+  LddNode *d, *r;
+
+  ldd = ctx->ldd;
+
+  mpq_set (ctx->k, b->val);
+  if (!IS_VAR (y))
+    {
+      var [0] = x;
+      coeff [0] = sx;
+      n = 1;
+      mpq_div_2exp (ctx->k, ctx->k, 1);
+    }
+  else
+    {
+      var [0] = x < y ? x : y;
+      coeff [0] = x < y ? sx : sy;
+      var [1] = x < y ? y : x;
+      coeff [1] = x < y ? sy : sx;
+      n = 2;
+    }
+
+  t = tvpi_create_term_sparse_si (var, coeff, n);
+  c = (tvpi_cons_t) ctx->theory->base.create_cons (t, b->strict,
+						   tvpi_create_cst (ctx->k));
+  d = tvpi_to_ldd (ldd, c);
+  tvpi_destroy_cons (c);
+
+  if (d == NULL)
+    {
+      Cudd_IterDerefBdd (CUDD, res);
+      return NULL;
+    }
+  cuddRef (d);
+
+  r = lddAndRecur (ldd, res, d);
+  if (r != NULL) cuddRef (r);
+  Cudd_IterDerefBdd (CUDD, res);
+  Cudd_IterDerefBdd (CUDD, d);
+  return r;
+}
+
+/**
+ * Projects the matrix onto the unquantified variables. Returns an
+ * unreferenced LDD, or NULL on failure.
+ */
+static LddNode *
+qelim_project (tvpi_qelim_ctx_t *ctx)
+{
+  LddManager *ldd;
+  LddNode *res;
+  size_t s, r;
+
+  ldd = ctx->ldd;
+  res = DD_ONE (CUDD);
+  cuddRef (res);
+
+  for (s = 0; s < ctx->nslots && res != NULL; s++)
+    {
+      int x;
+      unsigned int a, b;
+
+      x = ctx->slot_var [s];
+      if (ctx->vars [x]) continue;
+
+      /* m[2s+1][2s] bounds 2x and m[2s][2s+1] bounds -2x */
+      if (M(ctx, 2*s + 1, 2*s)->fin)
+	res = qelim_conjoin (ctx, res, x, 1, -1, 0, M(ctx, 2*s + 1, 2*s));
+      if (res != NULL && M(ctx, 2*s, 2*s + 1)->fin)
+	res = qelim_conjoin (ctx, res, x, -1, -1, 0, M(ctx, 2*s, 2*s + 1));
+
+      for (r = s + 1; r < ctx->nslots && res != NULL; r++)
+	{
+	  int y;
+
+	  y = ctx->slot_var [r];
+	  if (ctx->vars [y]) continue;
+
+	  /* m[a][b] bounds v_b - v_a. The entries from the nodes of y
+	     to the nodes of x are coherent with these */
+	  for (a = 2*s; a <= 2*s + 1 && res != NULL; a++)
+	    for (b = 2*r; b <= 2*r + 1 && res != NULL; b++)
+	      {
+		tvpi_bnd_t *e, *ua, *ub;
+
+		e = M(ctx, a, b);
+		if (!e->fin) continue;
+
+		/* skip bounds implied by the bounds on x and y */
+		ua = M(ctx, a, a ^ 1);
+		ub = M(ctx, b ^ 1, b);
+		if (ua->fin && ub->fin)
+		  {
+		    bnd_add (&ctx->s1, ua, ub);
+		    mpq_div_2exp (ctx->s1.val, ctx->s1.val, 1);
+		    if (!bnd_lt (e, &ctx->s1)) continue;
+		  }
+
+		res = qelim_conjoin (ctx, res,
+				     x, (a & 1) ? 1 : -1,
+				     y, (b & 1) ? -1 : 1, e);
+	      }
+	}
+    }
+
+  if (res != NULL) cuddDeref (res);
+  return res;
+}
+
+
+/**********************************************************************
+ * Fourier-Motzkin fallback
+ *********************************************************************/
+
+static tvpi_row_t *
+row_new (void)
+{
+  tvpi_row_t *r;
+
+  r = (tvpi_row_t*) malloc (sizeof (tvpi_row_t));
+  if (r == NULL) return NULL;
+  r->var [0] = r->var [1] = -1;
+  mpq_init (r->coeff [0]);
+  mpq_init (r->coeff [1]);
+  mpq_init (r->cst);
+  r->strict = 0;
+  return r;
+}
+
+static void
+row_free (tvpi_row_t *r)
+{
+  mpq_clear (r->coeff [0]);
+  mpq_clear (r->coeff [1]);
+  mpq_clear (r->cst);
+  free (r);
+}
+
+/* returns 0 if rs cannot grow. r is not added then */
+static int
+rows_add (tvpi_rows_t *rs, tvpi_row_t *r)
+{
+  if (rs->n == rs->cap)
+    {
+      size_t n;
+      tvpi_row_t **nr;
+
+      n = rs->cap == 0 ? 16 : 2 * rs->cap;
+      nr = (tvpi_row_t**) realloc (rs->r, n * sizeof (tvpi_row_t*));
+      if (nr == NULL) return 0;
+      rs->r = nr;
+      rs->cap = n;
+    }
+  rs->r [rs->n++] = r;
+  return 1;
+}
+
+/* frees the rows of rs. Rows moved out of rs are NULL */
+static void
+rows_clear (tvpi_rows_t *rs)
+{
+  size_t i;
+  for (i = 0; i < rs->n; i++)
+    if (rs->r [i] != NULL)
+      row_free (rs->r [i]);
+  free (rs->r);
+  rs->r = NULL;
+  rs->n = rs->cap = 0;
+}
+
+static int
+row_coeff_sgn (tvpi_row_t *r, int x)
+{
+  if (r->var [0] == x) return mpq_sgn (r->coeff [0]);
+  if (r->var [1] == x) return mpq_sgn (r->coeff [1]);
+  return 0;
+}
+
+/**
+ * Brings a row into a canonical form: variables are ordered, zero
+ * coefficients are removed, and the first coefficient is +1 or -1
+ * (over integers, the coefficients are co-prime integers and the
+ * constant is rounded down).
+ *
+ * Returns -1 if the row is inconsistent, 0 if it is trivially true,
+ * and 1 otherwise.
+ */
+static int
+row_normalize (tvpi_qelim_ctx_t *ctx, tvpi_row_t *r)
+{
+  int sgn;
+
+  if (IS_VAR (r->var [1]) && mpq_sgn (r->coeff [1]) == 0)
+    r->var [1] = -1;
+  if (IS_VAR (r->var [0]) && mpq_sgn (r->coeff [0]) == 0)
+    {
+      r->var [0] = r->var [1];
+      mpq_swap (r->coeff [0], r->coeff [1]);
+      r->var [1] = -1;
+    }
+  if (!IS_VAR (r->var [1])) mpq_set_ui (r->coeff [1], 0, 1);
+
+  /* no variables: 0 op cst */
+  if (!IS_VAR (r->var [0]))
+    {
+      sgn = mpq_sgn (r->cst);
+      return (sgn > 0 || (sgn == 0 && !r->strict)) ? 0 : -1;
+    }
+
+  if (IS_VAR (r->var [1]) && r->var [0] > r->var [1])
+    {
+      int v = r->var [0];
+      r->var [0] = r->var [1];
+      r->var [1] = v;
+      mpq_swap (r->coeff [0], r->coeff [1]);
+    }
+
+  if (ctx->is_int)
+    {
+      mpz_t l, g;
+      int i;
+
+      /* scale to co-prime integer coefficients */
+      mpz_init_set (l, mpq_denref (r->coeff [0]));
+      mpz_lcm (l, l, mpq_denref (r->coeff [1]));
+      mpz_init (g);
+      mpz_mul (g, mpq_numref (r->coeff [0]), l);
+      mpz_divexact (g, g, mpq_denref (r->coeff [0]));
+      mpz_abs (g, g);
+      if (IS_VAR (r->var [1]))
+	{
+	  mpz_t t;
+	  mpz_init (t);
+	  mpz_mul (t, mpq_numref (r->coeff [1]), l);
+	  mpz_divexact (t, t, mpq_denref (r->coeff [1]));
+	  mpz_gcd (g, g, t);
+	  mpz_clear (t);
+	}
+      /* multiply everything by l/g */
+      mpq_set_num (ctx->k, l);
+      mpq_set_den (ctx->k, g);
+      mpq_canonicalize (ctx->k);
+      for (i = 0; i < 2; i++)
+	mpq_mul (r->coeff [i], r->coeff [i], ctx->k);
+      mpq_mul (r->cst, r->cst, ctx->k);
+      mpz_clear (l);
+      mpz_clear (g);
+
+      if (r->strict)
+	{
+	  mpz_cdiv_q (mpq_numref (r->cst), mpq_numref (r->cst),
+		      mpq_denref (r->cst));
+	  mpz_sub_ui (mpq_numref (r->cst), mpq_numref (r->cst), 1);
+	}
+      else
+	mpz_fdiv_q (mpq_numref (r->cst), mpq_numref (r->cst),
+		    mpq_denref (r->cst));
+      mpz_set_ui (mpq_denref (r->cst), 1);
+      r->strict = 0;
+    }
+  else
+    {
+      /* divide everything by |coeff[0]| */
+      mpq_abs (ctx->k, r->coeff [0]);
+      mpq_div (r->coeff [1], r->coeff [1], ctx->k);
+      mpq_div (r->cst, r->cst, ctx->k);
+      sgn = mpq_sgn (r->coeff [0]);
+      mpq_set_si (r->coeff [0], sgn, 1);
+    }
+
+  return 1;
+}
+
+static tvpi_row_t *
+row_from_cons (tvpi_cons_t c)
+{
+  tvpi_row_t *r;
+
+  r = row_new ();
+  if (r == NULL) return NULL;
+  r->var [0] = c->var [0];
+  mpq_set_si (r->coeff [0], c->sgn > 0 ? 1 : -1, 1);
+  if (c->fst_coeff != NULL)
+    tvpi_cst_set_mpq (r->coeff [0], c->fst_coeff);
+  if (IS_VAR (c->var [1]))
+    {
+      r->var [1] = c->var [1];
+      tvpi_cst_set_mpq (r->coeff [1], c->coeff);
+    }
+  tvpi_cst_set_mpq (r->cst, c->cst);
+  r->strict = c->op == LT;
+  return r;
+}
+
+/**
+ * Combines rows p and n so that x is eliminated. Requires: x has a
+ * positive coefficient in p and a negative one in n.
+ */
+static tvpi_row_t *
+row_resolve (tvpi_row_t *p, tvpi_row_t *n, int x)
+{
+  tvpi_row_t *r;
+  mpq_t lp, ln, t;
+  int i, k;
+
+  r = row_new ();
+  if (r == NULL) return NULL;
+  mpq_init (lp);
+  mpq_init (ln);
+  mpq_init (t);
+
+  /* lp * p + ln * n, where lp = -coeff(x,n) and ln = coeff(x,p) */
+  mpq_neg (lp, n->var [0] == x ? n->coeff [0] : n->coeff [1]);
+  mpq_set (ln, p->var [0] == x ? p->coeff [0] : p->coeff [1]);
+
+  k = 0;
+  for (i = 0; i < 2; i++)
+    if (IS_VAR (p->var [i]) && p->var [i] != x)
+      {
+	r->var [k] = p->var [i];
+	mpq_mul (r->coeff [k], p->coeff [i], lp);
+	k++;
+      }
+  for (i = 0; i < 2; i++)
+    if (IS_VAR (n->var [i]) && n->var [i] != x)
+      {
+	mpq_mul (t, n->coeff [i], ln);
+	if (k > 0 && r->var [0] == n->var [i])
+	  mpq_add (r->coeff [0], r->coeff [0], t);
+	else
+	  {
+	    assert (k < 2);
+	    r->var [k] = n->var [i];
+	    mpq_set (r->coeff [k], t);
+	    k++;
+	  }
+      }
+
+  mpq_mul (r->cst, p->cst, lp);
+  mpq_mul (t, n->cst, ln);
+  mpq_add (r->cst, r->cst, t);
+  r->strict = p->strict || n->strict;
+
+  mpq_clear (lp);
+  mpq_clear (ln);
+  mpq_clear (t);
+  return r;
+}
+
+/**
+ * Adds a normalized row to rs, unless rs already has a row with the
+ * same term and a tighter bound. Takes ownership of r. Returns 0 if
+ * rs cannot grow.
+ */
+static int
+rows_add_tightest (tvpi_rows_t *rs, tvpi_row_t *r)
+{
+  size_t i;
+
+  for (i = 0; i < rs->n; i++)
+    {
+      tvpi_row_t *o = rs->r [i];
+      int c;
+
+      if (o->var [0] != r->var [0] || o->var [1] != r->var [1] ||
+	  !mpq_equal (o->coeff [0], r->coeff [0]) ||
+	  !mpq_equal (o->coeff [1], r->coeff [1]))
+	continue;
+
+      c = mpq_cmp (r->cst, o->cst);
+      if (c < 0 || (c == 0 && r->strict && !o->strict))
+	{
+	  rs->r [i] = r;
+	  row_free (o);
+	}
+      else
+	row_free (r);
+      return 1;
+    }
+  if (rows_add (rs, r)) return 1;
+  row_free (r);
+  return 0;
+}
+
+/**
+ * Eliminates the quantified variables from the constraints on the
+ * stack using Fourier-Motzkin. Returns an unreferenced LDD, or NULL
+ * on failure.
+ */
+static LddNode *
+qelim_solve_fm (tvpi_qelim_ctx_t *ctx)
+{
+  LddManager *ldd;
+  tvpi_rows_t rows, next;
+  int *pos, *neg;
+  size_t i;
+  LddNode *res;
+
+  ldd = ctx->ldd;
+  rows.r = next.r = NULL;
+  rows.n = next.n = rows.cap = next.cap = 0;
+  pos = neg = NULL;
+  /* the result if memory runs out */
+  res = NULL;
+
+  for (i = 0; i < ctx->depth; i++)
+    {
+      tvpi_row_t *r;
+
+      r = row_from_cons (ctx->stack [i].cons);
+      if (r == NULL) goto done;
+      if (row_normalize (ctx, r) < 0)
+	{
+	  row_free (r);
+	  res = Cudd_Not (DD_ONE (CUDD));
+	  goto done;
+	}
+      if (!rows_add_tightest (&rows, r)) goto done;
+    }
+
+  pos = (int*) malloc (ctx->nvars * sizeof (int));
+  neg = (int*) malloc (ctx->nvars * sizeof (int));
+  if (pos == NULL || neg == NULL) goto done;
+
+  while (1)
+    {
+      int x, y, k;
+      long best;
+      size_t j;
+
+      /* pick a quantified variable with fewest resolvents */
+      memset (pos, 0, ctx->nvars * sizeof (int));
+      memset (neg, 0, ctx->nvars * sizeof (int));
+      for (i = 0; i < rows.n; i++)
+	for (k = 0; k < 2; k++)
+	  {
+	    y = rows.r [i]->var [k];
+	    if (!IS_VAR (y) || (size_t)y >= ctx->nvars || !ctx->vars [y])
+	      continue;
+	    if (mpq_sgn (rows.r [i]->coeff [k]) > 0) pos [y]++;
+	    else neg [y]++;
+	  }
+
+      x = -1;
+      best = -1;
+      for (y = 0; (size_t)y < ctx->nvars; y++)
+	if (pos [y] + neg [y] > 0 &&
+	    (best < 0 || (long)pos [y] * neg [y] < best))
+	  {
+	    x = y;
+	    best = (long)pos [y] * neg [y];
+	  }
+      if (x < 0) break;
+
+      for (i = 0; i < rows.n; i++)
+	if (row_coeff_sgn (rows.r [i], x) == 0)
+	  {
+	    if (!rows_add (&next, rows.r [i])) goto done;
+	    rows.r [i] = NULL;
+	  }
+
+      for (i = 0; i < rows.n; i++)
+	{
+	  if (rows.r [i] == NULL || row_coeff_sgn (rows.r [i], x) < 0) continue;
+	  for (j = 0; j < rows.n; j++)
+	    {
+	      tvpi_row_t *r;
+	      int v;
+
+	      if (rows.r [j] == NULL || row_coeff_sgn (rows.r [j], x) > 0)
+		continue;
+
+	      r = row_resolve (rows.r [i], rows.r [j], x);
+	      if (r == NULL) goto done;
+	      v = row_normalize (ctx, r);
+	      if (v < 0)
+		{
+		  row_free (r);
+		  res = Cudd_Not (DD_ONE (CUDD));
+		  goto done;
+		}
+	      else if (v == 0)
+		row_free (r);
+	      else if (!rows_add_tightest (&next, r))
+		goto done;
+	    }
+	}
+
+      /* swap the row sets */
+      for (i = 0; i < rows.n; i++)
+	if (rows.r [i] != NULL) row_free (rows.r [i]);
+      rows.n = 0;
+      {
+	tvpi_rows_t tmp = rows;
+	rows = next;
+	next = tmp;
+      }
+    }
+
+  /* conjoin the remaining rows */
+  res = DD_ONE (CUDD);
+  cuddRef (res);
+  for (i = 0; i < rows.n && res != NULL; i++)
+    {
+      tvpi_row_t *r = rows.r [i];
+      int var [2];
+      tvpi_cst_t coeff [2];
+      tvpi_term_t t;
+      tvpi_cons_t c;
+      LddNode *d, *tmp;
+
+      var [0] = r->var [0];
+      var [1] = r->var [1];
+      coeff [0] = tvpi_create_cst (r->coeff [0]);
+      coeff [1] = tvpi_create_cst (r->coeff [1]);
+      t = tvpi_create_term_sparse (var, coeff, IS_VAR (var [1]) ? 2 : 1);
+      if (!IS_VAR (var [1])) tvpi_destroy_cst (coeff [1]);
+      c = (tvpi_cons_t) ctx->theory->base.create_cons
+	(t, r->strict, tvpi_create_cst (r->cst));
+      d = tvpi_to_ldd (ldd, c);
+      tvpi_destroy_cons (c);
+      if (d == NULL)
+	{
+	  Cudd_IterDerefBdd (CUDD, res);
+	  res = NULL;
+	  break;
+	}
+      cuddRef (d);
+      tmp = lddAndRecur (ldd, res, d);
+      if (tmp != NULL) cuddRef (tmp);
+      Cudd_IterDerefBdd (CUDD, res);
+      Cudd_IterDerefBdd (CUDD, d);
+      res = tmp;
+    }
+  if (res != NULL) cuddDeref (res);
+
+ done:
+  free (pos);
+  free (neg);
+  rows_clear (&rows);
+  rows_clear (&next);
+  return res;
+}
+
+
+/**
+ * Returns the projection of the conjunction of the constraints in the
+ * context onto the unquantified variables. The result is false iff
+ * the conjunction is unsatisfiable. Returns NULL on failure, in
+ * particular while a constraint that could not be pushed is on the
+ * context.
+ */
+LddNode *
+tvpi_qelim_solve (tvpi_qelim_ctx_t *ctx)
+{
+  LddManager *ldd;
+
+  ldd = ctx->ldd;
+  if (ctx->unsat >= 0) return Cudd_Not (DD_ONE (CUDD));
+  if (ctx->nfailed > 0 || ctx->lost > 0) return NULL;
+  if (ctx->ngeneral > 0) return qelim_solve_fm (ctx);
+  return qelim_project (ctx);
+}
+
+void
+tvpi_qelim_destroy_context (tvpi_qelim_ctx_t *ctx)
+{
+  size_t i, n;
+
+  n = 4 * ctx->cap * ctx->cap;
+  for (i = 0; i < n; i++)
+    mpq_clear (ctx->m [i].val);
+  free (ctx->m);
+
+  for (i = 0; i < ctx->trail_cap; i++)
+    mpq_clear (ctx->trail [i].old.val);
+  free (ctx->trail);
+
+  free (ctx->stack);
+  free (ctx->slot_var);
+  free (ctx->slot);
+  free (ctx->vars);
+
+  mpq_clear (ctx->zero.val);
+  mpq_clear (ctx->w.val);
+  mpq_clear (ctx->s1.val);
+  mpq_clear (ctx->s2.val);
+  mpq_clear (ctx->k);
+  free (ctx);
+}